@@ -45,6 +45,9 @@ struct smtp_state {
   struct psock psock;
 
   char inputbuffer[4];
+#if PSOCK_BUFFERED
+  uint8_t outputbuffer[64];
+#endif /* PSOCK_BUFFERED */
   
   char *to;
   char *cc;
@@ -180,6 +183,7 @@ PT_THREAD(smtp_thread(void))
   }
 
   SEND_STRING(&s.psock, (char *)smtp_quit);
+  PSOCK_FLUSH(&s.psock);
   smtp_done(SMTP_ERR_OK);
   PSOCK_END(&s.psock);
 }
@@ -225,7 +229,15 @@ smtp_send(char *to, char *cc, char *from, char *subject,
   s.msgwidth = msgwidth;
   s.msgheight = msgheight;
 
+#if PSOCK_BUFFERED
+  /* The commands and the message are written in many small pieces,
+     which the output buffer gathers into full segments. */
+  PSOCK_INIT_BUFFERED(&s.psock, (uint8_t *)s.inputbuffer,
+                      sizeof(s.inputbuffer),
+                      s.outputbuffer, sizeof(s.outputbuffer));
+#else /* PSOCK_BUFFERED */
   PSOCK_INIT(&s.psock, (uint8_t *)s.inputbuffer, sizeof(s.inputbuffer));
+#endif /* PSOCK_BUFFERED */
   
   return 1;
 }
@@ -292,7 +292,6 @@ generate_file_stats(void *arg)
   static const char httpd_cgi_filestat3[] HTTPD_STRING_ATTR = "%5u";
   char tmp[20];
   struct httpd_fsdata_file_noconst *f,fram;
-  uint16_t i;
   unsigned short numprinted;
   /* Transfer arg from whichever flash that contains the html file to RAM */
   httpd_fs_cpy(&tmp, s->u.ptr, 20);
@@ -310,7 +309,7 @@ generate_file_stats(void *arg)
   /* Count for all files */
   /* Note buffer will overflow if there are too many files! */
   } else if (tmp[0]=='*') {
-    i=0;numprinted=0;
+    numprinted=0;
     for(f = (struct httpd_fsdata_file_noconst *)httpd_fs_get_root();
         f != NULL;
         f = (struct httpd_fsdata_file_noconst *)fram.next) {
@@ -322,9 +321,9 @@ generate_file_stats(void *arg)
 #if WEBSERVER_CONF_FILESTATS==2
       numprinted+=httpd_snprintf((char *)uip_appdata+numprinted, uip_mss()-numprinted, httpd_cgi_filestat2, tmp, tmp, f->count);
 #else
-      numprinted+=httpd_snprintf((char *)uip_appdata+numprinted, uip_mss()-numprinted, httpd_cgi_filestat2, tmp, tmp, httpd_filecount[i]);
+      /* Look the count up by name, the counts need not be in list order */
+      numprinted+=httpd_snprintf((char *)uip_appdata+numprinted, uip_mss()-numprinted, httpd_cgi_filestat2, tmp, tmp, httpd_fs_open(tmp, 0));
 #endif
-      i++;
     }
 
   /* Count for specified file */
@@ -58,6 +58,67 @@ httpd_fs_get_size()
   return HTTPD_FS_SIZE;
 }
 /*-----------------------------------------------------------------------------------*/
+#ifdef HTTPD_FS_INDEX_BUCKETS
+/* The hash functions of the index that makefsdata -x generates */
+static uint32_t
+httpd_fs_hash(const char *name)
+{
+  uint32_t h;
+
+  h = 2166136261UL;
+  while(*name) {
+    h = (h ^ (uint8_t)*name++) * 16777619UL;
+  }
+  return h;
+}
+/*-----------------------------------------------------------------------------------*/
+static uint16_t
+httpd_fs_slot(uint32_t h, uint8_t displacement)
+{
+  h ^= displacement;
+  h = (h ^ (h >> 16)) * 0x45d9f3bUL;
+  h ^= h >> 16;
+  return h % HTTPD_FS_NUMFILES;
+}
+/*-----------------------------------------------------------------------------------*/
+uint16_t
+httpd_fs_open(const char *name, struct httpd_fs_file *file)
+{
+  struct httpd_fsdata_index e;
+  struct httpd_fsdata_file_noconst *f,fram;
+  uint32_t h;
+  uint16_t i;
+
+  h = httpd_fs_hash(name);
+  i = httpd_fs_slot(h, httpd_fs_getchar(&httpd_fs_index_disp[h % HTTPD_FS_INDEX_BUCKETS]));
+
+  /*Get the index entry and the linked list entry it points to into ram */
+  httpd_memcpy(&e, &httpd_fs_index[i], sizeof(e));
+  f = (struct httpd_fsdata_file_noconst *)e.file;
+  httpd_memcpy(&fram, f, sizeof(fram));
+
+  /*The slot holds the only file that can have this name */
+  if(httpd_fs_strcmp((char *)name, fram.name) != 0) {
+    return 0;
+  }
+  if (file) {
+    file->data = fram.data;
+    file->len  = fram.len;
+#if WEBSERVER_CONF_FILESTATS==2         //increment count in linked list field if it is in RAM
+    f->count++;
+  }
+  return f->count;
+#elif WEBSERVER_CONF_FILESTATS==1       //increment count in RAM array, by index slot
+    ++httpd_filecount[i];
+  }
+  return httpd_filecount[i];
+#else                              //no file statistics
+  }
+  return 1;
+#endif /* WEBSERVER_CONF_FILESTATS */
+}
+#else /* HTTPD_FS_INDEX_BUCKETS */
+/*-----------------------------------------------------------------------------------*/
 uint16_t
 httpd_fs_open(const char *name, struct httpd_fs_file *file)
 {
@@ -100,6 +161,7 @@ httpd_fs_open(const char *name, struct httpd_fs_file *file)
   }
   return 0;
 }
+#endif /* HTTPD_FS_INDEX_BUCKETS */
 /*-----------------------------------------------------------------------------------*/
 void
 httpd_fs_init(void)
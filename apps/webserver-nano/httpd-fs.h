@@ -34,6 +34,16 @@
 #include "contiki-net.h"
 #include "httpd.h"
 
+/* Content types of files, by file name extension. */
+#define HTTPD_FS_TYPE_BINARY 0
+#define HTTPD_FS_TYPE_HTML   1
+#define HTTPD_FS_TYPE_SHTML  2
+#define HTTPD_FS_TYPE_CSS    3
+#define HTTPD_FS_TYPE_PNG    4
+#define HTTPD_FS_TYPE_GIF    5
+#define HTTPD_FS_TYPE_JPG    6
+#define HTTPD_FS_TYPE_PLAIN  7
+
 struct httpd_fs_file {
   char *data;
   int len;
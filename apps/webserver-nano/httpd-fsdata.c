@@ -113,3 +113,15 @@ const struct httpd_fsdata_file       file_tcp_shtml[] HTTPD_STRING_ATTR ={{   fi
 #define HTTPD_FS_ROOT  file_tcp_shtml
 #define HTTPD_FS_NUMFILES  5
 #define HTTPD_FS_SIZE 751
+
+/* Perfect hash index of the file names, see httpd_fs_open() */
+#define HTTPD_FS_INDEX_BUCKETS 3
+const uint8_t httpd_fs_index_disp[HTTPD_FS_INDEX_BUCKETS] HTTPD_STRING_ATTR = {
+  1, 1, 2};
+const struct httpd_fsdata_index httpd_fs_index[HTTPD_FS_NUMFILES] HTTPD_STRING_ATTR = {
+  {file_index_shtml, 12, HTTPD_FS_TYPE_SHTML},
+  {file_files_shtml, 12, HTTPD_FS_TYPE_SHTML},
+  {file_tcp_shtml, 10, HTTPD_FS_TYPE_SHTML},
+  {file_status_shtml, 13, HTTPD_FS_TYPE_SHTML},
+  {file_404_html, 9, HTTPD_FS_TYPE_HTML}
+};
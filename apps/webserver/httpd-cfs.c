@@ -71,24 +71,70 @@ MEMB(conns, struct httpd_state, CONNS);
 #define ISO_period  0x2e
 #define ISO_slash   0x2f
 
+/*---------------------------------------------------------------------------*/
+/*
+ * Make the segment of the file at s->offset in the packet buffer. The
+ * file is read HTTPD_READAHEAD bytes at a time and small segments are
+ * copied from there. Segments of at least that size are read straight
+ * into the packet buffer. A retransmission is made from the same
+ * offset, and is only read again if it is no longer in readbuf.
+ */
+static unsigned short
+generate_file(void *state)
+{
+  struct httpd_state *s = (struct httpd_state *)state;
+  cfs_offset_t pos;
+  int len, n;
+
+  len = 0;
+  while(len < uip_mss()) {
+    pos = s->offset + len;
+    if(pos >= s->bufoffset && pos < s->bufoffset + s->buflen) {
+      n = s->bufoffset + s->buflen - pos;
+      if(n > uip_mss() - len) {
+	n = uip_mss() - len;
+      }
+      memcpy((char *)uip_appdata + len, &s->readbuf[pos - s->bufoffset], n);
+      len += n;
+      continue;
+    }
+
+    if(pos != s->filepos) {
+      cfs_seek(s->fd, pos, CFS_SEEK_SET);
+      s->filepos = pos;
+    }
+    if(uip_mss() - len >= (int)sizeof(s->readbuf)) {
+      n = cfs_read(s->fd, (char *)uip_appdata + len, uip_mss() - len);
+      if(n <= 0) {
+	break;
+      }
+      len += n;
+    } else {
+      n = cfs_read(s->fd, s->readbuf, sizeof(s->readbuf));
+      if(n <= 0) {
+	break;
+      }
+      s->bufoffset = pos;
+      s->buflen = n;
+    }
+    s->filepos += n;
+  }
+  s->len = len;
+  return len;
+}
 /*---------------------------------------------------------------------------*/
 static
 PT_THREAD(send_file(struct httpd_state *s))
 {
   PSOCK_BEGIN(&s->sout);
-  
-  do {
-    /* Read data from file system into buffer */
-    s->len = cfs_read(s->fd, s->outputbuf, sizeof(s->outputbuf));
 
-    /* If there is data in the buffer, send it */
-    if(s->len > 0) {
-      PSOCK_SEND(&s->sout, (uint8_t *)s->outputbuf, s->len);
-    } else {
-      break;
-    }
+  s->offset = s->bufoffset = s->filepos = 0;
+  s->buflen = 0;
+  do {
+    PSOCK_GENERATOR_SEND(&s->sout, generate_file, s);
+    s->offset += s->len;
   } while(s->len > 0);
-      
+
   PSOCK_END(&s->sout);
 }
 /*---------------------------------------------------------------------------*/
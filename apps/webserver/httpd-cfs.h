@@ -35,6 +35,7 @@
 #define __HTTPD_CFS_H__
 
 #include "contiki-net.h"
+#include "cfs/cfs.h"
 
 #ifndef WEBSERVER_CONF_CFS_PATHLEN
 #define HTTPD_PATHLEN 80
@@ -42,16 +43,29 @@
 #define HTTPD_PATHLEN WEBSERVER_CONF_CFS_PATHLEN
 #endif /* WEBSERVER_CONF_CFS_CONNS */
 
+/* The number of bytes of a file that are read from CFS at a time.
+   Segments are copied from them, so that small segments do not cost
+   one read each. A smaller buffer saves RAM but takes more reads. */
+#ifndef WEBSERVER_CONF_CFS_READAHEAD
+#define HTTPD_READAHEAD UIP_TCP_MSS
+#else /* WEBSERVER_CONF_CFS_READAHEAD */
+#define HTTPD_READAHEAD WEBSERVER_CONF_CFS_READAHEAD
+#endif /* WEBSERVER_CONF_CFS_READAHEAD */
+
 struct httpd_state {
   struct timer timer;
   struct psock sin, sout;
   struct pt outputpt;
   char inputbuf[HTTPD_PATHLEN + 30];
-  char outputbuf[UIP_TCP_MSS];
   char filename[HTTPD_PATHLEN];
   char state;
   int fd;
   int len;
+  cfs_offset_t offset;
+  /* The part of the file in readbuf, and the file position. */
+  cfs_offset_t bufoffset, filepos;
+  int buflen;
+  char readbuf[HTTPD_READAHEAD];
 };
 
 
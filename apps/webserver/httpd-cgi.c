@@ -96,6 +96,9 @@ static const char tcp_name[] = /*  "tcp-connections"*/
 static const char proc_name[] = /*  "processes"*/
 {0x70, 0x72, 0x6f, 0x63, 0x65, 0x73, 0x73,
  0x65, 0x73, 0};
+static const char httpd_name[] = /*  "httpd-stats"*/
+{0x68, 0x74, 0x74, 0x70, 0x64, 0x2d, 0x73,
+ 0x74, 0x61, 0x74, 0x73, 0};
 
 static const char *states[] = {
   closed,
@@ -203,6 +206,45 @@ PT_THREAD(tcp_stats(struct httpd_state *s, char *ptr))
 }
 /*---------------------------------------------------------------------------*/
 static unsigned short
+make_httpd_stats(void *arg)
+{
+  struct httpd_state *s = (struct httpd_state *)arg;
+
+  switch(s->u.count) {
+  case 0:
+    return snprintf((char *)uip_appdata, uip_mss(),
+		    "<tr><td>Connections</td><td>%u of %u, at most %u</td></tr>\r\n",
+		    httpd_stats.conns, httpd_stats.pool, httpd_stats.maxconns);
+  case 1:
+    return snprintf((char *)uip_appdata, uip_mss(),
+		    "<tr><td>Memory</td><td>%u of %u bytes</td></tr>\r\n",
+		    (unsigned)(httpd_stats.conns * sizeof(struct httpd_state)),
+		    (unsigned)(httpd_stats.pool * sizeof(struct httpd_state)));
+  case 2:
+    return snprintf((char *)uip_appdata, uip_mss(),
+		    "<tr><td>Requests</td><td>%lu, %lu on kept-alive connections</td></tr>\r\n",
+		    (unsigned long)httpd_stats.requests,
+		    (unsigned long)httpd_stats.reused);
+  default:
+    return snprintf((char *)uip_appdata, uip_mss(),
+		    "<tr><td>Evicted/refused</td><td>%u/%u</td></tr>\r\n",
+		    httpd_stats.evicted, httpd_stats.refused);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(httpd_stats_cgi(struct httpd_state *s, char *ptr))
+{
+  PSOCK_BEGIN(&s->sout);
+
+  for(s->u.count = 0; s->u.count < 4; ++s->u.count) {
+    PSOCK_GENERATOR_SEND(&s->sout, make_httpd_stats, s);
+  }
+
+  PSOCK_END(&s->sout);
+}
+/*---------------------------------------------------------------------------*/
+static unsigned short
 make_processes(void *p)
 {
   char name[40];
@@ -365,6 +407,7 @@ static const char   rtes_name[] HTTPD_STRING_ATTR = "routes";
 HTTPD_CGI_CALL(file, file_name, file_stats);
 HTTPD_CGI_CALL(tcp, tcp_name, tcp_stats);
 HTTPD_CGI_CALL(proc, proc_name, processes);
+HTTPD_CGI_CALL(httpd, httpd_name, httpd_stats_cgi);
 #if WEBSERVER_CONF_STATUSPAGE && UIP_CONF_IPV6
 HTTPD_CGI_CALL(adrs, adrs_name, addresses);
 HTTPD_CGI_CALL(nbrs, nbrs_name, neighbors);
@@ -377,6 +420,7 @@ httpd_cgi_init(void)
   httpd_cgi_add(&file);
   httpd_cgi_add(&tcp);
   httpd_cgi_add(&proc);
+  httpd_cgi_add(&httpd);
 #if WEBSERVER_CONF_STATUSPAGE && UIP_CONF_IPV6
   httpd_cgi_add(&adrs);
   httpd_cgi_add(&nbrs);
@@ -36,6 +36,9 @@
 #include "httpd.h"
 #include "httpd-fs.h"
 #include "httpd-fsdata.h"
+#include "http-strings.h"
+
+#include <string.h>
 
 #include "httpd-fsdata.c"
 
@@ -44,6 +47,7 @@ static uint16_t count[HTTPD_FS_NUMFILES];
 #endif /* HTTPD_FS_STATISTICS */
 
 /*-----------------------------------------------------------------------------------*/
+#ifndef HTTPD_FS_INDEX_BUCKETS
 static uint8_t
 httpd_fs_strcmp(const char *str1, const char *str2)
 {
@@ -64,6 +68,99 @@ loop:
   ++i;
   goto loop;
 }
+#endif /* HTTPD_FS_INDEX_BUCKETS */
+/*-----------------------------------------------------------------------------------*/
+#ifdef HTTPD_FS_INDEX_BUCKETS
+/* The hash functions of the index that makefsdata -x generates. A name
+   ends where httpd_fs_strcmp() would stop comparing it, or at a query. */
+static uint32_t
+httpd_fs_hash(const char *name, uint8_t *len)
+{
+  uint32_t h;
+  uint8_t i;
+
+  h = 2166136261UL;
+  for(i = 0; name[i] != 0 && name[i] != '\r' && name[i] != '\n' &&
+        name[i] != '?'; i++) {
+    h = (h ^ (uint8_t)name[i]) * 16777619UL;
+  }
+  *len = i;
+  return h;
+}
+/*-----------------------------------------------------------------------------------*/
+static uint16_t
+httpd_fs_slot(uint32_t h, uint8_t displacement)
+{
+  h ^= displacement;
+  h = (h ^ (h >> 16)) * 0x45d9f3bUL;
+  h ^= h >> 16;
+  return h % HTTPD_FS_NUMFILES;
+}
+/*-----------------------------------------------------------------------------------*/
+/* Returns the number of the file called name, or -1. */
+static int
+httpd_fs_find(const char *name)
+{
+  const struct httpd_fsdata_index *e;
+  uint32_t h;
+  uint16_t i;
+  uint8_t len;
+
+  h = httpd_fs_hash(name, &len);
+  i = httpd_fs_slot(h, httpd_fs_index_disp[h % HTTPD_FS_INDEX_BUCKETS]);
+  e = &httpd_fs_index[i];
+  if(e->namelen != len || memcmp(name, e->file->name, len) != 0) {
+    return -1;
+  }
+  return i;
+}
+/*-----------------------------------------------------------------------------------*/
+int
+httpd_fs_open(const char *name, struct httpd_fs_file *file)
+{
+  const struct httpd_fsdata_index *e;
+  int i;
+
+  i = httpd_fs_find(name);
+  if(i < 0) {
+    return 0;
+  }
+  e = &httpd_fs_index[i];
+  file->data = (char *)e->file->data;
+  file->len = e->file->len;
+  file->type = e->type;
+  file->hdrlen = e->hdrlen;
+  file->flags = e->flags;
+#if HTTPD_FS_STATISTICS
+  ++count[i];
+#endif /* HTTPD_FS_STATISTICS */
+  return 1;
+}
+#else /* HTTPD_FS_INDEX_BUCKETS */
+/*-----------------------------------------------------------------------------------*/
+static uint8_t
+httpd_fs_type(const char *name)
+{
+  const char *ptr;
+
+  ptr = strrchr(name, '.');
+  if(ptr == NULL) {
+    return HTTPD_FS_TYPE_BINARY;
+  } else if(strncmp(http_html, ptr, 5) == 0) {
+    return HTTPD_FS_TYPE_HTML;
+  } else if(strncmp(http_shtml, ptr, 6) == 0) {
+    return HTTPD_FS_TYPE_SHTML;
+  } else if(strncmp(http_css, ptr, 4) == 0) {
+    return HTTPD_FS_TYPE_CSS;
+  } else if(strncmp(http_png, ptr, 4) == 0) {
+    return HTTPD_FS_TYPE_PNG;
+  } else if(strncmp(http_gif, ptr, 4) == 0) {
+    return HTTPD_FS_TYPE_GIF;
+  } else if(strncmp(http_jpg, ptr, 4) == 0) {
+    return HTTPD_FS_TYPE_JPG;
+  }
+  return HTTPD_FS_TYPE_PLAIN;
+}
 /*-----------------------------------------------------------------------------------*/
 int
 httpd_fs_open(const char *name, struct httpd_fs_file *file)
@@ -80,6 +177,9 @@ httpd_fs_open(const char *name, struct httpd_fs_file *file)
     if(httpd_fs_strcmp(name, f->name) == 0) {
       file->data = f->data;
       file->len = f->len;
+      file->type = httpd_fs_type(f->name);
+      file->hdrlen = 0;
+      file->flags = 0;
 #if HTTPD_FS_STATISTICS
       ++count[i];
 #endif /* HTTPD_FS_STATISTICS */
@@ -92,6 +192,7 @@ httpd_fs_open(const char *name, struct httpd_fs_file *file)
   }
   return 0;
 }
+#endif /* HTTPD_FS_INDEX_BUCKETS */
 /*-----------------------------------------------------------------------------------*/
 void
 httpd_fs_init(void)
@@ -108,6 +209,12 @@ httpd_fs_init(void)
 uint16_t
 httpd_fs_count(char *name)
 {
+#ifdef HTTPD_FS_INDEX_BUCKETS
+  int i;
+
+  i = httpd_fs_find(name);
+  return i < 0 ? 0 : count[i];
+#else /* HTTPD_FS_INDEX_BUCKETS */
   struct httpd_fsdata_file_noconst *f;
   uint16_t i;
 
@@ -122,6 +229,7 @@ httpd_fs_count(char *name)
     ++i;
   }
   return 0;
+#endif /* HTTPD_FS_INDEX_BUCKETS */
 }
 #endif /* HTTPD_FS_STATISTICS */
 /*-----------------------------------------------------------------------------------*/
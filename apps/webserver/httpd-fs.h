@@ -38,9 +38,27 @@
 
 #define HTTPD_FS_STATISTICS 1
 
+/* Content types of files, by file name extension. */
+#define HTTPD_FS_TYPE_BINARY 0
+#define HTTPD_FS_TYPE_HTML   1
+#define HTTPD_FS_TYPE_SHTML  2
+#define HTTPD_FS_TYPE_CSS    3
+#define HTTPD_FS_TYPE_PNG    4
+#define HTTPD_FS_TYPE_GIF    5
+#define HTTPD_FS_TYPE_JPG    6
+#define HTTPD_FS_TYPE_PLAIN  7
+
+/* File flags. */
+#define HTTPD_FS_GZIP        1
+
 struct httpd_fs_file {
   char *data;
   int len;
+  uint8_t type;
+  /* Length of the HTTP header that makefsdata -H stored right before
+     data, or zero. */
+  uint8_t hdrlen;
+  uint8_t flags;
 };
 
 /* file must be allocated by caller and will be filled in
@@ -133,30 +133,37 @@ const char data_upload_html[209]  = {
    0x0a, 0x3c, 0x2f, 0x62, 0x6f, 0x64, 0x79, 0x3e, 0x0a, 0x3c,
    0x2f, 0x68, 0x74, 0x6d, 0x6c, 0x3e};
 
-const char data_tcp_shtml[221]  = {
+const char data_tcp_shtml[289]  = {
   /* /tcp.shtml */
    0x2f, 0x74, 0x63, 0x70, 0x2e, 0x73, 0x68, 0x74, 0x6d, 0x6c, 0x00,
    0x25, 0x21, 0x3a, 0x20, 0x2f, 0x68, 0x65, 0x61, 0x64, 0x65,
    0x72, 0x2e, 0x68, 0x74, 0x6d, 0x6c, 0x0a, 0x3c, 0x68, 0x31,
-   0x3e, 0x43, 0x75, 0x72, 0x72, 0x65, 0x6e, 0x74, 0x20, 0x63,
-   0x6f, 0x6e, 0x6e, 0x65, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x73,
-   0x3c, 0x2f, 0x68, 0x31, 0x3e, 0x3c, 0x62, 0x72, 0x3e, 0x3c,
-   0x74, 0x61, 0x62, 0x6c, 0x65, 0x20, 0x77, 0x69, 0x64, 0x74,
-   0x68, 0x3d, 0x22, 0x31, 0x30, 0x30, 0x25, 0x22, 0x3e, 0x0a,
-   0x3c, 0x74, 0x72, 0x3e, 0x3c, 0x74, 0x68, 0x3e, 0x4c, 0x6f,
-   0x63, 0x61, 0x6c, 0x3c, 0x2f, 0x74, 0x68, 0x3e, 0x3c, 0x74,
-   0x68, 0x3e, 0x52, 0x65, 0x6d, 0x6f, 0x74, 0x65, 0x3c, 0x2f,
-   0x74, 0x68, 0x3e, 0x3c, 0x74, 0x68, 0x3e, 0x53, 0x74, 0x61,
-   0x74, 0x65, 0x3c, 0x2f, 0x74, 0x68, 0x3e, 0x3c, 0x74, 0x68,
-   0x3e, 0x52, 0x65, 0x74, 0x72, 0x61, 0x6e, 0x73, 0x6d, 0x69,
-   0x73, 0x73, 0x69, 0x6f, 0x6e, 0x73, 0x3c, 0x2f, 0x74, 0x68,
-   0x3e, 0x3c, 0x74, 0x68, 0x3e, 0x54, 0x69, 0x6d, 0x65, 0x72,
-   0x3c, 0x2f, 0x74, 0x68, 0x3e, 0x3c, 0x74, 0x68, 0x3e, 0x46,
-   0x6c, 0x61, 0x67, 0x73, 0x3c, 0x2f, 0x74, 0x68, 0x3e, 0x3c,
-   0x2f, 0x74, 0x72, 0x3e, 0x0a, 0x25, 0x21, 0x20, 0x74, 0x63,
-   0x70, 0x2d, 0x63, 0x6f, 0x6e, 0x6e, 0x65, 0x63, 0x74, 0x69,
-   0x6f, 0x6e, 0x73, 0x0a, 0x25, 0x21, 0x3a, 0x20, 0x2f, 0x66,
-   0x6f, 0x6f, 0x74, 0x65, 0x72, 0x2e, 0x68, 0x74, 0x6d, 0x6c};
+   0x3e, 0x57, 0x65, 0x62, 0x20, 0x73, 0x65, 0x72, 0x76, 0x65,
+   0x72, 0x3c, 0x2f, 0x68, 0x31, 0x3e, 0x3c, 0x62, 0x72, 0x3e,
+   0x3c, 0x74, 0x61, 0x62, 0x6c, 0x65, 0x20, 0x77, 0x69, 0x64,
+   0x74, 0x68, 0x3d, 0x22, 0x31, 0x30, 0x30, 0x25, 0x22, 0x3e,
+   0x0a, 0x25, 0x21, 0x20, 0x68, 0x74, 0x74, 0x70, 0x64, 0x2d,
+   0x73, 0x74, 0x61, 0x74, 0x73, 0x0a, 0x3c, 0x2f, 0x74, 0x61,
+   0x62, 0x6c, 0x65, 0x3e, 0x0a, 0x3c, 0x68, 0x31, 0x3e, 0x43,
+   0x75, 0x72, 0x72, 0x65, 0x6e, 0x74, 0x20, 0x63, 0x6f, 0x6e,
+   0x6e, 0x65, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x73, 0x3c, 0x2f,
+   0x68, 0x31, 0x3e, 0x3c, 0x62, 0x72, 0x3e, 0x3c, 0x74, 0x61,
+   0x62, 0x6c, 0x65, 0x20, 0x77, 0x69, 0x64, 0x74, 0x68, 0x3d,
+   0x22, 0x31, 0x30, 0x30, 0x25, 0x22, 0x3e, 0x0a, 0x3c, 0x74,
+   0x72, 0x3e, 0x3c, 0x74, 0x68, 0x3e, 0x4c, 0x6f, 0x63, 0x61,
+   0x6c, 0x3c, 0x2f, 0x74, 0x68, 0x3e, 0x3c, 0x74, 0x68, 0x3e,
+   0x52, 0x65, 0x6d, 0x6f, 0x74, 0x65, 0x3c, 0x2f, 0x74, 0x68,
+   0x3e, 0x3c, 0x74, 0x68, 0x3e, 0x53, 0x74, 0x61, 0x74, 0x65,
+   0x3c, 0x2f, 0x74, 0x68, 0x3e, 0x3c, 0x74, 0x68, 0x3e, 0x52,
+   0x65, 0x74, 0x72, 0x61, 0x6e, 0x73, 0x6d, 0x69, 0x73, 0x73,
+   0x69, 0x6f, 0x6e, 0x73, 0x3c, 0x2f, 0x74, 0x68, 0x3e, 0x3c,
+   0x74, 0x68, 0x3e, 0x54, 0x69, 0x6d, 0x65, 0x72, 0x3c, 0x2f,
+   0x74, 0x68, 0x3e, 0x3c, 0x74, 0x68, 0x3e, 0x46, 0x6c, 0x61,
+   0x67, 0x73, 0x3c, 0x2f, 0x74, 0x68, 0x3e, 0x3c, 0x2f, 0x74,
+   0x72, 0x3e, 0x0a, 0x25, 0x21, 0x20, 0x74, 0x63, 0x70, 0x2d,
+   0x63, 0x6f, 0x6e, 0x6e, 0x65, 0x63, 0x74, 0x69, 0x6f, 0x6e,
+   0x73, 0x0a, 0x25, 0x21, 0x3a, 0x20, 0x2f, 0x66, 0x6f, 0x6f,
+   0x74, 0x65, 0x72, 0x2e, 0x68, 0x74, 0x6d, 0x6c};
 
 const char data_status_shtml[174]  = {
   /* /status.shtml */
@@ -672,4 +679,21 @@ const struct httpd_fsdata_file       file_style_css[] ={{       file_404_html, d
 
 #define HTTPD_FS_ROOT  file_style_css
 #define HTTPD_FS_NUMFILES  10
-#define HTTPD_FS_SIZE 6166
+#define HTTPD_FS_SIZE 6234
+
+/* Perfect hash index of the file names, see httpd_fs_open() */
+#define HTTPD_FS_INDEX_BUCKETS 5
+const uint8_t httpd_fs_index_disp[HTTPD_FS_INDEX_BUCKETS]  = {
+  1, 1, 15, 16, 0};
+const struct httpd_fsdata_index httpd_fs_index[HTTPD_FS_NUMFILES]  = {
+  {file_tcp_shtml, 10, HTTPD_FS_TYPE_SHTML},
+  {file_style_css, 10, HTTPD_FS_TYPE_CSS},
+  {file_files_shtml, 12, HTTPD_FS_TYPE_SHTML},
+  {file_footer_html, 12, HTTPD_FS_TYPE_HTML},
+  {file_404_html, 9, HTTPD_FS_TYPE_HTML},
+  {file_upload_html, 12, HTTPD_FS_TYPE_HTML},
+  {file_processes_shtml, 16, HTTPD_FS_TYPE_SHTML},
+  {file_header_html, 12, HTTPD_FS_TYPE_HTML},
+  {file_status_shtml, 13, HTTPD_FS_TYPE_SHTML},
+  {file_index_html, 11, HTTPD_FS_TYPE_HTML}
+};
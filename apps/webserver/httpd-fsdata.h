@@ -60,4 +60,13 @@ struct httpd_fsdata_file_noconst {
 #endif /* HTTPD_FS_STATISTICS */
 };
 
+/* An entry of the file name index that makefsdata -x generates. */
+struct httpd_fsdata_index {
+  const struct httpd_fsdata_file *file;
+  uint8_t namelen;
+  uint8_t type;
+  uint8_t hdrlen;
+  uint8_t flags;
+};
+
 #endif /* __HTTPD_FSDATA_H__ */
@@ -41,6 +41,7 @@
 #include "httpd-fs.h"
 #include "httpd-cgi.h"
 #include "lib/petsciiconv.h"
+#include "lib/list.h"
 #include "http-strings.h"
 
 #include "httpd.h"
@@ -51,47 +52,70 @@
 #define CONNS WEBSERVER_CONF_CGI_CONNS
 #endif /* WEBSERVER_CONF_CGI_CONNS */
 
-#define STATE_WAITING 0
-#define STATE_OUTPUT  1
+/* HTTP/1.1 persistent connections. */
+#ifdef WEBSERVER_CONF_KEEPALIVE
+#define KEEPALIVE WEBSERVER_CONF_KEEPALIVE
+#else /* WEBSERVER_CONF_KEEPALIVE */
+#define KEEPALIVE 1
+#endif /* WEBSERVER_CONF_KEEPALIVE */
+
+/* The number of TCP polls (half seconds) after which an idle
+   persistent connection is closed. */
+#ifdef WEBSERVER_CONF_KEEPALIVE_TIMEOUT
+#define KEEPALIVE_TIMEOUT WEBSERVER_CONF_KEEPALIVE_TIMEOUT
+#else /* WEBSERVER_CONF_KEEPALIVE_TIMEOUT */
+#define KEEPALIVE_TIMEOUT 10
+#endif /* WEBSERVER_CONF_KEEPALIVE_TIMEOUT */
 
 #define SEND_STRING(s, str) PSOCK_SEND(s, (uint8_t *)str, (unsigned int)strlen(str))
 MEMB(conns, struct httpd_state, CONNS);
 
+/* Persistent connections that wait for a request, least recently used
+   first. When all connection states are in use, the first one is
+   closed to make room for a new connection. */
+LIST(idle);
+
+struct httpd_stats httpd_stats;
+
 #define ISO_nl      0x0a
+#define ISO_cr      0x0d
 #define ISO_space   0x20
 #define ISO_bang    0x21
 #define ISO_percent 0x25
 #define ISO_period  0x2e
 #define ISO_slash   0x2f
 #define ISO_colon   0x3a
+#define ISO_tab     0x09
+#define ISO_asterisk 0x2a
+#define ISO_comma   0x2c
+#define ISO_semicolon 0x3b
+#define ISO_equal   0x3d
+#define ISO_0       0x30
+#define ISO_9       0x39
+#define ISO_A       0x41
+#define ISO_Z       0x5a
+#define ISO_q       0x71
 
-/*---------------------------------------------------------------------------*/
-static unsigned short
-generate(void *state)
-{
-  struct httpd_state *s = (struct httpd_state *)state;
-
-  if(s->file.len > uip_mss()) {
-    s->len = uip_mss();
-  } else {
-    s->len = s->file.len;
-  }
-  memcpy(uip_appdata, s->file.data, s->len);
-  
-  return s->len;
-}
 /*---------------------------------------------------------------------------*/
 static
 PT_THREAD(send_file(struct httpd_state *s))
 {
   PSOCK_BEGIN(&s->sout);
-  
-  do {
-    PSOCK_GENERATOR_SEND(&s->sout, generate, s);
+
+  /* The file is sent from where it is stored: uIP copies each segment
+     into the packet buffer as it computes the checksum. A protosocket
+     sends at most 64k at a time, so larger files are sent in chunks
+     of whole segments. */
+  while(s->file.len > 0) {
+    s->len = s->file.len;
+    if(s->len > 0xffff) {
+      s->len = 0xffff - 0xffff % uip_mss();
+    }
+    PSOCK_SEND(&s->sout, (uint8_t *)s->file.data, s->len);
     s->file.len -= s->len;
     s->file.data += s->len;
-  } while(s->file.len > 0);
-      
+  }
+
   PSOCK_END(&s->sout);
 }
 /*---------------------------------------------------------------------------*/
@@ -181,119 +205,403 @@ PT_THREAD(handle_script(struct httpd_state *s))
   PT_END(&s->scriptpt);
 }
 /*---------------------------------------------------------------------------*/
-static
-PT_THREAD(send_headers(struct httpd_state *s, const char *statushdr))
+/* Indexed by HTTPD_FS_TYPE_*. */
+static const char *const content_types[] = {
+  http_content_type_binary,
+  http_content_type_html,
+  http_content_type_html,
+  http_content_type_css,
+  http_content_type_png,
+  http_content_type_gif,
+  http_content_type_jpg,
+  http_content_type_plain,
+};
+/*---------------------------------------------------------------------------*/
+static unsigned short
+generate_length(void *state)
 {
-/* gcc warning if not initialized. 
- * If initialized, minimal-net platform segmentation fault if not static...
- */
-  static const char *ptr = NULL;
+  struct httpd_state *s = (struct httpd_state *)state;
+
+  return snprintf((char *)uip_appdata, uip_mss(),
+                  "Content-Length: %d\r\n", s->file.len);
+}
+/*---------------------------------------------------------------------------*/
+/* The status line, the length of the file for a persistent
+   connection, and the content type, as one segment. */
+static unsigned short
+generate_headers(void *state)
+{
+  struct httpd_state *s = (struct httpd_state *)state;
+  char *p = (char *)uip_appdata;
+  unsigned short len;
 
+  len = strlen(s->statushdr);
+  memcpy(p, s->statushdr, len);
+  if(s->keepalive) {
+    len += sprintf(&p[len], "Content-Length: %d\r\n", s->file.len);
+  }
+  strcpy(&p[len], content_types[s->file.type]);
+  return len + strlen(content_types[s->file.type]);
+}
+/*---------------------------------------------------------------------------*/
+/* Sends the status line and the headers. A persistent connection
+   gets the HTTP/1.1 status line statushdr11 and the length of the
+   file, as that is where the response ends. The headers go out in one
+   segment unless the segment is too small for them; each send waits
+   for an ACK without the TCP send buffer. */
+static
+PT_THREAD(send_headers(struct httpd_state *s, const char *statushdr,
+                       const char *statushdr11))
+{
   PSOCK_BEGIN(&s->sout);
 
-  SEND_STRING(&s->sout, statushdr);
-
-  ptr = strrchr(s->filename, ISO_period);
-  if(ptr == NULL) {
-    ptr = http_content_type_binary;
-  } else if(strncmp(http_html, ptr, 5) == 0 ||
-	    strncmp(http_shtml, ptr, 6) == 0) {
-    ptr = http_content_type_html;
-  } else if(strncmp(http_css, ptr, 4) == 0) {
-    ptr = http_content_type_css;
-  } else if(strncmp(http_png, ptr, 4) == 0) {
-    ptr = http_content_type_png;
-  } else if(strncmp(http_gif, ptr, 4) == 0) {
-    ptr = http_content_type_gif;
-  } else if(strncmp(http_jpg, ptr, 4) == 0) {
-    ptr = http_content_type_jpg;
+  s->statushdr = s->keepalive ? statushdr11 : statushdr;
+  /* "Content-Length: " with up to ten digits and CRLF. */
+  if(strlen(s->statushdr) + (s->keepalive ? 28 : 0) +
+     strlen(content_types[s->file.type]) <= uip_mss()) {
+    PSOCK_GENERATOR_SEND(&s->sout, generate_headers, s);
   } else {
-    ptr = http_content_type_plain;
+    SEND_STRING(&s->sout, s->statushdr);
+    if(s->keepalive) {
+      PSOCK_GENERATOR_SEND(&s->sout, generate_length, s);
+    }
+    SEND_STRING(&s->sout, content_types[s->file.type]);
   }
-  SEND_STRING(&s->sout, ptr);
   PSOCK_END(&s->sout);
 }
 /*---------------------------------------------------------------------------*/
+/* Makes the header that makefsdata -H stored in front of the file part of
+   the data to send, so that it goes out with the first bytes of the file.
+   The stored header is an HTTP/1.1 one with the length of the file, which
+   also does for HTTP/1.0 clients as the connection is then closed. */
+static void
+include_header(struct httpd_state *s)
+{
+  s->file.data -= s->file.hdrlen;
+  s->file.len += s->file.hdrlen;
+}
+/*---------------------------------------------------------------------------*/
 static
 PT_THREAD(handle_output(struct httpd_state *s))
 {
-  char *ptr;
-  
   PT_BEGIN(&s->outputpt);
- 
-  if(!httpd_fs_open(s->filename, &s->file)) {
-    strcpy(s->filename, http_404_html);
-    httpd_fs_open(s->filename, &s->file);
-    PT_WAIT_THREAD(&s->outputpt,
-		   send_headers(s,
-		   http_header_404));
-    PT_WAIT_THREAD(&s->outputpt,
-		   send_file(s));
-  } else {
-    PT_WAIT_THREAD(&s->outputpt,
-		   send_headers(s,
-		   http_header_200));
-    ptr = strrchr(s->filename, ISO_period);
-    if(ptr != NULL && strncmp(ptr, http_shtml, 6) == 0) {
-      PT_INIT(&s->scriptpt);
-      PT_WAIT_THREAD(&s->outputpt, handle_script(s));
-    } else {
+
+  while(1) {
+    PT_WAIT_UNTIL(&s->outputpt, s->reqcount > 0);
+    list_remove(idle, s);
+
+    /* Take the next request off the queue. */
+    memcpy(s->filename, s->req[s->reqhead].filename, sizeof(s->filename));
+    s->gzip = (s->req[s->reqhead].flags & HTTPD_REQ_GZIP) != 0;
+    s->keepalive = (s->req[s->reqhead].flags & HTTPD_REQ_KEEPALIVE) != 0;
+    s->reqhead = (s->reqhead + 1) % HTTPD_PIPELINE;
+    s->reqcount--;
+    httpd_stats.requests++;
+    if(s->served) {
+      httpd_stats.reused++;
+    }
+    s->served = 1;
+
+    if(!httpd_fs_open(s->filename, &s->file)) {
+      strcpy(s->filename, http_404_html);
+      httpd_fs_open(s->filename, &s->file);
+      if(s->file.hdrlen > 0) {
+	include_header(s);
+      } else {
+	PT_WAIT_THREAD(&s->outputpt,
+		       send_headers(s,
+		       http_header_404, http_header_404_11));
+      }
       PT_WAIT_THREAD(&s->outputpt,
 		     send_file(s));
+    } else if((s->file.flags & HTTPD_FS_GZIP) && !s->gzip) {
+      /* The file is only stored compressed. */
+      s->file.type = HTTPD_FS_TYPE_PLAIN;
+      s->keepalive = 0;
+      PT_WAIT_THREAD(&s->outputpt,
+		     send_headers(s,
+		     http_header_406, http_header_406));
+    } else {
+      if(s->file.type == HTTPD_FS_TYPE_SHTML) {
+	/* The length of script output is not known in advance, so the
+	   end of the response is marked by closing the connection. */
+	s->keepalive = 0;
+      }
+      if(s->file.hdrlen > 0) {
+	include_header(s);
+      } else {
+	PT_WAIT_THREAD(&s->outputpt,
+		       send_headers(s,
+		       http_header_200, http_header_200_11));
+      }
+      if(s->file.type == HTTPD_FS_TYPE_SHTML) {
+	PT_INIT(&s->scriptpt);
+	PT_WAIT_THREAD(&s->outputpt, handle_script(s));
+      } else {
+	PT_WAIT_THREAD(&s->outputpt,
+		       send_file(s));
+      }
+    }
+
+    if(!s->keepalive || (s->overflow && s->reqcount == 0)) {
+      break;
+    }
+    if(s->reqcount == 0) {
+      list_add(idle, s);
     }
   }
+
   PSOCK_CLOSE(&s->sout);
+  /* Wait here until the connection has been closed. */
+  PT_WAIT_UNTIL(&s->outputpt, 0);
   PT_END(&s->outputpt);
 }
 /*---------------------------------------------------------------------------*/
-static
-PT_THREAD(handle_input(struct httpd_state *s))
+/* Returns non-zero if str starts with name, in upper or lower case.
+   Header names and the tokens in their values are not case
+   sensitive. */
+static int
+starts_with(const char *str, const char *name)
 {
-  PSOCK_BEGIN(&s->sin);
+  char c1, c2;
 
-  PSOCK_READTO(&s->sin, ISO_space);
-  
-  if(strncmp(s->inputbuf, http_get, 4) != 0) {
-    PSOCK_CLOSE_EXIT(&s->sin);
+  for(; *name != 0; str++, name++) {
+    c1 = *str >= ISO_A && *str <= ISO_Z ? *str + 0x20 : *str;
+    c2 = *name >= ISO_A && *name <= ISO_Z ? *name + 0x20 : *name;
+    if(c1 != c2) {
+      return 0;
+    }
   }
-  PSOCK_READTO(&s->sin, ISO_space);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the length of the token at str in a header value. */
+static int
+token_len(const char *str)
+{
+  const char *p;
 
-  if(s->inputbuf[0] != ISO_slash) {
-    PSOCK_CLOSE_EXIT(&s->sin);
+  for(p = str; *p != 0 && *p != ISO_comma && *p != ISO_semicolon &&
+	*p != ISO_space && *p != ISO_tab && *p != ISO_cr; p++);
+  return p - str;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns non-zero if the token at str is name. */
+static int
+token_is(const char *str, const char *name)
+{
+  return token_len(str) == strlen(name) && starts_with(str, name);
+}
+/*---------------------------------------------------------------------------*/
+/* Returns non-zero if a comma separated header value lists name. */
+static int
+list_has(const char *p, const char *name)
+{
+  while(*p != 0) {
+    if(token_is(p, name)) {
+      return 1;
+    }
+    p += token_len(p);
+    if(*p != 0) {
+      p++;
+    }
   }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns non-zero if an Accept-Encoding value refuses gzip: gzip is
+   listed with a q-value of 0, or it is not listed and "*" is. A
+   request without the header accepts any encoding. */
+static int
+gzip_refused(const char *p)
+{
+  const char *coding;
+  const char *q;
+  int accepted;
+  int gzip = -1, any = -1;
 
-  if(s->inputbuf[1] == ISO_space) {
-    strncpy(s->filename, http_index_html, sizeof(s->filename));
-  } else {
-    s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] = 0;
-    strncpy(s->filename, s->inputbuf, sizeof(s->filename));
-  }
+  while(*p != 0) {
+    while(*p == ISO_space || *p == ISO_tab || *p == ISO_comma) {
+      p++;
+    }
+    coding = p;
+    p += token_len(p);
+    accepted = 1;
+
+    /* The parameters up to the next coding. */
+    while(*p != 0 && *p != ISO_comma) {
+      if(*p++ != ISO_semicolon) {
+	continue;
+      }
+      while(*p == ISO_space || *p == ISO_tab) {
+	p++;
+      }
+      if((*p | 0x20) == ISO_q && p[1] == ISO_equal) {
+	/* A q-value of 0, 0.0, 0.00 or 0.000. */
+	q = p + 2;
+	if(*q == ISO_0) {
+	  for(q++; *q == ISO_period || *q == ISO_0; q++);
+	  accepted = *q >= ISO_0 && *q <= ISO_9;
+	}
+      }
+    }
 
-  petsciiconv_topetscii(s->filename, sizeof(s->filename));
-  webserver_log_file(&uip_conn->ripaddr, s->filename);
-  petsciiconv_toascii(s->filename, sizeof(s->filename));
-  s->state = STATE_OUTPUT;
+    if(token_is(coding, http_gzip)) {
+      gzip = accepted;
+    } else if(*coding == ISO_asterisk && token_len(coding) == 1) {
+      any = accepted;
+    }
+  }
+  return gzip == 0 || (gzip == -1 && any == 0);
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(handle_input(struct httpd_state *s))
+{
+  PSOCK_BEGIN(&s->sin);
 
+  /* Pipelined requests are read as they arrive, while earlier ones
+     are being answered: the rest of a segment is lost unless it is
+     read in the same event. */
   while(1) {
+    if(s->reqcount == HTTPD_PIPELINE) {
+      /* Let the output take a request off the queue first. */
+      s->inputwait = 1;
+      PT_YIELD(&s->sin.pt);
+      PSOCK_WAIT_UNTIL(&s->sin, s->reqcount < HTTPD_PIPELINE ||
+		       PSOCK_NEWDATA(&s->sin));
+      if(s->reqcount == HTTPD_PIPELINE) {
+	break;
+      }
+    }
+#define REQ (&s->req[(s->reqhead + s->reqcount) % HTTPD_PIPELINE])
+    PSOCK_READTO(&s->sin, ISO_space);
+
+    if(strncmp(s->inputbuf, http_get, 4) != 0) {
+      PSOCK_CLOSE_EXIT(&s->sin);
+    }
+    PSOCK_READTO(&s->sin, ISO_space);
+
+    if(s->inputbuf[0] != ISO_slash) {
+      PSOCK_CLOSE_EXIT(&s->sin);
+    }
+
+    if(s->inputbuf[1] == ISO_space) {
+      strncpy(REQ->filename, http_index_html, sizeof(REQ->filename));
+    } else {
+      s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] = 0;
+      strncpy(REQ->filename, s->inputbuf, sizeof(REQ->filename));
+    }
+    /* gzip is acceptable unless an Accept-Encoding header refuses it. */
+    REQ->flags = HTTPD_REQ_GZIP;
+
+    petsciiconv_topetscii(REQ->filename, sizeof(REQ->filename));
+    webserver_log_file(&uip_conn->ripaddr, REQ->filename);
+    petsciiconv_toascii(REQ->filename, sizeof(REQ->filename));
+
+    /* The rest of the request line is the HTTP version. */
     PSOCK_READTO(&s->sin, ISO_nl);
+#if KEEPALIVE
+    if(strncmp(s->inputbuf, http_11, 8) == 0) {
+      REQ->flags |= HTTPD_REQ_KEEPALIVE;
+    }
+#endif /* KEEPALIVE */
 
-    if(strncmp(s->inputbuf, http_referer, 8) == 0) {
-      s->inputbuf[PSOCK_DATALEN(&s->sin) - 2] = 0;
-      petsciiconv_topetscii(s->inputbuf, PSOCK_DATALEN(&s->sin) - 2);
-      webserver_log(s->inputbuf);
+    while(1) {
+      PSOCK_READTO(&s->sin, ISO_nl);
+
+      if(starts_with(s->inputbuf, http_referer)) {
+	s->inputbuf[PSOCK_DATALEN(&s->sin) - 2] = 0;
+	petsciiconv_topetscii(s->inputbuf, PSOCK_DATALEN(&s->sin) - 2);
+	webserver_log(s->inputbuf);
+      } else if(starts_with(s->inputbuf, http_accept_encoding)) {
+	s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] = 0;
+	if(gzip_refused(s->inputbuf + sizeof(http_accept_encoding) - 1)) {
+	  REQ->flags &= ~HTTPD_REQ_GZIP;
+	}
+      } else if(starts_with(s->inputbuf, http_connection)) {
+	s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] = 0;
+	if(list_has(s->inputbuf + sizeof(http_connection) - 1, http_close)) {
+	  REQ->flags &= ~HTTPD_REQ_KEEPALIVE;
+	}
+      } else if(s->inputbuf[0] == ISO_cr || s->inputbuf[0] == ISO_nl) {
+	/* The empty line after the request headers. Output waits for
+	   it so that the reply can depend on the headers. */
+	break;
+      }
     }
+    s->reqcount++;
+#undef REQ
   }
-  
+
+  /* The queue is full. Requests that follow are dropped, and the
+     connection is closed after the queued ones have been answered, so
+     that the client sends them again on a new connection. */
+  s->overflow = 1;
+  while(1) {
+    PSOCK_READTO(&s->sin, ISO_nl);
+  }
+
   PSOCK_END(&s->sin);
 }
 /*---------------------------------------------------------------------------*/
 static void
 handle_connection(struct httpd_state *s)
 {
+  s->inputwait = 0;
   handle_input(s);
-  if(s->state == STATE_OUTPUT) {
-    handle_output(s);
+  handle_output(s);
+  if(s->inputwait) {
+    handle_input(s);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_idle(struct httpd_state *s)
+{
+  struct httpd_state *i;
+
+  for(i = list_head(idle); i != NULL; i = list_item_next(i)) {
+    if(i == s) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+free_state(struct httpd_state *s)
+{
+  list_remove(idle, s);
+  memb_free(&conns, s);
+  httpd_stats.conns--;
+}
+/*---------------------------------------------------------------------------*/
+static struct httpd_state *
+alloc_state(void)
+{
+  struct httpd_state *s;
+
+  s = (struct httpd_state *)memb_alloc(&conns);
+  if(s == NULL) {
+    /* Close the persistent connection that has been idle the longest.
+       It is aborted when it is polled, as it no longer has a state. */
+    s = list_pop(idle);
+    if(s == NULL) {
+      httpd_stats.refused++;
+      return NULL;
+    }
+    tcp_markconn(s->conn, NULL);
+    tcpip_poll_tcp(s->conn);
+    memb_free(&conns, s);
+    httpd_stats.conns--;
+    httpd_stats.evicted++;
+    s = (struct httpd_state *)memb_alloc(&conns);
+  }
+  if(++httpd_stats.conns > httpd_stats.maxconns) {
+    httpd_stats.maxconns = httpd_stats.conns;
   }
+  return s;
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -303,28 +611,44 @@ httpd_appcall(void *state)
 
   if(uip_closed() || uip_aborted() || uip_timedout()) {
     if(s != NULL) {
-      memb_free(&conns, s);
+      /* A connection that the client closes first is reported closed
+	 again when the last ACK arrives. */
+      tcp_markconn(uip_conn, NULL);
+      free_state(s);
     }
   } else if(uip_connected()) {
-    s = (struct httpd_state *)memb_alloc(&conns);
+    s = alloc_state();
     if(s == NULL) {
       uip_abort();
       return;
     }
     tcp_markconn(uip_conn, s);
+    s->conn = uip_conn;
     PSOCK_INIT(&s->sin, (uint8_t *)s->inputbuf, sizeof(s->inputbuf) - 1);
     PSOCK_INIT(&s->sout, (uint8_t *)s->inputbuf, sizeof(s->inputbuf) - 1);
     PT_INIT(&s->outputpt);
-    s->state = STATE_WAITING;
+    s->gzip = 0;
+    s->keepalive = 0;
+    s->overflow = 0;
+    s->served = 0;
+    s->reqhead = s->reqcount = 0;
     /*    timer_set(&s->timer, CLOCK_SECOND * 100);*/
     s->timer = 0;
     handle_connection(s);
   } else if(s != NULL) {
-    if(uip_poll()) {
+    /* With the TCP send buffer, a poll that reports data as taken
+       means progress, not a timer tick. */
+    if(uip_poll() && !uip_acked()) {
       ++s->timer;
+      if(s->timer >= KEEPALIVE_TIMEOUT && is_idle(s)) {
+	/* An idle persistent connection. */
+	uip_close();
+	return;
+      }
       if(s->timer >= 20) {
 	uip_abort();
-	memb_free(&conns, s);
+	free_state(s);
+	return;
       }
     } else {
       s->timer = 0;
@@ -340,6 +664,8 @@ httpd_init(void)
 {
   tcp_listen(UIP_HTONS(80));
   memb_init(&conns);
+  list_init(idle);
+  httpd_stats.pool = CONNS;
   httpd_cgi_init();
 }
 #if UIP_CONF_IPV6
@@ -38,13 +38,42 @@
 #include "contiki-net.h"
 #include "httpd-fs.h"
 
+/* The number of requests that can wait on a connection while a
+   response is being sent, for HTTP/1.1 pipelining. */
+#ifdef WEBSERVER_CONF_PIPELINE
+#define HTTPD_PIPELINE WEBSERVER_CONF_PIPELINE
+#else /* WEBSERVER_CONF_PIPELINE */
+#define HTTPD_PIPELINE 2
+#endif /* WEBSERVER_CONF_PIPELINE */
+
+/* Request flags. */
+#define HTTPD_REQ_GZIP      1
+#define HTTPD_REQ_KEEPALIVE 2
+
+struct httpd_request {
+  char filename[20];
+  uint8_t flags;
+};
+
 struct httpd_state {
+  /* Next in the list of idle keep-alive connections; must come first. */
+  struct httpd_state *next;
+  struct uip_conn *conn;
   unsigned char timer;
   struct psock sin, sout;
   struct pt outputpt, scriptpt;
   char inputbuf[50];
   char filename[20];
-  char state;
+  const char *statushdr;
+  char gzip;
+  char keepalive;
+  /* Set when a request did not fit in the queue; the connection is
+     closed when the queued requests have been served. */
+  char overflow;
+  char inputwait;
+  char served;
+  uint8_t reqhead, reqcount;
+  struct httpd_request req[HTTPD_PIPELINE];
   struct httpd_fs_file file;  
   int len;
   char *scriptptr;
@@ -56,6 +85,21 @@ struct httpd_state {
 };
 
 
+/* Web server statistics and connection memory accounting. Memory is
+   counted in connection states of sizeof(struct httpd_state) bytes
+   each, taken from a pool of httpd_stats.pool states. */
+struct httpd_stats {
+  uint16_t pool;
+  uint16_t conns;
+  uint16_t maxconns;
+  uint16_t evicted;
+  uint16_t refused;
+  uint32_t requests;
+  uint32_t reused;
+};
+
+extern struct httpd_stats httpd_stats;
+
 void httpd_init(void);
 void httpd_appcall(void *state);
 
@@ -44,7 +44,10 @@
 #include "lib/trickle-timer.h"
 #include "sys/ctimer.h"
 #include "sys/cc.h"
+#include "lib/list.h"
 #include "lib/random.h"
+
+#include <string.h>
 /*---------------------------------------------------------------------------*/
 #define DEBUG 0
 
@@ -65,13 +68,20 @@
 #define tt_rand() random_rand()
 #endif
 /*---------------------------------------------------------------------------*/
+#if TRICKLE_TIMER_STATS
+#define STAT(tt, field) ((tt)->stats.field++)
+#else
+#define STAT(tt, field)
+#endif
+/*---------------------------------------------------------------------------*/
 /* Declarations of variables of local interest */
 /*---------------------------------------------------------------------------*/
-static struct trickle_timer *loctt;   /* Pointer to a struct for local use */
-static clock_time_t loc_clock; /* A local, general-purpose placeholder */
+LIST(timers);           /* All running trickle timers */
+static struct ctimer ct; /* Shared by all of them */
+static clock_time_t armed_for; /* Expiration time of ct, when armed */
+static uint8_t armed;
 
-static void fire(void *ptr);
-static void double_interval(void *ptr);
+static void run(void *ptr);
 /*---------------------------------------------------------------------------*/
 /* Local utilities and functions to be used as ctimer callbacks */
 /*---------------------------------------------------------------------------*/
@@ -164,141 +174,163 @@ get_t(clock_time_t i_cur)
   return i_cur + (tt_rand() % i_cur);
 }
 /*---------------------------------------------------------------------------*/
+/* Non-zero if absolute time a comes before absolute time b */
+static int
+is_before(clock_time_t a, clock_time_t b)
+{
+  return (clock_time_t)(a - b) > (TRICKLE_TIMER_CLOCK_MAX >> 1);
+}
+/*---------------------------------------------------------------------------*/
+/* Sets the shared ctimer to expire at absolute time 'when' */
 static void
-schedule_for_end(struct trickle_timer *tt)
+arm(clock_time_t when)
 {
-  /* Reset our ctimer, schedule interval_end to run at time I */
   clock_time_t now = clock_time();
 
-  loc_clock = TRICKLE_TIMER_INTERVAL_END(tt) - now;
-
-  PRINTF("trickle_timer sched for end: at %lu, end in %ld\n",
-         (unsigned long)clock_time(), (signed long)loc_clock);
-
-  /* Interval's end will happen in loc_clock ticks. Make sure this isn't in
-   * the past... */
-  if(loc_clock > (TRICKLE_TIMER_CLOCK_MAX >> 1)) {
-    loc_clock = 0; /* Interval ended in the past, schedule for in 0 */
-    PRINTF("trickle_timer doubling: Was in the past. Compensating\n");
+  armed_for = when;
+  armed = 1;
+  if(is_before(when, now)) {
+    /* Already due, run as soon as possible */
+    when = now;
   }
+  ctimer_set(&ct, when - now, run, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/* Called when tt->expires has changed. The shared ctimer only needs to be
+ * moved if tt is now due before everybody else. */
+static void
+update(struct trickle_timer *tt)
+{
+  if(!armed || is_before(tt->expires, armed_for)) {
+    arm(tt->expires);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Sets the shared ctimer for the earliest of all running timers */
+static void
+schedule(void)
+{
+  struct trickle_timer *tt;
+  struct trickle_timer *soonest;
+
+  soonest = list_head(timers);
+  if(soonest == NULL) {
+    ctimer_stop(&ct);
+    armed = 0;
+    return;
+  }
+  for(tt = soonest->next; tt != NULL; tt = tt->next) {
+    if(is_before(tt->expires, soonest->expires)) {
+      soonest = tt;
+    }
+  }
+  arm(soonest->expires);
+}
+/*---------------------------------------------------------------------------*/
+/* Start a new interval of length tt->i_cur at absolute time 'start', with
+ * time t drawn in advance or now */
+static void
+start_interval(struct trickle_timer *tt, clock_time_t start, clock_time_t t)
+{
+  tt->c = 0;
+  tt->i_start = start;
+  tt->expires = start + t;
+  tt->at_t = 1;
+  STAT(tt, intervals);
 
-  ctimer_set(&tt->ct, loc_clock, double_interval, tt);
+  PRINTF("trickle_timer new interval: at %lu, ends %lu, t=%lu, I=%lu\n",
+         (unsigned long)start,
+         (unsigned long)TRICKLE_TIMER_INTERVAL_END(tt),
+         (unsigned long)t, (unsigned long)tt->i_cur);
 }
 /*---------------------------------------------------------------------------*/
-/* This is used as a ctimer callback, thus its argument must be void *. ptr is
- * a pointer to the struct trickle_timer that fired */
+/* The current interval of tt is over. Double I and start the next interval */
 static void
-double_interval(void *ptr)
+double_interval(struct trickle_timer *tt)
 {
   clock_time_t last_end;
 
-  /* 'cast' ptr to a struct trickle_timer */
-  loctt = (struct trickle_timer *)ptr;
-
-  loctt->c = 0;
-
-  PRINTF("trickle_timer doubling: at %lu, (was for %lu), ",
-         (unsigned long)clock_time(),
-         (unsigned long)TRICKLE_TIMER_INTERVAL_END(loctt));
-
   /* Remember the previous interval's end (absolute time), before we double */
-  last_end = TRICKLE_TIMER_INTERVAL_END(loctt);
-
-  /* Double the interval if we have to */
-  if(loctt->i_cur <= TRICKLE_TIMER_INTERVAL_MAX(loctt) >> 1) {
-    /* If I <= Imax/2, we double */
-    loctt->i_cur <<= 1;
-    PRINTF("I << 1 = %lu\n", (unsigned long)loctt->i_cur);
-  } else {
-    /* We may have I > Imax/2 but I <> Imax, in which case we set to Imax
-     * This will happen when I didn't start as Imin (before the first reset) */
-    loctt->i_cur = TRICKLE_TIMER_INTERVAL_MAX(loctt);
-    PRINTF("I = Imax = %lu\n", (unsigned long)loctt->i_cur);
-  }
+  last_end = TRICKLE_TIMER_INTERVAL_END(tt);
 
-  /* Random t in [I/2, I) */
-  loc_clock = get_t(loctt->i_cur);
-
-  PRINTF("trickle_timer doubling: t=%lu\n", (unsigned long)loc_clock);
+  /* If I <= Imax/2, we double. We may also have I > Imax/2 but I <> Imax, in
+   * which case we set to Imax. This will happen when I didn't start as Imin
+   * (before the first reset) */
+  tt->i_cur = TRICKLE_TIMER_NEXT_INTERVAL(tt);
 
 #if TRICKLE_TIMER_COMPENSATE_DRIFT
-  /* Schedule for t ticks after the previous interval's end, not after now. If
-   * that is in the past, schedule in 0 */
-  loc_clock = (last_end + loc_clock) - clock_time();
-  PRINTF("trickle_timer doubling: at %lu, in %ld ticks\n",
-         (unsigned long)clock_time(), (signed long)loc_clock);
-  if(loc_clock > (TRICKLE_TIMER_CLOCK_MAX >> 1)) {
-    /* Oops, that's in the past */
-    loc_clock = 0;
-    PRINTF("trickle_timer doubling: Was in the past. Compensating\n");
-  }
-  ctimer_set(&loctt->ct, loc_clock, fire, loctt);
-
-  /* Store the actual interval start (absolute time), we need it later.
-   * We pretend that it started at the same time when the last one ended */
-  loctt->i_start = last_end;
+  /* Pretend that the new interval started at the same time when the last one
+   * ended, not when we got called */
+  start_interval(tt, last_end, tt->t_next);
 #else
-  /* Assumed that the previous interval's end is 'now' and schedule in t ticks
-   * after 'now', ignoring potential offsets */
-  ctimer_set(&loctt->ct, loc_clock, fire, loctt);
-  /* Store the actual interval start (absolute time), we need it later */
-  loctt->i_start = loctt->ct.etimer.timer.start;
+  /* Assume that the previous interval's end is 'now', ignoring potential
+   * offsets */
+  start_interval(tt, clock_time(), tt->t_next);
 #endif
-
-  PRINTF("trickle_timer doubling: Last end %lu, new end %lu, for %lu, I=%lu\n",
-         (unsigned long)last_end,
-         (unsigned long)TRICKLE_TIMER_INTERVAL_END(loctt),
-         (unsigned long)(loctt->ct.etimer.timer.start +
-                         loctt->ct.etimer.timer.interval),
-         (unsigned long)(loctt->i_cur));
 }
 /*---------------------------------------------------------------------------*/
-/* Called by the ctimer module at time t within the current interval. ptr is
- * a pointer to the struct trickle_timer of interest */
+/* Time t within the current interval of tt has come */
 static void
-fire(void *ptr)
+fire(struct trickle_timer *tt)
 {
-  /* 'cast' c to a struct trickle_timer */
-  loctt = (struct trickle_timer *)ptr;
+  uint8_t tx;
+
+  tx = TRICKLE_TIMER_PROTO_TX_ALLOW(tt);
+  PRINTF("trickle_timer fire: at %lu (was for %lu), Suppression Status %u "
+         "(%u < %u)\n", (unsigned long)clock_time(),
+         (unsigned long)tt->expires, tx, tt->c, tt->k);
+  if(tx) {
+    STAT(tt, tx);
+  } else {
+    STAT(tt, suppressed);
+  }
 
-  PRINTF("trickle_timer fire: at %lu (was for %lu)\n",
-         (unsigned long)clock_time(),
-         (unsigned long)(loctt->ct.etimer.timer.start +
-                         loctt->ct.etimer.timer.interval));
+  /* Wait for the end of the interval next. This is done before the protocol
+   * is called, because the callback may well reset or stop the timer. */
+  tt->t_next = get_t(TRICKLE_TIMER_NEXT_INTERVAL(tt));
+  tt->expires = TRICKLE_TIMER_INTERVAL_END(tt);
+  tt->at_t = 0;
 
-  if(loctt->cb) {
+  if(tt->cb) {
     /*
      * Call the protocol's TX callback, with the suppression status as an
      * argument.
      */
-    PRINTF("trickle_timer fire: Suppression Status %u (%u < %u)\n",
-           TRICKLE_TIMER_PROTO_TX_ALLOW(loctt), loctt->c, loctt->k);
-    loctt->cb(loctt->cb_arg, TRICKLE_TIMER_PROTO_TX_ALLOW(loctt));
-  }
-
-  if(trickle_timer_is_running(loctt)) {
-    schedule_for_end(loctt);
+    PROCESS_CONTEXT_BEGIN(tt->p);
+    tt->cb(tt->cb_arg, tx);
+    PROCESS_CONTEXT_END(tt->p);
   }
 }
 /*---------------------------------------------------------------------------*/
-/* New trickle interval, either due to a newly set trickle timer or due to an
- * inconsistency. Schedule 'fire' to be called in t ticks. */
+/* Callback of the shared ctimer. Serve every timer that is due, then wait
+ * for the next one. */
 static void
-new_interval(struct trickle_timer *tt)
+run(void *ptr)
 {
-  tt->c = 0;
-
-  /* Random t in [I/2, I) */
-  loc_clock = get_t(tt->i_cur);
-
-  ctimer_set(&tt->ct, loc_clock, fire, tt);
+  struct trickle_timer *tt;
+  clock_time_t now;
+
+  armed = 0;
+  for(;;) {
+    /* The list is searched again after each step, since protocol callbacks
+     * may start, stop or reset any timer. */
+    now = clock_time();
+    for(tt = list_head(timers); tt != NULL; tt = tt->next) {
+      if(!is_before(now, tt->expires)) {
+        break;
+      }
+    }
+    if(tt == NULL) {
+      break;
+    }
+    if(tt->at_t) {
+      fire(tt);
+    } else {
+      double_interval(tt);
+    }
+  }
 
-  /* Store the actual interval start (absolute time), we need it later */
-  tt->i_start = tt->ct.etimer.timer.start;
-  PRINTF("trickle_timer new interval: at %lu, ends %lu, ",
-         (unsigned long)clock_time(),
-         (unsigned long)TRICKLE_TIMER_INTERVAL_END(tt));
-  PRINTF("t=%lu, I=%lu\n", (unsigned long)loc_clock, (unsigned long)tt->i_cur);
+  schedule();
 }
 /*---------------------------------------------------------------------------*/
 /* Functions to be called by the protocol implementation */
@@ -309,19 +341,23 @@ trickle_timer_consistency(struct trickle_timer *tt)
   if(tt->c < 0xFF) {
     tt->c++;
   }
+  STAT(tt, consistent);
   PRINTF("trickle_timer consistency: c=%u\n", tt->c);
 }
 /*---------------------------------------------------------------------------*/
 void
 trickle_timer_inconsistency(struct trickle_timer *tt)
 {
+  STAT(tt, inconsistent);
+
   /* "If I is equal to Imin when Trickle hears an "inconsistent" transmission,
    * Trickle does nothing." */
-  if(tt->i_cur != tt->i_min) {
+  if(trickle_timer_is_running(tt) && tt->i_cur != tt->i_min) {
     PRINTF("trickle_timer inconsistency\n");
     tt->i_cur = tt->i_min;
 
-    new_interval(tt);
+    start_interval(tt, clock_time(), get_t(tt->i_cur));
+    update(tt);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -340,7 +376,9 @@ trickle_timer_config(struct trickle_timer *tt, clock_time_t i_min,
     return TRICKLE_TIMER_ERROR;
   }
 
-  if(tt == NULL || i_max == 0 || k == 0) {
+  /* Imax = 0 (a fixed interval) and k = TRICKLE_TIMER_INFINITE_REDUNDANCY
+   * are both valid */
+  if(tt == NULL) {
     PRINTF("trickle_timer config: Bad arguments\n");
     return TRICKLE_TIMER_ERROR;
   }
@@ -386,6 +424,10 @@ trickle_timer_set(struct trickle_timer *tt, trickle_timer_cb_t proto_cb,
 
   tt->cb = proto_cb;
   tt->cb_arg = ptr;
+  tt->p = PROCESS_CURRENT();
+#if TRICKLE_TIMER_STATS
+  memset(&tt->stats, 0, sizeof(tt->stats));
+#endif
 
   /* Random I in [Imin , Imax] */
   tt->i_cur = tt->i_min +
@@ -395,15 +437,26 @@ trickle_timer_set(struct trickle_timer *tt, trickle_timer_cb_t proto_cb,
          (unsigned long)tt->i_min,
          (unsigned long)TRICKLE_TIMER_INTERVAL_MAX(tt));
 
-  new_interval(tt);
-
-  PRINTF("trickle_timer set: at %lu, ends %lu, t=%lu in [%lu , %lu)\n",
-         (unsigned long)tt->i_start,
-         (unsigned long)TRICKLE_TIMER_INTERVAL_END(tt),
-         (unsigned long)tt->ct.etimer.timer.interval,
-         (unsigned long)tt->i_cur >> 1, (unsigned long)tt->i_cur);
+  /* list_add() first removes tt if it was running already */
+  list_add(timers, tt);
+  start_interval(tt, clock_time(), get_t(tt->i_cur));
+  update(tt);
 
   return TRICKLE_TIMER_SUCCESS;
 }
 /*---------------------------------------------------------------------------*/
+void
+trickle_timer_stop(struct trickle_timer *tt)
+{
+  list_remove(timers, tt);
+  tt->i_cur = TRICKLE_TIMER_IS_STOPPED;
+
+  /* The shared ctimer is left running unless nobody needs it any more, a
+   * spurious expiration does no harm. */
+  if(list_head(timers) == NULL) {
+    ctimer_stop(&ct);
+    armed = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
 /** @} */
@@ -26,6 +26,11 @@
  * 'consistent' or 'inconsistent' message and when an 'external event' occurs
  * (in this context, those terms have the exact same meaning as in the RFC).
  *
+ * All running trickle timers share a single \ref ctimer, so a protocol can
+ * run one trickle timer per instance without paying for one ctimer each.
+ * The protocol's callback is still invoked in the context of the process
+ * that called trickle_timer_set().
+ *
  * @{
  */
 
@@ -72,7 +77,8 @@
 #define __TRICKLE_TIMER_H__
 
 #include "contiki-conf.h"
-#include "sys/ctimer.h"
+#include "sys/process.h"
+#include "sys/clock.h"
 /*---------------------------------------------------------------------------*/
 /* Trickle Timer Library Constants */
 /*---------------------------------------------------------------------------*/
@@ -203,6 +209,18 @@
 #else
 #define TRICKLE_TIMER_ERROR_CHECKING 1
 #endif
+/**
+ * \brief Enables/Disables per-timer statistics
+ * 1: Every ::trickle_timer keeps a ::trickle_timer_stats structure, counting
+ *    intervals, transmissions, suppressions and the consistent and
+ *    inconsistent transmissions reported by the protocol.
+ * 0: Disabled (default). Saves 10 bytes of RAM per timer.
+ */
+#ifdef TRICKLE_TIMER_CONF_STATS
+#define TRICKLE_TIMER_STATS TRICKLE_TIMER_CONF_STATS
+#else
+#define TRICKLE_TIMER_STATS 0
+#endif
 /*---------------------------------------------------------------------------*/
 /* Trickle Timer Library Macros */
 /*---------------------------------------------------------------------------*/
@@ -280,6 +298,33 @@
  */
 #define TRICKLE_TIMER_INTERVAL_END(tt) ((tt)->i_start + (tt)->i_cur)
 
+/**
+ * \brief Returns the absolute time when the library will next act on a timer
+ * \param tt A pointer to a ::trickle_timer structure
+ * \return Time t within the current interval until t has passed, and the
+ *         current interval's end after that
+ */
+#define TRICKLE_TIMER_EXPIRATION(tt) ((tt)->expires)
+
+/**
+ * \brief Returns the length of the interval that follows the current one
+ * \param tt A pointer to a ::trickle_timer structure
+ * \return The next interval's length in clock ticks, assuming that no
+ *         inconsistency resets the timer before the current interval ends
+ */
+#define TRICKLE_TIMER_NEXT_INTERVAL(tt) \
+  ((tt)->i_cur <= ((tt)->i_max_abs >> 1) ? (tt)->i_cur << 1 : (tt)->i_max_abs)
+
+/**
+ * \brief Returns time t within the interval that follows the current one
+ * \param tt A pointer to a ::trickle_timer structure
+ * \return The offset of t from the next interval's start, in clock ticks
+ * t is drawn one interval in advance, when the timer fires. Protocols can use
+ * this from within their callback to announce when they will transmit next.
+ * The value is not meaningful before the timer fires for the first time.
+ */
+#define TRICKLE_TIMER_NEXT_T(tt) ((tt)->t_next)
+
 /**
  * \brief Checks whether an Imin value is suitable considering the various
  * restrictions imposed by our platform's clock as well as by the library itself
@@ -360,7 +405,23 @@ typedef void (* trickle_timer_cb_t)(void *ptr, uint8_t suppress);
  * Imax in such a way that the maximum interval size does not exceed the
  * boundaries of clock_time_t
  */
+#if TRICKLE_TIMER_STATS
+/**
+ * \struct trickle_timer_stats
+ * Per-timer counters, kept when ::TRICKLE_TIMER_STATS is enabled. They are
+ * cleared by trickle_timer_set().
+ */
+struct trickle_timer_stats {
+  uint16_t intervals;     /**< Intervals started */
+  uint16_t tx;            /**< Callbacks with #TRICKLE_TIMER_TX_OK */
+  uint16_t suppressed;    /**< Callbacks with #TRICKLE_TIMER_TX_SUPPRESS */
+  uint16_t consistent;    /**< Consistent transmissions heard */
+  uint16_t inconsistent;  /**< Inconsistencies and external events */
+};
+#endif /* TRICKLE_TIMER_STATS */
+
 struct trickle_timer {
+  struct trickle_timer *next; /**< Next running timer, used internally */
   clock_time_t i_min;     /**< Imin: Clock ticks */
   clock_time_t i_cur;     /**< I: Current interval in clock_ticks */
   clock_time_t i_start;   /**< Start of this interval (absolute clock_time) */
@@ -369,7 +430,12 @@ struct trickle_timer {
                                Imin << Imax used internally, so that we can
                                have direct access to the maximum interval size
                                without having to calculate it all the time */
-  struct ctimer ct;       /**< A \ref ctimer used internally */
+  clock_time_t t_next;    /**< t of the next interval, drawn in advance */
+  clock_time_t expires;   /**< When the library will act next (absolute time).
+                               All running timers share a single \ref ctimer,
+                               which is set to the earliest of these */
+  struct process *p;      /**< The process in whose context the protocol's
+                               callback is invoked */
   trickle_timer_cb_t cb;  /**< Protocol's own callback, invoked at time t
                                within the current interval */
   void *cb_arg;           /**< Opaque pointer to be used as the argument of the
@@ -377,6 +443,10 @@ struct trickle_timer {
   uint8_t i_max;          /**< Imax: Max number of doublings */
   uint8_t k;              /**< k: Redundancy Constant */
   uint8_t c;              /**< c: Consistency Counter */
+  uint8_t at_t;           /**< Non-zero while waiting for time t */
+#if TRICKLE_TIMER_STATS
+  struct trickle_timer_stats stats; /**< Counters for this timer */
+#endif
 };
 /** @} */
 /*---------------------------------------------------------------------------*/
@@ -447,10 +517,7 @@ uint8_t trickle_timer_set(struct trickle_timer *tt,
  * to reset a timer manually. Instead, in response to events or inconsistencies,
  * the corresponding functions must be used
  */
-#define trickle_timer_stop(tt) do { \
-  ctimer_stop(&((tt)->ct)); \
-  (tt)->i_cur = TRICKLE_TIMER_IS_STOPPED; \
-} while(0)
+void trickle_timer_stop(struct trickle_timer *tt);
 
 /**
  * \brief      To be called by the protocol when it hears a consistent
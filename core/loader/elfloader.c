@@ -52,6 +52,42 @@
 
 #define EI_NIDENT 16
 
+/* Cached loader mode: the symbol and string tables are read through
+   buffers, resolved symbol addresses are cached, and relocations are
+   read and resolved in batches sorted by symbol. This takes fewer CFS
+   reads at the cost of some RAM while loading. */
+#ifdef ELFLOADER_CONF_CACHE
+#define CACHE ELFLOADER_CONF_CACHE
+#else /* ELFLOADER_CONF_CACHE */
+#define CACHE 0
+#endif /* ELFLOADER_CONF_CACHE */
+
+#if CACHE
+/* The size of each of the symbol and string table buffers. Names are
+   read 30 bytes at a time, so this must be at least 30. */
+#ifdef ELFLOADER_CONF_READBUF_SIZE
+#define READBUF_SIZE ELFLOADER_CONF_READBUF_SIZE
+#else /* ELFLOADER_CONF_READBUF_SIZE */
+#define READBUF_SIZE 64
+#endif /* ELFLOADER_CONF_READBUF_SIZE */
+
+/* The number of cached symbol addresses. */
+#ifdef ELFLOADER_CONF_SYMCACHE_SIZE
+#define SYMCACHE_SIZE ELFLOADER_CONF_SYMCACHE_SIZE
+#else /* ELFLOADER_CONF_SYMCACHE_SIZE */
+#define SYMCACHE_SIZE 16
+#endif /* ELFLOADER_CONF_SYMCACHE_SIZE */
+
+/* The number of relocations read at a time. */
+#ifdef ELFLOADER_CONF_RELOC_BATCH
+#define RELOC_BATCH ELFLOADER_CONF_RELOC_BATCH
+#else /* ELFLOADER_CONF_RELOC_BATCH */
+#define RELOC_BATCH 8
+#endif /* ELFLOADER_CONF_RELOC_BATCH */
+#else /* CACHE */
+#define RELOC_BATCH 1
+#endif /* CACHE */
+
 
 struct elf32_ehdr {
   unsigned char e_ident[EI_NIDENT];    /* ident bytes */
@@ -137,6 +173,28 @@ struct process * const * elfloader_autostart_processes;
 
 static struct relevant_section bss, data, rodata, text;
 
+#if CACHE
+/* A part of the ELF file, read with a single cfs_read(). */
+struct readbuf {
+  unsigned int offset;
+  int len;
+  char buf[READBUF_SIZE];
+};
+
+static struct readbuf symbuf, strbuf;
+
+/* Resolved symbol addresses, direct mapped by symbol index. Index 0,
+   the null symbol, marks an unused entry. */
+struct symcache_entry {
+  unsigned short index;
+  char *addr;
+};
+
+static struct symcache_entry symcache[SYMCACHE_SIZE];
+#endif /* CACHE */
+
+static struct elf32_rela relas[RELOC_BATCH];
+
 static const unsigned char elf_magic_header[] =
   {0x7f, 0x45, 0x4c, 0x46,  /* 0x7f, 'E', 'L', 'F' */
    0x01,                    /* Only 32-bit objects. */
@@ -172,6 +230,63 @@ seek_write(int fd, unsigned int offset, char *buf, int len)
 }
 */
 /*---------------------------------------------------------------------------*/
+#if CACHE
+/* Returns a pointer to len bytes of the file at offset, reading a new
+   part of the file into the buffer if they are not there. */
+static char *
+cached_read(int fd, struct readbuf *b, unsigned int offset, int len)
+{
+  if(offset < b->offset || offset + len > b->offset + b->len) {
+    cfs_seek(fd, offset, CFS_SEEK_SET);
+    b->offset = offset;
+    b->len = cfs_read(fd, b->buf, sizeof(b->buf));
+    if(b->len < len) {
+      /* At the end of the file. */
+      memset(&b->buf[b->len < 0 ? 0 : b->len], 0,
+             sizeof(b->buf) - (b->len < 0 ? 0 : b->len));
+      b->len = 0;
+    }
+  }
+  return &b->buf[offset - b->offset];
+}
+#endif /* CACHE */
+/*---------------------------------------------------------------------------*/
+static void
+read_sym(int fd, unsigned int offset, struct elf32_sym *s)
+{
+#if CACHE
+  memcpy(s, cached_read(fd, &symbuf, offset, sizeof(*s)), sizeof(*s));
+#else /* CACHE */
+  seek_read(fd, offset, (char *)s, sizeof(*s));
+#endif /* CACHE */
+}
+/*---------------------------------------------------------------------------*/
+static void
+read_name(int fd, unsigned int offset, char *name, int len)
+{
+#if CACHE
+  memcpy(name, cached_read(fd, &strbuf, offset, len), len);
+#else /* CACHE */
+  seek_read(fd, offset, name, len);
+#endif /* CACHE */
+  name[len - 1] = 0;
+}
+/*---------------------------------------------------------------------------*/
+static struct relevant_section *
+find_section(elf32_half shndx)
+{
+  if(shndx == bss.number) {
+    return &bss;
+  } else if(shndx == data.number) {
+    return &data;
+  } else if(shndx == rodata.number) {
+    return &rodata;
+  } else if(shndx == text.number) {
+    return &text;
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
 static void *
 find_local_symbol(int fd, const char *symbol,
 		  unsigned int symtab, unsigned short symtabsize,
@@ -183,20 +298,13 @@ find_local_symbol(int fd, const char *symbol,
   struct relevant_section *sect;
   
   for(a = symtab; a < symtab + symtabsize; a += sizeof(s)) {
-    seek_read(fd, a, (char *)&s, sizeof(s));
+    read_sym(fd, a, &s);
 
     if(s.st_name != 0) {
-      seek_read(fd, strtab + s.st_name, name, sizeof(name));
+      read_name(fd, strtab + s.st_name, name, sizeof(name));
       if(strcmp(name, symbol) == 0) {
-	if(s.st_shndx == bss.number) {
-	  sect = &bss;
-	} else if(s.st_shndx == data.number) {
-	  sect = &data;
-  } else if(s.st_shndx == rodata.number) {
-    sect = &rodata;
-	} else if(s.st_shndx == text.number) {
-	  sect = &text;
-	} else {
+	sect = find_section(s.st_shndx);
+	if(sect == NULL) {
 	  return NULL;
 	}
 	return &(sect->address[s.st_value]);
@@ -206,6 +314,91 @@ find_local_symbol(int fd, const char *symbol,
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+/* Finds the address of a symbol that a relocation refers to: a symbol
+   in the system, a symbol defined in the module, or a section. */
+static int
+resolve_symbol(int fd, unsigned int index,
+	       unsigned int symtab, unsigned int strtab, char **addr)
+{
+  struct elf32_sym s;
+  char name[30];
+  struct relevant_section *sect;
+#if CACHE
+  struct symcache_entry *c;
+
+  c = &symcache[index % SYMCACHE_SIZE];
+  if(c->index == index && index != 0) {
+    *addr = c->addr;
+    return ELFLOADER_OK;
+  }
+#endif /* CACHE */
+
+  read_sym(fd, symtab + sizeof(struct elf32_sym) * index, &s);
+  sect = find_section(s.st_shndx);
+  if(s.st_name != 0) {
+    read_name(fd, strtab + s.st_name, name, sizeof(name));
+    PRINTF("name: %s\n", name);
+    *addr = (char *)symtab_lookup(name);
+    if(*addr == NULL) {
+      PRINTF("name not found in global: %s\n", name);
+      if(sect == NULL) {
+	PRINTF("elfloader unknown name: '%30s'\n", name);
+	memcpy(elfloader_unknown, name, sizeof(elfloader_unknown));
+	elfloader_unknown[sizeof(elfloader_unknown) - 1] = 0;
+	return ELFLOADER_SYMBOL_NOT_FOUND;
+      }
+      /* Defined in the module. The symbol table entry gives the
+	 address, so the table need not be searched for the name. */
+      *addr = &sect->address[s.st_value];
+    }
+  } else {
+    if(sect == NULL) {
+      return ELFLOADER_SEGMENT_NOT_FOUND;
+    }
+    *addr = sect->address;
+  }
+
+#if CACHE
+  c->index = index;
+  c->addr = *addr;
+#endif /* CACHE */
+  return ELFLOADER_OK;
+}
+/*---------------------------------------------------------------------------*/
+#if CACHE
+/* Reads the next n relocations into relas[], converting elf32_rel
+   entries to elf32_rela, and sorts them by symbol index. */
+static void
+read_relocations(int fd, unsigned int offset, int n,
+		 unsigned char using_relas)
+{
+  struct elf32_rela r;
+  int i, j;
+
+  if(using_relas) {
+    seek_read(fd, offset, (char *)relas, n * sizeof(struct elf32_rela));
+  } else {
+    seek_read(fd, offset, (char *)relas, n * sizeof(struct elf32_rel));
+    /* Spread out the entries from the end, so that none is overwritten
+       before it has been moved. */
+    for(i = n - 1; i >= 0; --i) {
+      memmove(&relas[i], (char *)relas + i * sizeof(struct elf32_rel),
+	      sizeof(struct elf32_rel));
+    }
+  }
+
+  /* Insertion sort, as batches are small. */
+  for(i = 1; i < n; ++i) {
+    r = relas[i];
+    for(j = i; j > 0 &&
+	  ELF32_R_SYM(relas[j - 1].r_info) > ELF32_R_SYM(r.r_info); --j) {
+      relas[j] = relas[j - 1];
+    }
+    relas[j] = r;
+  }
+}
+#endif /* CACHE */
+/*---------------------------------------------------------------------------*/
 static int
 relocate_section(int fd,
 		 unsigned int section, unsigned short size,
@@ -217,13 +410,12 @@ relocate_section(int fd,
 		 unsigned char using_relas)
 {
   /* sectionbase added; runtime start address of current section */
-  struct elf32_rela rela; /* Now used both for rel and rela data! */
   int rel_size = 0;
-  struct elf32_sym s;
   unsigned int a;
-  char name[30];
+  unsigned int index, lastindex;
+  int i, n;
   char *addr;
-  struct relevant_section *sect;
+  int ret;
 
   /* determine correct relocation entry sizes */
   if(using_relas) {
@@ -232,60 +424,38 @@ relocate_section(int fd,
     rel_size = sizeof(struct elf32_rel);
   }
   
-  for(a = section; a < section + size; a += rel_size) {
-    seek_read(fd, a, (char *)&rela, rel_size);
-    seek_read(fd,
-	      symtab + sizeof(struct elf32_sym) * ELF32_R_SYM(rela.r_info),
-	      (char *)&s, sizeof(s));
-    if(s.st_name != 0) {
-      seek_read(fd, strtab + s.st_name, name, sizeof(name));
-      PRINTF("name: %s\n", name);
-      addr = (char *)symtab_lookup(name);
-      /* ADDED */
-      if(addr == NULL) {
-	PRINTF("name not found in global: %s\n", name);
-	addr = find_local_symbol(fd, name, symtab, symtabsize, strtab);
-	PRINTF("found address %p\n", addr);
-      }
-      if(addr == NULL) {
-	if(s.st_shndx == bss.number) {
-	  sect = &bss;
-	} else if(s.st_shndx == data.number) {
-	  sect = &data;
-	} else if(s.st_shndx == rodata.number) {
-	  sect = &rodata;
-	} else if(s.st_shndx == text.number) {
-	  sect = &text;
-	} else {
-	  PRINTF("elfloader unknown name: '%30s'\n", name);
-	  memcpy(elfloader_unknown, name, sizeof(elfloader_unknown));
-	  elfloader_unknown[sizeof(elfloader_unknown) - 1] = 0;
-	  return ELFLOADER_SYMBOL_NOT_FOUND;
+  addr = NULL;
+  for(a = section; a < section + size; a += n * rel_size) {
+#if CACHE
+    n = (section + size - a) / rel_size;
+    if(n > RELOC_BATCH) {
+      n = RELOC_BATCH;
+    }
+    read_relocations(fd, a, n, using_relas);
+#else /* CACHE */
+    n = 1;
+    seek_read(fd, a, (char *)&relas[0], rel_size);
+#endif /* CACHE */
+
+    lastindex = 0;
+    for(i = 0; i < n; ++i) {
+      index = ELF32_R_SYM(relas[i].r_info);
+      if(i == 0 || index != lastindex) {
+	ret = resolve_symbol(fd, index, symtab, strtab, &addr);
+	if(ret != ELFLOADER_OK) {
+	  return ret;
 	}
-	addr = sect->address;
+	lastindex = index;
       }
-    } else {
-      if(s.st_shndx == bss.number) {
-	sect = &bss;
-      } else if(s.st_shndx == data.number) {
-	sect = &data;
-      } else if(s.st_shndx == rodata.number) {
-	sect = &rodata;
-      } else if(s.st_shndx == text.number) {
-	sect = &text;
-      } else {
-	return ELFLOADER_SEGMENT_NOT_FOUND;
+
+      if(!using_relas) {
+	/* copy addend to rela structure */
+	seek_read(fd, sectionaddr + relas[i].r_offset,
+		  (char *)&relas[i].r_addend, 4);
       }
-      
-      addr = sect->address;
-    }
 
-    if(!using_relas) {
-      /* copy addend to rela structure */
-      seek_read(fd, sectionaddr + rela.r_offset, (char *)&rela.r_addend, 4);
+      elfloader_arch_relocate(fd, sectionaddr, sectionbase, &relas[i], addr);
     }
-
-    elfloader_arch_relocate(fd, sectionaddr, sectionbase, &rela, addr);
   }
   return ELFLOADER_OK;
 }
@@ -300,10 +470,10 @@ find_program_processes(int fd,
   char name[30];
   
   for(a = symtab; a < symtab + size; a += sizeof(s)) {
-    seek_read(fd, a, (char *)&s, sizeof(s));
+    read_sym(fd, a, &s);
 
     if(s.st_name != 0) {
-      seek_read(fd, strtab + s.st_name, name, sizeof(name));
+      read_name(fd, strtab + s.st_name, name, sizeof(name));
       if(strcmp(name, "autostart_processes") == 0) {
 	return &data.address[s.st_value];
       }
@@ -361,6 +531,10 @@ elfloader_load(int fd)
   int ret;
 
   elfloader_unknown[0] = 0;
+#if CACHE
+  symbuf.len = strbuf.len = 0;
+  memset(symcache, 0, sizeof(symcache));
+#endif /* CACHE */
 
   /* The ELF header is located at the start of the buffer. */
   seek_read(fd, 0, (char *)&ehdr, sizeof(ehdr));
@@ -438,7 +612,10 @@ elfloader_load(int fd)
       PRINTF("symtab\n");
       symtaboff = shdr.sh_offset;
       symtabsize = shdr.sh_size;
-    } else if(shdr.sh_type == SHT_STRTAB/*strncmp(name, ".strtab", 7) == 0*/) {
+    } else if(shdr.sh_type == SHT_STRTAB && i != ehdr.e_shstrndx
+	      /*strncmp(name, ".strtab", 7) == 0*/) {
+      /* The section name table is a string table too, and may come
+	 after the symbol string table. */
       PRINTF("strtab\n");
       strtaboff = shdr.sh_offset;
       strtabsize = shdr.sh_size;
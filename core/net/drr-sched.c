@@ -0,0 +1,467 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Deficit round robin packet scheduler with traffic classes
+ * \author
+ *         agent <agent@local>
+ */
+
+#include <string.h>
+
+#include "contiki.h"
+#include "net/uip.h"
+#include "net/uip-icmp6.h"
+#include "net/drr-sched.h"
+
+#define DEBUG 0
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+/* pick() goes round the flows until one of them has a deficit large
+   enough for its first packet, which never happens with a zero
+   quantum. */
+#if DRR_SCHED_QUANTUM_INTERACTIVE < 1 || DRR_SCHED_QUANTUM_BULK < 1
+#error DRR_SCHED_QUANTUM_INTERACTIVE and DRR_SCHED_QUANTUM_BULK must be at least 1
+#endif
+
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+struct flow;
+
+struct packet {
+  struct packet *next;
+  struct flow *flow;
+  uint16_t offset;
+  uint16_t len;
+};
+
+/* A flow is in use when it has at least one packet queued. */
+struct flow {
+  struct packet *head;
+  uip_lladdr_t lladdr;
+  int16_t deficit;
+  uint8_t npackets;
+  uint8_t class;
+  uint8_t broadcast;
+  uint8_t visited;
+};
+
+/* Packet descriptors. A descriptor is free when its flow is NULL. */
+static struct packet packets[DRR_SCHED_PACKETS];
+
+/* Packet data is kept back to back in this buffer, in allocation
+   order, like in uip-packetqueue.c. */
+static uint8_t databuf[DRR_SCHED_BYTES];
+static uint16_t databuf_used;
+
+static struct flow flows[DRR_SCHED_FLOWS];
+static uint8_t npackets;
+
+/* The flow that the round robin is currently serving. */
+static uint8_t current;
+
+/* Non-zero while the link layer has a packet from us. */
+static uint8_t busy;
+static struct ctimer tx_timer;
+
+static u8_t (* outputfunc)(uip_lladdr_t *);
+
+struct drr_sched_stats drr_sched_stats;
+
+PROCESS(drr_sched_process, "DRR scheduler");
+
+#ifdef NETSTACK_CONF_SCHED_CLASSIFY
+uint8_t NETSTACK_CONF_SCHED_CLASSIFY(void);
+#define classify NETSTACK_CONF_SCHED_CLASSIFY
+#else /* NETSTACK_CONF_SCHED_CLASSIFY */
+/*---------------------------------------------------------------------------*/
+static uint8_t
+classify(void)
+{
+  uint8_t *hdr;
+  uint16_t off;
+  uint8_t proto;
+  uint8_t dscp;
+
+  dscp = ((UIP_IP_BUF->vtc & 0x0f) << 2) | (UIP_IP_BUF->tcflow >> 6);
+  if(dscp >= 48) {
+    /* CS6 and CS7, network control. */
+    return DRR_SCHED_CLASS_CONTROL;
+  }
+
+  /* Skip the extension headers that RPL adds to data packets. */
+  proto = UIP_IP_BUF->proto;
+  off = UIP_IPH_LEN;
+  while((proto == UIP_PROTO_HBHO || proto == UIP_PROTO_DESTO ||
+         proto == UIP_PROTO_ROUTING) && off + 2 <= uip_len) {
+    hdr = &uip_buf[UIP_LLH_LEN + off];
+    proto = hdr[0];
+    off += (hdr[1] + 1) * 8;
+  }
+
+  if(proto == UIP_PROTO_ICMP6 && off < uip_len) {
+    switch(uip_buf[UIP_LLH_LEN + off]) {
+    case ICMP6_RS:
+    case ICMP6_RA:
+    case ICMP6_NS:
+    case ICMP6_NA:
+    case ICMP6_REDIRECT:
+    case ICMP6_RPL:
+      return DRR_SCHED_CLASS_CONTROL;
+    default:
+      return DRR_SCHED_CLASS_INTERACTIVE;
+    }
+  }
+
+  if(dscp == 46) {
+    /* Expedited forwarding. */
+    return DRR_SCHED_CLASS_INTERACTIVE;
+  }
+  if((proto == UIP_PROTO_UDP || proto == UIP_PROTO_TCP) &&
+     uip_len <= DRR_SCHED_INTERACTIVE_LEN) {
+    return DRR_SCHED_CLASS_INTERACTIVE;
+  }
+  return DRR_SCHED_CLASS_BULK;
+}
+#endif /* NETSTACK_CONF_SCHED_CLASSIFY */
+/*---------------------------------------------------------------------------*/
+static int16_t
+quantum(uint8_t class)
+{
+  if(class == DRR_SCHED_CLASS_BULK) {
+    return DRR_SCHED_QUANTUM_BULK;
+  }
+  return DRR_SCHED_QUANTUM_INTERACTIVE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+packet_remove(struct packet *p)
+{
+  struct flow *f = p->flow;
+  struct packet **pp;
+  int i;
+
+  for(pp = &f->head; *pp != NULL; pp = &(*pp)->next) {
+    if(*pp == p) {
+      *pp = p->next;
+      break;
+    }
+  }
+  f->npackets--;
+  npackets--;
+  drr_sched_stats.qlen[f->class]--;
+  drr_sched_stats.bytes -= p->len;
+  if(f->npackets == 0) {
+    /* An idle flow does not keep its deficit (DRR). */
+    f->deficit = 0;
+    f->visited = 0;
+  }
+
+  memmove(&databuf[p->offset], &databuf[p->offset + p->len],
+          databuf_used - p->offset - p->len);
+  databuf_used -= p->len;
+  for(i = 0; i < DRR_SCHED_PACKETS; i++) {
+    if(packets[i].flow != NULL && packets[i].offset > p->offset) {
+      packets[i].offset -= p->len;
+    }
+  }
+
+  p->flow = NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct flow *
+flow_lookup(uip_lladdr_t *lladdr, uint8_t class)
+{
+  struct flow *f, *free;
+
+  free = NULL;
+  for(f = flows; f < &flows[DRR_SCHED_FLOWS]; f++) {
+    if(f->npackets == 0) {
+      if(free == NULL) {
+        free = f;
+      }
+    } else if(f->class == class &&
+              (lladdr == NULL ? f->broadcast :
+               !f->broadcast && memcmp(&f->lladdr, lladdr,
+                                       UIP_LLADDR_LEN) == 0)) {
+      return f;
+    }
+  }
+  if(free != NULL) {
+    free->class = class;
+    free->broadcast = lladdr == NULL;
+    if(lladdr != NULL) {
+      memcpy(&free->lladdr, lladdr, UIP_LLADDR_LEN);
+    }
+  }
+  return free;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Drop the last packet of the flow with the lowest priority class
+ * and, within that class, the longest queue, if it ranks below a new
+ * packet of the given class arriving on a flow that already holds
+ * npackets packets. Returns non-zero if a packet was dropped.
+ */
+static int
+push_out(uint8_t class, uint8_t npackets)
+{
+  struct flow *f, *victim;
+  struct packet *p;
+
+  victim = NULL;
+  for(f = flows; f < &flows[DRR_SCHED_FLOWS]; f++) {
+    if(f->npackets > 0 &&
+       (victim == NULL || f->class > victim->class ||
+        (f->class == victim->class && f->npackets > victim->npackets))) {
+      victim = f;
+    }
+  }
+  if(victim == NULL || victim->class < class ||
+     (victim->class == class && victim->npackets <= npackets + 1)) {
+    return 0;
+  }
+
+  for(p = victim->head; p->next != NULL; p = p->next);
+  PRINTF("drr-sched: pushing out class %u packet len %u\n",
+         victim->class, p->len);
+  drr_sched_stats.dropped[victim->class]++;
+  packet_remove(p);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static struct packet *
+packet_alloc(void)
+{
+  struct packet *p;
+
+  for(p = packets; p < &packets[DRR_SCHED_PACKETS]; p++) {
+    if(p->flow == NULL) {
+      return p;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+enqueue(uip_lladdr_t *lladdr)
+{
+  struct flow *f;
+  struct packet *p, **pp;
+  uint8_t class;
+
+  class = classify();
+
+  if(uip_len > sizeof(databuf)) {
+    drr_sched_stats.dropped[class]++;
+    return 0;
+  }
+
+  for(;;) {
+    f = flow_lookup(lladdr, class);
+    p = packet_alloc();
+    if(f != NULL && p != NULL && uip_len <= sizeof(databuf) - databuf_used) {
+      break;
+    }
+    if(!push_out(class, f == NULL ? 0 : f->npackets)) {
+      PRINTF("drr-sched: dropping class %u packet len %u\n", class, uip_len);
+      drr_sched_stats.dropped[class]++;
+      return 0;
+    }
+  }
+
+  p->flow = f;
+  p->next = NULL;
+  p->offset = databuf_used;
+  p->len = uip_len;
+  memcpy(&databuf[p->offset], &uip_buf[UIP_LLH_LEN], uip_len);
+  databuf_used += uip_len;
+  for(pp = &f->head; *pp != NULL; pp = &(*pp)->next);
+  *pp = p;
+  f->npackets++;
+  npackets++;
+
+  drr_sched_stats.enqueued[class]++;
+  if(++drr_sched_stats.qlen[class] > drr_sched_stats.qlen_max[class]) {
+    drr_sched_stats.qlen_max[class] = drr_sched_stats.qlen[class];
+  }
+  drr_sched_stats.bytes += uip_len;
+  if(drr_sched_stats.bytes > drr_sched_stats.bytes_max) {
+    drr_sched_stats.bytes_max = drr_sched_stats.bytes;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Pick the next packet to send. Control flows are served in order of
+ * the flow table, before anything else. The other flows are served
+ * by deficit round robin: each time the round reaches a flow it gets
+ * its class quantum added to its deficit, and it may send packets as
+ * long as they fit in the deficit.
+ */
+static struct packet *
+pick(void)
+{
+  struct flow *f;
+
+  for(f = flows; f < &flows[DRR_SCHED_FLOWS]; f++) {
+    if(f->npackets > 0 && f->class == DRR_SCHED_CLASS_CONTROL) {
+      return f->head;
+    }
+  }
+
+  for(;;) {
+    f = &flows[current];
+    if(f->npackets > 0) {
+      if(!f->visited) {
+        f->visited = 1;
+        f->deficit += quantum(f->class);
+      }
+      if(f->head->len <= f->deficit) {
+        f->deficit -= f->head->len;
+        return f->head;
+      }
+      f->visited = 0;
+    }
+    current = (current + 1) % DRR_SCHED_FLOWS;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+tx_timeout(void *ptr)
+{
+  PRINTF("drr-sched: no sent callback from link layer\n");
+  drr_sched_stats.timeouts++;
+  busy = 0;
+  process_poll(&drr_sched_process);
+}
+/*---------------------------------------------------------------------------*/
+static void
+output(uip_lladdr_t *lladdr, uint8_t class)
+{
+  busy = 1;
+  ctimer_set(&tx_timer, DRR_SCHED_TX_TIMEOUT, tx_timeout, NULL);
+  drr_sched_stats.sent[class]++;
+  outputfunc(lladdr);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run(void)
+{
+  struct packet *p;
+  uip_lladdr_t lladdr;
+  uint8_t broadcast;
+  uint8_t class;
+
+  while(!busy && npackets > 0) {
+    p = pick();
+    memcpy(&uip_buf[UIP_LLH_LEN], &databuf[p->offset], p->len);
+    uip_len = p->len;
+    uip_ext_len = 0;
+    memcpy(&lladdr, &p->flow->lladdr, sizeof(lladdr));
+    broadcast = p->flow->broadcast;
+    class = p->flow->class;
+    packet_remove(p);
+    output(broadcast ? NULL : &lladdr, class);
+  }
+  uip_len = 0;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(drr_sched_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+    run();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(u8_t (* output)(uip_lladdr_t *))
+{
+  outputfunc = output;
+  process_start(&drr_sched_process, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static u8_t
+send(uip_lladdr_t *lladdr)
+{
+  uint8_t class;
+
+  if(!busy && npackets == 0) {
+    /* Nothing to schedule, send right away without a copy. */
+    class = classify();
+    drr_sched_stats.enqueued[class]++;
+    output(lladdr, class);
+    return 1;
+  }
+
+  /* The packet is copied; run() is called from our own process so
+     that the caller's uip_buf is not overwritten under its feet. */
+  if(!enqueue(lladdr)) {
+    return 0;
+  }
+  if(!busy) {
+    process_poll(&drr_sched_process);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+sent(void)
+{
+  if(busy) {
+    busy = 0;
+    ctimer_stop(&tx_timer);
+  }
+  if(npackets > 0) {
+    process_poll(&drr_sched_process);
+  }
+}
+/*---------------------------------------------------------------------------*/
+const struct sched_driver drr_sched_driver = {
+  "drr-sched",
+  init,
+  send,
+  sent,
+};
+/*---------------------------------------------------------------------------*/
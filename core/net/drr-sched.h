@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Deficit round robin packet scheduler with traffic classes
+ *
+ *         Outgoing IP packets are sorted into three classes: control
+ *         (ND, RPL and packets marked CS6/CS7), interactive (small
+ *         UDP, CoAP and TCP packets, ICMPv6 echo) and bulk
+ *         (everything else). Each (neighbor, class) pair is a flow
+ *         with its own FIFO queue. Control flows are always served
+ *         first. The other flows share the link by deficit round
+ *         robin with a per-class quantum, so that one neighbor's bulk
+ *         transfer cannot starve the other neighbors, and interactive
+ *         traffic gets a larger share than bulk.
+ *
+ *         Only one IP packet is handed to the MAC layer at a time, so
+ *         that a control packet waits for at most one packet ahead of
+ *         it instead of a full MAC queue. Select the scheduler with
+ *
+ *         #define NETSTACK_CONF_SCHED drr_sched_driver
+ *
+ * \author
+ *         agent <agent@local>
+ */
+
+#ifndef __DRR_SCHED_H__
+#define __DRR_SCHED_H__
+
+#include "net/sched.h"
+
+/**
+ * The number of packets that can be queued for all neighbors and
+ * classes together.
+ */
+#ifdef NETSTACK_CONF_SCHED_PACKETS
+#define DRR_SCHED_PACKETS NETSTACK_CONF_SCHED_PACKETS
+#else
+#define DRR_SCHED_PACKETS 8
+#endif
+
+/**
+ * The number of bytes of packet data that can be queued. Packets only
+ * take up as many bytes as they are long.
+ */
+#ifdef NETSTACK_CONF_SCHED_BYTES
+#define DRR_SCHED_BYTES NETSTACK_CONF_SCHED_BYTES
+#else
+#define DRR_SCHED_BYTES (2 * (UIP_BUFSIZE - UIP_LLH_LEN))
+#endif
+
+/**
+ * The number of flows, i.e. (neighbor, class) pairs, that can have
+ * packets queued at the same time.
+ */
+#ifdef NETSTACK_CONF_SCHED_FLOWS
+#define DRR_SCHED_FLOWS NETSTACK_CONF_SCHED_FLOWS
+#else
+#define DRR_SCHED_FLOWS 6
+#endif
+
+/**
+ * The number of bytes an interactive flow may send per round.
+ */
+#ifdef NETSTACK_CONF_SCHED_QUANTUM_INTERACTIVE
+#define DRR_SCHED_QUANTUM_INTERACTIVE NETSTACK_CONF_SCHED_QUANTUM_INTERACTIVE
+#else
+#define DRR_SCHED_QUANTUM_INTERACTIVE 256
+#endif
+
+/**
+ * The number of bytes a bulk flow may send per round.
+ */
+#ifdef NETSTACK_CONF_SCHED_QUANTUM_BULK
+#define DRR_SCHED_QUANTUM_BULK NETSTACK_CONF_SCHED_QUANTUM_BULK
+#else
+#define DRR_SCHED_QUANTUM_BULK 128
+#endif
+
+/**
+ * UDP and TCP packets up to this IP length are interactive, longer
+ * ones are bulk.
+ */
+#ifdef NETSTACK_CONF_SCHED_INTERACTIVE_LEN
+#define DRR_SCHED_INTERACTIVE_LEN NETSTACK_CONF_SCHED_INTERACTIVE_LEN
+#else
+#define DRR_SCHED_INTERACTIVE_LEN 128
+#endif
+
+/**
+ * How long to wait for the link layer to report that a packet has
+ * been sent before the next packet is released anyway.
+ */
+#ifdef NETSTACK_CONF_SCHED_TX_TIMEOUT
+#define DRR_SCHED_TX_TIMEOUT NETSTACK_CONF_SCHED_TX_TIMEOUT
+#else
+#define DRR_SCHED_TX_TIMEOUT (2 * CLOCK_SECOND)
+#endif
+
+/**
+ * Traffic classes, highest priority first. A platform can replace
+ * the built-in classifier by defining NETSTACK_CONF_SCHED_CLASSIFY
+ * as the name of a function that takes no arguments and returns the
+ * class of the packet in uip_buf.
+ */
+#define DRR_SCHED_CLASS_CONTROL     0
+#define DRR_SCHED_CLASS_INTERACTIVE 1
+#define DRR_SCHED_CLASS_BULK        2
+#define DRR_SCHED_CLASSES           3
+
+struct drr_sched_stats {
+  /** Packets accepted, per class. */
+  uint16_t enqueued[DRR_SCHED_CLASSES];
+  /** Packets handed to the link layer, per class. */
+  uint16_t sent[DRR_SCHED_CLASSES];
+  /** Packets dropped because the queue was full, per class. */
+  uint16_t dropped[DRR_SCHED_CLASSES];
+  /** Packets queued right now, per class. */
+  uint8_t qlen[DRR_SCHED_CLASSES];
+  /** The largest number of packets queued at once, per class. */
+  uint8_t qlen_max[DRR_SCHED_CLASSES];
+  /** Bytes queued right now, and the most ever queued. */
+  uint16_t bytes, bytes_max;
+  /** Times the link layer failed to report a sent packet. */
+  uint16_t timeouts;
+};
+
+extern struct drr_sched_stats drr_sched_stats;
+
+extern const struct sched_driver drr_sched_driver;
+
+#endif /* __DRR_SCHED_H__ */
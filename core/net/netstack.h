@@ -97,6 +97,14 @@
 #endif /* NETSTACK_CONF_FRAMER */
 #endif /* NETSTACK_FRAMER */
 
+#ifndef NETSTACK_SCHED
+#ifdef NETSTACK_CONF_SCHED
+#define NETSTACK_SCHED NETSTACK_CONF_SCHED
+#else /* NETSTACK_CONF_SCHED */
+#define NETSTACK_SCHED   nullsched_driver
+#endif /* NETSTACK_CONF_SCHED */
+#endif /* NETSTACK_SCHED */
+
 #include "net/mac/mac.h"
 #include "net/mac/rdc.h"
 #include "net/mac/framer.h"
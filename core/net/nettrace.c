@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Binary network event trace
+ * \author
+ *         agent <agent@local>
+ */
+
+#include "contiki.h"
+#include "net/nettrace.h"
+
+#if NETTRACE_CONF_ENABLED
+
+static uint8_t started;
+/*---------------------------------------------------------------------------*/
+static void
+put16(uint8_t *p, uint16_t v)
+{
+  p[0] = v & 0xff;
+  p[1] = v >> 8;
+}
+/*---------------------------------------------------------------------------*/
+static void
+put32(uint8_t *p, uint32_t v)
+{
+  put16(p, v & 0xffff);
+  put16(p + 2, v >> 16);
+}
+/*---------------------------------------------------------------------------*/
+static void
+start(void)
+{
+  uint8_t header[NETTRACE_HEADER_LEN];
+
+  header[0] = 'C';
+  header[1] = 'N';
+  header[2] = 'T';
+  header[3] = 'R';
+  header[4] = NETTRACE_VERSION;
+  header[5] = 0;
+  put16(&header[6], CLOCK_SECOND);
+  nettrace_arch_write(header, sizeof(header));
+  started = 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+nettrace_record(uint8_t type, const void *data, uint16_t len)
+{
+  uint8_t record[NETTRACE_RECORD_LEN];
+
+  if(!started) {
+    start();
+  }
+  put32(&record[0], clock_time());
+  record[4] = type;
+  put16(&record[5], len);
+  nettrace_arch_write(record, sizeof(record));
+  if(len > 0) {
+    nettrace_arch_write(data, len);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+nettrace_boot(uint16_t node_id, uint32_t seed)
+{
+  uint8_t boot[6];
+
+  put16(&boot[0], node_id);
+  put32(&boot[2], seed);
+  nettrace_record(NETTRACE_BOOT, boot, sizeof(boot));
+}
+/*---------------------------------------------------------------------------*/
+#endif /* NETTRACE_CONF_ENABLED */
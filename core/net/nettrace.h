@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Binary network event trace
+ * \author
+ *         agent <agent@local>
+ *
+ *         A node with NETTRACE_CONF_ENABLED records the frames its
+ *         radio sends and receives, and the IP packets that enter and
+ *         leave its IP stack, in a compact binary trace. The trace can
+ *         be replayed into a single simulated node (tools/netsim -R)
+ *         and compared with another trace (tools/netsim/nettrace).
+ *
+ *         A trace starts with an 8-byte header:
+ *
+ *           'C' 'N' 'T' 'R'    magic
+ *           version            NETTRACE_VERSION
+ *           0                  reserved
+ *           CLOCK_SECOND       two bytes, little endian
+ *
+ *         followed by records:
+ *
+ *           time               clock_time(), four bytes, little endian
+ *           type               one of NETTRACE_BOOT, ...
+ *           length             two bytes, little endian
+ *           data               length bytes
+ *
+ *         The platform provides nettrace_arch_write(), which appends
+ *         bytes to the trace.
+ */
+
+#ifndef __NETTRACE_H__
+#define __NETTRACE_H__
+
+#include "contiki-conf.h"
+
+#define NETTRACE_VERSION     1
+#define NETTRACE_HEADER_LEN  8
+#define NETTRACE_RECORD_LEN  7
+
+/* Record types. */
+#define NETTRACE_BOOT        1 /* Node ID (2 bytes), random seed (4). */
+#define NETTRACE_RX          2 /* A frame read from the radio. */
+#define NETTRACE_TX          3 /* A frame sent by the radio. */
+#define NETTRACE_IP_IN       4 /* An IP packet passed up to the IP stack. */
+#define NETTRACE_IP_OUT      5 /* An IP packet passed down to the link. */
+
+#if NETTRACE_CONF_ENABLED
+void nettrace_boot(uint16_t node_id, uint32_t seed);
+void nettrace_record(uint8_t type, const void *data, uint16_t len);
+
+void nettrace_arch_write(const void *data, uint16_t len);
+
+#define NETTRACE(type, data, len) nettrace_record(type, data, len)
+#define NETTRACE_BOOT_RECORD(node_id, seed) nettrace_boot(node_id, seed)
+#else /* NETTRACE_CONF_ENABLED */
+#define NETTRACE(type, data, len)
+#define NETTRACE_BOOT_RECORD(node_id, seed)
+#endif /* NETTRACE_CONF_ENABLED */
+
+#endif /* __NETTRACE_H__ */
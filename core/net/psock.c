@@ -108,36 +108,164 @@ static u8_t
 buf_bufto(CC_REGISTER_ARG struct psock_buf *buf, u8_t endmarker,
 	  CC_REGISTER_ARG u8_t **dataptr, CC_REGISTER_ARG u16_t *datalen)
 {
-  u8_t c;
-  while(buf->left > 0 && *datalen > 0) {
-    c = *buf->ptr = **dataptr;
-    ++*dataptr;
-    ++buf->ptr;
-    --*datalen;
-    --buf->left;
-    
-    if(c == endmarker) {
-      return BUF_FOUND;
-    }
+  u8_t *end;
+  u16_t len;
+
+  /* Copy up to and including the end marker, or as much as fits. */
+  len = *datalen < buf->left ? *datalen : buf->left;
+  end = memchr(*dataptr, endmarker, len);
+  if(end != NULL) {
+    len = (u16_t)(end - *dataptr) + 1;
+  }
+  memcpy(buf->ptr, *dataptr, len);
+  buf->ptr += len;
+  buf->left -= len;
+  *dataptr += len;
+  *datalen -= len;
+
+  if(end != NULL) {
+    return BUF_FOUND;
   }
 
   if(*datalen == 0) {
     return BUF_NOT_FOUND;
   }
 
-  while(*datalen > 0) {
-    c = **dataptr;
-    --*datalen;
-    ++*dataptr;
-    
-    if(c == endmarker) {
-      return BUF_FOUND | BUF_FULL;
-    }
+  /* The buffer is full, so we skip the data up to the end marker. */
+  end = memchr(*dataptr, endmarker, *datalen);
+  if(end != NULL) {
+    *datalen -= (u16_t)(end - *dataptr) + 1;
+    *dataptr = end + 1;
+    return BUF_FOUND | BUF_FULL;
   }
+  *dataptr += *datalen;
+  *datalen = 0;
   
   return BUF_FULL;
 }
 /*---------------------------------------------------------------------------*/
+#if PSOCK_BUFFERED
+/* Copy as much as fits of len bytes into the output ring. */
+static u16_t
+ring_put(struct psock *s, const u8_t *data, u16_t len)
+{
+  u16_t pos, n;
+
+  if(len > s->sndbufsize - s->sndlen) {
+    len = s->sndbufsize - s->sndlen;
+  }
+  pos = s->sndhead + s->sndlen;
+  if(pos >= s->sndbufsize) {
+    pos -= s->sndbufsize;
+  }
+  n = s->sndbufsize - pos;
+  if(n > len) {
+    n = len;
+  }
+  memcpy(&s->sndbuf[pos], data, n);
+  memcpy(&s->sndbuf[0], data + n, len - n);
+  s->sndlen += len;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/* Send the len oldest bytes of the output ring. */
+static void
+ring_send(struct psock *s, u16_t len)
+{
+  u8_t *p = uip_sappdata;
+  u16_t n;
+
+  n = s->sndbufsize - s->sndhead;
+  if(n > len) {
+    n = len;
+  }
+  memcpy(p, &s->sndbuf[s->sndhead], n);
+  memcpy(p + n, &s->sndbuf[0], len - n);
+  uip_send(p, len);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Do the output processing of a buffered protosocket: release data
+ * that has been acknowledged, retransmit, or send the next segment
+ * from the ring. This may be called several times for the same
+ * event. Unless we are called from a send function, we do not send
+ * when there is new data, because the application may not have read
+ * it from uip_appdata yet. We ask to be polled instead.
+ */
+static void
+output(CC_REGISTER_ARG struct psock *s, char sending)
+{
+  u16_t len;
+
+  if(s->sndbuf == NULL || uip_slen > 0) {
+    return;
+  }
+
+  if(s->sndinflight > 0) {
+    if(uip_rexmit()) {
+      ring_send(s, s->sndinflight);
+      return;
+    }
+    if(!uip_acked() && uip_outstanding(uip_conn)) {
+      return;
+    }
+    s->sndhead += s->sndinflight;
+    if(s->sndhead >= s->sndbufsize) {
+      s->sndhead -= s->sndbufsize;
+    }
+    s->sndlen -= s->sndinflight;
+    s->sndinflight = 0;
+  }
+
+  if(s->sndlen == 0 ||
+     !(uip_acked() || uip_poll() || uip_connected() || uip_newdata())) {
+    return;
+  }
+  if(uip_newdata() && !sending) {
+    tcpip_poll_tcp(uip_conn);
+    return;
+  }
+
+  len = s->sndlen;
+  if(len > uip_mss()) {
+    len = uip_mss();
+  }
+  if(len > 0) {
+    ring_send(s, len);
+    s->sndinflight = len;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+psock_output(CC_REGISTER_ARG struct psock *s)
+{
+  output(s, 0);
+}
+/*---------------------------------------------------------------------------*/
+/* Copy the data at sendptr into the output ring. Returns non-zero
+   when all of it has been copied. */
+static char
+data_is_buffered(CC_REGISTER_ARG struct psock *s)
+{
+  u16_t n;
+
+  n = ring_put(s, s->sendptr, s->sendlen);
+  s->sendptr += n;
+  s->sendlen -= n;
+  output(s, 1);
+  return s->sendlen == 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns non-zero when all data in the output ring has been
+   acknowledged. */
+static char
+ring_is_drained(CC_REGISTER_ARG struct psock *s)
+{
+  output(s, 1);
+  return s->sndlen == 0;
+}
+#endif /* PSOCK_BUFFERED */
+/*---------------------------------------------------------------------------*/
 static char
 data_is_sent_and_acked(CC_REGISTER_ARG struct psock *s)
 {
@@ -145,10 +273,12 @@ data_is_sent_and_acked(CC_REGISTER_ARG struct psock *s)
      increase the send pointer and call send_data() to send more
      data. */
   if(s->state != STATE_DATA_SENT || uip_rexmit()) {
+    /* The data stays in place until it has been acked, so uIP can
+       copy it straight into the outgoing segment. */
     if(s->sendlen > uip_mss()) {
-      uip_send(s->sendptr, uip_mss());
+      uip_send_const(s->sendptr, uip_mss());
     } else {
-      uip_send(s->sendptr, s->sendlen);
+      uip_send_const(s->sendptr, s->sendlen);
     }
     s->state = STATE_DATA_SENT;
     return 0;
@@ -181,6 +311,20 @@ PT_THREAD(psock_send(CC_REGISTER_ARG struct psock *s, const uint8_t *buf,
   s->sendptr = buf;
   s->sendlen = len;
 
+#if PSOCK_BUFFERED
+  if(s->sndbuf != NULL) {
+    if(len < s->sndbufsize) {
+      /* A buffered protosocket is done as soon as the data is in its
+	 output buffer. */
+      PT_WAIT_UNTIL(&s->psockpt, data_is_buffered(s));
+      PT_EXIT(&s->psockpt);
+    }
+    /* Data that is larger than the buffer is sent directly, after
+       what is already in the buffer. */
+    PT_WAIT_UNTIL(&s->psockpt, ring_is_drained(s));
+  }
+#endif /* PSOCK_BUFFERED */
+
   s->state = STATE_NONE;
 
   /* We loop here until all data is sent. The s->sendlen variable is
@@ -209,13 +353,25 @@ PT_THREAD(psock_generator_send(CC_REGISTER_ARG struct psock *s,
     PT_EXIT(&s->psockpt);
   }
 
+#if PSOCK_BUFFERED
+  /* The generated data goes after any buffered data. */
+  if(s->sndbuf != NULL) {
+    PT_WAIT_UNTIL(&s->psockpt, ring_is_drained(s));
+  }
+#endif /* PSOCK_BUFFERED */
+
   s->state = STATE_NONE;
   do {
     /* Call the generator function to generate the data in the
      uip_appdata buffer. */
     s->sendlen = generate(arg);
     s->sendptr = uip_appdata;
-    
+
+    /* A generator that has nothing more to send ends the send. */
+    if(s->sendlen == 0) {
+      break;
+    }
+
     if(s->sendlen > uip_mss()) {
       uip_send(s->sendptr, uip_mss());
     } else {
@@ -224,7 +380,6 @@ PT_THREAD(psock_generator_send(CC_REGISTER_ARG struct psock *s,
     s->state = STATE_DATA_SENT;
 
     /* Wait until all data is sent and acknowledged. */
- // if (!s->sendlen) break;   //useful debugging aid
     PT_YIELD_UNTIL(&s->psockpt, uip_acked() || uip_rexmit());
   } while(!uip_acked());
   
@@ -233,6 +388,51 @@ PT_THREAD(psock_generator_send(CC_REGISTER_ARG struct psock *s,
   PT_END(&s->psockpt);
 }
 /*---------------------------------------------------------------------------*/
+#if PSOCK_BUFFERED
+PT_THREAD(psock_sendv(CC_REGISTER_ARG struct psock *s,
+		      const struct psock_iov *iov, uint8_t iovcnt))
+{
+  PT_BEGIN(&s->psockpt);
+
+  s->iov = iov;
+  s->iovcnt = iovcnt;
+
+  for(; s->iovcnt > 0; ++s->iov, --s->iovcnt) {
+    s->sendptr = s->iov->ptr;
+    s->sendlen = s->iov->len;
+
+    if(s->sndbuf != NULL &&
+       (!(s->iov->flags & PSOCK_IOV_CONSTANT) ||
+	s->sendlen <= s->sndbufsize - s->sndlen)) {
+      PT_WAIT_UNTIL(&s->psockpt, data_is_buffered(s));
+    } else {
+      /* Send the fragment directly, like psock_send() does. */
+      if(s->sndbuf != NULL) {
+	PT_WAIT_UNTIL(&s->psockpt, ring_is_drained(s));
+      }
+      s->state = STATE_NONE;
+      while(s->sendlen > 0) {
+	PT_WAIT_UNTIL(&s->psockpt, data_is_sent_and_acked(s));
+      }
+      s->state = STATE_NONE;
+    }
+  }
+
+  PT_END(&s->psockpt);
+}
+/*---------------------------------------------------------------------------*/
+PT_THREAD(psock_flush(CC_REGISTER_ARG struct psock *s))
+{
+  PT_BEGIN(&s->psockpt);
+
+  if(s->sndbuf != NULL) {
+    PT_WAIT_UNTIL(&s->psockpt, ring_is_drained(s));
+  }
+
+  PT_END(&s->psockpt);
+}
+#endif /* PSOCK_BUFFERED */
+/*---------------------------------------------------------------------------*/
 u16_t
 psock_datalen(struct psock *psock)
 {
@@ -324,7 +524,26 @@ psock_init(CC_REGISTER_ARG struct psock *psock,
   psock->bufptr = buffer;
   psock->bufsize = buffersize;
   buf_setup(&psock->buf, buffer, buffersize);
+#if PSOCK_BUFFERED
+  psock->sndbuf = NULL;
+  psock->sndbufsize = 0;
+  psock->sndhead = 0;
+  psock->sndlen = 0;
+  psock->sndinflight = 0;
+#endif /* PSOCK_BUFFERED */
   PT_INIT(&psock->pt);
   PT_INIT(&psock->psockpt);
 }
 /*---------------------------------------------------------------------------*/
+#if PSOCK_BUFFERED
+void
+psock_init_buffered(CC_REGISTER_ARG struct psock *psock,
+		    uint8_t *buffer, unsigned int buffersize,
+		    uint8_t *sndbuf, unsigned int sndbufsize)
+{
+  psock_init(psock, buffer, buffersize);
+  psock->sndbuf = sndbuf;
+  psock->sndbufsize = sndbufsize;
+}
+#endif /* PSOCK_BUFFERED */
+/*---------------------------------------------------------------------------*/
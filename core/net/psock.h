@@ -91,6 +91,20 @@
 #include "contiki-lib.h"
 #include "contiki-net.h"
 
+/**
+ * Whether protosockets can have an output buffer.
+ *
+ * Buffered protosockets, PSOCK_INIT_BUFFERED() and PSOCK_SENDV(), make
+ * every struct psock larger and PSOCK_BEGIN() do more work, so they
+ * are only compiled in when an application asks for them with
+ * PSOCK_CONF_BUFFERED.
+ */
+#ifdef PSOCK_CONF_BUFFERED
+#define PSOCK_BUFFERED PSOCK_CONF_BUFFERED
+#else /* PSOCK_CONF_BUFFERED */
+#define PSOCK_BUFFERED 0
+#endif /* PSOCK_CONF_BUFFERED */
+
  /*
  * The structure that holds the state of a buffer.
  *
@@ -104,6 +118,40 @@ struct psock_buf {
   unsigned short left;
 };
 
+#if PSOCK_BUFFERED
+/**
+ * A fragment of data to be sent with PSOCK_SENDV().
+ *
+ * Use PSOCK_IOV_CONST() for data that stays valid for as long as the
+ * connection is open, such as string constants and ROM files, and
+ * PSOCK_IOV_DYNAMIC() for everything else.
+ */
+struct psock_iov {
+  const u8_t *ptr;
+  u16_t len;
+  u8_t flags;
+};
+
+#define PSOCK_IOV_CONSTANT 1
+
+/**
+ * Initialize a psock_iov element for constant data.
+ *
+ * \hideinitializer
+ */
+#define PSOCK_IOV_CONST(data, datalen) \
+  { (const u8_t *)(data), (datalen), PSOCK_IOV_CONSTANT }
+
+/**
+ * Initialize a psock_iov element for data that may change after
+ * PSOCK_SENDV() has returned.
+ *
+ * \hideinitializer
+ */
+#define PSOCK_IOV_DYNAMIC(data, datalen) \
+  { (const u8_t *)(data), (datalen), 0 }
+#endif /* PSOCK_BUFFERED */
+
 /**
  * The representation of a protosocket.
  *
@@ -128,6 +176,18 @@ struct psock {
   unsigned int bufsize;  /* The size of the input buffer. */
   
   unsigned char state;   /* The state of the protosocket. */
+
+#if PSOCK_BUFFERED
+  u8_t *sndbuf;          /* Ring buffer for outgoing data, or NULL. */
+  u16_t sndbufsize;      /* The size of the output ring buffer. */
+  u16_t sndhead;         /* Offset of the oldest byte in the ring. */
+  u16_t sndlen;          /* Bytes in the ring, including those in
+			    flight. */
+  u16_t sndinflight;     /* Bytes sent from the ring but not yet
+			    acknowledged. */
+  const struct psock_iov *iov; /* The next fragment for PSOCK_SENDV(). */
+  u8_t iovcnt;           /* The number of fragments left. */
+#endif /* PSOCK_BUFFERED */
 };
 
 void psock_init(struct psock *psock, uint8_t *buffer, unsigned int buffersize);
@@ -151,18 +211,61 @@ void psock_init(struct psock *psock, uint8_t *buffer, unsigned int buffersize);
 #define PSOCK_INIT(psock, buffer, buffersize) \
   psock_init(psock, buffer, buffersize)
 
+#if PSOCK_BUFFERED
+void psock_init_buffered(struct psock *psock,
+			 uint8_t *buffer, unsigned int buffersize,
+			 uint8_t *sndbuf, unsigned int sndbufsize);
+/**
+ * Initialize a protosocket with an output buffer.
+ *
+ * Data sent over a buffered protosocket is copied into the output
+ * buffer, which works as a ring, and PSOCK_SEND(), PSOCK_SEND_STR()
+ * and PSOCK_SENDV() return as soon as the data has been copied
+ * instead of waiting for it to be acknowledged. The buffered data is
+ * sent in segments as large as the connection allows, so a series of
+ * small writes costs one segment rather than one round-trip each.
+ *
+ * Use PSOCK_FLUSH() before PSOCK_CLOSE() to make sure that all
+ * buffered data has been received by the other end.
+ *
+ * \param psock (struct psock *) A pointer to the protosocket to be
+ * initialized
+ *
+ * \param buffer (uint8_t *) A pointer to the input buffer.
+ *
+ * \param buffersize (unsigned int) The size of the input buffer.
+ *
+ * \param sndbuf (uint8_t *) A pointer to the output buffer.
+ *
+ * \param sndbufsize (unsigned int) The size of the output buffer.
+ *
+ * \hideinitializer
+ */
+#define PSOCK_INIT_BUFFERED(psock, buffer, buffersize, sndbuf, sndbufsize) \
+  psock_init_buffered(psock, buffer, buffersize, sndbuf, sndbufsize)
+
+void psock_output(struct psock *psock);
+#endif /* PSOCK_BUFFERED */
+
 /**
  * Start the protosocket protothread in a function.
  *
  * This macro starts the protothread associated with the protosocket and
  * must come before other protosocket calls in the function it is used.
+ * With PSOCK_BUFFERED, it also sends buffered data and handles
+ * acknowledgements for a buffered protosocket, so the function must
+ * be called for every event on the connection.
  *
  * \param psock (struct psock *) A pointer to the protosocket to be
  * started.
  *
  * \hideinitializer
  */
+#if PSOCK_BUFFERED
+#define PSOCK_BEGIN(psock) psock_output(psock); PT_BEGIN(&(psock)->pt)
+#else /* PSOCK_BUFFERED */
 #define PSOCK_BEGIN(psock) PT_BEGIN(&((psock)->pt))
+#endif /* PSOCK_BUFFERED */
 
 PT_THREAD(psock_send(struct psock *psock, const uint8_t *buf, unsigned int len));
 /**
@@ -198,6 +301,49 @@ PT_THREAD(psock_send(struct psock *psock, const uint8_t *buf, unsigned int len))
 #define PSOCK_SEND_STR(psock, str)      		\
   PT_WAIT_THREAD(&((psock)->pt), psock_send(psock, (uint8_t *)str, strlen(str)))
 
+#if PSOCK_BUFFERED
+PT_THREAD(psock_sendv(struct psock *psock,
+		      const struct psock_iov *iov, uint8_t iovcnt));
+/**
+ * Send a list of data fragments.
+ *
+ * This macro sends the fragments in iov in order, as if they had been
+ * sent with one PSOCK_SEND() each. On a buffered protosocket the
+ * fragments are gathered in the output buffer and go out together;
+ * constant fragments that do not fit in the free space of the buffer
+ * are sent directly from where they are.
+ *
+ * The iov array must stay valid until the macro returns, so it
+ * should not be a local variable.
+ *
+ * \param psock (struct psock *) A pointer to the protosocket.
+ *
+ * \param iov (const struct psock_iov *) The fragments to be sent.
+ *
+ * \param iovcnt (uint8_t) The number of fragments.
+ *
+ * \hideinitializer
+ */
+#define PSOCK_SENDV(psock, iov, iovcnt)				\
+  PT_WAIT_THREAD(&((psock)->pt), psock_sendv(psock, iov, iovcnt))
+
+PT_THREAD(psock_flush(struct psock *psock));
+/**
+ * Wait until all buffered data has been acknowledged.
+ *
+ * For a protosocket without an output buffer, this macro does
+ * nothing.
+ *
+ * \param psock (struct psock *) A pointer to the protosocket.
+ *
+ * \hideinitializer
+ */
+#define PSOCK_FLUSH(psock)					\
+  PT_WAIT_THREAD(&((psock)->pt), psock_flush(psock))
+#else /* PSOCK_BUFFERED */
+#define PSOCK_FLUSH(psock)
+#endif /* PSOCK_BUFFERED */
+
 PT_THREAD(psock_generator_send(struct psock *psock,
 				unsigned short (*f)(void *), void *arg));
 
@@ -220,6 +366,8 @@ PT_THREAD(psock_generator_send(struct psock *psock,
  *             length of the generated data. The generator function is
  *             called by the protosocket layer when the data first is
  *             sent, and once for every retransmission that is needed.
+ *             If it returns zero, nothing is sent and
+ *             PSOCK_GENERATOR_SEND() returns at once.
  *
  * \hideinitializer
  */
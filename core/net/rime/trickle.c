@@ -49,9 +49,10 @@
 #include "ether.h"
 #endif
 
-#define INTERVAL_MIN 1
+/* Imax, as the number of doublings of the interval given to trickle_open() */
 #define INTERVAL_MAX 4
 
+/* k, transmissions are suppressed once this many duplicates were heard */
 #define DUPLICATE_THRESHOLD 1
 
 #define SEQNO_LT(a, b) ((signed char)((a) - (b)) < 0)
@@ -70,7 +71,6 @@ static const struct packetbuf_attrlist attributes[] =
 #define PRINTF(...)
 #endif
 
-static int run_trickle(struct trickle_conn *c);
 /*---------------------------------------------------------------------------*/
 static void
 send(void *ptr)
@@ -87,48 +87,22 @@ send(void *ptr)
 }
 /*---------------------------------------------------------------------------*/
 static void
-timer_callback(void *ptr)
+timer_callback(void *ptr, uint8_t suppress)
 {
   struct trickle_conn *c = ptr;
-  run_trickle(c);
+
+  if(suppress == TRICKLE_TIMER_TX_OK) {
+    send(c);
+  }
 }
 /*---------------------------------------------------------------------------*/
 static void
 reset_interval(struct trickle_conn *c)
 {
-  PT_INIT(&c->pt);
-  run_trickle(c);
-}
-/*---------------------------------------------------------------------------*/
-static void
-set_timer(struct trickle_conn *c, struct ctimer *t, clock_time_t i)
-{
-  ctimer_set(t, i, timer_callback, c);
-}
-/*---------------------------------------------------------------------------*/
-static int
-run_trickle(struct trickle_conn *c)
-{
-  clock_time_t interval;
-  PT_BEGIN(&c->pt);
-
-  while(1) {
-    interval = c->interval << c->interval_scaling;
-    set_timer(c, &c->interval_timer, interval);
-    set_timer(c, &c->t, interval / 2 + (random_rand() % (interval / 2)));
-
-    c->duplicates = 0;
-    PT_YIELD(&c->pt); /* Wait until listen timeout */
-    if(c->duplicates < DUPLICATE_THRESHOLD) {
-      send(c);
-    }
-    PT_YIELD(&c->pt); /* Wait until interval timer expired. */
-    if(c->interval_scaling < INTERVAL_MAX) {
-      c->interval_scaling++;
-    }
+  if(!trickle_timer_is_running(&c->tt)) {
+    trickle_timer_set(&c->tt, timer_callback, c);
   }
-  
-  PT_END(&c->pt);
+  trickle_timer_reset_event(&c->tt);
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -147,9 +121,9 @@ recv(struct broadcast_conn *bc, const rimeaddr_t *from)
 
   if(seqno == c->seqno) {
     /*    c->cb->recv(c);*/
-    ++c->duplicates;
+    trickle_timer_consistency(&c->tt);
   } else if(SEQNO_LT(seqno, c->seqno)) {
-    c->interval_scaling = 0;
+    trickle_timer_inconsistency(&c->tt);
     send(c);
   } else { /* hdr->seqno > c->seqno */
 #if CONTIKI_TARGET_NETSIM
@@ -161,9 +135,8 @@ recv(struct broadcast_conn *bc, const rimeaddr_t *from)
       queuebuf_free(c->q);
     }
     c->q = queuebuf_new_from_packetbuf();
-    c->interval_scaling = 0;
     reset_interval(c);
-    ctimer_set(&c->first_transmission_timer, random_rand() % c->interval,
+    ctimer_set(&c->first_transmission_timer, random_rand() % c->tt.i_min,
 	       send, c);
     c->cb->recv(c);
   }
@@ -178,8 +151,7 @@ trickle_open(struct trickle_conn *c, clock_time_t interval,
   broadcast_open(&c->c, channel, &bc);
   c->cb = cb;
   c->q = NULL;
-  c->interval = interval;
-  c->interval_scaling = 0;
+  trickle_timer_config(&c->tt, interval, INTERVAL_MAX, DUPLICATE_THRESHOLD);
   channel_set_attributes(channel, attributes);
 }
 /*---------------------------------------------------------------------------*/
@@ -187,8 +159,8 @@ void
 trickle_close(struct trickle_conn *c)
 {
   broadcast_close(&c->c);
-  ctimer_stop(&c->t);
-  ctimer_stop(&c->interval_timer);
+  trickle_timer_stop(&c->tt);
+  ctimer_stop(&c->first_transmission_timer);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -46,7 +46,6 @@
 #include "net/uip.h"
 #include "net/uip-nd6.h"
 #include "lib/list.h"
-#include "lib/memb.h"
 #include "sys/ctimer.h"
 
 #include <limits.h>
@@ -59,7 +58,7 @@
 
 /************************************************************************/
 extern rpl_of_t RPL_OF;
-static rpl_of_t * const objective_functions[] = {&RPL_OF};
+static rpl_of_t * const objective_functions[] = RPL_SUPPORTED_OFS;
 /************************************************************************/
 
 #ifndef RPL_CONF_MAX_DAG_ENTRIES
@@ -95,10 +94,54 @@ static rpl_of_t * const objective_functions[] = {&RPL_OF};
 #endif /* !RPL_CONF_DIO_INTERVAL_DOUBLINGS */
 
 /************************************************************************/
-/* Allocate parents from the same static MEMB chunk to reduce memory waste. */
-MEMB(parent_memb, struct rpl_parent, RPL_MAX_PARENTS);
-
 static rpl_dag_t dag_table[RPL_MAX_DAG_ENTRIES];
+
+/* Each DAG slot keeps its parents in a neighbor table of its own. The
+   tables share the link-layer address keys with each other and with
+   the rest of the stack, so a neighbor that is a parent in several
+   instances is stored once per instance but looked up once. */
+static rpl_parent_t parent_mem[RPL_MAX_DAG_ENTRIES][NBR_TABLE_MAX_NEIGHBORS];
+static nbr_table_t parent_tables[RPL_MAX_DAG_ENTRIES];
+/************************************************************************/
+/* Parent link-local addresses are formed from the link-layer address
+   of the neighbor, see uip_ds6_set_addr_iid(). */
+static void
+lladdr_from_ipaddr(uip_lladdr_t *lladdr, const uip_ipaddr_t *ipaddr)
+{
+#if (UIP_LLADDR_LEN == 8)
+  memcpy(lladdr, ipaddr->u8 + 8, UIP_LLADDR_LEN);
+#elif (UIP_LLADDR_LEN == 6)
+  memcpy(lladdr, ipaddr->u8 + 8, 3);
+  memcpy((uint8_t *)lladdr + 3, ipaddr->u8 + 13, 3);
+#else
+#error rpl-dag.c cannot map addresses when UIP_LLADDR_LEN is not 6 or 8
+#endif
+  ((uint8_t *)lladdr)[0] ^= 0x02;
+}
+/************************************************************************/
+/* Called by the neighbor table when it reclaims a parent entry for
+   another neighbor. */
+static void
+parent_evicted(nbr_table_item_t *item)
+{
+  rpl_parent_t *p;
+
+  p = item;
+  PRINTF("RPL: Neighbor table reclaimed a parent\n");
+  rpl_remove_parent(p->dag, p);
+}
+/************************************************************************/
+/* The preferred parent is locked in the neighbor table so that it is
+   never reclaimed while in use. */
+static void
+set_preferred_parent(rpl_dag_t *dag, rpl_parent_t *p)
+{
+  if(dag->preferred_parent != p) {
+    nbr_table_unlock(dag->parents, dag->preferred_parent);
+    nbr_table_lock(dag->parents, p);
+    dag->preferred_parent = p;
+  }
+}
 /************************************************************************/
 /* Remove DAG parents with a rank that is at least the same as minimum_rank. */
 static void
@@ -109,8 +152,8 @@ remove_parents(rpl_dag_t *dag, rpl_rank_t minimum_rank)
   PRINTF("RPL: Removing parents (minimum rank %u)\n",
 	minimum_rank);
 
-  for(p = list_head(dag->parents); p != NULL; p = p2) {
-    p2 = p->next;
+  for(p = nbr_table_head(dag->parents); p != NULL; p = p2) {
+    p2 = nbr_table_next(dag->parents, p);
     if(p->rank >= minimum_rank) {
       rpl_remove_parent(dag, p);
     }
@@ -126,7 +169,8 @@ remove_worst_parent(rpl_dag_t *dag, rpl_rank_t min_worst_rank)
 
   /* Find the parent with the highest rank. */
   worst = NULL;
-  for(p = list_head(dag->parents); p != NULL; p = list_item_next(p)) {
+  for(p = nbr_table_head(dag->parents); p != NULL;
+      p = nbr_table_next(dag->parents, p)) {
     if(p != dag->preferred_parent &&
        (worst == NULL || p->rank > worst->rank)) {
       worst = p;
@@ -156,20 +200,33 @@ acceptable_rank(rpl_dag_t *dag, rpl_rank_t rank)
 }
 /************************************************************************/
 rpl_dag_t *
-rpl_set_root(uip_ipaddr_t *dag_id)
+rpl_set_root(uint8_t instance_id, uip_ipaddr_t *dag_id)
+{
+  return rpl_set_root_of(instance_id, dag_id, RPL_OF.ocp);
+}
+/************************************************************************/
+rpl_dag_t *
+rpl_set_root_of(uint8_t instance_id, uip_ipaddr_t *dag_id, rpl_ocp_t ocp)
 {
   rpl_dag_t *dag;
+  rpl_of_t *of;
   int version;
 
+  of = rpl_find_of(ocp);
+  if(of == NULL) {
+    PRINTF("RPL: Objective function %u is not supported\n", ocp);
+    return NULL;
+  }
+
   version = -1;
-  dag = rpl_get_dag(RPL_DEFAULT_INSTANCE);
+  dag = rpl_get_dag(instance_id);
   if(dag != NULL) {
     PRINTF("RPL: Dropping a joined DAG when setting this node as root");
     version = dag->version;
     rpl_free_dag(dag);
   }
 
-  dag = rpl_alloc_dag(RPL_DEFAULT_INSTANCE);
+  dag = rpl_alloc_dag(instance_id);
   if(dag == NULL) {
     PRINTF("RPL: Failed to allocate a DAG\n");
     return NULL;
@@ -179,7 +236,7 @@ rpl_set_root(uip_ipaddr_t *dag_id)
   dag->version = version + 1;
   dag->grounded = RPL_GROUNDED;
   dag->mop = RPL_MOP_DEFAULT;
-  dag->of = &RPL_OF;
+  dag->of = of;
   dag->preferred_parent = NULL;
   dag->dtsn_out = 1; /* Trigger DAOs from the beginning. */
 
@@ -224,23 +281,45 @@ rpl_set_prefix(rpl_dag_t *dag, uip_ipaddr_t *prefix, int len)
   return 0;
 }
 /************************************************************************/
+/* A default router entry is shared by all instances that have the same
+   preferred parent, and is removed when the last of them lets go. */
+static void
+release_default_route(rpl_dag_t *dag)
+{
+  rpl_dag_t *other;
+
+  if(dag->def_route == NULL) {
+    return;
+  }
+  for(other = rpl_get_next_dag(NULL); other != NULL;
+      other = rpl_get_next_dag(other)) {
+    if(other != dag && other->def_route == dag->def_route) {
+      dag->def_route = NULL;
+      return;
+    }
+  }
+  PRINTF("RPL: Removing default route through ");
+  PRINT6ADDR(&dag->def_route->ipaddr);
+  PRINTF("\n");
+  uip_ds6_defrt_rm(dag->def_route);
+  dag->def_route = NULL;
+}
+/************************************************************************/
 int
 rpl_set_default_route(rpl_dag_t *dag, uip_ipaddr_t *from)
 {
-  if(dag->def_route != NULL) {
-    PRINTF("RPL: Removing default route through ");
-    PRINT6ADDR(&dag->def_route->ipaddr);
-    PRINTF("\n");
-    uip_ds6_defrt_rm(dag->def_route);
-  }
+  release_default_route(dag);
 
   if(from != NULL) {
     PRINTF("RPL: Adding default route through ");
     PRINT6ADDR(from);
     PRINTF("\n");
-    dag->def_route = uip_ds6_defrt_add(from,
-                                       RPL_LIFETIME(dag,
-                                                    dag->default_lifetime));
+    dag->def_route = uip_ds6_defrt_lookup(from);
+    if(dag->def_route == NULL) {
+      dag->def_route = uip_ds6_defrt_add(from,
+                                         RPL_LIFETIME(dag,
+                                                      dag->default_lifetime));
+    }
     if(dag->def_route == NULL) {
       return 0;
     }
@@ -258,8 +337,8 @@ rpl_alloc_dag(uint8_t instance_id)
   for(dag = &dag_table[0], end = dag + RPL_MAX_DAG_ENTRIES; dag < end; dag++) {
     if(dag->used == 0) {
       memset(dag, 0, sizeof(*dag));
-      dag->parents = &dag->parent_list;
-      list_init(dag->parents);
+      dag->used = 1;
+      dag->parents = &parent_tables[dag - dag_table];
       dag->instance_id = instance_id;
       dag->def_route = NULL;
       dag->rank = INFINITE_RANK;
@@ -286,23 +365,37 @@ rpl_free_dag(rpl_dag_t *dag)
   remove_parents(dag, 0);
   rpl_set_default_route(dag, NULL);
 
-  ctimer_stop(&dag->dio_timer);
+  trickle_timer_stop(&dag->dio_timer);
   ctimer_stop(&dag->dao_timer);
 
   dag->used = 0;
   dag->joined = 0;
 }
 /************************************************************************/
+void
+rpl_dag_init(void)
+{
+  int i;
+
+  for(i = 0; i < RPL_MAX_DAG_ENTRIES; i++) {
+    parent_tables[i].item_size = sizeof(rpl_parent_t);
+    parent_tables[i].data = parent_mem[i];
+    nbr_table_register(&parent_tables[i], parent_evicted);
+  }
+}
+/************************************************************************/
 rpl_parent_t *
 rpl_add_parent(rpl_dag_t *dag, rpl_dio_t *dio, uip_ipaddr_t *addr)
 {
   rpl_parent_t *p;
-  p = memb_alloc(&parent_memb);
+  uip_lladdr_t lladdr;
+
+  lladdr_from_ipaddr(&lladdr, addr);
+  p = nbr_table_add_lladdr(dag->parents, (rimeaddr_t *)&lladdr);
   if(p == NULL) {
     RPL_STAT(rpl_stats.mem_overflows++);
     return NULL;
   }
-  memcpy(&p->addr, addr, sizeof(p->addr));
   p->dag = dag;
   p->rank = dio->rank;
   p->link_metric = INITIAL_LINK_METRIC;
@@ -310,36 +403,76 @@ rpl_add_parent(rpl_dag_t *dag, rpl_dio_t *dio, uip_ipaddr_t *addr)
 
   memcpy(&p->mc, &dio->mc, sizeof(p->mc));
 
-  list_add(dag->parents, p);
-
   return p;
 }
 /************************************************************************/
 rpl_parent_t *
 rpl_find_parent(rpl_dag_t *dag, uip_ipaddr_t *addr)
 {
+  uip_lladdr_t lladdr;
+
+  lladdr_from_ipaddr(&lladdr, addr);
+  return nbr_table_get_from_lladdr(dag->parents, (rimeaddr_t *)&lladdr);
+}
+/************************************************************************/
+rpl_parent_t *
+rpl_get_parent(rpl_dag_t *dag, const rimeaddr_t *addr)
+{
+  return nbr_table_get_from_lladdr(dag->parents, addr);
+}
+/************************************************************************/
+rimeaddr_t *
+rpl_get_parent_lladdr(rpl_parent_t *p)
+{
+  return nbr_table_get_lladdr(p->dag->parents, p);
+}
+/************************************************************************/
+uip_ipaddr_t *
+rpl_get_parent_ipaddr(rpl_parent_t *p, uip_ipaddr_t *addr)
+{
+  uip_ip6addr(addr, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(addr, (uip_lladdr_t *)rpl_get_parent_lladdr(p));
+  return addr;
+}
+/************************************************************************/
+rpl_rank_t
+rpl_get_parent_rank(rimeaddr_t *addr)
+{
+  rpl_dag_t *dag;
   rpl_parent_t *p;
 
-  for(p = list_head(dag->parents); p != NULL; p = p->next) {
-    if(uip_ipaddr_cmp(&p->addr, addr)) {
-      return p;
-    }
+  dag = rpl_get_dag(RPL_DEFAULT_INSTANCE);
+  if(dag == NULL || (p = rpl_get_parent(dag, addr)) == NULL) {
+    return INFINITE_RANK;
   }
+  return p->rank;
+}
+/************************************************************************/
+int
+rpl_parent_count(rpl_dag_t *dag)
+{
+  rpl_parent_t *p;
+  int count;
 
-  return NULL;
+  count = 0;
+  for(p = nbr_table_head(dag->parents); p != NULL;
+      p = nbr_table_next(dag->parents, p)) {
+    count++;
+  }
+  return count;
 }
 
 /************************************************************************/
-rpl_parent_t *
-rpl_select_parent(rpl_dag_t *dag)
+static rpl_parent_t *
+best_of_all_parents(rpl_dag_t *dag)
 {
   rpl_parent_t *p;
   rpl_parent_t *best;
 
   best = NULL;
-  for(p = list_head(dag->parents); p != NULL; p = p->next) {
+  for(p = nbr_table_head(dag->parents); p != NULL;
+      p = nbr_table_next(dag->parents, p)) {
     if(p->rank == INFINITE_RANK) {
-      PRINTF("RPL: Infinite rank\n");
       /* ignore this neighbor */
     } else if(best == NULL) {
       best = p;
@@ -347,6 +480,73 @@ rpl_select_parent(rpl_dag_t *dag)
       best = dag->of->best_parent(best, p);
     }
   }
+  return best;
+}
+/************************************************************************/
+static rpl_parent_t *
+best_after_update(rpl_dag_t *dag, rpl_parent_t *updated)
+{
+  rpl_parent_t *preferred;
+
+  preferred = dag->preferred_parent;
+  if(preferred == NULL || preferred == updated ||
+     preferred->rank == INFINITE_RANK || updated == NULL) {
+    /* The cached choice is gone or may have become worse than one of
+       the other parents, so they all have to be compared again. */
+    return best_of_all_parents(dag);
+  }
+  if(updated->rank == INFINITE_RANK) {
+    return preferred;
+  }
+  /* Only the updated parent has changed, and the preferred parent
+     was better than all the others before. */
+  return dag->of->best_parent(preferred, updated);
+}
+/************************************************************************/
+static rpl_parent_t *
+hold_preferred_parent(rpl_dag_t *dag, rpl_parent_t *best,
+                      rpl_parent_t *updated)
+{
+  rpl_parent_t *preferred;
+
+  preferred = dag->preferred_parent;
+  if(preferred == NULL || preferred->rank == INFINITE_RANK) {
+    dag->switch_candidate = NULL;
+    return best;
+  }
+
+  if(best == preferred) {
+    if(updated == dag->switch_candidate || updated == preferred) {
+      /* The candidate lost against the preferred parent. */
+      dag->switch_candidate = NULL;
+    }
+    return best;
+  }
+
+  if(best != dag->switch_candidate) {
+    dag->switch_candidate = best;
+    dag->switch_wins = 0;
+  }
+  if(++dag->switch_wins < RPL_PARENT_SWITCH_HOLD) {
+    PRINTF("RPL: Holding the preferred parent, candidate won %u/%u times\n",
+           dag->switch_wins, RPL_PARENT_SWITCH_HOLD);
+    RPL_STAT(rpl_stats.parent_switch_held++);
+    return preferred;
+  }
+  dag->switch_candidate = NULL;
+  return best;
+}
+/************************************************************************/
+rpl_parent_t *
+rpl_select_parent(rpl_dag_t *dag, rpl_parent_t *updated)
+{
+  rpl_parent_t *best;
+  uip_ipaddr_t addr;
+
+  best = best_after_update(dag, updated);
+  if(best != NULL) {
+    best = hold_preferred_parent(dag, best, updated);
+  }
 
   if(best == NULL) {
     /* need to handle update of best... */
@@ -357,11 +557,10 @@ rpl_select_parent(rpl_dag_t *dag)
     PRINTF("RPL: Sending a No-Path DAO to old DAO parent\n");
     dao_output(dag->preferred_parent, ZERO_LIFETIME);
 
-    dag->preferred_parent = best; /* Cache the value. */
-    
+    set_preferred_parent(dag, best); /* Cache the value. */
 
     dag->of->update_metric_container(dag);
-    rpl_set_default_route(dag, &best->addr);
+    rpl_set_default_route(dag, rpl_get_parent_ipaddr(best, &addr));
     /* The DAO parent set changed - schedule a DAO transmission. */
     if(dag->mop != RPL_MOP_NO_DOWNWARD_ROUTES) {
       rpl_schedule_dao(dag);
@@ -390,29 +589,30 @@ rpl_select_parent(rpl_dag_t *dag)
 int
 rpl_remove_parent(rpl_dag_t *dag, rpl_parent_t *parent)
 {
-  uip_ds6_defrt_t *defrt;
+  uip_ipaddr_t addr;
+
+  rpl_get_parent_ipaddr(parent, &addr);
 
   /* Remove uIPv6 routes that have this parent as the next hop. **/
-  uip_ds6_route_rm_by_nexthop(&parent->addr);
-  defrt = uip_ds6_defrt_lookup(&parent->addr);
-  if(defrt != NULL) {
-    PRINTF("RPL: Removing default route ");
-    PRINT6ADDR(&parent->addr);
-    PRINTF("\n");
-    uip_ds6_defrt_rm(defrt);
-    dag->def_route = NULL;
+  uip_ds6_route_rm_by_nexthop(&addr);
+  if(dag->def_route != NULL &&
+     uip_ipaddr_cmp(&dag->def_route->ipaddr, &addr)) {
+    release_default_route(dag);
   }
 
   PRINTF("RPL: Removing parent ");
-  PRINT6ADDR(&parent->addr);
+  PRINT6ADDR(&addr);
   PRINTF("\n");
 
+  if(parent == dag->switch_candidate) {
+    dag->switch_candidate = NULL;
+  }
   if(parent == dag->preferred_parent) {
     dag->preferred_parent = NULL;
   }
 
-  list_remove(dag->parents, parent);
-  memb_free(&parent_memb, parent);
+  /* Also drops the lock taken for a preferred parent. */
+  nbr_table_remove(dag->parents, parent);
   return 0;
 }
 /************************************************************************/
@@ -430,6 +630,20 @@ rpl_get_dag(int instance_id)
   return NULL;
 }
 /************************************************************************/
+rpl_dag_t *
+rpl_get_next_dag(rpl_dag_t *dag)
+{
+  rpl_dag_t *end;
+
+  dag = dag == NULL ? &dag_table[0] : dag + 1;
+  for(end = &dag_table[RPL_MAX_DAG_ENTRIES]; dag < end; dag++) {
+    if(dag->joined) {
+      return dag;
+    }
+  }
+  return NULL;
+}
+/************************************************************************/
 rpl_of_t *
 rpl_find_of(rpl_ocp_t ocp)
 {
@@ -465,6 +679,7 @@ join_dag(uip_ipaddr_t *from, rpl_dio_t *dio)
   PRINTF(" as a parent: \n");
   if(p == NULL) {
     PRINTF("failed\n");
+    rpl_free_dag(dag);
     return;
   }
   PRINTF("succeeded\n");
@@ -475,6 +690,7 @@ join_dag(uip_ipaddr_t *from, rpl_dio_t *dio)
   if(of == NULL) {
     PRINTF("RPL: DIO for DAG instance %u does not specify a supported OF\n",
         dio->instance_id);
+    rpl_free_dag(dag);
     return;
   }
 
@@ -506,7 +722,7 @@ join_dag(uip_ipaddr_t *from, rpl_dio_t *dio)
   dag->min_hoprankinc = dio->dag_min_hoprankinc;
 
   dag->version = dio->version;
-  dag->preferred_parent = p;
+  set_preferred_parent(dag, p);
   dag->of->update_metric_container(dag);
 
   dag->dio_intdoubl = dio->dag_intdoubl;
@@ -528,7 +744,7 @@ join_dag(uip_ipaddr_t *from, rpl_dio_t *dio)
 
   //ANNOTATE("#A join=%u\n",dag->dag_id.u8[sizeof(dag->dag_id) - 1]);
 
-  ANNOTATE("#L %d 1;blue\n",dag->preferred_parent->addr.u8[sizeof(uip_ipaddr_t) - 1]);
+  ANNOTATE("#L %d 1;blue\n",rpl_get_parent_lladdr(dag->preferred_parent)->u8[RIMEADDR_SIZE - 1]);
 
   dag->default_lifetime = dio->default_lifetime;
   dag->lifetime_unit = dio->lifetime_unit;
@@ -605,9 +821,10 @@ rpl_recalculate_ranks(void)
    * than RPL protocol messages. This periodical recalculation is called
    * from a timer in order to keep the stack depth reasonably low.
    */
-  dag = rpl_get_dag(RPL_ANY_INSTANCE);
-  if(dag != NULL) {
-    for(p = list_head(dag->parents); p != NULL; p = p->next) {
+  for(dag = rpl_get_next_dag(NULL); dag != NULL;
+      dag = rpl_get_next_dag(dag)) {
+    for(p = nbr_table_head(dag->parents); p != NULL;
+        p = nbr_table_next(dag->parents, p)) {
       if(p->updated) {
 	p->updated = 0;
 	PRINTF("RPL: Recalculate rank\n");
@@ -633,7 +850,7 @@ rpl_process_parent_event(rpl_dag_t *dag, rpl_parent_t *p)
   parent_rank = p->rank;
   old_rank = dag->rank;
 
-  if(rpl_select_parent(dag) == NULL) {
+  if(rpl_select_parent(dag, p) == NULL) {
     /* No suitable parent; trigger a local repair. */
     PRINTF("RPL: No parents found in a DAG\n");
     rpl_local_repair(dag);
@@ -647,7 +864,7 @@ rpl_process_parent_event(rpl_dag_t *dag, rpl_parent_t *p)
     PRINTF("RPL: Moving in the DAG from rank %hu to %hu\n",
 	   DAG_RANK(old_rank, dag), DAG_RANK(dag->rank, dag));
     PRINTF("RPL: The preferred parent is ");
-    PRINT6ADDR(&dag->preferred_parent->addr);
+    PRINTLLADDR((uip_lladdr_t *)rpl_get_parent_lladdr(dag->preferred_parent));
     PRINTF(" (rank %u)\n",
            (unsigned)DAG_RANK(dag->preferred_parent->rank, dag));
     rpl_reset_dio_timer(dag, 1);
@@ -718,7 +935,7 @@ rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
 
   if(dag->rank == ROOT_RANK(dag)) {
     if(dio->rank != INFINITE_RANK) {
-      dag->dio_counter++;
+      trickle_timer_consistency(&dag->dio_timer);
     }
     return;
   }
@@ -751,7 +968,7 @@ rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
     PRINTF("\n");
   } else if(DAG_RANK(p->rank, dag) == DAG_RANK(dio->rank, dag)) {
     PRINTF("RPL: Received consistent DIO\n");
-    dag->dio_counter++;
+    trickle_timer_consistency(&dag->dio_timer);
   }
   
   /* We have allocated a candidate parent; process the DIO further. */
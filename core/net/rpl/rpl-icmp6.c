@@ -132,8 +132,8 @@ dis_input(void)
   PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
   PRINTF("\n");
 
-  dag = rpl_get_dag(RPL_ANY_INSTANCE);
-  if(dag != NULL) {
+  for(dag = rpl_get_next_dag(NULL); dag != NULL;
+      dag = rpl_get_next_dag(dag)) {
     if(uip_is_addr_mcast(&UIP_IP_BUF->destipaddr)) {
       PRINTF("RPL: Multicast DIS => reset DIO timer\n");
       rpl_reset_dio_timer(dag, 0);
@@ -476,10 +476,259 @@ dio_output(rpl_dag_t *dag, uip_ipaddr_t *uc_addr)
   }
 }
 /*---------------------------------------------------------------------------*/
+#define DAO_TARGET_MAX_LEN  (4 + sizeof(uip_ipaddr_t))
+#define DAO_TRANSIT_LEN     6
+#define DAO_MAX_LEN         (UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPICMPH_LEN)
+
+#if RPL_DAO_AGGREGATION
+/* A target learned from a child that has not been forwarded yet. */
+struct dao_agg_target {
+  rpl_dag_t *dag;
+  uip_ipaddr_t prefix;
+  uint8_t prefixlen;
+  rpl_lifetime_t lifetime;
+  /* Added or renewed by the DAO that is being processed. */
+  uint8_t current;
+};
+
+static struct dao_agg_target dao_agg[RPL_DAO_AGGREGATION_TARGETS];
+static uint8_t dao_agg_count;
+static struct ctimer dao_agg_timer;
+#endif /* RPL_DAO_AGGREGATION */
+/*---------------------------------------------------------------------------*/
+static int
+dao_add_header(unsigned char *buffer, rpl_dag_t *dag)
+{
+  int pos;
+
+  ++dao_sequence;
+  pos = 0;
+
+  buffer[pos++] = dag->instance_id;
+#if RPL_CONF_DAO_ACK
+  buffer[pos++] = RPL_DAO_K_FLAG; /* DAO ACK request, no DODAGID */
+#else
+  buffer[pos++] = 0; /* No DAO ACK request, no DODAGID */
+#endif
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = dao_sequence & 0xff;
+
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+static int
+dao_add_target(unsigned char *buffer, int pos,
+               uip_ipaddr_t *prefix, uint8_t prefixlen)
+{
+  buffer[pos++] = RPL_OPTION_TARGET;
+  buffer[pos++] = 2 + ((prefixlen + 7) / CHAR_BIT);
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = prefixlen;
+  memcpy(buffer + pos, prefix, (prefixlen + 7) / CHAR_BIT);
+  pos += ((prefixlen + 7) / CHAR_BIT);
+
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+#if RPL_DAO_AGGREGATION
+static void
+dao_agg_send(rpl_dag_t *dag, int len, int targets)
+{
+  uip_ipaddr_t addr;
+
+  if(!dag->used || dag->preferred_parent == NULL) {
+    PRINTF("RPL: No parent to forward %d aggregated DAO targets to\n",
+           targets);
+    return;
+  }
+
+  rpl_get_parent_ipaddr(dag->preferred_parent, &addr);
+  PRINTF("RPL: Forwarding a DAO with %d targets to parent ", targets);
+  PRINT6ADDR(&addr);
+  PRINTF("\n");
+
+  RPL_STAT(rpl_stats.dao_out++);
+  uip_icmp6_send(&addr, ICMP6_RPL, RPL_CODE_DAO, len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+dao_add_transit(unsigned char *buffer, int pos, rpl_lifetime_t lifetime)
+{
+  buffer[pos++] = RPL_OPTION_TRANSIT;
+  buffer[pos++] = DAO_TRANSIT_LEN - 2;
+  buffer[pos++] = 0; /* flags - ignored */
+  buffer[pos++] = 0; /* path control - ignored */
+  buffer[pos++] = 0; /* path seq - ignored */
+  buffer[pos++] = lifetime;
+
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+static void
+dao_agg_flush(void *ptr)
+{
+  unsigned char *buffer;
+  rpl_dag_t *dag;
+  rpl_lifetime_t lifetime;
+  int pos;
+  int targets;
+  int group;
+  int i, j, k;
+
+  ctimer_stop(&dao_agg_timer);
+
+  buffer = UIP_ICMP_PAYLOAD;
+
+  /* One DAO per DAG, in which targets that share a lifetime share a
+     Transit Information option. */
+  for(i = 0; i < dao_agg_count; i++) {
+    dag = dao_agg[i].dag;
+    if(dag == NULL) {
+      continue;
+    }
+    pos = 0;
+    targets = 0;
+    for(j = i; j < dao_agg_count; j++) {
+      if(dao_agg[j].dag != dag) {
+        continue;
+      }
+      lifetime = dao_agg[j].lifetime;
+      group = 0;
+      for(k = j; k < dao_agg_count; k++) {
+        if(dao_agg[k].dag != dag || dao_agg[k].lifetime != lifetime) {
+          continue;
+        }
+        if(pos + DAO_TARGET_MAX_LEN + DAO_TRANSIT_LEN > DAO_MAX_LEN) {
+          if(group > 0) {
+            pos = dao_add_transit(buffer, pos, lifetime);
+          }
+          dao_agg_send(dag, pos, targets);
+          pos = 0;
+          targets = 0;
+          group = 0;
+        }
+        if(pos == 0) {
+          pos = dao_add_header(buffer, dag);
+        }
+        pos = dao_add_target(buffer, pos, &dao_agg[k].prefix,
+                             dao_agg[k].prefixlen);
+        targets++;
+        group++;
+        dao_agg[k].dag = NULL;
+      }
+      pos = dao_add_transit(buffer, pos, lifetime);
+    }
+    dao_agg_send(dag, pos, targets);
+  }
+
+  dao_agg_count = 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+dao_agg_add(rpl_dag_t *dag, uip_ipaddr_t *prefix, uint8_t prefixlen,
+            rpl_lifetime_t lifetime)
+{
+  struct dao_agg_target *t;
+  int i;
+
+  for(i = 0; i < dao_agg_count; i++) {
+    t = &dao_agg[i];
+    if(t->dag == dag && t->prefixlen == prefixlen &&
+       uip_ipaddr_cmp(&t->prefix, prefix)) {
+      /* A newer advertisement of a target that is already held. */
+      t->lifetime = lifetime;
+      t->current = 1;
+      RPL_STAT(rpl_stats.dao_targets_aggregated++);
+      return 1;
+    }
+  }
+
+  if(dao_agg_count == RPL_DAO_AGGREGATION_TARGETS) {
+    return 0;
+  }
+
+  t = &dao_agg[dao_agg_count++];
+  t->dag = dag;
+  uip_ipaddr_copy(&t->prefix, prefix);
+  t->prefixlen = prefixlen;
+  t->lifetime = lifetime;
+  t->current = 1;
+
+  if(dao_agg_count == 1) {
+    ctimer_set(&dao_agg_timer, RPL_DAO_AGGREGATION_WINDOW,
+               dao_agg_flush, NULL);
+  } else {
+    RPL_STAT(rpl_stats.dao_targets_aggregated++);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Called when a DAO has been processed. If the DAO is forwarded as it
+   is, the targets that it added or renewed are dropped, so that they
+   are not sent a second time by dao_agg_flush(). */
+static void
+dao_agg_done(int forwarded)
+{
+  int i;
+
+  for(i = 0; i < dao_agg_count;) {
+    if(dao_agg[i].current && forwarded) {
+      dao_agg[i] = dao_agg[--dao_agg_count];
+    } else {
+      dao_agg[i++].current = 0;
+    }
+  }
+  if(dao_agg_count == 0) {
+    ctimer_stop(&dao_agg_timer);
+  }
+}
+#endif /* RPL_DAO_AGGREGATION */
+/*---------------------------------------------------------------------------*/
+static int
+dao_target_input(rpl_dag_t *dag, uip_ipaddr_t *from, int learned_from,
+                 uip_ipaddr_t *prefix, uint8_t prefixlen,
+                 rpl_lifetime_t lifetime)
+{
+  uip_ds6_route_t *rep;
+
+  PRINTF("RPL: DAO lifetime: %u, prefix length: %u prefix: ",
+         (unsigned)lifetime, (unsigned)prefixlen);
+  PRINT6ADDR(prefix);
+  PRINTF("\n");
+
+  rep = uip_ds6_route_lookup(prefix);
+
+  if(lifetime == ZERO_LIFETIME) {
+    /* No-Path DAO received; invoke the route purging routine. */
+    if(rep != NULL && rep->state.saved_lifetime == 0) {
+      PRINTF("RPL: Setting expiration timer for prefix ");
+      PRINT6ADDR(prefix);
+      PRINTF("\n");
+      rep->state.saved_lifetime = rep->state.lifetime;
+      rep->state.lifetime = DAO_EXPIRATION_TIMEOUT;
+    }
+    return 1;
+  }
+
+  if(rep == NULL) {
+    rep = rpl_add_route(dag, prefix, prefixlen, from);
+    if(rep == NULL) {
+      RPL_STAT(rpl_stats.mem_overflows++);
+      PRINTF("RPL: Could not add a route after receiving a DAO\n");
+      return 0;
+    }
+  }
+
+  rep->state.lifetime = RPL_LIFETIME(dag, lifetime);
+  rep->state.learned_from = learned_from;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 static void
 dao_input(void)
 {
   uip_ipaddr_t dao_sender_addr;
+  uip_ipaddr_t parent_addr;
   rpl_dag_t *dag;
   unsigned char *buffer;
   uint16_t sequence;
@@ -488,18 +737,22 @@ dao_input(void)
   uint8_t prefixlen;
   uint8_t flags;
   uint8_t subopt_type;
-  uint8_t pathcontrol;
-  uint8_t pathsequence;
   uip_ipaddr_t prefix;
-  uip_ds6_route_t *rep;
-  uint8_t buffer_length;
+  uint16_t buffer_length;
   int pos;
   int len;
   int i;
+  int j;
   int learned_from;
+  int target_pos;
+  int accepted;
+  int forward;
+  int queued;
   rpl_parent_t *p;
-
-  prefixlen = 0;
+#if RPL_WITH_NON_STORING
+  uip_ipaddr_t parent;
+  uint8_t has_parent;
+#endif /* RPL_WITH_NON_STORING */
 
   uip_ipaddr_copy(&dao_sender_addr, &UIP_IP_BUF->srcipaddr);
 
@@ -508,6 +761,8 @@ dao_input(void)
   PRINT6ADDR(&dao_sender_addr);
   PRINTF("\n");
 
+  RPL_STAT(rpl_stats.dao_in++);
+
   buffer = UIP_ICMP_PAYLOAD;
   buffer_length = uip_len - uip_l2_l3_icmp_hdr_len;
 #if RPL_CONF_ADJUST_LLH_LEN
@@ -524,8 +779,6 @@ dao_input(void)
     return;
   }
 
-  lifetime = dag->default_lifetime;
-
   flags = buffer[pos++];
   /* reserved */
   pos++;
@@ -538,57 +791,11 @@ dao_input(void)
     pos += 16;
   }
 
-  /* Check if there are any RPL options present. */
-  i = pos;
-  for(; i < buffer_length; i += len) {
-    subopt_type = buffer[i];
-    if(subopt_type == RPL_OPTION_PAD1) {
-      len = 1;
-    } else {
-      /* The option consists of a two-byte header and a payload. */
-      len = 2 + buffer[i + 1];
-    }
-
-    switch(subopt_type) {
-    case RPL_OPTION_TARGET:
-      /* handle the target option */
-      prefixlen = buffer[i + 3];
-      memset(&prefix, 0, sizeof(prefix));
-      memcpy(&prefix, buffer + i + 4, (prefixlen + 7) / CHAR_BIT);
-      break;
-    case RPL_OPTION_TRANSIT:
-      /* The path sequence and control are ignored. */
-      pathcontrol = buffer[i + 3];
-      pathsequence = buffer[i + 4];
-      lifetime = buffer[i + 5];
-      /* The parent address is also ignored. */
-      break;
-    }
-  }
-
-  PRINTF("RPL: DAO lifetime: %u, prefix length: %u prefix: ",
-         (unsigned)lifetime, (unsigned)prefixlen);
-  PRINT6ADDR(&prefix);
-  PRINTF("\n");
-
-  rep = uip_ds6_route_lookup(&prefix);
-
-  if(lifetime == ZERO_LIFETIME) {
-    /* No-Path DAO received; invoke the route purging routine. */
-    if(rep != NULL && rep->state.saved_lifetime == 0) {
-      PRINTF("RPL: Setting expiration timer for prefix ");
-      PRINT6ADDR(&prefix);
-      PRINTF("\n");
-      rep->state.saved_lifetime = rep->state.lifetime;
-      rep->state.lifetime = DAO_EXPIRATION_TIMEOUT;
-    }
-    return;
-  }
-
   learned_from = uip_is_addr_mcast(&dao_sender_addr) ?
                  RPL_ROUTE_FROM_MULTICAST_DAO : RPL_ROUTE_FROM_UNICAST_DAO;
 
-  if(learned_from == RPL_ROUTE_FROM_UNICAST_DAO) {
+  if(dag->mop != RPL_MOP_NON_STORING &&
+     learned_from == RPL_ROUTE_FROM_UNICAST_DAO) {
     /* Check whether this is a DAO forwarding loop. */
     p = rpl_find_parent(dag, &dao_sender_addr);
     if(p != NULL && DAG_RANK(p->rank, dag) < DAG_RANK(dag->rank, dag)) {
@@ -600,29 +807,142 @@ dao_input(void)
     }
   }
 
-  if(rep == NULL) {
-    rep = rpl_add_route(dag, &prefix, prefixlen, &dao_sender_addr);
-    if(rep == NULL) {
-      RPL_STAT(rpl_stats.mem_overflows++);
-      PRINTF("RPL: Could not add a route after receiving a DAO\n");
-      return;
+  /* A DAO may carry several targets. A Transit Information option
+     applies to the Target options that precede it; targets that no
+     Transit Information option follows get the default lifetime. */
+  accepted = 1;
+  forward = 0;
+  queued = 0;
+  target_pos = -1;
+  for(i = pos; i <= buffer_length; i += len) {
+    if(i == buffer_length) {
+      if(target_pos < 0) {
+        break;
+      }
+      /* Targets at the end of the message. */
+      subopt_type = RPL_OPTION_TRANSIT;
+      len = 0;
+      lifetime = dag->default_lifetime;
+#if RPL_WITH_NON_STORING
+      has_parent = 0;
+#endif /* RPL_WITH_NON_STORING */
+    } else {
+      subopt_type = buffer[i];
+      if(subopt_type == RPL_OPTION_PAD1) {
+        len = 1;
+      } else {
+        /* The option consists of a two-byte header and a payload. */
+        len = 2 + buffer[i + 1];
+      }
+      if(subopt_type == RPL_OPTION_TARGET && target_pos < 0) {
+        target_pos = i;
+      }
+      if(subopt_type != RPL_OPTION_TRANSIT) {
+        continue;
+      }
+      /* The path sequence and control are ignored. */
+      lifetime = buffer[i + 5];
+#if RPL_WITH_NON_STORING
+      /* The parent address is only used by the root in non-storing
+         mode. */
+      has_parent = 0;
+      if(len >= 22) {
+        memcpy(&parent, buffer + i + 6, 16);
+        has_parent = 1;
+      }
+#endif /* RPL_WITH_NON_STORING */
+    }
+
+    /* Handle the targets that this transit information applies to. */
+    for(j = target_pos; j >= 0 && j < i;
+        j += buffer[j] == RPL_OPTION_PAD1 ? 1 : 2 + buffer[j + 1]) {
+      if(buffer[j] != RPL_OPTION_TARGET) {
+        continue;
+      }
+      prefixlen = buffer[j + 3];
+      memset(&prefix, 0, sizeof(prefix));
+      memcpy(&prefix, buffer + j + 4, (prefixlen + 7) / CHAR_BIT);
+
+#if RPL_WITH_NON_STORING
+      if(dag->mop == RPL_MOP_NON_STORING) {
+        /* DAOs are addressed to the root, which is the only node that
+           keeps the links. Other nodes just forward them. */
+        if(dag->rank == ROOT_RANK(dag) && has_parent) {
+          rpl_ns_update_node(dag, &prefix, &parent,
+                             lifetime == ZERO_LIFETIME ? 0 :
+                             RPL_LIFETIME(dag, lifetime));
+        } else {
+          accepted = 0;
+        }
+        continue;
+      }
+#endif /* RPL_WITH_NON_STORING */
+
+      if(!dao_target_input(dag, &dao_sender_addr, learned_from,
+                           &prefix, prefixlen, lifetime)) {
+        accepted = 0;
+        continue;
+      }
+      if(lifetime != ZERO_LIFETIME) {
+        forward++;
+#if RPL_DAO_AGGREGATION
+        if(learned_from == RPL_ROUTE_FROM_UNICAST_DAO &&
+           dag->preferred_parent != NULL &&
+           dao_agg_add(dag, &prefix, prefixlen, lifetime)) {
+          queued++;
+        }
+#endif /* RPL_DAO_AGGREGATION */
+      }
     }
+    target_pos = -1;
   }
 
-  rep->state.lifetime = RPL_LIFETIME(dag, lifetime);
-  rep->state.learned_from = learned_from;
+#if RPL_WITH_NON_STORING
+  if(dag->mop == RPL_MOP_NON_STORING) {
+    if(accepted && (flags & RPL_DAO_K_FLAG)) {
+      dao_ack_output(dag, &dao_sender_addr, sequence);
+    }
+    return;
+  }
+#endif /* RPL_WITH_NON_STORING */
 
-  if(learned_from == RPL_ROUTE_FROM_UNICAST_DAO) {
-    if(dag->preferred_parent) {
-      PRINTF("RPL: Forwarding DAO to parent ");
-      PRINT6ADDR(&dag->preferred_parent->addr);
-      PRINTF("\n");
-      uip_icmp6_send(&dag->preferred_parent->addr,
-                     ICMP6_RPL, RPL_CODE_DAO, buffer_length);
-    } else if(flags & RPL_DAO_K_FLAG) {
+  if(learned_from != RPL_ROUTE_FROM_UNICAST_DAO) {
+    return;
+  }
+
+  if(dag->preferred_parent == NULL) {
+    if(accepted && (flags & RPL_DAO_K_FLAG)) {
       dao_ack_output(dag, &dao_sender_addr, sequence);
     }
+    return;
   }
+
+#if RPL_DAO_AGGREGATION
+  dao_agg_done(queued < forward);
+#endif /* RPL_DAO_AGGREGATION */
+
+  if(queued < forward) {
+    /* Some targets could not be held back: forward the DAO as is,
+       with the targets that were. */
+    rpl_get_parent_ipaddr(dag->preferred_parent, &parent_addr);
+    PRINTF("RPL: Forwarding DAO to parent ");
+    PRINT6ADDR(&parent_addr);
+    PRINTF("\n");
+    RPL_STAT(rpl_stats.dao_out++);
+    uip_icmp6_send(&parent_addr, ICMP6_RPL, RPL_CODE_DAO, buffer_length);
+  }
+
+#if RPL_DAO_AGGREGATION
+  /* The targets are now ours to advertise, so the child gets its
+     acknowledgment from us rather than from the root. */
+  if(accepted && (flags & RPL_DAO_K_FLAG)) {
+    dao_ack_output(dag, &dao_sender_addr, sequence);
+  }
+
+  if(dao_agg_count == RPL_DAO_AGGREGATION_TARGETS) {
+    dao_agg_flush(NULL);
+  }
+#endif /* RPL_DAO_AGGREGATION */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -630,7 +950,6 @@ dao_output(rpl_parent_t *n, rpl_lifetime_t lifetime)
 {
   rpl_dag_t *dag;
   unsigned char *buffer;
-  uint8_t prefixlen;
   uip_ipaddr_t addr;
   uip_ipaddr_t prefix;
   int pos;
@@ -651,32 +970,23 @@ dao_output(rpl_parent_t *n, rpl_lifetime_t lifetime)
     dag = n->dag;
   }
 
-  buffer = UIP_ICMP_PAYLOAD;
+#if RPL_WITH_NON_STORING
+  if(dag->mop == RPL_MOP_NON_STORING && n == NULL) {
+    PRINTF("RPL: No parent to report in a non-storing mode DAO\n");
+    return;
+  }
+#endif /* RPL_WITH_NON_STORING */
 
-  ++dao_sequence;
-  pos = 0;
+  buffer = UIP_ICMP_PAYLOAD;
 
-  buffer[pos++] = dag->instance_id;
-#if RPL_CONF_DAO_ACK
-  buffer[pos++] = RPL_DAO_K_FLAG; /* DAO ACK request, no DODAGID */
-#else
-  buffer[pos++] = 0; /* No DAO ACK request, no DODAGID */
-#endif
-  buffer[pos++] = 0; /* reserved */
-  buffer[pos++] = dao_sequence & 0xff;
+  pos = dao_add_header(buffer, dag);
 
   /* create target subopt */
-  prefixlen = sizeof(prefix) * CHAR_BIT;
-  buffer[pos++] = RPL_OPTION_TARGET;
-  buffer[pos++] = 2 + ((prefixlen + 7) / CHAR_BIT);
-  buffer[pos++] = 0; /* reserved */
-  buffer[pos++] = prefixlen;
-  memcpy(buffer + pos, &prefix, (prefixlen + 7) / CHAR_BIT);
-  pos += ((prefixlen + 7) / CHAR_BIT);
+  pos = dao_add_target(buffer, pos, &prefix, sizeof(prefix) * CHAR_BIT);
 
   /* Create a transit information sub-option. */
   buffer[pos++] = RPL_OPTION_TRANSIT;
-  buffer[pos++] = 4;
+  buffer[pos++] = dag->mop == RPL_MOP_NON_STORING ? 20 : 4;
   buffer[pos++] = 0; /* flags - ignored */
   buffer[pos++] = 0; /* path control - ignored */
   buffer[pos++] = 0; /* path seq - ignored */
@@ -685,19 +995,31 @@ dao_output(rpl_parent_t *n, rpl_lifetime_t lifetime)
   if(n == NULL) {
     uip_create_linklocal_rplnodes_mcast(&addr);
   } else {
-    uip_ipaddr_copy(&addr, &n->addr);
+    rpl_get_parent_ipaddr(n, &addr);
+  }
+
+#if RPL_WITH_NON_STORING
+  if(dag->mop == RPL_MOP_NON_STORING) {
+    /* Tell the root which parent we use. The parent is known by its
+       link-local address, its global address has our prefix. */
+    memcpy(buffer + pos, &prefix, 8);
+    memcpy(buffer + pos + 8, &addr.u8[8], 8);
+    pos += 16;
+    uip_ipaddr_copy(&addr, &dag->dag_id);
   }
+#endif /* RPL_WITH_NON_STORING */
 
   PRINTF("RPL: Sending DAO with prefix ");
   PRINT6ADDR(&prefix);
   PRINTF(" to ");
   if(n != NULL) {
-    PRINT6ADDR(&n->addr);
+    PRINTLLADDR((uip_lladdr_t *)rpl_get_parent_lladdr(n));
   } else {
     PRINTF("multicast address");
   }
   PRINTF("\n");
 
+  RPL_STAT(rpl_stats.dao_out++);
   uip_icmp6_send(&addr, ICMP6_RPL, RPL_CODE_DAO, pos);
 }
 /*---------------------------------------------------------------------------*/
@@ -41,35 +41,37 @@
  *         transmissions (ETX) as the additive routing metric,
  *         and also provides stubs for the energy metric.
  *
+ *         Unlike rpl-of-etx.c, which implements the same OCP, the
+ *         rank keeps the fractional part of the link ETX, and the
+ *         metric container may be left out (RPL_DAG_MC_NONE), in
+ *         which case the path cost is derived from the rank.
+ *
  * \author Joakim Eriksson <joakime@sics.se>, Nicolas Tsiftes <nvt@sics.se>
  */
 
 #include "net/rpl/rpl-private.h"
-#include "net/nbr-table.h"
+#include "net/neighbor-info.h"
 
 #define DEBUG DEBUG_NONE
 #include "net/uip-debug.h"
 
 static void reset(rpl_dag_t *);
-static void neighbor_link_callback(rpl_parent_t *, int, int);
+static void parent_state_callback(rpl_parent_t *, int, int);
 static rpl_parent_t *best_parent(rpl_parent_t *, rpl_parent_t *);
-static rpl_dag_t *best_dag(rpl_dag_t *, rpl_dag_t *);
 static rpl_rank_t calculate_rank(rpl_parent_t *, rpl_rank_t);
-static void update_metric_container(rpl_instance_t *);
+static void update_metric_container(rpl_dag_t *);
 
 rpl_of_t rpl_mrhof = {
   reset,
-  neighbor_link_callback,
+  parent_state_callback,
   best_parent,
-  best_dag,
   calculate_rank,
   update_metric_container,
   1
 };
 
-/* Constants for the ETX moving average */
-#define ETX_SCALE   100
-#define ETX_ALPHA   90
+#define NI_ETX_TO_RPL_ETX(etx)						\
+	((etx) * (RPL_DAG_MC_ETX_DIVISOR / NEIGHBOR_INFO_ETX_DIVISOR))
 
 /* Reject parents that have a higher link metric than the following. */
 #define MAX_LINK_METRIC			10
@@ -85,76 +87,74 @@ rpl_of_t rpl_mrhof = {
 
 typedef uint16_t rpl_path_metric_t;
 
+/* The path cost that the parent advertises, in units of
+   1/RPL_DAG_MC_ETX_DIVISOR. */
+static uint32_t
+parent_path_cost(rpl_parent_t *p)
+{
+  switch(p->mc.type) {
+  case RPL_DAG_MC_ETX:
+    return p->mc.obj.etx;
+  case RPL_DAG_MC_ENERGY:
+    return (uint32_t)p->mc.obj.energy.energy_est * RPL_DAG_MC_ETX_DIVISOR;
+  default:
+    /* No metric container: each hop adds its ETX times the minimum
+       rank increase to the rank. */
+    if(p->rank <= ROOT_RANK(p->dag)) {
+      return 0;
+    }
+    return (uint32_t)(p->rank - ROOT_RANK(p->dag)) *
+      RPL_DAG_MC_ETX_DIVISOR / p->dag->min_hoprankinc;
+  }
+}
+
 static rpl_path_metric_t
 calculate_path_metric(rpl_parent_t *p)
 {
-  if(p == NULL) {
+  uint32_t cost;
+
+  if(p == NULL || p->rank == INFINITE_RANK ||
+     (p->mc.type == RPL_DAG_MC_ETX && p->mc.obj.etx == 0 &&
+      p->rank > ROOT_RANK(p->dag))) {
     return MAX_PATH_COST * RPL_DAG_MC_ETX_DIVISOR;
   }
 
-#if RPL_DAG_MC == RPL_DAG_MC_NONE
-  return p->rank + (uint16_t)p->link_metric;
-#elif RPL_DAG_MC == RPL_DAG_MC_ETX
-  return p->mc.obj.etx + (uint16_t)p->link_metric;
-#elif RPL_DAG_MC == RPL_DAG_MC_ENERGY
-  return p->mc.obj.energy.energy_est + (uint16_t)p->link_metric;
-#else
-#error "Unsupported RPL_DAG_MC configured. See rpl.h."
-#endif /* RPL_DAG_MC */
+  cost = parent_path_cost(p) + NI_ETX_TO_RPL_ETX(p->link_metric);
+  if(cost > MAX_PATH_COST * RPL_DAG_MC_ETX_DIVISOR) {
+    return MAX_PATH_COST * RPL_DAG_MC_ETX_DIVISOR;
+  }
+  return cost;
 }
 
 static void
-reset(rpl_dag_t *sag)
+reset(rpl_dag_t *dag)
 {
   PRINTF("RPL: Reset MRHOF\n");
 }
 
 static void
-neighbor_link_callback(rpl_parent_t *p, int status, int numtx)
+parent_state_callback(rpl_parent_t *parent, int known, int etx)
 {
-  uint16_t recorded_etx = p->link_metric;
-  uint16_t packet_etx = numtx * RPL_DAG_MC_ETX_DIVISOR;
-  uint16_t new_etx;
-  printf("recorded etx %d\n", recorded_etx);
-  printf("packet etx %d\n", packet_etx);
-  //printf("new etx %d\n", new_etx);
-  printf("link metric. %d\n",p->link_metric);
-  printf("status %d\n",status);
-  /* Do not penalize the ETX when collisions or transmission errors occur. */
-  if(status == MAC_TX_OK || status == MAC_TX_NOACK) {
-    if(status == MAC_TX_NOACK) {
-      packet_etx = MAX_LINK_METRIC * RPL_DAG_MC_ETX_DIVISOR;
-      printf("packet etx......... %d %d\n", packet_etx, MAX_LINK_METRIC);
-      printf("status %d\n",status);
-    }
-
-    new_etx = ((uint32_t)recorded_etx * ETX_ALPHA +
-               (uint32_t)packet_etx * (ETX_SCALE - ETX_ALPHA)) / ETX_SCALE;
-
-    printf("RPL: ETX changed from %u to %u (packet ETX = %u)\n",
-        (unsigned)(recorded_etx / RPL_DAG_MC_ETX_DIVISOR),
-        (unsigned)(new_etx  / RPL_DAG_MC_ETX_DIVISOR),
-        (unsigned)(packet_etx / RPL_DAG_MC_ETX_DIVISOR));
-    p->link_metric = new_etx;
-    printf("recorded etx %d\n", recorded_etx);
-    printf("packet etx %d\n", packet_etx);
-    printf("new etx %d\n", new_etx);
-  }
+  /* The link ETX is averaged by neighbor-info, and rpl.c has already
+     stored it in parent->link_metric. */
 }
 
 static rpl_rank_t
 calculate_rank(rpl_parent_t *p, rpl_rank_t base_rank)
 {
   rpl_rank_t new_rank;
-  rpl_rank_t rank_increase;
+  uint32_t rank_increase;
 
   if(p == NULL) {
     if(base_rank == 0) {
       return INFINITE_RANK;
     }
-    rank_increase = RPL_INIT_LINK_METRIC * RPL_DAG_MC_ETX_DIVISOR;
+    rank_increase = NEIGHBOR_INFO_FIX2ETX(INITIAL_LINK_METRIC) * DEFAULT_MIN_HOPRANKINC;
   } else {
-    rank_increase = p->link_metric;
+    /* The link ETX with its fractional part, times the minimum rank
+       increase. */
+    rank_increase = (uint32_t)p->link_metric * p->dag->min_hoprankinc /
+      NEIGHBOR_INFO_ETX_DIVISOR;
     if(base_rank == 0) {
       base_rank = p->rank;
     }
@@ -172,20 +172,6 @@ calculate_rank(rpl_parent_t *p, rpl_rank_t base_rank)
   return new_rank;
 }
 
-static rpl_dag_t *
-best_dag(rpl_dag_t *d1, rpl_dag_t *d2)
-{
-  if(d1->grounded != d2->grounded) {
-    return d1->grounded ? d1 : d2;
-  }
-
-  if(d1->preference != d2->preference) {
-    return d1->preference > d2->preference ? d1 : d2;
-  }
-
-  return d1->rank < d2->rank ? d1 : d2;
-}
-
 static rpl_parent_t *
 best_parent(rpl_parent_t *p1, rpl_parent_t *p2)
 {
@@ -219,57 +205,53 @@ best_parent(rpl_parent_t *p1, rpl_parent_t *p2)
 
 #if RPL_DAG_MC == RPL_DAG_MC_NONE
 static void
-update_metric_container(rpl_instance_t *instance)
+update_metric_container(rpl_dag_t *dag)
 {
-  instance->mc.type = RPL_DAG_MC;
+  dag->mc.type = RPL_DAG_MC_NONE;
 }
 #else
 static void
-update_metric_container(rpl_instance_t *instance)
+update_metric_container(rpl_dag_t *dag)
 {
   rpl_path_metric_t path_metric;
-  rpl_dag_t *dag;
 #if RPL_DAG_MC == RPL_DAG_MC_ENERGY
   uint8_t type;
 #endif
 
-  instance->mc.type = RPL_DAG_MC;
-  instance->mc.flags = RPL_DAG_MC_FLAG_P;
-  instance->mc.aggr = RPL_DAG_MC_AGGR_ADDITIVE;
-  instance->mc.prec = 0;
+  dag->mc.type = RPL_DAG_MC;
+  dag->mc.flags = RPL_DAG_MC_FLAG_P;
+  dag->mc.aggr = RPL_DAG_MC_AGGR_ADDITIVE;
+  dag->mc.prec = 0;
 
-  dag = instance->current_dag;
-
-  if (!dag->joined) {
-    PRINTF("RPL: Cannot update the metric container when not joined\n");
-    return;
-  }
-
-  if(dag->rank == ROOT_RANK(instance)) {
+  if(dag->rank == ROOT_RANK(dag)) {
     path_metric = 0;
   } else {
     path_metric = calculate_path_metric(dag->preferred_parent);
   }
 
 #if RPL_DAG_MC == RPL_DAG_MC_ETX
-  instance->mc.length = sizeof(instance->mc.obj.etx);
-  instance->mc.obj.etx = path_metric;
+  dag->mc.length = sizeof(dag->mc.obj.etx);
+  dag->mc.obj.etx = path_metric;
 
-  printf("RPL: My path ETX to the root is %u.%u\n",
-	instance->mc.obj.etx / RPL_DAG_MC_ETX_DIVISOR,
-	(instance->mc.obj.etx % RPL_DAG_MC_ETX_DIVISOR * 100) /
+  PRINTF("RPL: My path ETX to the root is %u.%u\n",
+	dag->mc.obj.etx / RPL_DAG_MC_ETX_DIVISOR,
+	(dag->mc.obj.etx % RPL_DAG_MC_ETX_DIVISOR * 100) /
 	 RPL_DAG_MC_ETX_DIVISOR);
 #elif RPL_DAG_MC == RPL_DAG_MC_ENERGY
-  instance->mc.length = sizeof(instance->mc.obj.energy);
+  dag->mc.length = sizeof(dag->mc.obj.energy);
 
-  if(dag->rank == ROOT_RANK(instance)) {
+  if(dag->rank == ROOT_RANK(dag)) {
     type = RPL_DAG_MC_ENERGY_TYPE_MAINS;
   } else {
     type = RPL_DAG_MC_ENERGY_TYPE_BATTERY;
   }
 
-  instance->mc.obj.energy.flags = type << RPL_DAG_MC_ENERGY_TYPE;
-  instance->mc.obj.energy.energy_est = path_metric;
+  /* The path cost in whole transmissions, which fits in the 8-bit
+     estimate as it is at most MAX_PATH_COST. */
+  dag->mc.obj.energy.flags = type << RPL_DAG_MC_ENERGY_TYPE;
+  dag->mc.obj.energy.energy_est = path_metric / RPL_DAG_MC_ETX_DIVISOR;
+#else
+#error "Unsupported RPL_DAG_MC configured. See rpl.h."
 #endif /* RPL_DAG_MC == RPL_DAG_MC_ETX */
 }
 #endif /* RPL_DAG_MC == RPL_DAG_MC_NONE */
@@ -0,0 +1,238 @@
+/**
+ * \addtogroup uip6
+ * @{
+ */
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+/**
+ * \file
+ *         RPL non-storing mode: the DODAG as seen by the root.
+ *
+ *         In non-storing mode, nodes do not keep routes to their
+ *         descendants. Each node instead reports its preferred parent
+ *         to the root in a DAO, and the root keeps the resulting
+ *         child-parent links. Downward packets are source routed
+ *         along the links (see rpl-srh.c), so only the root needs
+ *         memory proportional to the size of the network.
+ *
+ * \author agent <agent@local>
+ */
+
+#include "net/rpl/rpl-private.h"
+
+#include <string.h>
+
+#define DEBUG DEBUG_NONE
+#include "net/uip-debug.h"
+
+#if RPL_WITH_NON_STORING
+
+static rpl_ns_node_t nodes[RPL_NS_LINK_NUM];
+
+/* The parent of the children of the root. */
+static rpl_ns_node_t root_node;
+/************************************************************************/
+static int
+is_root_addr(rpl_dag_t *dag, uip_ipaddr_t *addr)
+{
+  return uip_ipaddr_cmp(addr, &dag->dag_id) || uip_ds6_is_my_addr(addr);
+}
+/************************************************************************/
+static void
+free_node(rpl_ns_node_t *node)
+{
+  int i;
+
+  PRINTF("RPL: NS removing node ");
+  PRINT6ADDR(&node->addr);
+  PRINTF("\n");
+
+  /* The children of the node are now cut off from the root until
+     they send a new DAO. */
+  for(i = 0; i < RPL_NS_LINK_NUM; i++) {
+    if(nodes[i].parent == node) {
+      nodes[i].parent = NULL;
+    }
+  }
+  node->dag = NULL;
+  node->parent = NULL;
+}
+/************************************************************************/
+rpl_ns_node_t *
+rpl_ns_get_node(rpl_dag_t *dag, uip_ipaddr_t *addr)
+{
+  int i;
+
+  for(i = 0; i < RPL_NS_LINK_NUM; i++) {
+    if(nodes[i].dag == dag && uip_ipaddr_cmp(&nodes[i].addr, addr)) {
+      return &nodes[i];
+    }
+  }
+  return NULL;
+}
+/************************************************************************/
+static rpl_ns_node_t *
+alloc_node(rpl_dag_t *dag, uip_ipaddr_t *addr)
+{
+  rpl_ns_node_t *node;
+  int i;
+
+  node = rpl_ns_get_node(dag, addr);
+  if(node != NULL) {
+    return node;
+  }
+  for(i = 0; i < RPL_NS_LINK_NUM; i++) {
+    if(nodes[i].dag == NULL) {
+      node = &nodes[i];
+      node->dag = dag;
+      node->parent = NULL;
+      node->lifetime = 0;
+      uip_ipaddr_copy(&node->addr, addr);
+      return node;
+    }
+  }
+  RPL_STAT(rpl_stats.mem_overflows++);
+  PRINTF("RPL: NS no space for more nodes\n");
+  return NULL;
+}
+/************************************************************************/
+int
+rpl_ns_update_node(rpl_dag_t *dag, uip_ipaddr_t *child, uip_ipaddr_t *parent,
+                   uint32_t lifetime)
+{
+  rpl_ns_node_t *child_node;
+  rpl_ns_node_t *parent_node;
+
+  PRINTF("RPL: NS link ");
+  PRINT6ADDR(child);
+  PRINTF(" -> ");
+  PRINT6ADDR(parent);
+  PRINTF(" lifetime %lu\n", (unsigned long)lifetime);
+
+  child_node = rpl_ns_get_node(dag, child);
+
+  if(lifetime == 0) {
+    /* A No-Path DAO for the link. The node may already have reported
+       a new parent, in which case the link is gone already. */
+    if(child_node != NULL && child_node->parent != NULL &&
+       (child_node->parent == &root_node ?
+        is_root_addr(dag, parent) :
+        uip_ipaddr_cmp(&child_node->parent->addr, parent))) {
+      child_node->parent = NULL;
+      child_node->lifetime = DAO_EXPIRATION_TIMEOUT;
+    }
+    return 1;
+  }
+
+  if(child_node == NULL) {
+    child_node = alloc_node(dag, child);
+    if(child_node == NULL) {
+      return 0;
+    }
+  }
+
+  if(is_root_addr(dag, parent)) {
+    parent_node = &root_node;
+  } else {
+    /* We may hear from a node before we hear from its parent. The
+       parent gets an entry that expires unless the parent reports
+       its own link in time. */
+    parent_node = alloc_node(dag, parent);
+    if(parent_node == NULL) {
+      return 0;
+    }
+    if(parent_node->lifetime == 0) {
+      parent_node->lifetime = DAO_EXPIRATION_TIMEOUT;
+    }
+  }
+
+  child_node->parent = parent_node;
+  child_node->lifetime = lifetime;
+  return 1;
+}
+/************************************************************************/
+int
+rpl_ns_get_path(rpl_dag_t *dag, uip_ipaddr_t *dest,
+                rpl_ns_node_t **path, int max)
+{
+  rpl_ns_node_t *node;
+  int hops;
+
+  node = rpl_ns_get_node(dag, dest);
+  for(hops = 0; node != NULL && node != &root_node; hops++) {
+    if(hops == max) {
+      /* Either the path is too long or the links form a loop. */
+      PRINTF("RPL: NS no path to ");
+      PRINT6ADDR(dest);
+      PRINTF(" within %d hops\n", max);
+      return 0;
+    }
+    path[hops] = node;
+    node = node->parent;
+  }
+  if(node == NULL) {
+    return 0;
+  }
+  return hops;
+}
+/************************************************************************/
+void
+rpl_ns_periodic(void)
+{
+  int i;
+
+  for(i = 0; i < RPL_NS_LINK_NUM; i++) {
+    if(nodes[i].dag != NULL) {
+      if(nodes[i].lifetime <= 1) {
+        free_node(&nodes[i]);
+      } else {
+        nodes[i].lifetime--;
+      }
+    }
+  }
+}
+/************************************************************************/
+void
+rpl_ns_free_all(rpl_dag_t *dag)
+{
+  int i;
+
+  for(i = 0; i < RPL_NS_LINK_NUM; i++) {
+    if(nodes[i].dag == dag) {
+      free_node(&nodes[i]);
+    }
+  }
+}
+/************************************************************************/
+#endif /* RPL_WITH_NON_STORING */
+/** @} */
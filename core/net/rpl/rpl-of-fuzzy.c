@@ -0,0 +1,347 @@
+/**
+ * \addtogroup uip6
+ * @{
+ */
+/*
+ * Copyright (c) 2010, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+/**
+ * \file
+ *         The fuzzy logic objective function.
+ *
+ *         Parents whose ranks are close are compared by a quality
+ *         that fuzzify.c computes from the energy that the parent
+ *         advertises and the ETX and hop count of the path through
+ *         it. The rank is computed as in rpl-of-etx.c.
+ *
+ *         This stack carries a single metric object per DIO, which
+ *         here is the energy of the node that sends it. The path ETX
+ *         and the hop count are derived from the rank of the parent,
+ *         and the inputs that it does not measure (throughput, link
+ *         quality level and latency) are given to the rules as 0.
+ *
+ * \author Joakim Eriksson <joakime@sics.se>, Nicolas Tsiftes <nvt@sics.se>
+ * \author Olfa Gaddour <olfa.gaddour@ceslab.org> (fuzzy logic)
+ */
+
+#include "net/rpl/rpl-private.h"
+#include "net/neighbor-info.h"
+#include "net/rplfuzzy/fuzzify.h"
+
+#define DEBUG DEBUG_NONE
+#include "net/uip-debug.h"
+
+/* Keep runtime updates of the rule base across reboots. */
+#ifdef RPL_CONF_FUZZY_SETTINGS
+#define RPL_FUZZY_SETTINGS RPL_CONF_FUZZY_SETTINGS
+#else
+#define RPL_FUZZY_SETTINGS 0
+#endif /* RPL_CONF_FUZZY_SETTINGS */
+
+#if RPL_FUZZY_SETTINGS
+#include "lib/settings.h"
+#define SETTINGS_KEY_RPL_FUZZY TCC('R','F')
+#endif /* RPL_FUZZY_SETTINGS */
+
+static void reset(rpl_dag_t *);
+static void parent_state_callback(rpl_parent_t *, int, int);
+static rpl_parent_t *best_parent(rpl_parent_t *, rpl_parent_t *);
+static rpl_rank_t calculate_rank(rpl_parent_t *, rpl_rank_t);
+static void update_metric_container(rpl_dag_t *);
+
+rpl_of_t rpl_of_fuzzy = {
+  reset,
+  parent_state_callback,
+  best_parent,
+  calculate_rank,
+  update_metric_container,
+  RPL_OCP_FUZZY
+};
+
+#define NI_ETX_TO_RPL_ETX(etx)						\
+	((etx) * (RPL_DAG_MC_ETX_DIVISOR / NEIGHBOR_INFO_ETX_DIVISOR))
+
+/* Parents whose ranks differ by at most this many hops are compared
+   by their fuzzy quality instead. */
+#ifdef RPL_CONF_FUZZY_RANK_HYSTERESIS
+#define RPL_FUZZY_RANK_HYSTERESIS	RPL_CONF_FUZZY_RANK_HYSTERESIS
+#else
+#define RPL_FUZZY_RANK_HYSTERESIS	1
+#endif /* RPL_CONF_FUZZY_RANK_HYSTERESIS */
+
+/* The quality advantage a parent needs over the preferred parent to
+   replace it. */
+#ifdef RPL_CONF_FUZZY_METRIC_HYSTERESIS
+#define RPL_FUZZY_METRIC_HYSTERESIS	RPL_CONF_FUZZY_METRIC_HYSTERESIS
+#else
+#define RPL_FUZZY_METRIC_HYSTERESIS	5
+#endif /* RPL_CONF_FUZZY_METRIC_HYSTERESIS */
+
+typedef uint16_t rpl_path_metric_t;
+
+/* The energy of this node, from 0 (depleted) to ENERGY_MAX. */
+static uint8_t node_energy = ENERGY_MAX;
+static uint8_t rules_loaded;
+
+/* The ETX of the path through the parent, in units of
+   1/RPL_DAG_MC_ETX_DIVISOR. Each hop adds its ETX times the minimum
+   rank increase to the rank. */
+static rpl_path_metric_t
+calculate_etx_path_metric(rpl_parent_t *p)
+{
+  uint32_t etx;
+
+  if(p->rank == INFINITE_RANK) {
+    return 0xffff;
+  }
+  etx = NI_ETX_TO_RPL_ETX(p->link_metric);
+  if(p->rank > ROOT_RANK(p->dag)) {
+    etx += (uint32_t)(p->rank - ROOT_RANK(p->dag)) *
+      RPL_DAG_MC_ETX_DIVISOR / p->dag->min_hoprankinc;
+  }
+  return etx > 0xffff ? 0xffff : etx;
+}
+
+/* The number of hops to the root through the parent. As the ETX of a
+   hop is at least 1, this is an upper bound. */
+static rpl_path_metric_t
+calculate_hopcount_path_metric(rpl_parent_t *p)
+{
+  return DAG_RANK(p->rank, p->dag);
+}
+
+static rpl_path_metric_t
+calculate_energy_metric(rpl_parent_t *p)
+{
+  if(p->mc.type != RPL_DAG_MC_ENERGY) {
+    /* Nothing known: assume the parent is not short of energy. */
+    return ENERGY_MAX;
+  }
+  return p->mc.obj.energy.energy_est;
+}
+
+static rpl_path_metric_t
+calculate_fuzzy_metric(rpl_parent_t *p)
+{
+  return quality(consumption(calculate_energy_metric(p), 0),
+                 qos(reliability(0, calculate_etx_path_metric(p)),
+                     duration(calculate_hopcount_path_metric(p), 0)));
+}
+
+static void
+load_rules(void)
+{
+#if RPL_FUZZY_SETTINGS
+  struct fuzzy_rules stored;
+  settings_length_t size;
+
+  size = sizeof(stored);
+  if(settings_get(SETTINGS_KEY_RPL_FUZZY, 0, (uint8_t *)&stored,
+                  &size) == SETTINGS_STATUS_OK &&
+     size == sizeof(stored) && fuzzy_rules_set(&stored)) {
+    PRINTF("RPL: Using the stored fuzzy rule base\n");
+  }
+#endif /* RPL_FUZZY_SETTINGS */
+  rules_loaded = 1;
+}
+
+static void
+reset(rpl_dag_t *dag)
+{
+}
+
+static void
+parent_state_callback(rpl_parent_t *parent, int known, int etx)
+{
+}
+
+static rpl_rank_t
+calculate_rank(rpl_parent_t *p, rpl_rank_t base_rank)
+{
+  rpl_rank_t new_rank;
+  rpl_rank_t rank_increase;
+
+  if(p == NULL) {
+    if(base_rank == 0) {
+      return INFINITE_RANK;
+    }
+    rank_increase = NEIGHBOR_INFO_FIX2ETX(INITIAL_LINK_METRIC) * DEFAULT_MIN_HOPRANKINC;
+  } else {
+    rank_increase = NEIGHBOR_INFO_FIX2ETX(p->link_metric) * p->dag->min_hoprankinc;
+    if(base_rank == 0) {
+      base_rank = p->rank;
+    }
+  }
+
+  if(INFINITE_RANK - base_rank < rank_increase) {
+    /* Reached the maximum rank. */
+    new_rank = INFINITE_RANK;
+  } else {
+   /* Calculate the rank based on the new rank information from DIO or
+      stored otherwise. */
+    new_rank = base_rank + rank_increase;
+  }
+
+  return new_rank;
+}
+
+static rpl_parent_t *
+best_parent(rpl_parent_t *p1, rpl_parent_t *p2)
+{
+  rpl_dag_t *dag;
+  rpl_rank_t p1_rank;
+  rpl_rank_t p2_rank;
+  rpl_path_metric_t p1_metric;
+  rpl_path_metric_t p2_metric;
+
+  dag = p1->dag; /* Both parents must be in the same DAG. */
+
+  /*
+   * First compare ranks: a clearly lower rank is the best, and the
+   * fuzzy metrics need not be computed at all.
+   */
+  p1_rank = DAG_RANK(p1->rank, dag);
+  p2_rank = DAG_RANK(p2->rank, dag);
+  if(p1_rank + RPL_FUZZY_RANK_HYSTERESIS < p2_rank) {
+    return p1;
+  } else if(p1_rank > p2_rank + RPL_FUZZY_RANK_HYSTERESIS) {
+    return p2;
+  }
+
+  if(!rules_loaded) {
+    load_rules();
+  }
+  p1_metric = calculate_fuzzy_metric(p1);
+  p2_metric = calculate_fuzzy_metric(p2);
+
+  /* Maintain stability of the preferred parent in case of similar
+     qualities: the other parent must be clearly better. */
+  if(p1 == dag->preferred_parent || p2 == dag->preferred_parent) {
+    if(p1_metric < p2_metric + RPL_FUZZY_METRIC_HYSTERESIS &&
+       p2_metric < p1_metric + RPL_FUZZY_METRIC_HYSTERESIS) {
+      PRINTF("RPL: Fuzzy hysteresis: %u and %u\n", p1_metric, p2_metric);
+      return dag->preferred_parent;
+    }
+  }
+
+  /* Ranks are similar so the best is the higher quality. */
+  return p1_metric >= p2_metric ? p1 : p2;
+}
+
+static void
+update_metric_container(rpl_dag_t *dag)
+{
+  uint8_t type;
+
+  /* The energy of this node, which its children weigh against the
+     quality of the path. A root is assumed to be mains powered. */
+  dag->mc.type = RPL_DAG_MC_ENERGY;
+  dag->mc.flags = RPL_DAG_MC_FLAG_P;
+  dag->mc.aggr = RPL_DAG_MC_AGGR_ADDITIVE;
+  dag->mc.prec = 0;
+  dag->mc.length = sizeof(dag->mc.obj.energy);
+
+  if(dag->rank == ROOT_RANK(dag)) {
+    type = RPL_DAG_MC_ENERGY_TYPE_MAINS;
+    dag->mc.obj.energy.energy_est = ENERGY_MAX;
+  } else {
+    type = RPL_DAG_MC_ENERGY_TYPE_BATTERY;
+    dag->mc.obj.energy.energy_est = node_energy;
+  }
+  dag->mc.obj.energy.flags = type << RPL_DAG_MC_ENERGY_TYPE;
+}
+
+/* Make the DAGs that use this OF compare their parents again, and
+   advertise the new state. */
+static void
+rerank(void)
+{
+  rpl_dag_t *dag;
+
+  for(dag = rpl_get_next_dag(NULL); dag != NULL;
+      dag = rpl_get_next_dag(dag)) {
+    if(dag->of != &rpl_of_fuzzy) {
+      continue;
+    }
+    /* An event on the preferred parent makes rpl_select_parent()
+       compare all parents again. */
+    if(dag->preferred_parent != NULL) {
+      rpl_process_parent_event(dag, dag->preferred_parent);
+    }
+  }
+}
+
+void
+rpl_of_fuzzy_set_energy(uint8_t energy)
+{
+  rpl_dag_t *dag;
+
+  if(energy == node_energy) {
+    return;
+  }
+  node_energy = energy;
+  for(dag = rpl_get_next_dag(NULL); dag != NULL;
+      dag = rpl_get_next_dag(dag)) {
+    if(dag->of == &rpl_of_fuzzy) {
+      update_metric_container(dag);
+      rpl_reset_dio_timer(dag, 1);
+    }
+  }
+}
+
+int
+rpl_of_fuzzy_update_rules(const uint8_t *buf, uint16_t len)
+{
+  if(!rules_loaded) {
+    load_rules();
+  }
+  if(!fuzzy_rules_update(buf, len)) {
+    PRINTF("RPL: Rejected a fuzzy rule base update\n");
+    return 0;
+  }
+#if RPL_FUZZY_SETTINGS
+  settings_set(SETTINGS_KEY_RPL_FUZZY, (const uint8_t *)fuzzy_rules_get(),
+               sizeof(struct fuzzy_rules));
+#endif /* RPL_FUZZY_SETTINGS */
+  rerank();
+  return 1;
+}
+
+void
+rpl_of_fuzzy_reset_rules(void)
+{
+  fuzzy_rules_reset();
+#if RPL_FUZZY_SETTINGS
+  settings_delete(SETTINGS_KEY_RPL_FUZZY, 0);
+#endif /* RPL_FUZZY_SETTINGS */
+  rules_loaded = 1;
+  rerank();
+}
@@ -45,6 +45,7 @@
  */
 
 #include "net/rpl/rpl.h"
+#include "net/rpl/rpl-srh.h"
 
 #include "lib/list.h"
 #include "net/uip.h"
@@ -154,6 +155,38 @@
 #define DEFAULT_DIO_REDUNDANCY          10
 #endif
 
+/* The number of consecutive parent events in which the same parent
+   must beat the preferred parent before RPL switches to it. */
+#ifdef RPL_CONF_PARENT_SWITCH_HOLD
+#define RPL_PARENT_SWITCH_HOLD          RPL_CONF_PARENT_SWITCH_HOLD
+#else
+#define RPL_PARENT_SWITCH_HOLD          1
+#endif
+
+/* Aggregation of the DAOs that a storing-mode node forwards: targets
+   learned from children are held for a short window and advertised
+   to the preferred parent together, in DAOs with several targets. */
+#ifdef RPL_CONF_DAO_AGGREGATION
+#define RPL_DAO_AGGREGATION             RPL_CONF_DAO_AGGREGATION
+#else
+#define RPL_DAO_AGGREGATION             1
+#endif
+
+/* How long targets are held before they are forwarded. */
+#ifdef RPL_CONF_DAO_AGGREGATION_WINDOW
+#define RPL_DAO_AGGREGATION_WINDOW      RPL_CONF_DAO_AGGREGATION_WINDOW
+#else
+#define RPL_DAO_AGGREGATION_WINDOW      (CLOCK_SECOND / 2)
+#endif
+
+/* The number of targets that can be held; a full buffer is forwarded
+   at once. */
+#ifdef RPL_CONF_DAO_AGGREGATION_TARGETS
+#define RPL_DAO_AGGREGATION_TARGETS     RPL_CONF_DAO_AGGREGATION_TARGETS
+#else
+#define RPL_DAO_AGGREGATION_TARGETS     8
+#endif
+
 /* Expire DAOs from neighbors that do not respond in this time. (seconds) */
 #define DAO_EXPIRATION_TIMEOUT          60
 /*---------------------------------------------------------------------------*/
@@ -166,16 +199,23 @@
 #define RPL_ROUTE_FROM_MULTICAST_DAO    2
 #define RPL_ROUTE_FROM_DIO              3
 
-/* DAG Mode of Operation */
-#define RPL_MOP_NO_DOWNWARD_ROUTES      0
-#define RPL_MOP_NON_STORING             1
-#define RPL_MOP_STORING_NO_MULTICAST    2
-#define RPL_MOP_STORING_MULTICAST       3
+/* The DAG Mode of Operation, RPL_MOP_*, is in rpl-srh.h. In
+   non-storing mode, the root source routes downward packets. */
+#define RPL_WITH_NON_STORING RPL_SRH
 
-#ifdef  RPL_CONF_MOP
-#define RPL_MOP_DEFAULT                 RPL_CONF_MOP
+/* The number of nodes the root can source route to in non-storing
+   mode. */
+#ifdef RPL_NS_CONF_LINK_NUM
+#define RPL_NS_LINK_NUM                 RPL_NS_CONF_LINK_NUM
 #else
-#define RPL_MOP_DEFAULT                 RPL_MOP_STORING_NO_MULTICAST
+#define RPL_NS_LINK_NUM                 UIP_DS6_ROUTE_NB
+#endif
+
+/* The maximum number of hops in a source route. */
+#ifdef RPL_SRH_CONF_MAX_HOPS
+#define RPL_SRH_MAX_HOPS                RPL_SRH_CONF_MAX_HOPS
+#else
+#define RPL_SRH_MAX_HOPS                16
 #endif
 
 /*
@@ -218,6 +258,16 @@ struct rpl_dio {
 };
 typedef struct rpl_dio rpl_dio_t;
 
+/* A node and its preferred parent, as reported to the root in
+   non-storing mode. */
+struct rpl_ns_node {
+  struct rpl_ns_node *parent;
+  rpl_dag_t *dag;
+  uint32_t lifetime;
+  uip_ipaddr_t addr;
+};
+typedef struct rpl_ns_node rpl_ns_node_t;
+
 #if RPL_CONF_STATS
 /* Statistics for fault management. */
 struct rpl_stats {
@@ -227,6 +277,10 @@ struct rpl_stats {
   uint16_t malformed_msgs;
   uint16_t resets;
   uint16_t parent_switch;
+  uint16_t parent_switch_held;
+  uint16_t dao_in;
+  uint16_t dao_out;
+  uint16_t dao_targets_aggregated;
 };
 typedef struct rpl_stats rpl_stats_t;
 
@@ -256,14 +310,16 @@ void rpl_process_dio(uip_ipaddr_t *, rpl_dio_t *);
 int rpl_process_parent_event(rpl_dag_t *, rpl_parent_t *);
 
 /* DAG object management. */
+void rpl_dag_init(void);
 rpl_dag_t *rpl_alloc_dag(uint8_t);
 void rpl_free_dag(rpl_dag_t *);
 
 /* DAG parent management function. */
 rpl_parent_t *rpl_add_parent(rpl_dag_t *, rpl_dio_t *dio, uip_ipaddr_t *);
 rpl_parent_t *rpl_find_parent(rpl_dag_t *, uip_ipaddr_t *);
+rpl_parent_t *rpl_get_parent(rpl_dag_t *, const rimeaddr_t *);
 int rpl_remove_parent(rpl_dag_t *, rpl_parent_t *);
-rpl_parent_t *rpl_select_parent(rpl_dag_t *dag);
+rpl_parent_t *rpl_select_parent(rpl_dag_t *dag, rpl_parent_t *updated);
 void rpl_recalculate_ranks(void);
 
 /* RPL routing table functions. */
@@ -272,6 +328,15 @@ uip_ds6_route_t *rpl_add_route(rpl_dag_t *dag, uip_ipaddr_t *prefix,
                                int prefix_len, uip_ipaddr_t *next_hop);
 void rpl_purge_routes(void);
 
+/* Non-storing mode links, kept by the root. */
+int rpl_ns_update_node(rpl_dag_t *dag, uip_ipaddr_t *child,
+                       uip_ipaddr_t *parent, uint32_t lifetime);
+rpl_ns_node_t *rpl_ns_get_node(rpl_dag_t *dag, uip_ipaddr_t *addr);
+int rpl_ns_get_path(rpl_dag_t *dag, uip_ipaddr_t *dest,
+                    rpl_ns_node_t **path, int max);
+void rpl_ns_periodic(void);
+void rpl_ns_free_all(rpl_dag_t *dag);
+
 /* Objective function. */
 rpl_of_t *rpl_find_of(rpl_ocp_t);
 
@@ -0,0 +1,282 @@
+/**
+ * \addtogroup uip6
+ * @{
+ */
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+/**
+ * \file
+ *         RPL source routing header (RFC 6554).
+ *
+ *         The root of a non-storing mode DODAG inserts the path to
+ *         the destination, taken from the links in rpl-ns.c, into
+ *         downward packets. The path is carried as the list of
+ *         addresses after the first hop, with the prefix that they
+ *         share with the first hop elided. Each router on the path
+ *         swaps the next address into the destination address and
+ *         forwards the packet to it, without any routing state.
+ *
+ * \author agent <agent@local>
+ */
+
+#include "net/rpl/rpl-private.h"
+#include "net/rpl/rpl-srh.h"
+#include "net/uip-icmp6.h"
+
+#include <string.h>
+
+#define DEBUG DEBUG_NONE
+#include "net/uip-debug.h"
+
+#if RPL_WITH_NON_STORING
+
+#define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define UIP_RH_BUF(off)   ((struct uip_routing_hdr *)&uip_buf[UIP_LLH_LEN + (off)])
+
+/* The fields after the generic routing header. */
+#define SRH_CMPR          4 /* CmprI << 4 | CmprE */
+#define SRH_PAD           5 /* Pad << 4 */
+#define SRH_HDR_LEN       8
+/************************************************************************/
+static void
+set_nexthop(uip_ipaddr_t *nexthop, uip_ipaddr_t *addr)
+{
+  /* Nodes on the path are neighbors of the previous hop. We reach
+     them through their link-local address, which has the same
+     interface identifier. */
+  uip_ip6addr(nexthop, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+  memcpy(&nexthop->u8[8], &addr->u8[8], 8);
+}
+/************************************************************************/
+/* Find the routing header of the packet in uip_buf, which may follow
+   Hop-by-Hop and Destination Options headers. Returns its offset from
+   the start of the IPv6 header, or 0 if there is none. */
+static uint16_t
+find_routing_header(void)
+{
+  uint8_t proto;
+  uint16_t offset;
+
+  proto = UIP_IP_BUF->proto;
+  offset = UIP_IPH_LEN;
+  while(proto == UIP_PROTO_HBHO || proto == UIP_PROTO_DESTO) {
+    if(offset + 2 > uip_len) {
+      return 0;
+    }
+    proto = uip_buf[UIP_LLH_LEN + offset];
+    offset += (uip_buf[UIP_LLH_LEN + offset + 1] << 3) + 8;
+  }
+  if(proto != UIP_PROTO_ROUTING || offset + SRH_HDR_LEN > uip_len) {
+    return 0;
+  }
+  return offset;
+}
+/************************************************************************/
+static uint8_t
+common_prefix(uip_ipaddr_t *a, uip_ipaddr_t *b)
+{
+  uint8_t n;
+
+  /* At least one byte is always carried. */
+  for(n = 0; n < 15 && a->u8[n] == b->u8[n]; n++);
+  return n;
+}
+/************************************************************************/
+int
+rpl_srh_output(uip_ipaddr_t *nexthop)
+{
+  rpl_dag_t *dag;
+  rpl_ns_node_t *path[RPL_SRH_MAX_HOPS];
+  uip_ipaddr_t *first;
+  uint8_t *hdr;
+  uint8_t cmpri, cmpre, pad;
+  uint16_t rh, ext_len, len;
+  int hops, i, pos;
+
+  rh = find_routing_header();
+  if(rh > 0 && UIP_RH_BUF(rh)->routing_type == RPL_RH_TYPE_SRH) {
+    /* Forwarding a source routed packet: the previous hop has put the
+       address of the next hop in the destination address. */
+    set_nexthop(nexthop, &UIP_IP_BUF->destipaddr);
+    return 1;
+  }
+
+  /* path[0] is the destination and path[hops - 1] is a child of the
+     root. Use the first instance we are the non-storing root of that
+     knows the destination. */
+  hops = 0;
+  for(dag = rpl_get_next_dag(NULL); dag != NULL && hops == 0;
+      dag = rpl_get_next_dag(dag)) {
+    if(dag->mop == RPL_MOP_NON_STORING && dag->rank == ROOT_RANK(dag)) {
+      hops = rpl_ns_get_path(dag, &UIP_IP_BUF->destipaddr, path,
+                             RPL_SRH_MAX_HOPS);
+    }
+  }
+  if(hops == 0) {
+    return 0;
+  }
+  if(hops == 1) {
+    /* The destination is one of our children. */
+    set_nexthop(nexthop, &UIP_IP_BUF->destipaddr);
+    return 1;
+  }
+
+  /* The header carries the hops after the first one. All of them
+     share the elided prefix with the first hop, which is in the
+     destination address while the packet travels. */
+  first = &path[hops - 1]->addr;
+  cmpre = common_prefix(first, &path[0]->addr);
+  cmpri = cmpre;
+  for(i = 1; i < hops - 1; i++) {
+    pos = common_prefix(first, &path[i]->addr);
+    if(i == 1 || pos < cmpri) {
+      cmpri = pos;
+    }
+  }
+  ext_len = (hops - 2) * (16 - cmpri) + (16 - cmpre);
+  pad = (8 - (ext_len & 7)) & 7;
+  ext_len += SRH_HDR_LEN + pad;
+
+  if(uip_len + ext_len > UIP_LINK_MTU ||
+     uip_len + ext_len > UIP_BUFSIZE - UIP_LLH_LEN) {
+    PRINTF("RPL: Source routing header does not fit, %u hops\n", hops);
+    return 0;
+  }
+
+  PRINTF("RPL: Inserting a source routing header, %u hops, CmprI %u CmprE %u\n",
+         hops, cmpri, cmpre);
+
+  memmove(&uip_buf[UIP_LLIPH_LEN + ext_len], &uip_buf[UIP_LLIPH_LEN],
+          uip_len - UIP_IPH_LEN);
+
+  hdr = &uip_buf[UIP_LLIPH_LEN];
+  hdr[0] = UIP_IP_BUF->proto;
+  hdr[1] = (ext_len >> 3) - 1;
+  hdr[2] = RPL_RH_TYPE_SRH;
+  hdr[3] = hops - 1;
+  hdr[SRH_CMPR] = (cmpri << 4) | cmpre;
+  hdr[SRH_PAD] = pad << 4;
+  hdr[6] = 0;
+  hdr[7] = 0;
+  pos = SRH_HDR_LEN;
+  for(i = hops - 2; i > 0; i--) {
+    memcpy(&hdr[pos], &path[i]->addr.u8[cmpri], 16 - cmpri);
+    pos += 16 - cmpri;
+  }
+  memcpy(&hdr[pos], &path[0]->addr.u8[cmpre], 16 - cmpre);
+  pos += 16 - cmpre;
+  memset(&hdr[pos], 0, pad);
+
+  UIP_IP_BUF->proto = UIP_PROTO_ROUTING;
+  len = ((uint16_t)UIP_IP_BUF->len[0] << 8) + UIP_IP_BUF->len[1] + ext_len;
+  UIP_IP_BUF->len[0] = len >> 8;
+  UIP_IP_BUF->len[1] = len & 0xff;
+  uip_len += ext_len;
+
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, first);
+  set_nexthop(nexthop, first);
+  return 1;
+}
+/************************************************************************/
+int
+rpl_srh_input(void)
+{
+  uint8_t *hdr;
+  uint8_t *addr;
+  uip_ipaddr_t *dest;
+  uip_ipaddr_t next;
+  uint8_t tmp[16];
+  uint8_t cmpri, cmpre, pad, size;
+  uint16_t len;
+  int n, i, j;
+
+  hdr = &uip_buf[UIP_LLIPH_LEN + uip_ext_len];
+  dest = &UIP_IP_BUF->destipaddr;
+
+  cmpri = hdr[SRH_CMPR] >> 4;
+  cmpre = hdr[SRH_CMPR] & 0x0f;
+  pad = hdr[SRH_PAD] >> 4;
+  len = hdr[1] << 3;
+
+  if(UIP_IPH_LEN + uip_ext_len + SRH_HDR_LEN + len > uip_len ||
+     len < pad + 16 - cmpre) {
+    PRINTF("RPL: Malformed source routing header\n");
+    return 1;
+  }
+
+  /* RFC 6554, section 4.2. */
+  n = (len - pad - (16 - cmpre)) / (16 - cmpri) + 1;
+  if(hdr[3] > n) {
+    uip_icmp6_error_output(ICMP6_PARAM_PROB, ICMP6_PARAMPROB_HEADER,
+                           UIP_IPH_LEN + uip_ext_len + 3);
+    return 2;
+  }
+
+  hdr[3]--;
+  i = n - hdr[3];
+  addr = &hdr[SRH_HDR_LEN + (i - 1) * (16 - cmpri)];
+  size = i < n ? 16 - cmpri : 16 - cmpre;
+
+  memcpy(tmp, addr, size);
+  memcpy(addr, &dest->u8[16 - size], size);
+  memcpy(&dest->u8[16 - size], tmp, size);
+
+  if(uip_is_addr_mcast(dest)) {
+    PRINTF("RPL: Multicast address in source routing header\n");
+    return 1;
+  }
+
+  /* One of our own addresses further down the path means that the
+     path loops back through us. */
+  for(j = i + 1; j <= n; j++) {
+    size = j < n ? 16 - cmpri : 16 - cmpre;
+    uip_ipaddr_copy(&next, dest);
+    memcpy(&next.u8[16 - size], &hdr[SRH_HDR_LEN + (j - 1) * (16 - cmpri)],
+           size);
+    if(uip_ds6_is_my_addr(&next)) {
+      PRINTF("RPL: Loop in source routing header\n");
+      uip_icmp6_error_output(ICMP6_PARAM_PROB, ICMP6_PARAMPROB_HEADER,
+                             UIP_IPH_LEN + uip_ext_len + SRH_HDR_LEN +
+                             (j - 1) * (16 - cmpri));
+      return 2;
+    }
+  }
+
+  PRINTF("RPL: Source routing to ");
+  PRINT6ADDR(dest);
+  PRINTF(", %u segments left\n", hdr[3]);
+  return 0;
+}
+/************************************************************************/
+#endif /* RPL_WITH_NON_STORING */
+/** @} */
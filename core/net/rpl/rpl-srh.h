@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+/**
+ * \file
+ *         RPL source routing header (RFC 6554), used in non-storing
+ *         mode. This is the interface to the IPv6 layer.
+ *
+ * \author agent <agent@local>
+ */
+
+#ifndef RPL_SRH_H
+#define RPL_SRH_H
+
+#include "net/uip.h"
+
+/* The routing type of the RPL source routing header. */
+#define RPL_RH_TYPE_SRH                 3
+
+/* DAG Mode of Operation. This is defined here rather than in
+   rpl-private.h, as uIP has to know whether RPL runs in non-storing
+   mode. */
+#define RPL_MOP_NO_DOWNWARD_ROUTES      0
+#define RPL_MOP_NON_STORING             1
+#define RPL_MOP_STORING_NO_MULTICAST    2
+#define RPL_MOP_STORING_MULTICAST       3
+
+#ifdef  RPL_CONF_MOP
+#define RPL_MOP_DEFAULT                 RPL_CONF_MOP
+#else
+#define RPL_MOP_DEFAULT                 RPL_MOP_STORING_NO_MULTICAST
+#endif
+
+/* Packets are source routed when RPL runs in non-storing mode. */
+#if UIP_CONF_IPV6_RPL && RPL_MOP_DEFAULT == RPL_MOP_NON_STORING
+#define RPL_SRH                         1
+#else
+#define RPL_SRH                         0
+#endif
+
+/**
+ * Find the next hop for the packet in uip_buf, called by
+ * tcpip_ipv6_output() for unicast packets to off-link destinations.
+ *
+ * On the root, a source routing header with the path to the
+ * destination is inserted, and the destination address is set to the
+ * first hop. A packet that already carries a source routing header
+ * is sent to its destination address, which the previous hop has set
+ * to one of our neighbors.
+ *
+ * \return Non-zero if nexthop was set, zero if the packet should be
+ * routed as usual.
+ */
+int rpl_srh_output(uip_ipaddr_t *nexthop);
+
+/**
+ * Process the source routing header at uip_ext_len in uip_buf, on a
+ * router that the packet is addressed to and that is not its final
+ * destination. The next address in the header is swapped into the
+ * destination address.
+ *
+ * \return 0 if the packet should be forwarded, 1 if it should be
+ * silently discarded, and 2 if an ICMPv6 error has been put in
+ * uip_buf instead.
+ */
+int rpl_srh_input(void);
+
+#endif /* RPL_SRH_H */
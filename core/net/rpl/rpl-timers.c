@@ -51,8 +51,6 @@
 static struct ctimer periodic_timer;
 
 static void handle_periodic_timer(void *ptr);
-static void new_dio_interval(rpl_dag_t *dag);
-static void handle_dio_timer(void *ptr);
 
 static uint16_t next_dis;
 
@@ -77,54 +75,15 @@ handle_periodic_timer(void *ptr)
   ctimer_reset(&periodic_timer);
 }
 /************************************************************************/
-static void
-new_dio_interval(rpl_dag_t *dag)
+static clock_time_t
+dio_imin(rpl_dag_t *dag)
 {
-  uint32_t time;
-
-  /* TODO: too small timer intervals for many cases */
-  time = 1UL << dag->dio_intcurrent;
-
-  /* Convert from milliseconds to CLOCK_TICKS. */
-  time = (time * CLOCK_SECOND) / 1000;
-
-  dag->dio_next_delay = time;
-
-  /* random number between I/2 and I */
-  time = time >> 1;
-  time += (time * random_rand()) / RANDOM_RAND_MAX;
-
-  /*
-   * The intervals must be equally long among the nodes for Trickle to
-   * operate efficiently. Therefore we need to calculate the delay between
-   * the randomized time and the start time of the next interval.
-   */
-  dag->dio_next_delay -= time;
-  dag->dio_send = 1;
-
-#if RPL_CONF_STATS
-  /* keep some stats */
-  dag->dio_totint++;
-  dag->dio_totrecv += dag->dio_counter;
-  ANNOTATE("#A rank=%u.%u(%u),stats=%d %d %d %d,color=%s\n",
-	   DAG_RANK(dag->rank, dag),
-           (10 * (dag->rank % dag->min_hoprankinc)) / dag->min_hoprankinc,
-           dag->version,
-           dag->dio_totint, dag->dio_totsend,
-           dag->dio_totrecv,dag->dio_intcurrent,
-	   dag->rank == ROOT_RANK(dag) ? "BLUE" : "ORANGE");
-#endif /* RPL_CONF_STATS */
-
-  /* reset the redundancy counter */
-  dag->dio_counter = 0;
-
-  /* schedule the timer */
-  PRINTF("RPL: Scheduling DIO timer %lu ticks in future (Interval)\n", time);
-  ctimer_set(&dag->dio_timer, time, &handle_dio_timer, dag);
+  /* Imin is 2^dio_intmin milliseconds. */
+  return (clock_time_t)(((1UL << dag->dio_intmin) * CLOCK_SECOND) / 1000);
 }
 /************************************************************************/
 static void
-handle_dio_timer(void *ptr)
+handle_dio_timer(void *ptr, uint8_t suppress)
 {
   rpl_dag_t *dag;
 
@@ -135,34 +94,27 @@ handle_dio_timer(void *ptr)
     if(uip_ds6_get_link_local(ADDR_PREFERRED) != NULL) {
       dio_send_ok = 1;
     } else {
-      PRINTF("RPL: Postponing DIO transmission since link local address is not ok\n");
-      ctimer_set(&dag->dio_timer, CLOCK_SECOND, &handle_dio_timer, dag);
+      PRINTF("RPL: Skipping DIO transmission since link local address is not ok\n");
       return;
     }
   }
 
-  if(dag->dio_send) {
-    /* send DIO if counter is less than desired redundancy */
-    if(dag->dio_counter < dag->dio_redundancy) {
-#if RPL_CONF_STATS
-      dag->dio_totsend++;
-#endif /* RPL_CONF_STATS */
-      dio_output(dag, NULL);
-    } else {
-      PRINTF("RPL: Supressing DIO transmission (%d >= %d)\n",
-             dag->dio_counter, dag->dio_redundancy);
-    }
-    dag->dio_send = 0;
-    PRINTF("RPL: Scheduling DIO timer %u ticks in future (sent)\n",
-           dag->dio_next_delay);
-    ctimer_set(&dag->dio_timer, dag->dio_next_delay, handle_dio_timer, dag);
+#if RPL_CONF_STATS && TRICKLE_TIMER_STATS
+  ANNOTATE("#A rank=%u.%u(%u),stats=%d %d %d %lu,color=%s\n",
+	   DAG_RANK(dag->rank, dag),
+           (10 * (dag->rank % dag->min_hoprankinc)) / dag->min_hoprankinc,
+           dag->version,
+           dag->dio_timer.stats.intervals, dag->dio_timer.stats.tx,
+           dag->dio_timer.stats.consistent,
+           (unsigned long)dag->dio_timer.i_cur,
+	   dag->rank == ROOT_RANK(dag) ? "BLUE" : "ORANGE");
+#endif /* RPL_CONF_STATS && TRICKLE_TIMER_STATS */
+
+  if(suppress == TRICKLE_TIMER_TX_OK) {
+    dio_output(dag, NULL);
   } else {
-    /* check if we need to double interval */
-    if(dag->dio_intcurrent < dag->dio_intmin + dag->dio_intdoubl) {
-      dag->dio_intcurrent++;
-      PRINTF("RPL: DIO Timer interval doubled %d\n", dag->dio_intcurrent);
-    }
-    new_dio_interval(dag);
+    PRINTF("RPL: Supressing DIO transmission (%d >= %d)\n",
+           dag->dio_timer.c, dag->dio_redundancy);
   }
 }
 /************************************************************************/
@@ -177,12 +129,16 @@ rpl_reset_periodic_timer(void)
 void
 rpl_reset_dio_timer(rpl_dag_t *dag, uint8_t force)
 {
-  /* only reset if not just reset or started */
-  if(force || dag->dio_intcurrent > dag->dio_intmin) {
-    dag->dio_counter = 0;
-    dag->dio_intcurrent = dag->dio_intmin;
-    new_dio_interval(dag);
+  if(force) {
+    /* The DAG configuration may have changed the Trickle parameters. */
+    trickle_timer_config(&dag->dio_timer, dio_imin(dag), dag->dio_intdoubl,
+                         dag->dio_redundancy);
+    if(!trickle_timer_is_running(&dag->dio_timer)) {
+      trickle_timer_set(&dag->dio_timer, handle_dio_timer, dag);
+    }
   }
+  /* Trickle ignores the reset if the interval is Imin already. */
+  trickle_timer_reset_event(&dag->dio_timer);
 #if RPL_CONF_STATS
   rpl_stats.resets++;
 #endif
@@ -51,12 +51,21 @@
 #include <limits.h>
 #include <string.h>
 
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
 #if RPL_CONF_STATS
 rpl_stats_t rpl_stats;
 #endif
 
 /************************************************************************/
 extern uip_ds6_route_t uip_ds6_routing_table[UIP_DS6_ROUTE_NB];
+
+/* Traffic classes that are routed upwards on a specific instance. */
+static struct rpl_dscp_map {
+  uint8_t used;
+  uint8_t dscp;
+  uint8_t instance_id;
+} dscp_map[RPL_DSCP_MAP_SIZE];
 /************************************************************************/
 void
 rpl_purge_routes(void)
@@ -72,6 +81,9 @@ rpl_purge_routes(void)
       }
     }
   }
+#if RPL_WITH_NON_STORING
+  rpl_ns_periodic();
+#endif /* RPL_WITH_NON_STORING */
 }
 /************************************************************************/
 void
@@ -84,6 +96,9 @@ rpl_remove_routes(rpl_dag_t *dag)
       uip_ds6_route_rm(&uip_ds6_routing_table[i]);
     }
   }
+#if RPL_WITH_NON_STORING
+  rpl_ns_free_all(dag);
+#endif /* RPL_WITH_NON_STORING */
 }
 /************************************************************************/
 uip_ds6_route_t *
@@ -132,36 +147,36 @@ rpl_link_neighbor_callback(const rimeaddr_t *addr, int known, int etx)
   PRINT6ADDR(&ipaddr);
   PRINTF(" is %sknown. ETX = %u\n", known ? "" : "no longer ", NEIGHBOR_INFO_FIX2ETX(etx));
 
-  dag = rpl_get_dag(RPL_DEFAULT_INSTANCE);
-  if(dag == NULL) {
-    return;
-  }
-
-  parent = rpl_find_parent(dag, &ipaddr);
-  if(parent == NULL) {
-    if(!known) {
-      PRINTF("RPL: Deleting routes installed by DAOs received from ");
-      PRINT6ADDR(&ipaddr);
-      PRINTF("\n");
-      uip_ds6_route_rm_by_nexthop(&ipaddr);
+  /* The neighbor may be a parent in any number of instances. */
+  for(dag = rpl_get_next_dag(NULL); dag != NULL;
+      dag = rpl_get_next_dag(dag)) {
+    parent = rpl_get_parent(dag, addr);
+    if(parent == NULL) {
+      continue;
     }
-    return;
-  }
 
-  /* Trigger DAG rank recalculation. */
-  parent->updated = 1;
+    /* Trigger DAG rank recalculation. */
+    parent->updated = 1;
 
-  parent->link_metric = etx;
+    parent->link_metric = etx;
 
-  if(dag->of->parent_state_callback != NULL) {
-    dag->of->parent_state_callback(parent, known, etx);
+    if(dag->of->parent_state_callback != NULL) {
+      dag->of->parent_state_callback(parent, known, etx);
+    }
+
+    if(!known) {
+      PRINTF("RPL: Removing parent ");
+      PRINT6ADDR(&ipaddr);
+      PRINTF(" because of bad connectivity (ETX %d)\n", etx);
+      parent->rank = INFINITE_RANK;
+    }
   }
 
   if(!known) {
-    PRINTF("RPL: Removing parent ");
-    PRINT6ADDR(&parent->addr);
-    PRINTF(" because of bad connectivity (ETX %d)\n", etx);
-    parent->rank = INFINITE_RANK;
+    PRINTF("RPL: Deleting routes installed by DAOs received from ");
+    PRINT6ADDR(&ipaddr);
+    PRINTF("\n");
+    uip_ds6_route_rm_by_nexthop(&ipaddr);
   }
 }
 /************************************************************************/
@@ -171,29 +186,74 @@ rpl_ipv6_neighbor_callback(uip_ds6_nbr_t *nbr)
   rpl_dag_t *dag;
   rpl_parent_t *p;
 
-  /* This only handles one DODAG - if multiple we need to check all */
-  dag = rpl_get_dag(RPL_ANY_INSTANCE);
-  if(dag == NULL) {
-    return;
+  for(dag = rpl_get_next_dag(NULL); dag != NULL;
+      dag = rpl_get_next_dag(dag)) {
+    /* if this is our default route then clean the dag->def_route state */
+    if(dag->def_route != NULL &&
+       uip_ipaddr_cmp(&dag->def_route->ipaddr, &nbr->ipaddr)) {
+      dag->def_route = NULL;
+    }
+
+    if(!nbr->isused) {
+      PRINTF("RPL: Removing neighbor ");
+      PRINT6ADDR(&nbr->ipaddr);
+      PRINTF("\n");
+      p = rpl_get_parent(dag, (rimeaddr_t *)&nbr->lladdr);
+      if(p != NULL) {
+        p->rank = INFINITE_RANK;
+        /* Trigger DAG rank recalculation. */
+        p->updated = 1;
+      }
+    }
   }
+}
+/************************************************************************/
+int
+rpl_map_dscp(uint8_t dscp, uint8_t instance_id)
+{
+  struct rpl_dscp_map *m, *free;
 
-  /* if this is our default route then clean the dag->def_route state */
-  if(dag->def_route != NULL &&
-     uip_ipaddr_cmp(&dag->def_route->ipaddr, &nbr->ipaddr)) {
-    dag->def_route = NULL;
+  free = NULL;
+  for(m = &dscp_map[0]; m < &dscp_map[RPL_DSCP_MAP_SIZE]; m++) {
+    if(m->used && m->dscp == dscp) {
+      m->instance_id = instance_id;
+      return 1;
+    }
+    if(!m->used && free == NULL) {
+      free = m;
+    }
   }
+  if(free == NULL) {
+    return 0;
+  }
+  free->used = 1;
+  free->dscp = dscp;
+  free->instance_id = instance_id;
+  return 1;
+}
+/************************************************************************/
+int
+rpl_instance_nexthop(uip_ipaddr_t *nexthop)
+{
+  struct rpl_dscp_map *m;
+  rpl_dag_t *dag;
+  uint8_t dscp;
 
-  if(!nbr->isused) {
-    PRINTF("RPL: Removing neighbor ");
-    PRINT6ADDR(&nbr->ipaddr);
-    PRINTF("\n");
-    p = rpl_find_parent(dag, &nbr->ipaddr);
-    if(p != NULL) {
-      p->rank = INFINITE_RANK;
-      /* Trigger DAG rank recalculation. */
-      p->updated = 1;
+  /* The DSCP is the upper six bits of the traffic class, which spans
+     the first two bytes of the header. */
+  dscp = ((UIP_IP_BUF->vtc & 0x0f) << 2) | (UIP_IP_BUF->tcflow >> 6);
+
+  for(m = &dscp_map[0]; m < &dscp_map[RPL_DSCP_MAP_SIZE]; m++) {
+    if(m->used && m->dscp == dscp) {
+      dag = rpl_get_dag(m->instance_id);
+      if(dag != NULL && dag->preferred_parent != NULL) {
+        rpl_get_parent_ipaddr(dag->preferred_parent, nexthop);
+        return 1;
+      }
+      return 0;
     }
   }
+  return 0;
 }
 /************************************************************************/
 void
@@ -202,6 +262,7 @@ rpl_init(void)
   uip_ipaddr_t rplmaddr;
   PRINTF("RPL started\n");
 
+  rpl_dag_init();
   rpl_reset_periodic_timer();
   neighbor_info_subscribe(rpl_link_neighbor_callback);
 
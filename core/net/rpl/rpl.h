@@ -42,7 +42,9 @@
 #include "lib/list.h"
 #include "net/uip.h"
 #include "net/uip-ds6.h"
+#include "net/nbr-table.h"
 #include "sys/ctimer.h"
+#include "lib/trickle-timer.h"
 
 /* set to 1 for some statistics on trickle / DIO */
 #ifndef RPL_CONF_STATS
@@ -72,15 +74,47 @@
 #define RPL_OF rpl_of_etx
 #endif /* RPL_CONF_OF */
 
+/*
+ * The objective functions that DAGs may use, as an initializer for an
+ * array of rpl_of_t pointers. A node joins an instance only if the
+ * objective code point in its DIOs is in this list. RPL_OF must be
+ * included. rpl_of_etx and rpl_mrhof share OCP 1, so at most one of
+ * them can be listed. For instance, {&rpl_mrhof, &rpl_of_fuzzy} with
+ * RPL_CONF_DAG_MC set to RPL_DAG_MC_ENERGY lets a root start an
+ * instance for each with rpl_set_root_of().
+ */
+#ifdef RPL_CONF_SUPPORTED_OFS
+#define RPL_SUPPORTED_OFS RPL_CONF_SUPPORTED_OFS
+#else
+#define RPL_SUPPORTED_OFS {&RPL_OF}
+#endif /* RPL_CONF_SUPPORTED_OFS */
+
+/* The objective code point of the fuzzy logic objective function. */
+#ifdef RPL_CONF_OCP_FUZZY
+#define RPL_OCP_FUZZY RPL_CONF_OCP_FUZZY
+#else
+#define RPL_OCP_FUZZY 99
+#endif /* RPL_CONF_OCP_FUZZY */
+
 /* This value decides which DAG instance we should participate in by default. */
 #define RPL_DEFAULT_INSTANCE		0
 
-/* This value is used to access an arbitrary DAG. It will likely be 
-   replaced when we support multiple DAGs more. */
+/* This value is used to access an arbitrary DAG. With more than one
+   instance, the DAG of the first joined instance is returned. */
 #define RPL_ANY_INSTANCE               -1
+
+/*
+ * The number of traffic classes that can be mapped to an instance
+ * with rpl_map_dscp().
+ */
+#ifdef RPL_CONF_DSCP_MAP_SIZE
+#define RPL_DSCP_MAP_SIZE RPL_CONF_DSCP_MAP_SIZE
+#else
+#define RPL_DSCP_MAP_SIZE 4
+#endif /* RPL_CONF_DSCP_MAP_SIZE */
 /*---------------------------------------------------------------------------*/
 /* The amount of parents that this node has in a particular DAG. */
-#define RPL_PARENT_COUNT(dag)   list_length((dag)->parents)
+#define RPL_PARENT_COUNT(dag)   rpl_parent_count(dag)
 /*---------------------------------------------------------------------------*/
 typedef uint16_t rpl_rank_t;
 typedef uint8_t rpl_lifetime_t;
@@ -141,11 +175,12 @@ typedef struct rpl_metric_container rpl_metric_container_t;
 /*---------------------------------------------------------------------------*/
 struct rpl_dag;
 /*---------------------------------------------------------------------------*/
+/* Parents live in a neighbor table and are keyed by the link-layer
+   address of the neighbor; their link-local IPv6 address is derived
+   from it with rpl_get_parent_ipaddr(). */
 struct rpl_parent {
-  struct rpl_parent *next;
   struct rpl_dag *dag;
   rpl_metric_container_t mc;
-  uip_ipaddr_t addr;
   rpl_rank_t rank;
   uint8_t link_metric;
   uint8_t dtsn;
@@ -193,6 +228,11 @@ struct rpl_of {
   rpl_ocp_t ocp;
 };
 typedef struct rpl_of rpl_of_t;
+
+extern rpl_of_t rpl_of0;
+extern rpl_of_t rpl_of_etx;
+extern rpl_of_t rpl_mrhof;
+extern rpl_of_t rpl_of_fuzzy;
 /*---------------------------------------------------------------------------*/
 /* RPL DIO prefix suboption */
 struct rpl_prefix {
@@ -229,31 +269,60 @@ struct rpl_dag {
   uint16_t lifetime_unit; /* lifetime in seconds = l_u * d_l */
   /* live data for the DAG */
   uint8_t joined;
-  uint8_t dio_intcurrent;
-  uint8_t dio_send; /* for keeping track of which mode the timer is in 
-*/
-  uint8_t dio_counter;
-#if RPL_CONF_STATS
-  uint16_t dio_totint;
-  uint16_t dio_totsend;
-  uint16_t dio_totrecv;
-#endif /* RPL_CONF_STATS */
-  uint32_t dio_next_delay; /* delay for completion of dio interval */
-  struct ctimer dio_timer;
+  struct trickle_timer dio_timer;
   struct ctimer dao_timer;
   rpl_parent_t *preferred_parent;
-  void *parent_list;
-  list_t parents;
+  rpl_parent_t *switch_candidate; /* challenger of the preferred parent */
+  uint8_t switch_wins;
+  nbr_table_t *parents;
   rpl_prefix_t prefix_info;
 };
 typedef struct rpl_dag rpl_dag_t;
 /*---------------------------------------------------------------------------*/
 /* Public RPL functions. */
 void rpl_init(void);
-rpl_dag_t *rpl_set_root(uip_ipaddr_t *);
+rpl_dag_t *rpl_set_root(uint8_t instance_id, uip_ipaddr_t *dag_id);
+rpl_dag_t *rpl_set_root_of(uint8_t instance_id, uip_ipaddr_t *dag_id,
+                           rpl_ocp_t ocp);
 int rpl_set_prefix(rpl_dag_t *dag, uip_ipaddr_t *prefix, int len);
 int rpl_repair_dag(rpl_dag_t *dag);
 int rpl_set_default_route(rpl_dag_t *dag, uip_ipaddr_t *from);
 rpl_dag_t *rpl_get_dag(int instance_id);
+/* The DAG of the next joined instance after dag, or of the first one
+   if dag is NULL. */
+rpl_dag_t *rpl_get_next_dag(rpl_dag_t *dag);
+int rpl_parent_count(rpl_dag_t *dag);
+/* The link-layer address of a parent, which is its key in the
+   neighbor table. */
+rimeaddr_t *rpl_get_parent_lladdr(rpl_parent_t *p);
+/* Put the link-local address of a parent in addr, and return addr. */
+uip_ipaddr_t *rpl_get_parent_ipaddr(rpl_parent_t *p, uip_ipaddr_t *addr);
+/* The rank of the neighbor in the default instance, or INFINITE_RANK
+   if it is not a parent there. */
+rpl_rank_t rpl_get_parent_rank(rimeaddr_t *addr);
+
+/*
+ * Route packets with the given DSCP upwards on an instance, through
+ * that instance's preferred parent instead of the default router.
+ * Returns 0 if the map is full.
+ */
+int rpl_map_dscp(uint8_t dscp, uint8_t instance_id);
+/* Put the address of the preferred parent of the instance that the
+   DSCP of the packet in uip_buf is mapped to in nexthop. Returns 0 if
+   the DSCP is not mapped or the instance has no preferred parent. */
+int rpl_instance_nexthop(uip_ipaddr_t *nexthop);
+
+/*
+ * Replace records of the rule base of the fuzzy objective function
+ * (see net/rplfuzzy/fuzzify.h for the format) and re-rank the parents
+ * with it. Returns 0, leaving the rule base as it was, if any record
+ * is invalid.
+ */
+int rpl_of_fuzzy_update_rules(const uint8_t *buf, uint16_t len);
+/* Go back to the compiled-in rule base. */
+void rpl_of_fuzzy_reset_rules(void);
+/* Set the energy that this node advertises in the instances that use
+   the fuzzy objective function, from 0 (depleted) to 255. */
+void rpl_of_fuzzy_set_energy(uint8_t energy);
 /*---------------------------------------------------------------------------*/
 #endif /* RPL_H */
@@ -6,66 +6,480 @@
  *  Copyright 2014 __MyCompanyName__. All rights reserved.
  *
  */
+#include <stddef.h>
+#include <string.h>
 #include "fuzzify.h"
 
-unsigned short DOWN(unsigned short x1, unsigned short x2, unsigned short X){
-	return (TRUE * ((long)(X) - (long)(x2)))/((long)(x1) - (long)(x2));
+/*
+ * The rule base that all evaluations use. It is only changed as a
+ * whole by fuzzy_rules_update() and fuzzy_rules_set(), which return
+ * before anything else runs, so every rank computation sees either
+ * the old or the new rules.
+ */
+static const struct fuzzy_rules default_rules = {
+  { E_B_1, E_B_2, E_B_3, E_B_4,
+    T_B_1, T_B_2, T_B_3, T_B_4,
+    LQ_B_1, LQ_B_2, LQ_B_3, LQ_B_4,
+    ETX_B_1, ETX_B_2, ETX_B_3, ETX_B_4,
+    H_B_1, H_B_2, H_B_3, H_B_4,
+    L_B_1, L_B_2, L_B_3, L_B_4,
+    O1_B1, O1_B2, O1_B3, O1_B4, O1_B5, O1_B6, O1_B7, O1_B8,
+    O2_B1, O2_B2, O2_B3, O2_B4, O2_B5, O2_B6, O2_B7, O2_B8,
+    O2_B9, O2_B10, O2_B11, O2_B12, O2_B13, O2_B14, O2_B15, O2_B16 },
+  { 10, 30, 50, 70, 90 },
+  { 6, 16, 28, 38, 50, 60, 72, 82, 93 },
+  { 12, 24, 36, 48, 60, 72, 84 },
+  /* Energy (less, avg, full) x throughput (low, avg, high). */
+  { 0, 1, 2,
+    1, 2, 3,
+    2, 3, 4 },
+  /* LQL (low, avg, high) x ETX (short, avg, long). */
+  { 2, 1, 0,
+    3, 2, 1,
+    4, 3, 2 },
+  /* Hop count (near, vicinity, far) x latency (short, avg, long). */
+  { 4, 3, 2,
+    3, 2, 1,
+    2, 1, 0 },
+  /* Reliability (very weak .. very strong) x duration (very slow ..
+     very fast) to awful .. excellent. */
+  { 0, 1, 2, 3, 4,
+    1, 2, 3, 4, 5,
+    2, 3, 4, 5, 6,
+    3, 4, 5, 6, 7,
+    4, 5, 6, 7, 8 },
+  /* Consumption (very costly .. very cheap) x qos (awful ..
+     excellent) to very bad .. very good. */
+  { 0, 0, 1, 1, 2, 3, 3, 3, 4,
+    0, 1, 1, 2, 3, 3, 3, 4, 5,
+    1, 1, 2, 3, 3, 3, 4, 5, 5,
+    1, 2, 3, 3, 3, 4, 5, 5, 6,
+    2, 3, 3, 3, 4, 5, 5, 6, 6 },
+};
+
+static struct fuzzy_rules rules;
+
+/* Precomputed slope of each transition, TRUE / width in 16.16 fixed
+   point, so that fuzzifying a value takes no division. */
+static uint32_t slope[FUZZY_BREAKPOINTS / 2];
+static uint8_t prepared;
+
+static const uint8_t var_sets[FUZZY_VARS] = {
+  FUZZY_INPUT_SETS, FUZZY_INPUT_SETS, FUZZY_INPUT_SETS,
+  FUZZY_INPUT_SETS, FUZZY_INPUT_SETS, FUZZY_INPUT_SETS,
+  FUZZY_O1_SETS, FUZZY_O2_SETS
+};
+static const uint8_t var_offset[FUZZY_VARS] = {
+  0, 4, 8, 12, 16, 20, 24, 32
+};
+
+#define CONSUMPTION 0
+#define RELIABILITY 1
+#define DURATION    2
+#define QOS         3
+#define QUALITY     4
+
+struct fuzzy_block {
+  uint8_t in1;
+  uint8_t in2;
+  uint8_t outputs;
+  uint8_t rules;
+  uint8_t cog;
+};
+
+static const struct fuzzy_block blocks[] = {
+  { FUZZY_ENERGY, FUZZY_THROUGHPUT, FUZZY_O1_SETS,
+    offsetof(struct fuzzy_rules, consumption),
+    offsetof(struct fuzzy_rules, cog1) },
+  { FUZZY_LQL, FUZZY_ETX, FUZZY_O1_SETS,
+    offsetof(struct fuzzy_rules, reliability),
+    offsetof(struct fuzzy_rules, cog1) },
+  { FUZZY_HOPCOUNT, FUZZY_LATENCY, FUZZY_O1_SETS,
+    offsetof(struct fuzzy_rules, duration),
+    offsetof(struct fuzzy_rules, cog1) },
+  { FUZZY_O1, FUZZY_O1, FUZZY_O2_SETS,
+    offsetof(struct fuzzy_rules, qos),
+    offsetof(struct fuzzy_rules, cog2) },
+  { FUZZY_O1, FUZZY_O2, FUZZY_QUALITY_SETS,
+    offsetof(struct fuzzy_rules, quality),
+    offsetof(struct fuzzy_rules, cog3) },
+};
+
+/* The records of the binary representation, in the order they are
+   read back. */
+struct fuzzy_record {
+  uint8_t type;
+  uint8_t offset;
+  uint8_t count;
+  uint8_t block;       /* For rule records; the outputs bound values. */
+};
+
+#define NO_BLOCK 0xff
+#define BP_RECORD(var) { FUZZY_REC_BP + (var), 0, 0, NO_BLOCK }
+
+static const struct fuzzy_record records[] = {
+  BP_RECORD(0), BP_RECORD(1), BP_RECORD(2), BP_RECORD(3),
+  BP_RECORD(4), BP_RECORD(5), BP_RECORD(6), BP_RECORD(7),
+  { FUZZY_REC_COG, offsetof(struct fuzzy_rules, cog1),
+    FUZZY_O1_SETS, NO_BLOCK },
+  { FUZZY_REC_COG + 1, offsetof(struct fuzzy_rules, cog2),
+    FUZZY_O2_SETS, NO_BLOCK },
+  { FUZZY_REC_COG + 2, offsetof(struct fuzzy_rules, cog3),
+    FUZZY_QUALITY_SETS, NO_BLOCK },
+  { FUZZY_REC_RULES, offsetof(struct fuzzy_rules, consumption),
+    FUZZY_INPUT_SETS * FUZZY_INPUT_SETS, CONSUMPTION },
+  { FUZZY_REC_RULES + 1, offsetof(struct fuzzy_rules, reliability),
+    FUZZY_INPUT_SETS * FUZZY_INPUT_SETS, RELIABILITY },
+  { FUZZY_REC_RULES + 2, offsetof(struct fuzzy_rules, duration),
+    FUZZY_INPUT_SETS * FUZZY_INPUT_SETS, DURATION },
+  { FUZZY_REC_RULES + 3, offsetof(struct fuzzy_rules, qos),
+    FUZZY_O1_SETS * FUZZY_O1_SETS, QOS },
+  { FUZZY_REC_RULES + 4, offsetof(struct fuzzy_rules, quality),
+    FUZZY_O1_SETS * FUZZY_O2_SETS, QUALITY },
+};
+#define RECORDS (sizeof(records) / sizeof(records[0]))
+
+#define IS_BP_RECORD(r) ((r)->type < FUZZY_REC_COG)
+/*---------------------------------------------------------------------------*/
+static uint8_t
+record_var(const struct fuzzy_record *r)
+{
+  return r->type - FUZZY_REC_BP;
 }
+/*---------------------------------------------------------------------------*/
+/* The number of data bytes of a record. */
+static uint8_t
+record_size(const struct fuzzy_record *r)
+{
+  if(IS_BP_RECORD(r)) {
+    return 4 * (var_sets[record_var(r)] - 1);
+  }
+  return r->count;
+}
+/*---------------------------------------------------------------------------*/
+static const struct fuzzy_record *
+find_record(uint8_t type)
+{
+  const struct fuzzy_record *r;
 
-unsigned short UP(unsigned short x1, unsigned short x2, unsigned short X){
-	return DOWN(x2, x1, X);
+  for(r = records; r < &records[RECORDS]; r++) {
+    if(r->type == type) {
+      return r;
+    }
+  }
+  return NULL;
 }
+/*---------------------------------------------------------------------------*/
+static void
+prepare(void)
+{
+  uint8_t k;
+  uint16_t width;
 
-unsigned short FIRST_T_NORM(unsigned short b1, unsigned short b2, unsigned short px){
-  if (px <= b1) return TRUE;
-  if (px > b1 && px <= b2) return DOWN(b1, b2, px);
-  return FALSE;
+  for(k = 0; k < FUZZY_BREAKPOINTS / 2; k++) {
+    width = rules.bp[2 * k + 1] - rules.bp[2 * k];
+    slope[k] = width == 0 ? 0 : ((uint32_t)TRUE << 16) / width;
+  }
+  prepared = 1;
 }
+/*---------------------------------------------------------------------------*/
+/* Breakpoints must not decrease within a variable. */
+static int
+valid_breakpoints(const uint16_t *bp, uint8_t count)
+{
+  uint8_t i;
 
-unsigned short LAST_T_NORM(unsigned short b1, unsigned short b2, unsigned short px){
-  if (px <= b1) return FALSE;
-  if (px > b1 && px <= b2) return UP(b1, b2, px);
-  return TRUE;
+  for(i = 1; i < count; i++) {
+    if(bp[i] < bp[i - 1]) {
+      return 0;
+    }
+  }
+  return 1;
 }
+/*---------------------------------------------------------------------------*/
+static int
+valid_rules(const uint8_t *rule, uint8_t count, uint8_t outputs)
+{
+  uint8_t i;
 
-unsigned short T_NORM(unsigned short b1, unsigned short b2, unsigned short b3, unsigned short b4, unsigned short px){
-  if (px <= b1) return 0;
-  if (px > b1 && px <= b2) return UP(b1, b2, px);
-  if (px > b2 && px <= b3) return TRUE;
-  if (px > b3 && px <= b4) return DOWN(b3, b4, px);
-  return FALSE;
+  for(i = 0; i < count; i++) {
+    if(rule[i] >= outputs) {
+      return 0;
+    }
+  }
+  return 1;
 }
+/*---------------------------------------------------------------------------*/
+static void
+fuzzify(uint8_t var, uint16_t x, uint8_t *mu)
+{
+  const uint16_t *bp;
+  const uint32_t *s;
+  uint8_t k, sets;
+  uint8_t r;
 
-unsigned short COG_1(unsigned short fv1,unsigned short fv2,unsigned short fv3,unsigned short fv4, unsigned short fv5){
+  bp = &rules.bp[var_offset[var]];
+  s = &slope[var_offset[var] / 2];
+  sets = var_sets[var];
+  memset(mu, 0, sets);
 
-  return (fv1*10 + fv2 * 30 + fv3 * 50 + fv4 * 70 + fv5 * 90)/(fv1 + fv2 + fv3 + fv4 + fv5);
+  for(k = 0; k < sets - 1; k++) {
+    if(x <= bp[2 * k]) {
+      mu[k] = TRUE;
+      return;
+    }
+    if(x <= bp[2 * k + 1]) {
+      r = ((uint32_t)(x - bp[2 * k]) * s[k] + 0x8000) >> 16;
+      mu[k] = TRUE - r;
+      mu[k + 1] = r;
+      return;
+    }
+  }
+  mu[sets - 1] = TRUE;
 }
+/*---------------------------------------------------------------------------*/
+/* Max-min inference over the rules of a block, defuzzified with the
+   centre of gravity of the output sets. */
+static unsigned short
+evaluate(uint8_t block, uint16_t x1, uint16_t x2)
+{
+  const struct fuzzy_block *b;
+  const uint8_t *rule, *cog;
+  uint8_t mu1[FUZZY_MAX_SETS], mu2[FUZZY_MAX_SETS], w[FUZZY_MAX_SETS];
+  uint8_t n1, n2, i, j, m;
+  uint32_t num;
+  uint16_t den;
 
-unsigned short compose(unsigned short c1, unsigned short c2, unsigned short c3, 
-		     unsigned short l1, unsigned short l2, unsigned short l3){
-  unsigned short b1 = 0, b2 = 0, b3 = 0, b4 = 0, b5 = 0;
+  if(!prepared) {
+    fuzzy_rules_reset();
+  }
 
-  if(c1 && l1) b1 = min(c1,l1);
-  if (c1 && l2 || c2 && l1) b2 = max(min(c1,l2),min(c2,l1));
-  if (c3 && l1 || c2 && l2 || c1 && l3) b3 = max(min(c3,l1),max(min(c2,l2),min(c1,l3)));
-  if (c3 && l2 || c2 && l3) b4 = max(min(c3,l2),min(c2,l3));
-  if (c3 && l3) b5 = min(c3,l3);
-  return COG_1(b1,b2,b3,b4,b5);
-}
+  b = &blocks[block];
+  rule = (const uint8_t *)&rules + b->rules;
+  cog = (const uint8_t *)&rules + b->cog;
+  n1 = var_sets[b->in1];
+  n2 = var_sets[b->in2];
+
+  fuzzify(b->in1, x1, mu1);
+  fuzzify(b->in2, x2, mu2);
+  memset(w, 0, b->outputs);
 
-unsigned short consumption(unsigned short e, unsigned short t){
+  for(i = 0; i < n1; i++) {
+    if(mu1[i] == 0) {
+      continue;
+    }
+    for(j = 0; j < n2; j++) {
+      if(mu2[j] == 0) {
+        continue;
+      }
+      m = mu1[i] < mu2[j] ? mu1[i] : mu2[j];
+      if(m > w[rule[i * n2 + j]]) {
+        w[rule[i * n2 + j]] = m;
+      }
+    }
+  }
 
-  return compose(energy_less(e),energy_avg(e),energy_full(e),throughput_low(t),throughput_avg(t),throughput_hight(t));
+  num = 0;
+  den = 0;
+  for(i = 0; i < b->outputs; i++) {
+    num += (uint32_t)w[i] * cog[i];
+    den += w[i];
+  }
+  return den == 0 ? 0 : num / den;
 }
+/*---------------------------------------------------------------------------*/
+unsigned short
+consumption(unsigned short e, unsigned short t)
+{
+  return evaluate(CONSUMPTION, e, t);
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+reliability(unsigned short lql, unsigned short etx)
+{
+  return evaluate(RELIABILITY, lql, etx);
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+duration(unsigned short hc, unsigned short lat)
+{
+  return evaluate(DURATION, hc, lat);
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+qos(unsigned short rel, unsigned short dur)
+{
+  return evaluate(QOS, rel, dur);
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+quality(unsigned short cons, unsigned short qos)
+{
+  return evaluate(QUALITY, cons, qos);
+}
+/*---------------------------------------------------------------------------*/
+void
+fuzzy_rules_reset(void)
+{
+  memcpy(&rules, &default_rules, sizeof(rules));
+  prepare();
+}
+/*---------------------------------------------------------------------------*/
+const struct fuzzy_rules *
+fuzzy_rules_get(void)
+{
+  if(!prepared) {
+    fuzzy_rules_reset();
+  }
+  return &rules;
+}
+/*---------------------------------------------------------------------------*/
+int
+fuzzy_rules_set(const struct fuzzy_rules *r)
+{
+  const struct fuzzy_record *rec;
+  uint8_t var;
 
+  for(rec = records; rec < &records[RECORDS]; rec++) {
+    if(IS_BP_RECORD(rec)) {
+      var = record_var(rec);
+      if(!valid_breakpoints(&r->bp[var_offset[var]],
+                            2 * (var_sets[var] - 1))) {
+        return 0;
+      }
+    } else if(rec->block != NO_BLOCK &&
+              !valid_rules((const uint8_t *)r + rec->offset, rec->count,
+                           blocks[rec->block].outputs)) {
+      return 0;
+    }
+  }
+  memcpy(&rules, r, sizeof(rules));
+  prepare();
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+get16(const uint8_t *p)
+{
+  return ((uint16_t)p[0] << 8) | p[1];
+}
+/*---------------------------------------------------------------------------*/
+/* Checks one record (apply == 0) or copies it into the rule base. */
+static int
+process_record(const struct fuzzy_record *r, const uint8_t *data, int apply)
+{
+  uint16_t bp[2 * (FUZZY_MAX_SETS - 1)];
+  uint8_t var, i, count;
+
+  if(!IS_BP_RECORD(r)) {
+    if(!apply) {
+      return r->block == NO_BLOCK ||
+        valid_rules(data, r->count, blocks[r->block].outputs);
+    }
+    memcpy((uint8_t *)&rules + r->offset, data, r->count);
+    return 1;
+  }
 
-unsigned short reliability(unsigned short lql, unsigned short etx){
+  var = record_var(r);
+  count = 2 * (var_sets[var] - 1);
+  for(i = 0; i < count; i++) {
+    bp[i] = get16(&data[2 * i]);
+  }
+  if(!apply) {
+    return valid_breakpoints(bp, count);
+  }
+  memcpy(&rules.bp[var_offset[var]], bp, count * sizeof(bp[0]));
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+fuzzy_rules_update(const uint8_t *buf, uint16_t len)
+{
+  const struct fuzzy_record *r;
+  uint16_t pos;
+  int apply;
 
-  return compose(lql_low(lql),lql_avg(lql),lql_hight(lql),etx_long(etx),etx_avg(etx),etx_short(etx));
+  if(!prepared) {
+    fuzzy_rules_reset();
+  }
 
+  /* The first pass only validates, so that a bad record leaves the
+     rule base untouched. */
+  for(apply = 0; apply <= 1; apply++) {
+    for(pos = 0; pos < len; pos += 2 + buf[pos + 1]) {
+      if(len - pos < 2) {
+        return 0;
+      }
+      r = find_record(buf[pos]);
+      if(r == NULL || buf[pos + 1] != record_size(r) ||
+         len - pos - 2 < buf[pos + 1]) {
+        return 0;
+      }
+      if(!process_record(r, &buf[pos + 2], apply)) {
+        return 0;
+      }
+    }
+  }
+  prepare();
+  return 1;
 }
+/*---------------------------------------------------------------------------*/
+static uint8_t
+record_byte(const struct fuzzy_record *r, uint8_t i)
+{
+  uint16_t v;
 
-unsigned short duration(unsigned short hc, unsigned short lat){
+  if(i == 0) {
+    return r->type;
+  } else if(i == 1) {
+    return record_size(r);
+  }
+  i -= 2;
+  if(!IS_BP_RECORD(r)) {
+    return ((const uint8_t *)&rules)[r->offset + i];
+  }
+  v = rules.bp[var_offset[record_var(r)] + i / 2];
+  return (i & 1) ? v & 0xff : v >> 8;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+fuzzy_rules_read(uint8_t *buf, uint16_t offset, uint16_t len)
+{
+  const struct fuzzy_record *r;
+  uint16_t pos, n;
+  uint8_t i, size;
+
+  if(!prepared) {
+    fuzzy_rules_reset();
+  }
+
+  pos = 0;
+  n = 0;
+  for(r = records; r < &records[RECORDS] && n < len; r++) {
+    size = 2 + record_size(r);
+    if(pos + size <= offset) {
+      pos += size;
+      continue;
+    }
+    for(i = 0; i < size && n < len; i++, pos++) {
+      if(pos >= offset) {
+        buf[n++] = record_byte(r, i);
+      }
+    }
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+fuzzy_rules_size(void)
+{
+  const struct fuzzy_record *r;
+  uint16_t size;
 
-  return compose(hop_far(hc),hop_vicinity(hc),hop_near(hc),latency_long(lat),latency_avg(lat),latency_short(lat));
+  size = 0;
+  for(r = records; r < &records[RECORDS]; r++) {
+    size += 2 + record_size(r);
+  }
+  return size;
 }
+/*---------------------------------------------------------------------------*/
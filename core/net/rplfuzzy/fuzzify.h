@@ -7,6 +7,11 @@
  */
 
 
+#ifndef FUZZIFY_H
+#define FUZZIFY_H
+
+#include <stdint.h>
+
 unsigned short consumption(unsigned short e, unsigned short t);
 unsigned short reliability(unsigned short l, unsigned short e);
 unsigned short duration(unsigned short h, unsigned short l);
@@ -16,11 +21,10 @@ unsigned short quality(unsigned short c, unsigned short q);
 #define TRUE 100
 #define FALSE 0
 
-
-#define min(x,y) ((x)>(y))?(y):(x)
-
-#define max(x,y) ((x)<(y))?(y):(x)
-
+/*
+ * Compiled-in membership breakpoints. They initialize the rule base,
+ * which may then be replaced at runtime (see the end of this file).
+ */
 
 /*******************************
  *           Energy            *
@@ -33,9 +37,6 @@ unsigned short quality(unsigned short c, unsigned short q);
 #define E_B_3 E_B_1 * 3
 #define E_B_4 E_B_1 * 4
 
-#define energy_less(e) FIRST_T_NORM(E_B_1, E_B_2, (e))
-#define energy_avg(e) T_NORM(E_B_1, E_B_2, E_B_3, E_B_4, (e))
-#define energy_full(e) LAST_T_NORM(E_B_3, E_B_4, (e))
 
 /*******************************
  *        Throughput           *
@@ -48,9 +49,6 @@ unsigned short quality(unsigned short c, unsigned short q);
 #define T_B_3 T_B_1 * 3
 #define T_B_4 T_B_1 * 4
 
-#define throughput_low(e) FIRST_T_NORM(T_B_1, T_B_2, (e))
-#define throughput_avg(e) T_NORM(T_B_1, T_B_2, T_B_3, T_B_4, (e))
-#define throughput_hight(e) LAST_T_NORM(T_B_3, T_B_4, (e))
 
 /*******************************
  *            ETX              *
@@ -70,10 +68,6 @@ unsigned short quality(unsigned short c, unsigned short q);
 #define ETX_B_4 ETX_B_3 + 128
 
 
-#define etx_short(e) FIRST_T_NORM(ETX_B_1, ETX_B_2, (e))
-#define etx_avg(e) T_NORM(ETX_B_1, ETX_B_2, ETX_B_3, ETX_B_4, (e))
-#define etx_long(e) LAST_T_NORM(ETX_B_3, ETX_B_4, (e))
-
 /*******************************
  *            LQL              *
  ******************************/
@@ -85,10 +79,6 @@ unsigned short quality(unsigned short c, unsigned short q);
 #define LQ_B_3 5
 #define LQ_B_4 6
 
-#define lql_low(x) FIRST_T_NORM(LQ_B_1, LQ_B_2, (x))
-#define lql_avg(x) T_NORM(LQ_B_1, LQ_B_2, LQ_B_3, LQ_B_4, (x))
-#define lql_hight(x) LAST_T_NORM(LQ_B_3, LQ_B_4, (x))
-
 
 /*******************************
  *        Hop Count            *
@@ -101,9 +91,6 @@ unsigned short quality(unsigned short c, unsigned short q);
 #define H_B_3 H_B_1 * 3
 #define H_B_4 H_B_1 * 4
 
-#define hop_near(x) FIRST_T_NORM(H_B_1, H_B_2, (x))
-#define hop_vicinity(x) T_NORM(H_B_1, H_B_2, H_B_3, H_B_4, (x))
-#define hop_far(x) LAST_T_NORM(H_B_3, H_B_4, (x))
 
 /*******************************
  *          Latency            *
@@ -116,10 +103,6 @@ unsigned short quality(unsigned short c, unsigned short q);
 #define L_B_3 L_B_1 * 3
 #define L_B_4 L_B_1 * 4
 
-#define latency_short(x) FIRST_T_NORM(L_B_1, L_B_2, (x))
-#define latency_avg(x) T_NORM(L_B_1, L_B_2, L_B_3, L_B_4, (x))
-#define latency_long(x) LAST_T_NORM(L_B_3, L_B_4, (x))
-
 
 /*******************************
  *       Output metrics 1      *
@@ -134,23 +117,6 @@ unsigned short quality(unsigned short c, unsigned short q);
 #define O1_B7 75
 #define O1_B8 85
 
-#define duration_very_slow(x) FIRST_T_NORM(O1_B1, O1_B2,(x))
-#define duration_slow(x) T_NORM(O1_B1, O1_B2, O1_B3, O1_B4, (x))
-#define duration_avg(x) T_NORM(O1_B3, O1_B4, O1_B5, O1_B6, (x))
-#define duration_fast(x) T_NORM(O1_B5, O1_B6, O1_B7, O1_B8, (x))
-#define duration_very_fast(x) LAST_T_NORM(O1_B7, O1_B8, (x))
-
-#define reliability_very_weak(x) FIRST_T_NORM(O1_B1, O1_B2,(x))
-#define reliability_weak(x) T_NORM(O1_B1, O1_B2, O1_B3, O1_B4, (x))
-#define reliability_avg(x) T_NORM(O1_B3, O1_B4, O1_B5, O1_B6, (x))
-#define reliability_strong(x) T_NORM(O1_B5, O1_B6, O1_B7, O1_B8, (x))
-#define reliability_very_strong(x) LAST_T_NORM(O1_B7, O1_B8, (x))
-
-#define consumption_very_costly(x) FIRST_T_NORM(O1_B1, O1_B2,(x))
-#define consumption_costly(x) T_NORM(O1_B1, O1_B2, O1_B3, O1_B4, (x))
-#define consumption_avg(x) T_NORM(O1_B3, O1_B4, O1_B5, O1_B6, (x))
-#define consumption_cheap(x) T_NORM(O1_B5, O1_B6, O1_B7, O1_B8, (x))
-#define consumption_very_cheap(x) LAST_T_NORM(O1_B7, O1_B8, (x))
 
 /*******************************
  *       Output metrics 2      *
@@ -173,12 +139,90 @@ unsigned short quality(unsigned short c, unsigned short q);
 #define O2_B15 85
 #define O2_B16 90
 
-#define qos_awful(x) FIRST_T_NORM(O2_B1, O2_B2, (x))
-#define qos_very_bad(x) T_NORM(O2_B1, O2_B2, O2_B3, O2_B4, (x))
-#define qos_bad(x) T_NORM(O2_B3, O2_B4, O2_B5, O2_B6, (x))
-#define qos_degraded(x) T_NORM(O2_B5, O2_B6, O2_B7, O2_B8, (x))
-#define qos_avg(x) T_NORM(O2_B7, O2_B8, O2_B9, O2_B10, (x))
-#define qos_acceptable(x) T_NORM(O2_B9, O2_B10, O2_B11, O2_B12, (x))
-#define qos_good(x) T_NORM(O2_B11, O2_B12, O2_B13, O2_B14, (x))
-#define qos_very_good(x) T_NORM(O2_B13, O2_B14, O2_B15, O2_B16, (x))
-#define qos_excellent(x) LAST_T_NORM(O2_B15, O2_B16, (x))
+/*******************************
+ *         Rule base           *
+ ******************************/
+
+/*
+ * The membership breakpoints, output centroids and rules are kept in
+ * RAM so that they can be replaced at runtime. Each variable is a
+ * partition of its range into sets; between two sets there is a
+ * transition [bp[2k], bp[2k + 1]] where set k falls and set k + 1
+ * rises. Inputs have three sets, the "output metrics 1" five and the
+ * "output metrics 2" nine.
+ *
+ * Each block combines two variables: the rule for set i of the first
+ * and set j of the second gives the index of an output set, whose
+ * centroid is weighted by min(mu_i, mu_j) (max over rules that share
+ * an output set).
+ */
+#define FUZZY_ENERGY        0
+#define FUZZY_THROUGHPUT    1
+#define FUZZY_LQL           2
+#define FUZZY_ETX           3
+#define FUZZY_HOPCOUNT      4
+#define FUZZY_LATENCY       5
+#define FUZZY_O1            6
+#define FUZZY_O2            7
+#define FUZZY_VARS          8
+
+#define FUZZY_INPUT_SETS    3
+#define FUZZY_O1_SETS       5
+#define FUZZY_O2_SETS       9
+#define FUZZY_QUALITY_SETS  7
+#define FUZZY_MAX_SETS      FUZZY_O2_SETS
+
+/* Breakpoints of all variables, in the order above. */
+#define FUZZY_BREAKPOINTS   (6 * 2 * (FUZZY_INPUT_SETS - 1) + \
+                             2 * (FUZZY_O1_SETS - 1) + \
+                             2 * (FUZZY_O2_SETS - 1))
+
+struct fuzzy_rules {
+  uint16_t bp[FUZZY_BREAKPOINTS];
+  uint8_t cog1[FUZZY_O1_SETS];
+  uint8_t cog2[FUZZY_O2_SETS];
+  uint8_t cog3[FUZZY_QUALITY_SETS];
+  uint8_t consumption[FUZZY_INPUT_SETS * FUZZY_INPUT_SETS];
+  uint8_t reliability[FUZZY_INPUT_SETS * FUZZY_INPUT_SETS];
+  uint8_t duration[FUZZY_INPUT_SETS * FUZZY_INPUT_SETS];
+  uint8_t qos[FUZZY_O1_SETS * FUZZY_O1_SETS];
+  uint8_t quality[FUZZY_O1_SETS * FUZZY_O2_SETS];
+};
+
+/*
+ * Binary representation, used both to read and to update the rule
+ * base: a sequence of records, each made of a type byte, a length byte
+ * and the data. An update may carry any subset of the records.
+ *
+ *  0x01-0x08  breakpoints of variable (type - 1), 16-bit big-endian
+ *  0x11       centroids of the consumption, reliability and duration
+ *             outputs
+ *  0x12       centroids of the qos output
+ *  0x13       centroids of the quality output
+ *  0x21-0x25  rules of consumption, reliability, duration, qos and
+ *             quality, one output set index per rule, row by row
+ */
+#define FUZZY_REC_BP        0x01
+#define FUZZY_REC_COG       0x11
+#define FUZZY_REC_RULES     0x21
+
+/* Validates the records in buf and, only if all of them are valid,
+   applies them. Returns 1 on success and 0 otherwise. */
+int fuzzy_rules_update(const uint8_t *buf, uint16_t len);
+
+/* Copies up to len bytes of the binary representation of the rule
+   base, starting at offset. Returns the number of bytes copied. */
+uint16_t fuzzy_rules_read(uint8_t *buf, uint16_t offset, uint16_t len);
+
+/* The total size of the binary representation. */
+uint16_t fuzzy_rules_size(void);
+
+/* Restores the compiled-in rule base. */
+void fuzzy_rules_reset(void);
+
+/* Raw access to the rule base, e.g. to store it. fuzzy_rules_set()
+   returns 0 if the rule base is not consistent. */
+const struct fuzzy_rules *fuzzy_rules_get(void);
+int fuzzy_rules_set(const struct fuzzy_rules *rules);
+
+#endif /* FUZZIFY_H */
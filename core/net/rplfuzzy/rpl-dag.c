@@ -74,12 +74,6 @@ static rpl_of_t * const objective_functions[] = {&RPL_OF};
 #else
 #define RPL_MAX_PARENTS       RPL_CONF_MAX_PARENTS
 #endif /* !RPL_CONF_MAX_PARENTS */
-/************************************************************************/
-/* Metrics */
-
-#define RPL_METRICS_COUNT 6
-
-
 /************************************************************************/
 /* RPL definitions. */
 
@@ -106,8 +100,6 @@ static rpl_of_t * const objective_functions[] = {&RPL_OF};
 
 MEMB(parent_memb, struct rpl_parent, RPL_MAX_PARENTS);
 
-MEMB(mc_memb, rpl_metric_container_t,(RPL_MAX_PARENTS) * RPL_METRICS_COUNT);
-
 static rpl_dag_t dag_table[RPL_MAX_DAG_ENTRIES];
 
 /************************************************************************/
@@ -296,7 +288,7 @@ rpl_free_dag(rpl_dag_t *dag)
   remove_parents(dag, 0);
   rpl_set_default_route(dag, NULL);
 
-  ctimer_stop(&dag->dio_timer);
+  trickle_timer_stop(&dag->dio_timer);
   ctimer_stop(&dag->dao_timer);
 
   dag->used = 0;
@@ -309,8 +301,6 @@ rpl_parent_t *
 rpl_add_parent(rpl_dag_t *dag, rpl_dio_t *dio, uip_ipaddr_t *addr)
 {
   rpl_parent_t *p;
-  rpl_metric_container_t *m,*n;
-
 
   p = memb_alloc(&parent_memb);
   
@@ -324,22 +314,10 @@ rpl_add_parent(rpl_dag_t *dag, rpl_dio_t *dio, uip_ipaddr_t *addr)
   p->rank = dio->rank;
   p->link_metric = INITIAL_LINK_METRIC;
   p->dtsn = 0;
-  p->mcs = &p->mc_list;
-  list_init(p->mcs);
-  
-  
-  for (m = list_head(dio->mcs); m != NULL; m = m->next){
-    n = memb_alloc(&mc_memb);
-    if (n == NULL){
-      RPL_STAT(rpl_stats.mem_overflows++);
-      return NULL;
-    }
-    memcpy(n, m, sizeof(rpl_metric_container_t));
-    list_add(p->mcs,n);
-  }
+  memcpy(&p->metrics, &dio->metrics, sizeof(p->metrics));
 
-  p->first_dio_received = 0;
-  p->latency_metric = 0;
+  p->dio_window = 0;
+  p->link_latency = 0;
   
   list_add(dag->parents, p);
 
@@ -361,8 +339,8 @@ rpl_find_parent(rpl_dag_t *dag, uip_ipaddr_t *addr)
 }
 
 /************************************************************************/
-rpl_parent_t *
-rpl_select_parent(rpl_dag_t *dag)
+static rpl_parent_t *
+best_of_all_parents(rpl_dag_t *dag)
 {
   rpl_parent_t *p;
   rpl_parent_t *best;
@@ -371,15 +349,78 @@ rpl_select_parent(rpl_dag_t *dag)
   for(p = list_head(dag->parents); p != NULL; p = p->next) {
     if(p->rank == INFINITE_RANK) {
       /* ignore this neighbor */
+    } else if(best == NULL) {
+      best = p;
     } else {
-      if(best == NULL) {
-	best = p;
-      } else {
-	best = dag->of->best_parent(best, p);
-      }
+      best = dag->of->best_parent(best, p);
     }
   }
+  return best;
+}
+/************************************************************************/
+static rpl_parent_t *
+best_after_update(rpl_dag_t *dag, rpl_parent_t *updated)
+{
+  rpl_parent_t *preferred;
 
+  preferred = dag->preferred_parent;
+  if(preferred == NULL || preferred == updated ||
+     preferred->rank == INFINITE_RANK || updated == NULL) {
+    /* The cached choice is gone or may have become worse than one of
+       the other parents, so they all have to be compared again. */
+    return best_of_all_parents(dag);
+  }
+  if(updated->rank == INFINITE_RANK) {
+    return preferred;
+  }
+  /* Only the updated parent has changed, and the preferred parent
+     was better than all the others before. */
+  return dag->of->best_parent(preferred, updated);
+}
+/************************************************************************/
+static rpl_parent_t *
+hold_preferred_parent(rpl_dag_t *dag, rpl_parent_t *best,
+                      rpl_parent_t *updated)
+{
+  rpl_parent_t *preferred;
+
+  preferred = dag->preferred_parent;
+  if(preferred == NULL || preferred->rank == INFINITE_RANK) {
+    dag->switch_candidate = NULL;
+    return best;
+  }
+
+  if(best == preferred) {
+    if(updated == dag->switch_candidate || updated == preferred) {
+      /* The candidate lost against the preferred parent. */
+      dag->switch_candidate = NULL;
+    }
+    return best;
+  }
+
+  if(best != dag->switch_candidate) {
+    dag->switch_candidate = best;
+    dag->switch_wins = 0;
+  }
+  if(++dag->switch_wins < RPL_PARENT_SWITCH_HOLD) {
+    PRINTF("RPL: Holding the preferred parent, candidate won %u/%u times\n",
+           dag->switch_wins, RPL_PARENT_SWITCH_HOLD);
+    RPL_STAT(rpl_stats.parent_switch_held++);
+    return preferred;
+  }
+  dag->switch_candidate = NULL;
+  return best;
+}
+/************************************************************************/
+rpl_parent_t *
+rpl_select_parent(rpl_dag_t *dag, rpl_parent_t *updated)
+{
+  rpl_parent_t *best;
+
+  best = best_after_update(dag, updated);
+  if(best != NULL) {
+    best = hold_preferred_parent(dag, best, updated);
+  }
 
   if(best == NULL) {
     /* need to handle update of best... */
@@ -395,7 +436,6 @@ rpl_select_parent(rpl_dag_t *dag)
       ANNOTATE("#L %d 0\n",dag->preferred_parent->addr.u8[sizeof(uip_ipaddr_t) - 1]);
     }
     dag->preferred_parent = best; /* Cache the value. */
-    dag->preferred_parent->first_dio_received = 0;
 
     ANNOTATE("#L %d 1;red\n",dag->preferred_parent->addr.u8[sizeof(uip_ipaddr_t) - 1]);
 
@@ -447,20 +487,15 @@ rpl_remove_parent(rpl_dag_t *dag, rpl_parent_t *parent)
   PRINT6ADDR(&parent->addr);
   PRINTF("\n");
 
+  if(parent == dag->switch_candidate) {
+    dag->switch_candidate = NULL;
+  }
   if(parent == dag->preferred_parent) {
     dag->preferred_parent = NULL;
     ANNOTATE("#L %d 0\n",parent->addr.u8[sizeof(uip_ipaddr_t) - 1]);
   }
 
-  rpl_metric_container_t *mc, *tmp;
-  for (mc = list_head(parent->mcs); mc != NULL;){
-    tmp = mc->next;
-    memb_free(&mc_memb, mc); 
-    mc = tmp;
-  }
-
   list_remove(dag->parents, parent);
-  ctimer_stop(&parent->latency_timer);
   memb_free(&parent_memb, parent);
 
   return 0;
@@ -587,7 +622,7 @@ join_dag(uip_ipaddr_t *from, rpl_dio_t *dio)
     PRINTF("RPL: The DIO does not meet the prerequisites for sending a DAO\n");
   }
 
-  rpl_dio_received(p, dio->dio_delay, dio->next_dio_time, dio->next_dio_delay);
+  rpl_latency_dio_received(p, dio);
 }
 /************************************************************************/
 static void
@@ -678,7 +713,7 @@ rpl_process_parent_event(rpl_dag_t *dag, rpl_parent_t *p)
   parent_rank = p->rank;
   old_rank = dag->rank;
 
-  if(rpl_select_parent(dag) == NULL) {
+  if(rpl_select_parent(dag, p) == NULL) {
     /* No suitable parent; trigger a local repair. */
     PRINTF("RPL: No parents found in a DAG\n");
     rpl_local_repair(dag);
@@ -765,7 +800,7 @@ rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
   if(dag->rank == ROOT_RANK(dag)) {
     
     if(dio->rank != INFINITE_RANK) {
-      dag->dio_counter++;
+      trickle_timer_consistency(&dag->dio_timer);
     }
     
     return;
@@ -804,24 +839,16 @@ rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
   } else {
 
     /*
-     * The parent is already in the set.
-     * We replace metrics
+     * The parent is already in the set. Only touch its cached
+     * metrics if the DIO carries different values.
      */
-
-    rpl_metric_container_t *m, *mc, *mcn;
-
-    mc = list_head(p->mcs); 
-    for (m = list_head(dio->mcs); m != NULL; m = m->next){
-      mcn = mc->next;
-      memcpy(mc, m, sizeof(rpl_metric_container_t)); 
-      mc->next = mcn;
-      mc = mcn;
+    if(memcmp(&p->metrics, &dio->metrics, sizeof(p->metrics)) != 0) {
+      memcpy(&p->metrics, &dio->metrics, sizeof(p->metrics));
     }
-  
-    
+
     if(DAG_RANK(p->rank, dag) == DAG_RANK(dio->rank, dag)) {
       PRINTF("RPL: Received consistent DIO\n");
-      dag->dio_counter++;
+      trickle_timer_consistency(&dag->dio_timer);
     }
   }
 
@@ -836,7 +863,7 @@ rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
     rpl_schedule_dao(dag);
   }
   p->dtsn = dio->dtsn;
-  rpl_dio_received(p, dio->dio_delay, dio->next_dio_time, dio->next_dio_delay);
+  rpl_latency_dio_received(p, dio);
 }
 /************************************************************************/
 
@@ -82,10 +82,6 @@ static void dao_ack_input(void);
 
 static uint8_t dao_sequence;
 
-
-MEMB(mc_memb, rpl_metric_container_t,6);
-
-
 /*---------------------------------------------------------------------------*/
 static int
 get_global_addr(uip_ipaddr_t *addr)
@@ -136,6 +132,95 @@ set16(uint8_t *buffer, int pos, uint16_t value)
   buffer[pos] = value & 0xff;
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Decode the body of a DAG Metric Container sub-option, len bytes at
+ * buffer[pos], into dio. The body starts with the three 32-bit latency
+ * measurement fields, followed by metric objects with a four byte
+ * header each. Known objects have a fixed size, and a zero length
+ * field is accepted for them since older nodes leave it unset; unknown
+ * objects are skipped using their length field. Returns 0 if the
+ * container is malformed.
+ */
+static int
+parse_metric_container(uint8_t *buffer, int pos, int len, rpl_dio_t *dio)
+{
+  int end;
+  uint8_t type;
+  uint8_t obj_len;
+
+  if(len < 12) {
+    return 0;
+  }
+  end = pos + len;
+
+  dio->dio_delay = get32(buffer, pos);
+  dio->next_dio_time = get32(buffer, pos + 4);
+  dio->next_dio_delay = get32(buffer, pos + 8);
+  pos += 12;
+
+  while(pos < end) {
+    if(pos + 4 > end) {
+      return 0;
+    }
+    type = buffer[pos];
+    obj_len = buffer[pos + 3];
+    pos += 4;
+
+    switch(type) {
+    case RPL_DAG_MC_ENERGY:
+    case RPL_DAG_MC_THROUGHPUT:
+    case RPL_DAG_MC_ETX:
+    case RPL_DAG_MC_LQL:
+    case RPL_DAG_MC_HOPCOUNT:
+      if(obj_len != 0 && obj_len != 2) {
+        return 0;
+      }
+      obj_len = 2;
+      break;
+    case RPL_DAG_MC_LATENCY:
+      if(obj_len != 0 && obj_len != 4) {
+        return 0;
+      }
+      obj_len = 4;
+      break;
+    default:
+      PRINTF("RPL: Unknown metric type %u\n", type);
+      break;
+    }
+    if(pos + obj_len > end) {
+      return 0;
+    }
+
+    switch(type) {
+    case RPL_DAG_MC_ENERGY:
+      dio->metrics.energy.flags = buffer[pos];
+      dio->metrics.energy.energy_est = buffer[pos + 1];
+      break;
+    case RPL_DAG_MC_THROUGHPUT:
+      dio->metrics.throughput = get16(buffer, pos);
+      break;
+    case RPL_DAG_MC_ETX:
+      dio->metrics.etx = get16(buffer, pos);
+      break;
+    case RPL_DAG_MC_LQL:
+      dio->metrics.lql = get16(buffer, pos);
+      break;
+    case RPL_DAG_MC_HOPCOUNT:
+      dio->metrics.hopcount = get16(buffer, pos);
+      break;
+    case RPL_DAG_MC_LATENCY:
+      dio->metrics.latency = get32(buffer, pos);
+      break;
+    default:
+      pos += obj_len;
+      continue;
+    }
+    dio->metrics.present |= 1 << type;
+    pos += obj_len;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 static void
 dis_input(void)
 {
@@ -265,8 +350,10 @@ dio_input(void)
   dio.mop = (buffer[i]& RPL_DIO_MOP_MASK) >> RPL_DIO_MOP_SHIFT;
   dio.preference = buffer[i++] & RPL_DIO_PREFERENCE_MASK;
 
-  dio.mcs = &dio.mc_list;
-  list_init(dio.mcs);
+  memset(&dio.metrics, 0, sizeof(dio.metrics));
+  dio.dio_delay = 0;
+  dio.next_dio_time = 0;
+  dio.next_dio_delay = 0;
 
   dio.dtsn = buffer[i++];
   /* two reserved bytes */
@@ -284,79 +371,20 @@ dio_input(void)
       /* Suboption with a two-byte header + payload */
       len = 2 + buffer[i + 1];
     }
-    /*  TO DO decommenter pour la place
     if(len + i > buffer_length) {
       PRINTF("RPL: Invalid DIO packet\n");
       RPL_STAT(rpl_stats.malformed_msgs++);
       return;
     }
-    */
     PRINTF("RPL: DIO suboption %u, length: %u\n", subopt_type, len - 2);
 
-      int j = i + 2;
-
     switch(subopt_type) {
     case RPL_DIO_SUBOPT_DAG_METRIC_CONTAINER:
-      /*TO DO decommenter pour la place
-      if(len < 6) {
+      if(parse_metric_container(buffer, i + 2, len - 2, &dio) == 0) {
         PRINTF("RPL: Invalid DAG MC, len = %d\n", len);
 	RPL_STAT(rpl_stats.malformed_msgs++);
         return;
       }
-      */
-      /************************************************
-       * extracting a list of metric container from DIO
-       ************************************************/
-   
-      dio.dio_delay = get32(buffer, j);
-      j += 4;
-      dio.next_dio_time  = get32(buffer, j);
-      j+=4;
-      dio.next_dio_delay = get32(buffer, j);
-      j+=4;
-
-      while (j < i + len - 2){
-	rpl_metric_container_t *mc;
-
-	mc = memb_alloc(&mc_memb);
-	mc->type = buffer[j++];
-	mc->flags = buffer[j++] << 1;
-	mc->flags |= buffer[j] >> 7;
-	mc->aggr = (buffer[j] >> 4) & 0x3;
-	mc->prec = buffer[j++] & 0xf;
-	mc->length = buffer[j++];
-
-	switch(mc->type){
-	case RPL_DAG_MC_ENERGY:
-	  mc->obj.energy.energy_est = get16(buffer,j);
-	  j+=2;
-	  break;
-	case RPL_DAG_MC_THROUGHPUT:
-	  mc->obj.throughput = get16(buffer,j);
-	  j+=2;
-	  break;
-	case RPL_DAG_MC_ETX:
-	  mc->obj.etx = get16(buffer,j);
-	  j+=2;
-	  break;
-	case RPL_DAG_MC_LQL:
-	  mc->obj.lql = get16(buffer,j);
-	  j+=2;
-	  break;
-	case RPL_DAG_MC_HOPCOUNT:
-	  mc->obj.hopcount = get16(buffer,j);
-	  j+=2;
-	  break;
-	case RPL_DAG_MC_LATENCY:
-	  mc->obj.latency = get32(buffer,j);
-	  j +=4;
-	  break;
-	default:
-	  PRINTF("Unknown metric type : %u\n",mc->type);
-	  break;
-	}
-	list_add(dio.mcs, mc);
-      }
       break;
     case RPL_DIO_SUBOPT_ROUTE_INFO:
       if(len < 9) {
@@ -429,7 +457,6 @@ dio_input(void)
   
   }
   rpl_process_dio(&from, &dio);
-  clear_dio_mc(&dio);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -608,6 +635,252 @@ dio_output(rpl_dag_t *dag, uip_ipaddr_t *uc_addr)
   }
 }
 /*---------------------------------------------------------------------------*/
+#define DAO_TARGET_MAX_LEN  (4 + sizeof(uip_ipaddr_t))
+#define DAO_TRANSIT_LEN     6
+#define DAO_MAX_LEN         (UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPICMPH_LEN)
+
+#if RPL_DAO_AGGREGATION
+/* A target learned from a child that has not been forwarded yet. */
+struct dao_agg_target {
+  rpl_dag_t *dag;
+  uip_ipaddr_t prefix;
+  uint8_t prefixlen;
+  rpl_lifetime_t lifetime;
+  /* Added or renewed by the DAO that is being processed. */
+  uint8_t current;
+};
+
+static struct dao_agg_target dao_agg[RPL_DAO_AGGREGATION_TARGETS];
+static uint8_t dao_agg_count;
+static struct ctimer dao_agg_timer;
+#endif /* RPL_DAO_AGGREGATION */
+/*---------------------------------------------------------------------------*/
+static int
+dao_add_header(unsigned char *buffer, rpl_dag_t *dag)
+{
+  int pos;
+
+  ++dao_sequence;
+  pos = 0;
+
+  buffer[pos++] = dag->instance_id;
+#if RPL_CONF_DAO_ACK
+  buffer[pos++] = RPL_DAO_K_FLAG; /* DAO ACK request, no DODAGID */
+#else
+  buffer[pos++] = 0; /* No DAO ACK request, no DODAGID */
+#endif
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = dao_sequence & 0xff;
+
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+static int
+dao_add_target(unsigned char *buffer, int pos,
+               uip_ipaddr_t *prefix, uint8_t prefixlen)
+{
+  buffer[pos++] = RPL_DIO_SUBOPT_TARGET;
+  buffer[pos++] = 2 + ((prefixlen + 7) / CHAR_BIT);
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = prefixlen;
+  memcpy(buffer + pos, prefix, (prefixlen + 7) / CHAR_BIT);
+  pos += ((prefixlen + 7) / CHAR_BIT);
+
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+#if RPL_DAO_AGGREGATION
+static void
+dao_agg_send(rpl_dag_t *dag, int len, int targets)
+{
+  if(!dag->used || dag->preferred_parent == NULL) {
+    PRINTF("RPL: No parent to forward %d aggregated DAO targets to\n",
+           targets);
+    return;
+  }
+
+  PRINTF("RPL: Forwarding a DAO with %d targets to parent ", targets);
+  PRINT6ADDR(&dag->preferred_parent->addr);
+  PRINTF("\n");
+
+  RPL_STAT(rpl_stats.dao_out++);
+  uip_icmp6_send(&dag->preferred_parent->addr,
+                 ICMP6_RPL, RPL_CODE_DAO, len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+dao_add_transit(unsigned char *buffer, int pos, rpl_lifetime_t lifetime)
+{
+  buffer[pos++] = RPL_DIO_SUBOPT_TRANSIT;
+  buffer[pos++] = DAO_TRANSIT_LEN - 2;
+  buffer[pos++] = 0; /* flags - ignored */
+  buffer[pos++] = 0; /* path control - ignored */
+  buffer[pos++] = 0; /* path seq - ignored */
+  buffer[pos++] = lifetime;
+
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+static void
+dao_agg_flush(void *ptr)
+{
+  unsigned char *buffer;
+  rpl_dag_t *dag;
+  rpl_lifetime_t lifetime;
+  int pos;
+  int targets;
+  int group;
+  int i, j, k;
+
+  ctimer_stop(&dao_agg_timer);
+
+  buffer = UIP_ICMP_PAYLOAD;
+
+  /* One DAO per DAG, in which targets that share a lifetime share a
+     Transit Information option. */
+  for(i = 0; i < dao_agg_count; i++) {
+    dag = dao_agg[i].dag;
+    if(dag == NULL) {
+      continue;
+    }
+    pos = 0;
+    targets = 0;
+    for(j = i; j < dao_agg_count; j++) {
+      if(dao_agg[j].dag != dag) {
+        continue;
+      }
+      lifetime = dao_agg[j].lifetime;
+      group = 0;
+      for(k = j; k < dao_agg_count; k++) {
+        if(dao_agg[k].dag != dag || dao_agg[k].lifetime != lifetime) {
+          continue;
+        }
+        if(pos + DAO_TARGET_MAX_LEN + DAO_TRANSIT_LEN > DAO_MAX_LEN) {
+          if(group > 0) {
+            pos = dao_add_transit(buffer, pos, lifetime);
+          }
+          dao_agg_send(dag, pos, targets);
+          pos = 0;
+          targets = 0;
+          group = 0;
+        }
+        if(pos == 0) {
+          pos = dao_add_header(buffer, dag);
+        }
+        pos = dao_add_target(buffer, pos, &dao_agg[k].prefix,
+                             dao_agg[k].prefixlen);
+        targets++;
+        group++;
+        dao_agg[k].dag = NULL;
+      }
+      pos = dao_add_transit(buffer, pos, lifetime);
+    }
+    dao_agg_send(dag, pos, targets);
+  }
+
+  dao_agg_count = 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+dao_agg_add(rpl_dag_t *dag, uip_ipaddr_t *prefix, uint8_t prefixlen,
+            rpl_lifetime_t lifetime)
+{
+  struct dao_agg_target *t;
+  int i;
+
+  for(i = 0; i < dao_agg_count; i++) {
+    t = &dao_agg[i];
+    if(t->dag == dag && t->prefixlen == prefixlen &&
+       uip_ipaddr_cmp(&t->prefix, prefix)) {
+      /* A newer advertisement of a target that is already held. */
+      t->lifetime = lifetime;
+      t->current = 1;
+      RPL_STAT(rpl_stats.dao_targets_aggregated++);
+      return 1;
+    }
+  }
+
+  if(dao_agg_count == RPL_DAO_AGGREGATION_TARGETS) {
+    return 0;
+  }
+
+  t = &dao_agg[dao_agg_count++];
+  t->dag = dag;
+  uip_ipaddr_copy(&t->prefix, prefix);
+  t->prefixlen = prefixlen;
+  t->lifetime = lifetime;
+  t->current = 1;
+
+  if(dao_agg_count == 1) {
+    ctimer_set(&dao_agg_timer, RPL_DAO_AGGREGATION_WINDOW,
+               dao_agg_flush, NULL);
+  } else {
+    RPL_STAT(rpl_stats.dao_targets_aggregated++);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Called when a DAO has been processed. If the DAO is forwarded as it
+   is, the targets that it added or renewed are dropped, so that they
+   are not sent a second time by dao_agg_flush(). */
+static void
+dao_agg_done(int forwarded)
+{
+  int i;
+
+  for(i = 0; i < dao_agg_count;) {
+    if(dao_agg[i].current && forwarded) {
+      dao_agg[i] = dao_agg[--dao_agg_count];
+    } else {
+      dao_agg[i++].current = 0;
+    }
+  }
+  if(dao_agg_count == 0) {
+    ctimer_stop(&dao_agg_timer);
+  }
+}
+#endif /* RPL_DAO_AGGREGATION */
+/*---------------------------------------------------------------------------*/
+static int
+dao_target_input(rpl_dag_t *dag, uip_ipaddr_t *from, int learned_from,
+                 uip_ipaddr_t *prefix, uint8_t prefixlen,
+                 rpl_lifetime_t lifetime)
+{
+  uip_ds6_route_t *rep;
+
+  PRINTF("RPL: DAO lifetime: %u, prefix length: %u prefix: ",
+         (unsigned)lifetime, (unsigned)prefixlen);
+  PRINT6ADDR(prefix);
+  PRINTF("\n");
+
+  rep = uip_ds6_route_lookup(prefix);
+
+  if(lifetime == ZERO_LIFETIME) {
+    /* No-Path DAO received; invoke the route purging routine. */
+    if(rep != NULL && rep->state.saved_lifetime == 0) {
+      PRINTF("RPL: Setting expiration timer for prefix ");
+      PRINT6ADDR(prefix);
+      PRINTF("\n");
+      rep->state.saved_lifetime = rep->state.lifetime;
+      rep->state.lifetime = DAO_EXPIRATION_TIMEOUT;
+    }
+    return 1;
+  }
+
+  if(rep == NULL) {
+    rep = rpl_add_route(dag, prefix, prefixlen, from);
+    if(rep == NULL) {
+      RPL_STAT(rpl_stats.mem_overflows++);
+      PRINTF("RPL: Could not add a route after receiving a DAO\n");
+      return 0;
+    }
+  }
+
+  rep->state.lifetime = RPL_LIFETIME(dag, lifetime);
+  rep->state.learned_from = learned_from;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 static void
 dao_input(void)
 {
@@ -620,19 +893,19 @@ dao_input(void)
   uint8_t prefixlen;
   uint8_t flags;
   uint8_t subopt_type;
-  uint8_t pathcontrol;
-  uint8_t pathsequence;
   uip_ipaddr_t prefix;
-  uip_ds6_route_t *rep;
-  uint8_t buffer_length;
+  uint16_t buffer_length;
   int pos;
   int len;
   int i;
+  int j;
   int learned_from;
+  int target_pos;
+  int accepted;
+  int forward;
+  int queued;
   rpl_parent_t *p;
 
-  prefixlen = 0;
-
   uip_ipaddr_copy(&dao_sender_addr, &UIP_IP_BUF->srcipaddr);
 
   /* Destination Advertisement Object */
@@ -640,6 +913,8 @@ dao_input(void)
   PRINT6ADDR(&dao_sender_addr);
   PRINTF("\n");
 
+  RPL_STAT(rpl_stats.dao_in++);
+
   buffer = UIP_ICMP_PAYLOAD;
   buffer_length = uip_len - uip_l2_l3_icmp_hdr_len;
 #if RPL_CONF_ADJUST_LLH_LEN
@@ -656,8 +931,6 @@ dao_input(void)
     return;
   }
 
-  lifetime = dag->default_lifetime;
-
   flags = buffer[pos++];
   /* reserved */
   pos++;
@@ -670,53 +943,6 @@ dao_input(void)
     pos += 16;
   }
 
-  /* Check if there are any DIO sub-options. */
-  i = pos;
-  for(; i < buffer_length; i += len) {
-    subopt_type = buffer[i];
-    if(subopt_type == RPL_DIO_SUBOPT_PAD1) {
-      len = 1;
-    } else {
-      /* Sub-option with a two-byte header and payload */
-      len = 2 + buffer[i + 1];
-    }
-
-    switch(subopt_type) {
-    case RPL_DIO_SUBOPT_TARGET:
-      /* handle the target option */
-      prefixlen = buffer[i + 3];
-      memset(&prefix, 0, sizeof(prefix));
-      memcpy(&prefix, buffer + i + 4, (prefixlen + 7) / CHAR_BIT);
-      break;
-    case RPL_DIO_SUBOPT_TRANSIT:
-      /* The path sequence and control are ignored. */
-      pathcontrol = buffer[i + 3];
-      pathsequence = buffer[i + 4];
-      lifetime = buffer[i + 5];
-      /* The parent address is also ignored. */
-      break;
-    }
-  }
-
-  PRINTF("RPL: DAO lifetime: %u, prefix length: %u prefix: ",
-       (unsigned)lifetime, (unsigned)prefixlen);
-  PRINT6ADDR(&prefix);
-  PRINTF("\n");
-
-  rep = uip_ds6_route_lookup(&prefix);
-
-  if(lifetime == ZERO_LIFETIME) {
-    /* No-Path DAO received; invoke the route purging routine. */
-    if(rep != NULL && rep->state.saved_lifetime == 0) {
-      PRINTF("RPL: Setting expiration timer for prefix ");
-      PRINT6ADDR(&prefix);
-      PRINTF("\n");
-      rep->state.saved_lifetime = rep->state.lifetime;
-      rep->state.lifetime = DAO_EXPIRATION_TIMEOUT;
-    }
-    return;
-  }
-
   learned_from = uip_is_addr_mcast(&dao_sender_addr) ?
                  RPL_ROUTE_FROM_MULTICAST_DAO : RPL_ROUTE_FROM_UNICAST_DAO;
 
@@ -725,36 +951,113 @@ dao_input(void)
     p = rpl_find_parent(dag, &dao_sender_addr);
     if(p != NULL && DAG_RANK(p->rank, dag) < DAG_RANK(dag->rank, dag)) {
       PRINTF("RPL: Loop detected when receiving a unicast DAO from a node with a lower rank! (%u < %u)\n",
-        DAG_RANK(p->rank, dag), DAG_RANK(dag->rank, dag));
+          DAG_RANK(p->rank, dag), DAG_RANK(dag->rank, dag));
       p->rank = INFINITE_RANK;
       p->updated = 1;
       return;
     }
   }
 
-  if(rep == NULL) {
-    rep = rpl_add_route(dag, &prefix, prefixlen, &dao_sender_addr);
-    if(rep == NULL) {
-      RPL_STAT(rpl_stats.mem_overflows++);
-      PRINTF("RPL: Could not add a route after receiving a DAO\n");
-      return;
+  /* A DAO may carry several targets. A Transit Information option
+     applies to the Target options that precede it; targets that no
+     Transit Information option follows get the default lifetime. */
+  accepted = 1;
+  forward = 0;
+  queued = 0;
+  target_pos = -1;
+  for(i = pos; i <= buffer_length; i += len) {
+    if(i == buffer_length) {
+      if(target_pos < 0) {
+        break;
+      }
+      /* Targets at the end of the message. */
+      subopt_type = RPL_DIO_SUBOPT_TRANSIT;
+      len = 0;
+      lifetime = dag->default_lifetime;
+    } else {
+      subopt_type = buffer[i];
+      if(subopt_type == RPL_DIO_SUBOPT_PAD1) {
+        len = 1;
+      } else {
+        /* The option consists of a two-byte header and a payload. */
+        len = 2 + buffer[i + 1];
+      }
+      if(subopt_type == RPL_DIO_SUBOPT_TARGET && target_pos < 0) {
+        target_pos = i;
+      }
+      if(subopt_type != RPL_DIO_SUBOPT_TRANSIT) {
+        continue;
+      }
+      /* The path sequence and control are ignored. */
+      lifetime = buffer[i + 5];
+    }
+
+    /* Handle the targets that this transit information applies to. */
+    for(j = target_pos; j >= 0 && j < i;
+        j += buffer[j] == RPL_DIO_SUBOPT_PAD1 ? 1 : 2 + buffer[j + 1]) {
+      if(buffer[j] != RPL_DIO_SUBOPT_TARGET) {
+        continue;
+      }
+      prefixlen = buffer[j + 3];
+      memset(&prefix, 0, sizeof(prefix));
+      memcpy(&prefix, buffer + j + 4, (prefixlen + 7) / CHAR_BIT);
+
+      if(!dao_target_input(dag, &dao_sender_addr, learned_from,
+                           &prefix, prefixlen, lifetime)) {
+        accepted = 0;
+        continue;
+      }
+      if(lifetime != ZERO_LIFETIME) {
+        forward++;
+#if RPL_DAO_AGGREGATION
+        if(learned_from == RPL_ROUTE_FROM_UNICAST_DAO &&
+           dag->preferred_parent != NULL &&
+           dao_agg_add(dag, &prefix, prefixlen, lifetime)) {
+          queued++;
+        }
+#endif /* RPL_DAO_AGGREGATION */
+      }
     }
+    target_pos = -1;
   }
 
-  rep->state.lifetime = RPL_LIFETIME(dag, lifetime);
-  rep->state.learned_from = learned_from;
+  if(learned_from != RPL_ROUTE_FROM_UNICAST_DAO) {
+    return;
+  }
 
-  if(learned_from == RPL_ROUTE_FROM_UNICAST_DAO) {
-    if(dag->preferred_parent) {
-      PRINTF("RPL: Forwarding DAO to parent ");
-      PRINT6ADDR(&dag->preferred_parent->addr);
-      PRINTF("\n");
-      uip_icmp6_send(&dag->preferred_parent->addr,
-                     ICMP6_RPL, RPL_CODE_DAO, buffer_length);
-    } else if(flags & RPL_DAO_K_FLAG) {
+  if(dag->preferred_parent == NULL) {
+    if(accepted && (flags & RPL_DAO_K_FLAG)) {
       dao_ack_output(dag, &dao_sender_addr, sequence);
     }
+    return;
+  }
+
+#if RPL_DAO_AGGREGATION
+  dao_agg_done(queued < forward);
+#endif /* RPL_DAO_AGGREGATION */
+
+  if(queued < forward) {
+    /* Some targets could not be held back: forward the DAO as is,
+       with the targets that were. */
+    PRINTF("RPL: Forwarding DAO to parent ");
+    PRINT6ADDR(&dag->preferred_parent->addr);
+    PRINTF("\n");
+    RPL_STAT(rpl_stats.dao_out++);
+    uip_icmp6_send(&dag->preferred_parent->addr,
+                   ICMP6_RPL, RPL_CODE_DAO, buffer_length);
+  }
+
+#if RPL_DAO_AGGREGATION
+  /* The targets are now ours to advertise, so the child gets its
+     acknowledgment from us rather than from the root. */
+  if(accepted && (flags & RPL_DAO_K_FLAG)) {
+    dao_ack_output(dag, &dao_sender_addr, sequence);
   }
+
+  if(dao_agg_count == RPL_DAO_AGGREGATION_TARGETS) {
+    dao_agg_flush(NULL);
+  }
+#endif /* RPL_DAO_AGGREGATION */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -762,7 +1065,6 @@ dao_output(rpl_parent_t *n, rpl_lifetime_t lifetime)
 {
   rpl_dag_t *dag;
   unsigned char *buffer;
-  uint8_t prefixlen;
   uip_ipaddr_t addr;
   uip_ipaddr_t prefix;
   int pos;
@@ -785,26 +1087,10 @@ dao_output(rpl_parent_t *n, rpl_lifetime_t lifetime)
 
   buffer = UIP_ICMP_PAYLOAD;
 
-  ++dao_sequence;
-  pos = 0;
-
-  buffer[pos++] = dag->instance_id;
-#if RPL_CONF_DAO_ACK
-  buffer[pos++] = RPL_DAO_K_FLAG; /* DAO ACK request, no DODAGID */
-#else
-  buffer[pos++] = 0; /* No DAO ACK request, no DODAGID */
-#endif
-  buffer[pos++] = 0; /* reserved */
-  buffer[pos++] = dao_sequence & 0xff;
+  pos = dao_add_header(buffer, dag);
 
   /* create target subopt */
-  prefixlen = sizeof(prefix) * CHAR_BIT;
-  buffer[pos++] = RPL_DIO_SUBOPT_TARGET;
-  buffer[pos++] = 2 + ((prefixlen + 7) / CHAR_BIT);
-  buffer[pos++] = 0; /* reserved */
-  buffer[pos++] = prefixlen;
-  memcpy(buffer + pos, &prefix, (prefixlen + 7) / CHAR_BIT);
-  pos += ((prefixlen + 7) / CHAR_BIT);
+  pos = dao_add_target(buffer, pos, &prefix, sizeof(prefix) * CHAR_BIT);
 
   /* Create a transit information sub-option. */
   buffer[pos++] = RPL_DIO_SUBOPT_TRANSIT;
@@ -832,6 +1118,7 @@ dao_output(rpl_parent_t *n, rpl_lifetime_t lifetime)
   }
   PRINTF("\n");
 
+  RPL_STAT(rpl_stats.dao_out++);
   uip_icmp6_send(&addr, ICMP6_RPL, RPL_CODE_DAO, pos);
 }
 /*---------------------------------------------------------------------------*/
@@ -902,14 +1189,3 @@ uip_rpl_input(void)
 
   uip_len = 0;
 }
-
-void clear_dio_mc(rpl_dio_t *dio){
-
-  rpl_metric_container_t *m,*tmp;
-  for (m = list_head(dio->mcs); m != NULL;){
-    tmp = m->next;
-    memb_free(&mc_memb,m);
-    m = tmp;
-  }
-  
-}
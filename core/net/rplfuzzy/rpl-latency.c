@@ -0,0 +1,206 @@
+/**
+ * \addtogroup uip6
+ * @{
+ */
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+/**
+ * \file
+ *         Passive one-hop latency estimation for the fuzzy OF.
+ *
+ *         Every DIO carries the sender's Trickle schedule: the time
+ *         left of the current interval and the offset and remaining
+ *         length of the next one. From that a parent's next DIO is
+ *         expected at a known time after the current one was received,
+ *         and how late it actually arrives is a one-hop delay sample.
+ *         Samples are smoothed per parent and added to the path latency
+ *         the parent advertises in its metric container.
+ *
+ *         All parents share one timer, set to the earliest point at
+ *         which an expected DIO is overdue.
+ *
+ * \author agent <agent@local>
+ */
+
+#include "net/rplfuzzy/rpl-private.h"
+#include "sys/ctimer.h"
+
+#define DEBUG DEBUG_NONE
+#include "net/uip-debug.h"
+
+/* Weight, out of RPL_LATENCY_SCALE, of the old estimate when a new
+   sample is merged into it. */
+#ifdef RPL_CONF_LATENCY_ALPHA
+#define RPL_LATENCY_ALPHA RPL_CONF_LATENCY_ALPHA
+#else
+#define RPL_LATENCY_ALPHA 90
+#endif /* RPL_CONF_LATENCY_ALPHA */
+#define RPL_LATENCY_SCALE 100
+
+/* Slack added to the end of the advertised window before a DIO is
+   considered missed. It bounds the largest delay that can be
+   measured. */
+#ifdef RPL_CONF_LATENCY_GUARD
+#define RPL_LATENCY_GUARD RPL_CONF_LATENCY_GUARD
+#else
+#define RPL_LATENCY_GUARD (CLOCK_SECOND / 2)
+#endif /* RPL_CONF_LATENCY_GUARD */
+
+/* Schedules longer than this cannot be timed with clock_time_t. */
+#define MAX_WAIT ((clock_time_t)~0 >> 1)
+
+static struct ctimer latency_timer;
+
+static void handle_latency_timer(void *ptr);
+/************************************************************************/
+static uint16_t
+ticks_to_ms(clock_time_t ticks)
+{
+  uint32_t ms;
+
+  ms = ((uint32_t)ticks * 1000) / CLOCK_SECOND;
+  return ms > 0xffff ? 0xffff : ms;
+}
+/************************************************************************/
+static void
+schedule(rpl_dag_t *dag)
+{
+  rpl_parent_t *p;
+  clock_time_t now;
+  clock_time_t left;
+  clock_time_t next;
+  int armed;
+
+  now = clock_time();
+  armed = 0;
+  next = 0;
+  for(p = list_head(dag->parents); p != NULL; p = p->next) {
+    if(p->dio_window == 0) {
+      continue;
+    }
+    left = p->dio_offset + p->dio_window - (clock_time_t)(now - p->dio_rx_time);
+    if(left > MAX_WAIT) {
+      /* Already overdue. */
+      left = 0;
+    }
+    if(!armed || left < next) {
+      next = left;
+      armed = 1;
+    }
+  }
+
+  if(armed) {
+    ctimer_set(&latency_timer, next + 1, handle_latency_timer, dag);
+  } else {
+    ctimer_stop(&latency_timer);
+  }
+}
+/************************************************************************/
+static void
+handle_latency_timer(void *ptr)
+{
+  rpl_dag_t *dag;
+  rpl_parent_t *p;
+  clock_time_t now;
+
+  dag = ptr;
+  now = clock_time();
+  for(p = list_head(dag->parents); p != NULL; p = p->next) {
+    if(p->dio_window != 0 &&
+       (clock_time_t)(now - p->dio_rx_time) > p->dio_offset + p->dio_window) {
+      PRINTF("RPL: Expected DIO from ");
+      PRINT6ADDR(&p->addr);
+      PRINTF(" not received\n");
+      p->dio_window = 0;
+      if(p == dag->preferred_parent) {
+        /* Ask for a DIO to pick up the parent's schedule again. */
+        dis_output(&p->addr);
+      }
+    }
+  }
+  schedule(dag);
+}
+/************************************************************************/
+void
+rpl_latency_dio_received(rpl_parent_t *p, rpl_dio_t *dio)
+{
+  clock_time_t elapsed;
+  uint32_t wait;
+  uint16_t sample;
+
+  elapsed = (clock_time_t)(dio->reception_time - p->dio_rx_time);
+  if(p->dio_window != 0) {
+    if(elapsed < p->dio_offset) {
+      /* Either a unicast DIO or the parent has reset its Trickle timer.
+         Keep waiting; if the schedule is gone the DIO will be missed
+         and the next one re-arms the estimator. */
+      return;
+    }
+    if(elapsed <= p->dio_offset + p->dio_window) {
+      sample = ticks_to_ms(elapsed - p->dio_offset);
+      if(p->link_latency == 0) {
+        p->link_latency = sample;
+      } else {
+        p->link_latency = ((uint32_t)p->link_latency * RPL_LATENCY_ALPHA +
+                           (uint32_t)sample * (RPL_LATENCY_SCALE - RPL_LATENCY_ALPHA) +
+                           RPL_LATENCY_SCALE / 2) / RPL_LATENCY_SCALE;
+      }
+      PRINTF("RPL: Latency sample %u ms, estimate %u ms\n",
+             sample, p->link_latency);
+      p->updated = 1;
+    }
+  }
+
+  wait = dio->dio_delay + dio->next_dio_time + dio->next_dio_delay;
+  if(dio->next_dio_time == 0 || wait > MAX_WAIT - RPL_LATENCY_GUARD) {
+    p->dio_window = 0;
+  } else {
+    p->dio_rx_time = dio->reception_time;
+    p->dio_offset = dio->dio_delay + dio->next_dio_time;
+    p->dio_window = dio->next_dio_delay + RPL_LATENCY_GUARD;
+  }
+  schedule(p->dag);
+}
+/************************************************************************/
+uint16_t
+rpl_latency_path(rpl_parent_t *p)
+{
+  uint32_t latency;
+
+  if(p->metrics.latency >= 0xffff) {
+    return 0xffff;
+  }
+  latency = p->metrics.latency + p->link_latency;
+  return latency > 0xffff ? 0xffff : latency;
+}
+/************************************************************************/
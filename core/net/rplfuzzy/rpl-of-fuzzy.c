@@ -61,6 +61,18 @@
 
 #include "fuzzify.h"
 
+/* Keep runtime updates of the rule base across reboots. */
+#ifdef RPL_CONF_FUZZY_SETTINGS
+#define RPL_FUZZY_SETTINGS RPL_CONF_FUZZY_SETTINGS
+#else
+#define RPL_FUZZY_SETTINGS 0
+#endif /* RPL_CONF_FUZZY_SETTINGS */
+
+#if RPL_FUZZY_SETTINGS
+#include "lib/settings.h"
+#define SETTINGS_KEY_RPL_FUZZY TCC('R','F')
+#endif /* RPL_FUZZY_SETTINGS */
+
 MEMB(mc_memb, rpl_metric_container_t,6);
 
 
@@ -95,11 +107,21 @@ rpl_of_t rpl_of_fuzzy = {
 /* Reject parents that have a higher path cost than the following. */
 #define MAX_PATH_COST			100
 
-/*
- * The rank must differ more than 1/PARENT_SWITCH_THRESHOLD_DIV in order
- * to switch preferred parent.
- */
-#define PARENT_SWITCH_THRESHOLD_DIV	2
+/* Parents whose ranks differ by at most this many hops are compared
+   by their fuzzy quality instead. */
+#ifdef RPL_CONF_FUZZY_RANK_HYSTERESIS
+#define RPL_FUZZY_RANK_HYSTERESIS	RPL_CONF_FUZZY_RANK_HYSTERESIS
+#else
+#define RPL_FUZZY_RANK_HYSTERESIS	1
+#endif /* RPL_CONF_FUZZY_RANK_HYSTERESIS */
+
+/* The quality advantage a parent needs over the preferred parent to
+   replace it. */
+#ifdef RPL_CONF_FUZZY_METRIC_HYSTERESIS
+#define RPL_FUZZY_METRIC_HYSTERESIS	RPL_CONF_FUZZY_METRIC_HYSTERESIS
+#else
+#define RPL_FUZZY_METRIC_HYSTERESIS	5
+#endif /* RPL_CONF_FUZZY_METRIC_HYSTERESIS */
 
 typedef uint16_t rpl_path_metric_t;
 
@@ -122,59 +144,26 @@ calculate_path_metric(rpl_parent_t *p)
     return MAX_PATH_COST * RPL_DAG_MC_ETX_DIVISOR;
   }
 
-  rpl_metric_container_t *m,*etx_mc = NULL;
-  for (m = list_head(p->mcs);m != NULL && etx_mc == NULL; m = m->next){
-    switch(m->type){
-    case RPL_DAG_MC_ETX:
-      etx_mc = m;
-      break;
-    }
-  }
-  if (etx_mc == NULL){
+  if(!RPL_METRICS_HAS(&p->metrics, RPL_DAG_MC_ETX)) {
     PRINTF("No ETX metric container for parent\n");
     return 0;
   }
 
-  if(etx_mc->obj.etx == 0 && p->rank > ROOT_RANK(p->dag)) {
+  if(p->metrics.etx == 0 && p->rank > ROOT_RANK(p->dag)) {
     return MAX_PATH_COST * RPL_DAG_MC_ETX_DIVISOR;
   }
-  return etx_mc->obj.etx + NI_ETX_TO_RPL_ETX(p->link_metric);
+  return p->metrics.etx + NI_ETX_TO_RPL_ETX(p->link_metric);
 }
 
 static rpl_path_metric_t
 calculate_fuzzy_metric(rpl_parent_t *p)
 {
 
-  rpl_metric_container_t *m;
-  uint16_t energy, hopcount, etx, throughput, lql;
-  uint32_t latency;
-  
-  for (m = list_head(p->mcs);m != NULL; m = m->next){
-    switch(m->type){
-    case RPL_DAG_MC_ENERGY:
-      energy = m->obj.energy.energy_est;
-      break;
-    case RPL_DAG_MC_THROUGHPUT:
-      throughput = m->obj.throughput;
-      break;
-    case RPL_DAG_MC_HOPCOUNT:
-      hopcount = m->obj.hopcount;
-      break;
-    case RPL_DAG_MC_LATENCY:
-      latency = m->obj.latency;
-      break;
-    case RPL_DAG_MC_ETX:
-      etx = m->obj.etx;
-      break;
-    case RPL_DAG_MC_LQL:
-      lql = m->obj.lql;
-      break;
-    }
-  }
-  
-  return quality(consumption(energy,throughput),
-   		 qos(reliability(lql,etx),
-   		     duration(hopcount,latency)));
+  rpl_metrics_t *m = &p->metrics;
+
+  return quality(consumption(m->energy.energy_est, m->throughput),
+   		 qos(reliability(m->lql, m->etx),
+   		     duration(m->hopcount, rpl_latency_path(p))));
   /*return consumption(energy, throughput);*/
   
   
@@ -196,38 +185,20 @@ calculate_lql_path_metric(int nid)
   return 4;
 }*/
 
-static rpl_metric_container_t * calculate_incremental_metric(rpl_parent_t *p, int type){
-  rpl_metric_container_t *m;
-  if (p != NULL)
-    for (m = list_head(p->mcs);m != NULL; m = m->next){
-      if (m->type == type)
-	return m;
-    }
-  return NULL;
-}
-
-
 static rpl_path_metric_t
 calculate_hopcount_path_metric(rpl_parent_t *p){
-  rpl_metric_container_t *m;
   if (p == NULL)
     return 0;
-  m = calculate_incremental_metric(p, RPL_DAG_MC_HOPCOUNT);
-  return m->obj.hopcount + 1;
+  return p->metrics.hopcount + 1;
 }
   
   
 
 static rpl_path_metric_t
 calculate_latency_path_metric(rpl_parent_t *p){  
-  rpl_metric_container_t *m;
   if (p == NULL)
     return 0;
-  m = calculate_incremental_metric(p, RPL_DAG_MC_LATENCY);
-  if (p->latency_metric ){
-    return 200;/*m->obj.latency + *//*p->latency_metric;*/
-  }
-  return 0;
+  return rpl_latency_path(p);
 }
 
 
@@ -325,63 +296,97 @@ static rpl_parent_t *
 best_parent(rpl_parent_t *p1, rpl_parent_t *p2)
 {
   rpl_dag_t *dag;
-  rpl_path_metric_t min_diff;
+  rpl_rank_t p1_rank;
+  rpl_rank_t p2_rank;
   uint32_t p1_metric;
-  uint32_t  p2_metric;
+  uint32_t p2_metric;
 
   dag = p1->dag; /* Both parents must be in the same DAG. */
-  
-  min_diff = RPL_DAG_MC_ETX_DIVISOR / 
-             PARENT_SWITCH_THRESHOLD_DIV;
-  
-  min_diff = 5;
+
+  /*
+   * First compare ranks: a clearly lower rank is the best, and the
+   * fuzzy metrics need not be computed at all.
+   */
+  p1_rank = DAG_RANK(p1->rank, dag);
+  p2_rank = DAG_RANK(p2->rank, dag);
+  if(p1_rank + RPL_FUZZY_RANK_HYSTERESIS < p2_rank) {
+    return p1;
+  } else if(p1_rank > p2_rank + RPL_FUZZY_RANK_HYSTERESIS) {
+    return p2;
+  }
 
   p1_metric = calculate_fuzzy_metric(p1);
   p2_metric = calculate_fuzzy_metric(p2);
 
-  /* Maintain stability of the preferred parent in case of similar ranks. */
-  
-  /*
+  /* Maintain stability of the preferred parent in case of similar
+     qualities: the other parent must be clearly better. */
   if(p1 == dag->preferred_parent || p2 == dag->preferred_parent) {
-    if(p1_metric < p2_metric + min_diff &&
-       p1_metric > p2_metric - min_diff) {
-      PRINTF("RPL: MRHOF hysteresis: %u <= %u <= %u\n",
-             p2_metric - min_diff,
-             p1_metric,
-             p2_metric + min_diff);
+    if(p1_metric < p2_metric + RPL_FUZZY_METRIC_HYSTERESIS &&
+       p2_metric < p1_metric + RPL_FUZZY_METRIC_HYSTERESIS) {
+      PRINTF("RPL: Fuzzy hysteresis: %lu and %lu\n",
+             (unsigned long)p1_metric, (unsigned long)p2_metric);
       return dag->preferred_parent;
     }
   }
-  */
- 
 
-  /*
-   * First compare ranks : any less rank
-   * is the best
-   */
-    
-  if (DAG_RANK(p1->rank,dag) + 1 < DAG_RANK(p2->rank,dag))
-    return p1;
-  else  if (DAG_RANK(p1->rank,dag) > DAG_RANK(p2->rank,dag) + 1)
-    return p2;
-  /*
-   * if ranks and metrics equalities and if one is the preferred
-   * parent then return the preferred parent to improve stability
-   */
-  if (p1 == dag->preferred_parent || p2 == dag->preferred_parent)
-    if (p1_metric == p2_metric)
-      return dag->preferred_parent;
-  /*
-   * Only ranks are equals so the best is the
-   * higher metric
-   */
-  return  p1_metric >= p2_metric ? p1 : p2;
+  /* Ranks are similar so the best is the higher quality. */
+  return p1_metric >= p2_metric ? p1 : p2;
+}
 
 
-  
+static void
+load_rules(void)
+{
+#if RPL_FUZZY_SETTINGS
+  struct fuzzy_rules stored;
+  settings_length_t size;
+
+  size = sizeof(stored);
+  if(settings_get(SETTINGS_KEY_RPL_FUZZY, 0, (uint8_t *)&stored,
+                  &size) == SETTINGS_STATUS_OK &&
+     size == sizeof(stored) && fuzzy_rules_set(&stored)) {
+    PRINTF("RPL: Using the stored fuzzy rule base\n");
+  }
+#endif /* RPL_FUZZY_SETTINGS */
+}
+
+static void
+rerank(void)
+{
+  rpl_dag_t *dag;
 
+  /* An event on the preferred parent makes rpl_select_parent()
+     compare all parents again. */
+  dag = rpl_get_dag(RPL_ANY_INSTANCE);
+  if(dag != NULL && dag->preferred_parent != NULL) {
+    rpl_process_parent_event(dag, dag->preferred_parent);
+  }
 }
 
+int
+rpl_of_fuzzy_update_rules(const uint8_t *buf, uint16_t len)
+{
+  if(!fuzzy_rules_update(buf, len)) {
+    PRINTF("RPL: Rejected a fuzzy rule base update\n");
+    return 0;
+  }
+#if RPL_FUZZY_SETTINGS
+  settings_set(SETTINGS_KEY_RPL_FUZZY, (const uint8_t *)fuzzy_rules_get(),
+               sizeof(struct fuzzy_rules));
+#endif /* RPL_FUZZY_SETTINGS */
+  rerank();
+  return 1;
+}
+
+void
+rpl_of_fuzzy_reset_rules(void)
+{
+  fuzzy_rules_reset();
+#if RPL_FUZZY_SETTINGS
+  settings_delete(SETTINGS_KEY_RPL_FUZZY, 0);
+#endif /* RPL_FUZZY_SETTINGS */
+  rerank();
+}
 
 static initialized = 0;
 static int nodeid = -1;
@@ -398,6 +403,7 @@ static void init(rpl_dag_t *dag){
     return;
 
   mydag = dag;
+  load_rules();
 
   list_init(dag->mcs);
 
@@ -413,8 +419,8 @@ static void init(rpl_dag_t *dag){
   /*
   energy->aggr =  RPL_DAG_MC_AGGR_ADDITIVE;
   energy->prec = 0;
-  energy->length = sizeof(energy->obj.energy);
   */
+  energy->length = sizeof(energy->obj.energy);
   list_add(dag->mcs,energy);
   //ANNOTATE("#A E=%u\n",energy->obj.energy.energy_est);
 
@@ -429,8 +435,8 @@ static void init(rpl_dag_t *dag){
   throughput->flags = RPL_DAG_MC_FLAG_P;
   throughput->aggr =  RPL_DAG_MC_AGGR_ADDITIVE;
   throughput->prec = 0;
-  throughput->length = sizeof(throughput->obj.throughput);
   */
+  throughput->length = sizeof(throughput->obj.throughput);
   list_add(dag->mcs,throughput);
   //ANNOTATE("#A T=%u\n",throughput->obj.throughput);*/
 
@@ -462,8 +468,8 @@ static void init(rpl_dag_t *dag){
   etx->flags = RPL_DAG_MC_FLAG_P;
   etx->aggr =  RPL_DAG_MC_AGGR_ADDITIVE;
   etx->prec = 0;
-  etx->length = sizeof(etx->obj.etx);
   */
+  etx->length = sizeof(etx->obj.etx);
   list_add(dag->mcs,etx);
   //ANNOTATE("#A ETX=%u\n",etx->obj.etx);
 
@@ -478,8 +484,8 @@ static void init(rpl_dag_t *dag){
   hopcount->flags = RPL_DAG_MC_FLAG_P;
   hopcount->aggr =  RPL_DAG_MC_AGGR_ADDITIVE;
   hopcount->prec = 0;
-  hopcount->length = sizeof(hopcount->obj.hopcount);
   */
+  hopcount->length = sizeof(hopcount->obj.hopcount);
   list_add(dag->mcs,hopcount);
   //ANNOTATE("#A HC=%u\n",hopcount->obj.hopcount);
 
@@ -494,8 +500,8 @@ static void init(rpl_dag_t *dag){
   latency->flags = RPL_DAG_MC_FLAG_P;
   latency->aggr =  RPL_DAG_MC_AGGR_ADDITIVE;
   latency->prec = 0;
-  latency->length = sizeof(latency->obj.latency);
   */
+  latency->length = sizeof(latency->obj.latency);
   list_add(dag->mcs,latency);
   //ANNOTATE("#A Lat=%u\n",latency->obj.latency);
 
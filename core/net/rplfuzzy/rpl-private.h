@@ -153,6 +153,38 @@
 #define DEFAULT_DIO_REDUNDANCY          10
 #endif
 
+/* The number of consecutive parent events in which the same parent
+   must beat the preferred parent before RPL switches to it. */
+#ifdef RPL_CONF_PARENT_SWITCH_HOLD
+#define RPL_PARENT_SWITCH_HOLD          RPL_CONF_PARENT_SWITCH_HOLD
+#else
+#define RPL_PARENT_SWITCH_HOLD          2
+#endif
+
+/* Aggregation of the DAOs that a storing-mode node forwards: targets
+   learned from children are held for a short window and advertised
+   to the preferred parent together, in DAOs with several targets. */
+#ifdef RPL_CONF_DAO_AGGREGATION
+#define RPL_DAO_AGGREGATION             RPL_CONF_DAO_AGGREGATION
+#else
+#define RPL_DAO_AGGREGATION             1
+#endif
+
+/* How long targets are held before they are forwarded. */
+#ifdef RPL_CONF_DAO_AGGREGATION_WINDOW
+#define RPL_DAO_AGGREGATION_WINDOW      RPL_CONF_DAO_AGGREGATION_WINDOW
+#else
+#define RPL_DAO_AGGREGATION_WINDOW      (CLOCK_SECOND / 2)
+#endif
+
+/* The number of targets that can be held; a full buffer is forwarded
+   at once. */
+#ifdef RPL_CONF_DAO_AGGREGATION_TARGETS
+#define RPL_DAO_AGGREGATION_TARGETS     RPL_CONF_DAO_AGGREGATION_TARGETS
+#else
+#define RPL_DAO_AGGREGATION_TARGETS     8
+#endif
+
 /* Expire DAOs from neighbors that do not respond in this time. (seconds) */
 #define DAO_EXPIRATION_TIMEOUT          60
 /*---------------------------------------------------------------------------*/
@@ -214,8 +246,7 @@ struct rpl_dio {
   rpl_prefix_t destination_prefix;
   rpl_prefix_t prefix_info;
   /* Fuzzy metrics */
-  list_t mcs;
-  void * mc_list;
+  rpl_metrics_t metrics;
   uint32_t reception_time;
   uint32_t dio_delay;
   uint32_t next_dio_time;
@@ -233,6 +264,10 @@ struct rpl_stats {
   uint16_t malformed_msgs;
   uint16_t resets;
   uint16_t parent_switch;
+  uint16_t parent_switch_held;
+  uint16_t dao_in;
+  uint16_t dao_out;
+  uint16_t dao_targets_aggregated;
 };
 typedef struct rpl_stats rpl_stats_t;
 
@@ -250,6 +285,7 @@ extern rpl_stats_t rpl_stats;
 /* ICMPv6 functions for RPL. */
 void dis_output(uip_ipaddr_t *addr);
 void dio_output(rpl_dag_t *, uip_ipaddr_t *uc_addr);
+void dio_output_set_next(uint32_t, uint32_t, uint32_t);
 void dao_output(rpl_parent_t *, rpl_lifetime_t lifetime);
 void dao_ack_output(rpl_dag_t *, uip_ipaddr_t *, uint8_t);
 void uip_rpl_input(void);
@@ -269,7 +305,7 @@ void rpl_free_dag(rpl_dag_t *);
 rpl_parent_t *rpl_add_parent(rpl_dag_t *, rpl_dio_t *dio, uip_ipaddr_t *);
 rpl_parent_t *rpl_find_parent(rpl_dag_t *, uip_ipaddr_t *);
 int rpl_remove_parent(rpl_dag_t *, rpl_parent_t *);
-rpl_parent_t *rpl_select_parent(rpl_dag_t *dag);
+rpl_parent_t *rpl_select_parent(rpl_dag_t *dag, rpl_parent_t *updated);
 void rpl_recalculate_ranks(void);
 
 /* RPL routing table functions. */
@@ -289,4 +325,8 @@ void rpl_reset_periodic_timer(void);
 /* Route poisoning. */
 void rpl_poison_routes(rpl_dag_t *, rpl_parent_t *);
 
+/* Latency estimation. */
+void rpl_latency_dio_received(rpl_parent_t *, rpl_dio_t *);
+uint16_t rpl_latency_path(rpl_parent_t *);
+
 #endif /* RPL_PRIVATE_H */
@@ -55,8 +55,6 @@
 static struct ctimer periodic_timer;
 
 static void handle_periodic_timer(void *ptr);
-static void new_dio_interval(rpl_dag_t *dag);
-static void handle_dio_timer(void *ptr);
 
 static uint16_t next_dis;
 
@@ -82,100 +80,53 @@ handle_periodic_timer(void *ptr)
   ctimer_reset(&periodic_timer);
 }
 /************************************************************************/
-
-static uint32_t next_time = 0;
-static uint32_t next_delay = 0;
-
-new_interval(uint32_t * time, uint32_t * next){
-  *time = (*time * CLOCK_SECOND)/1000;
-  *next = *time;
-  *time = *time >> 1;
-  *time += (*time * random_rand()) / RANDOM_RAND_MAX;
-  *next -= *time;
-}
-
-/************************************************************************/
-static void
-new_dio_interval(rpl_dag_t *dag)
+static clock_time_t
+dio_imin(rpl_dag_t *dag)
 {
-  uint32_t time;
-
-  if (!next_time){
-  /* TODO: too small timer intervals for many cases */
-     time = 1UL << dag->dio_intcurrent;
-
-     new_interval(&time, &dag->dio_next_delay);
-  } else {
-    time = next_time;
-    dag->dio_next_delay = next_delay;
-  }
-  dag->dio_send = 1;
-  
-#if RPL_CONF_STATS
-  /* keep some stats */
-  dag->dio_totint++;
-  dag->dio_totrecv += dag->dio_counter;
-  ANNOTATE("#A rank=%u.%u(%u),stats=%d %d %d %d,color=%s\n",
-	   DAG_RANK(dag->rank, dag),
-           (10 * (dag->rank % dag->min_hoprankinc)) / dag->min_hoprankinc,
-           dag->version,
-           dag->dio_totint, dag->dio_totsend,
-           dag->dio_totrecv,dag->dio_intcurrent,
-	   dag->rank == ROOT_RANK(dag) ? "BLUE" : "ORANGE");
-#endif /* RPL_CONF_STATS */
-  
-  /* reset the redundancy counter */
-  dag->dio_counter = 0;
-  
-  /* schedule the timer */
-  PRINTF("RPL: Scheduling DIO timer %lu ticks in future (Interval)\n", time);
-  ctimer_set(&dag->dio_timer, time, &handle_dio_timer, dag);
-
-  /* schedule the next next dio output */
-
-  next_time = 1UL << (dag->dio_intcurrent+1);
-  new_interval(&next_time, &next_delay);
-  dio_output_set_next(next_time, next_delay,dag->dio_next_delay);
+  /* Imin is 2^dio_intmin milliseconds. */
+  return (clock_time_t)(((1UL << dag->dio_intmin) * CLOCK_SECOND) / 1000);
 }
 /************************************************************************/
 static void
-handle_dio_timer(void *ptr)
+handle_dio_timer(void *ptr, uint8_t suppress)
 {
   rpl_dag_t *dag;
-  PRINTF("RPL: handle dio timer\n");
-  dag = (rpl_dag_t *)ptr; 
 
+  dag = (rpl_dag_t *)ptr;
+
+  PRINTF("RPL: DIO Timer triggered\n");
   if(!dio_send_ok) {
     if(uip_ds6_get_link_local(ADDR_PREFERRED) != NULL) {
       dio_send_ok = 1;
     } else {
-      PRINTF("RPL: Postponing DIO transmission since link local address is not ok\n");
-      ctimer_set(&dag->dio_timer, CLOCK_SECOND, &handle_dio_timer, dag);
+      PRINTF("RPL: Skipping DIO transmission since link local address is not ok\n");
       return;
     }
   }
 
-  if(dag->dio_send) {
-    /* send DIO if counter is less than desired redundancy */
-    if(dag->dio_counter < dag->dio_redundancy) {
-#if RPL_CONF_STATS
-      dag->dio_totsend++;
-#endif /* RPL_CONF_STATS */
-      dio_output(dag, NULL);
-    } else {
-      PRINTF("RPL: Supressing DIO transmission (%d >= %d)\n",
-           dag->dio_counter, dag->dio_redundancy);
-    }
-    dag->dio_send = 0;
-    PRINTF("RPL: Scheduling DIO timer %lu ticks in future (sent)\n", dag->dio_next_delay);
-    ctimer_set(&dag->dio_timer, dag->dio_next_delay, handle_dio_timer, dag);
+#if RPL_CONF_STATS && TRICKLE_TIMER_STATS
+  ANNOTATE("#A rank=%u.%u(%u),stats=%d %d %d %lu,color=%s\n",
+	   DAG_RANK(dag->rank, dag),
+           (10 * (dag->rank % dag->min_hoprankinc)) / dag->min_hoprankinc,
+           dag->version,
+           dag->dio_timer.stats.intervals, dag->dio_timer.stats.tx,
+           dag->dio_timer.stats.consistent,
+           (unsigned long)dag->dio_timer.i_cur,
+	   dag->rank == ROOT_RANK(dag) ? "BLUE" : "ORANGE");
+#endif /* RPL_CONF_STATS && TRICKLE_TIMER_STATS */
+
+  if(suppress == TRICKLE_TIMER_TX_OK) {
+    /* Tell the children when our next DIO is due, for their latency
+       estimates. */
+    dio_output_set_next(TRICKLE_TIMER_NEXT_T(&dag->dio_timer),
+                        TRICKLE_TIMER_NEXT_INTERVAL(&dag->dio_timer) -
+                        TRICKLE_TIMER_NEXT_T(&dag->dio_timer),
+                        TRICKLE_TIMER_INTERVAL_END(&dag->dio_timer) -
+                        clock_time());
+    dio_output(dag, NULL);
   } else {
-    /* check if we need to double interval */
-    if(dag->dio_intcurrent < dag->dio_intmin + dag->dio_intdoubl) {
-      dag->dio_intcurrent++;
-    }
-    new_dio_interval(dag);
-
+    PRINTF("RPL: Supressing DIO transmission (%d >= %d)\n",
+           dag->dio_timer.c, dag->dio_redundancy);
   }
 }
 /************************************************************************/
@@ -190,18 +141,16 @@ rpl_reset_periodic_timer(void)
 void
 rpl_reset_dio_timer(rpl_dag_t *dag, uint8_t force)
 {
-    /* only reset if not just reset or started */
-  if(force || dag->dio_intcurrent > dag->dio_intmin) {
-    PRINTF("RPL: Reset DIO Timer\n");
-    dag->dio_counter = 0;
-    dag->dio_intcurrent = dag->dio_intmin;
-
-    /* FUZZY LATENCY */
-    next_time = 0;
-    /* FUZZY LATENCY */
-
-    new_dio_interval(dag);
+  if(force) {
+    /* The DAG configuration may have changed the Trickle parameters. */
+    trickle_timer_config(&dag->dio_timer, dio_imin(dag), dag->dio_intdoubl,
+                         dag->dio_redundancy);
+    if(!trickle_timer_is_running(&dag->dio_timer)) {
+      trickle_timer_set(&dag->dio_timer, handle_dio_timer, dag);
+    }
   }
+  /* Trickle ignores the reset if the interval is Imin already. */
+  trickle_timer_reset_event(&dag->dio_timer);
 #if RPL_CONF_STATS
   rpl_stats.resets++;
 #endif
@@ -250,100 +199,5 @@ rpl_schedule_dao(rpl_dag_t *dag)
   }
 }
 /************************************************************************/
-void handle_next_dio(void * ptr);
-
-void rpl_schedule_next_dio_reception(rpl_parent_t * p, uint32_t delay, uint32_t next_time, uint32_t next_delay){
-  if(p->dag->preferred_parent == p){
-    uint32_t now = clock_time();
-    p->next_dio_delay = next_delay;
-    p->next_dio_time = next_time;
-    p->next_dio_start_interval = now + delay;
-    ctimer_set(&p->latency_timer, delay + next_time + next_delay ,handle_next_dio, p);
-    ANNOTATE("RPL:TRIGGER:DIO it is %lu, next DIO waited at %lu until %lu\n", 
-	     now,
-	     p->next_dio_start_interval + next_time, 
-	     p->next_dio_start_interval + next_time + next_delay);
-  }
-}
-
-static int dis_sended;
-
-static struct ctimer dis_timer;
-
-void send_dis(void * ptr){
-  rpl_parent_t * p = (rpl_parent_t *)ptr;
-  if (!p->first_dio_received){
-    ANNOTATE("RPL:TRIGGER:DIO Send DIS to %u %lu\n",p->addr.u8[15],(100000 * random_rand()) / RANDOM_RAND_MAX);
-    dis_output(p->addr.u8);
-    //dis_output(NULL);
-    ctimer_set(&dis_timer, (100000 * random_rand()) / RANDOM_RAND_MAX, send_dis, p);
-  }
-}
-
-
-void handle_next_dio(void * ptr){
-  rpl_parent_t * p = (rpl_parent_t *)ptr;
-  if(p->dag->preferred_parent == p){
-    p->first_dio_received = 0;
-    ANNOTATE("RPL:TRIGGER:DIO is is %lu and no DIO received : RAZ\n",clock_time());
-    /* p->next_dio_start_interval = clock_time(); */
-    /* p->next_dio_time += p->next_dio_time ; */
-    /* p->next_dio_delay += p->next_dio_delay; */
-    /* ANNOTATE("RPL:TRIGGER:DIO non recu at %lu. Wait next DIO at %lu until %lu\n",  */
-    /* 	     p->next_dio_start_interval, */
-    /* 	     p->next_dio_start_interval + p->next_dio_time, */
-    /* 	     p->next_dio_start_interval + p->next_dio_time  + p->next_dio_delay); */
-    //ctimer_set(&p->latency_timer, p->next_dio_time + p->next_dio_delay,handle_next_dio, p);
-
-    ctimer_set(&dis_timer, (100000 * random_rand()) / RANDOM_RAND_MAX, send_dis, p);
-    /* send_dis(p->addr.u8); */
-    /* dis_sended = 1; */
-  }
-}
-
-void rpl_dio_received(rpl_parent_t * p, uint32_t delay, uint32_t next_time, uint32_t next_delay){
-  if(p->dag->preferred_parent == p){
-    next_delay += 400;
-    if (!p->first_dio_received){
-      ANNOTATE("RPL:TRIGGER:DIO first recu delay %lu, next time %lu, next delay %lu\n",
-	       delay, 
-	       next_time, 
-	       next_delay);
-      rpl_schedule_next_dio_reception(p,delay, next_time, next_delay);
-      p->first_dio_received = 1;
-      dis_sended = 0;
-    }
-    else {
-      uint32_t now = clock_time();
-
-      if (dis_sended){
-
-	uint8_t residual = p->next_dio_start_interval + p->next_dio_time + p->next_dio_delay + next_time - now;
-	ctimer_set(&p->latency_timer,residual + next_delay, handle_next_dio, p);
-	p->next_dio_start_interval = p->next_dio_start_interval;
-	p->next_dio_time = next_time;
-	p->next_dio_delay = next_delay;
-	dis_sended = 0;
-      }	   
-
-      if (now > (p->next_dio_start_interval + p->next_dio_time)){
-	p->latency_metric = now - (p->next_dio_start_interval + p->next_dio_time);
-	ANNOTATE("RPL:TRIGGER:DIO recu at %lu. Latency = %lu\n",now, p->latency_metric);
-	p->dag->of->update_metric_container(p->dag);
-	rpl_schedule_next_dio_reception(p, delay, next_time, next_delay);
-      }
-      else {
-	if ((next_time + next_delay) == (p->next_dio_time + p->next_dio_delay)){
-	  ANNOTATE("RPL:TRIGGER:DIO recu at %lu < %lu + %lu. Latency too early  de %lu\n",
-		   now,
-		   p->next_dio_start_interval,
-		   p->next_dio_time,
-		   (p->next_dio_time + p->next_dio_start_interval) - now );
-	  rpl_schedule_next_dio_reception(p, delay, next_time, next_delay);
-	}
-      }
-    }
-  }
-}
 
 
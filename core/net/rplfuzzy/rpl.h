@@ -43,6 +43,7 @@
 #include "net/uip.h"
 #include "net/uip-ds6.h"
 #include "sys/ctimer.h"
+#include "lib/trickle-timer.h"
 
 /* set to 1 for some statistics on trickle / DIO */
 #ifndef RPL_CONF_STATS
@@ -151,20 +152,33 @@ struct rpl_metric_container {
   } obj;
 };
 typedef struct rpl_metric_container rpl_metric_container_t;
+
+/* The metric objects received from a neighbor, decoded. Bit (1 << type)
+   of "present" is set for each object that was in the container. */
+struct rpl_metrics {
+  uint16_t present;
+  struct rpl_metric_object_energy energy;
+  uint16_t throughput;
+  uint16_t lql;
+  uint16_t etx;
+  uint16_t hopcount;
+  uint32_t latency;
+};
+typedef struct rpl_metrics rpl_metrics_t;
+
+#define RPL_METRICS_HAS(m, type) (((m)->present >> (type)) & 1)
 /*---------------------------------------------------------------------------*/
 struct rpl_dag;
 /*---------------------------------------------------------------------------*/
 struct rpl_parent {
   struct rpl_parent *next;
   struct rpl_dag *dag;
-  list_t mcs;
-  void * mc_list;
-  uint32_t latency_metric;
-  uint8_t first_dio_received;
-  uint32_t next_dio_delay;
-  uint32_t next_dio_time;
-  uint32_t next_dio_start_interval;
-  struct ctimer latency_timer;
+  rpl_metrics_t metrics;
+  /* Latency estimation state, see rpl-latency.c. */
+  clock_time_t dio_rx_time;
+  clock_time_t dio_offset;
+  clock_time_t dio_window;
+  uint16_t link_latency;
   uip_ipaddr_t addr;
   rpl_rank_t rank;
   uint8_t link_metric;
@@ -254,19 +268,11 @@ struct rpl_dag {
   uint16_t lifetime_unit; /* lifetime in seconds = l_u * d_l */
   /* live data for the DAG */
   uint8_t joined;
-  uint8_t dio_intcurrent;
-  uint8_t dio_send; /* for keeping track of which mode the timer is in 
-*/
-  uint8_t dio_counter;
-#if RPL_CONF_STATS
-  uint16_t dio_totint;
-  uint16_t dio_totsend;
-  uint16_t dio_totrecv;
-#endif /* RPL_CONF_STATS */
-  uint32_t dio_next_delay; /* delay for completion of dio interval */
-  struct ctimer dio_timer;
+  struct trickle_timer dio_timer;
   struct ctimer dao_timer;
   rpl_parent_t *preferred_parent;
+  rpl_parent_t *switch_candidate; /* challenger of the preferred parent */
+  uint8_t switch_wins;
   void *parent_list;
   list_t parents;
   rpl_prefix_t prefix_info;
@@ -280,5 +286,14 @@ int rpl_set_prefix(rpl_dag_t *dag, uip_ipaddr_t *prefix, int len);
 int rpl_repair_dag(rpl_dag_t *dag);
 int rpl_set_default_route(rpl_dag_t *dag, uip_ipaddr_t *from);
 rpl_dag_t *rpl_get_dag(int instance_id);
+
+/*
+ * Replace records of the rule base of the fuzzy objective function
+ * (see fuzzify.h for the format) and re-rank the parents with it.
+ * Returns 0, leaving the rule base as it was, if any record is invalid.
+ */
+int rpl_of_fuzzy_update_rules(const uint8_t *buf, uint16_t len);
+/* Go back to the compiled-in rule base. */
+void rpl_of_fuzzy_reset_rules(void);
 /*---------------------------------------------------------------------------*/
 #endif /* RPL_H */
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Interface between tcpip and the link layer for packet schedulers
+ *
+ *         A scheduler sits between tcpip_output() and the 6lowpan
+ *         output function. It may transmit a packet immediately or
+ *         keep a copy and release it later, in a different order,
+ *         when the link layer has finished with the previous one.
+ *         The scheduler is selected with NETSTACK_CONF_SCHED; the
+ *         default, nullsched_driver, passes every packet straight
+ *         through.
+ *
+ * \author
+ *         agent <agent@local>
+ */
+
+#ifndef __SCHED_H__
+#define __SCHED_H__
+
+#include "net/uip.h"
+#include "net/netstack.h"
+
+/**
+ * The structure of a packet scheduler in Contiki.
+ */
+struct sched_driver {
+  char *name;
+
+  /** Initialize the scheduler. output is the function that compresses
+      the IP packet in uip_buf and hands it to the MAC layer. */
+  void (* init)(u8_t (* output)(uip_lladdr_t *));
+
+  /** Send or queue the IP packet in uip_buf. A NULL lladdr means
+      link-layer broadcast. */
+  u8_t (* send)(uip_lladdr_t *lladdr);
+
+  /** Called by the link layer when it has finished with all frames
+      of the packet last passed to output. */
+  void (* sent)(void);
+};
+
+extern const struct sched_driver nullsched_driver;
+extern const struct sched_driver NETSTACK_SCHED;
+
+#endif /* __SCHED_H__ */
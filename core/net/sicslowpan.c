@@ -68,6 +68,7 @@
 #include "net/sicslowpan.h"
 #include "net/neighbor-info.h"
 #include "net/netstack.h"
+#include "net/sched.h"
 
 #include <stdio.h>
 
@@ -157,9 +158,11 @@ void uip_log(char *msg);
  */
 #define SICSLOWPAN_IP_BUF   ((struct uip_ip_hdr *)&sicslowpan_buf[UIP_LLH_LEN])
 #define SICSLOWPAN_UDP_BUF ((struct uip_udp_hdr *)&sicslowpan_buf[UIP_LLIPH_LEN])
+#define SICSLOWPAN_EXT_BUF ((struct uip_ext_hdr *)&sicslowpan_buf[UIP_LLIPH_LEN])
 
 #define UIP_IP_BUF          ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
 #define UIP_UDP_BUF          ((struct uip_udp_hdr *)&uip_buf[UIP_LLIPH_LEN])
+#define UIP_EXT_BUF          ((struct uip_ext_hdr *)&uip_buf[UIP_LLIPH_LEN])
 #define UIP_TCP_BUF          ((struct uip_tcp_hdr *)&uip_buf[UIP_LLIPH_LEN])
 /** @} */
 
@@ -177,6 +180,23 @@ void uip_log(char *msg);
 #define COMPRESSION_THRESHOLD 0
 #endif
 
+/** \brief Encode a routing header that directly follows the IPv6
+    header with LOWPAN_NHC, so that the transport header behind it
+    can be compressed too. Configurable through
+    SICSLOWPAN_CONF_COMPRESS_EXT_HDR. */
+#ifdef SICSLOWPAN_CONF_COMPRESS_EXT_HDR
+#define SICSLOWPAN_COMPRESS_EXT_HDR SICSLOWPAN_CONF_COMPRESS_EXT_HDR
+#else
+#define SICSLOWPAN_COMPRESS_EXT_HDR 1
+#endif
+
+/* Longer routing headers (in units of 8 octets, not counting the
+   first 8) are sent inline. Up to 48 bytes of IPHC, LOWPAN_NHC and
+   LOWPAN_UDP headers come with the routing header, and all of them
+   must fit in the first fragment. */
+#define NHC_EXT_MAX_LEN \
+  ((MAC_MAX_PAYLOAD - SICSLOWPAN_FRAG1_HDR_LEN - 48) / 8 - 1)
+
 /** \name General variables
  *  @{
  */
@@ -215,6 +235,13 @@ static u8_t rime_payload_len;
  * is used this includes the UDP header in addition to the IP header).
  */
 static u8_t uncomp_hdr_len;
+
+/**
+ * The number of frames handed to the MAC layer whose sent callback
+ * has not been called yet. The packet scheduler is told when it
+ * drops back to zero.
+ */
+static u8_t frames_in_mac;
 /** @} */
 
 #if SICSLOWPAN_CONF_FRAG
@@ -267,9 +294,51 @@ static struct timer reass_timer;
 
 /** Addresses contexts for IPHC. */
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 16
+#error IPHC has context numbers 0-15, SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS must be at most 16
+#endif
 static struct sicslowpan_addr_context 
 addr_contexts[SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS];
+
+/*
+ * The contexts are indexed by number and hashed by prefix, so that
+ * neither lookup has to walk the whole table. Both tables hold index
+ * + 1 into addr_contexts, 0 means none. They are rebuilt by
+ * context_table_update() whenever a context changes.
+ */
+#define CONTEXT_BUCKETS 8
+static uint8_t context_by_number[16];
+static uint8_t context_bucket[CONTEXT_BUCKETS];
+static uint8_t context_next[SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS];
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+
+/* Changed by context_table_update() to invalidate the caches. Never
+   0, so that zeroed cache entries are invalid. */
+static uint8_t context_generation = 1;
+
+/*
+ * The context last used for each neighbor's destination addresses,
+ * together with the interface identifier derived from its link-layer
+ * address. Neighbors map to entries by the last byte of their address.
+ */
+#ifdef SICSLOWPAN_CONF_CONTEXT_CACHE
+#define CONTEXT_CACHE SICSLOWPAN_CONF_CONTEXT_CACHE
+#else
+#define CONTEXT_CACHE 4
 #endif
+#if CONTEXT_CACHE < 1
+#error SICSLOWPAN_CONF_CONTEXT_CACHE must be at least 1
+#endif
+struct context_cache_entry {
+  rimeaddr_t lladdr;
+  uint8_t iid[8];
+  uint8_t generation;
+  uint8_t context; /* index + 1, 0 if the last address had none */
+};
+static struct context_cache_entry context_cache[CONTEXT_CACHE];
+
+/* The same for our own source addresses. */
+static struct context_cache_entry own_context;
 
 /** pointer to an address context. */
 static struct sicslowpan_addr_context *context;
@@ -310,17 +379,47 @@ static const uint8_t ttl_values[] = {0, 1, 64, 255};
 /** \name HC06 related functions
  * @{                                                                 */
 /*--------------------------------------------------------------------*/
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+static uint8_t
+prefix_hash(const uint8_t *prefix)
+{
+  return (prefix[0] ^ prefix[1] ^ prefix[2] ^ prefix[3] ^
+          prefix[4] ^ prefix[5] ^ prefix[6] ^ prefix[7]) % CONTEXT_BUCKETS;
+}
+/*--------------------------------------------------------------------*/
+/** \brief rebuild the lookup tables after a context has changed */
+static void
+context_table_update(void)
+{
+  uint8_t i, h;
+
+  memset(context_by_number, 0, sizeof(context_by_number));
+  memset(context_bucket, 0, sizeof(context_bucket));
+  for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+    if(addr_contexts[i].used == 1 && addr_contexts[i].number < 16) {
+      context_by_number[addr_contexts[i].number] = i + 1;
+      h = prefix_hash(addr_contexts[i].prefix);
+      context_next[i] = context_bucket[h];
+      context_bucket[h] = i + 1;
+    }
+  }
+  if(++context_generation == 0) {
+    context_generation = 1;
+  }
+}
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+/*--------------------------------------------------------------------*/
 /** \brief find the context corresponding to prefix ipaddr */
 static struct sicslowpan_addr_context*
 addr_context_lookup_by_prefix(uip_ipaddr_t *ipaddr)
 {
 /* Remove code to avoid warnings and save flash if no context is used */
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
-  int i;
-  for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
-    if((addr_contexts[i].used == 1) &&
-       uip_ipaddr_prefixcmp(&addr_contexts[i].prefix, ipaddr, 64)) {
-      return &addr_contexts[i];
+  uint8_t i;
+  for(i = context_bucket[prefix_hash(ipaddr->u8)]; i != 0;
+      i = context_next[i - 1]) {
+    if(uip_ipaddr_prefixcmp(&addr_contexts[i - 1].prefix, ipaddr, 64)) {
+      return &addr_contexts[i - 1];
     }
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
@@ -333,21 +432,56 @@ addr_context_lookup_by_number(u8_t number)
 {
 /* Remove code to avoid warnings and save flash if no context is used */ 
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
-  int i;
-  for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
-    if((addr_contexts[i].used == 1) &&
-       addr_contexts[i].number == number) {
-      return &addr_contexts[i];
-    }
+  if(number < 16 && context_by_number[number] != 0) {
+    return &addr_contexts[context_by_number[number] - 1];
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
   return NULL;
 }
 /*--------------------------------------------------------------------*/
+/**
+ * \brief find the context for an address, trying the one that was
+ * used last for the same link-layer address first
+ *
+ * The cache entry is refreshed for lladdr, so that its iid field
+ * holds the interface identifier derived from lladdr.
+ */
+static struct sicslowpan_addr_context *
+addr_context_lookup_cached(struct context_cache_entry *e,
+                           uip_ipaddr_t *ipaddr, rimeaddr_t *lladdr)
+{
+  struct sicslowpan_addr_context *c;
+  uip_ipaddr_t iidaddr;
+
+  if(e->generation != context_generation ||
+     !rimeaddr_cmp(&e->lladdr, lladdr)) {
+    rimeaddr_copy(&e->lladdr, lladdr);
+    uip_ds6_set_addr_iid(&iidaddr, (uip_lladdr_t *)lladdr);
+    memcpy(e->iid, &iidaddr.u8[8], 8);
+    e->generation = context_generation;
+    e->context = 0;
+  }
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  if(e->context != 0 &&
+     uip_ipaddr_prefixcmp(&addr_contexts[e->context - 1].prefix,
+                          ipaddr, 64)) {
+    return &addr_contexts[e->context - 1];
+  }
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+
+  c = addr_context_lookup_by_prefix(ipaddr);
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  if(c != NULL) {
+    e->context = c - addr_contexts + 1;
+  }
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+  return c;
+}
+/*--------------------------------------------------------------------*/
 static uint8_t
-compress_addr_64(uint8_t bitpos, uip_ipaddr_t *ipaddr, uip_lladdr_t *lladdr)
+compress_addr_64(uint8_t bitpos, uip_ipaddr_t *ipaddr, const uint8_t *iid)
 {
-  if(uip_is_addr_mac_addr_based(ipaddr, lladdr)) {
+  if(memcmp(&ipaddr->u8[8], iid, 8) == 0) {
     return 3 << bitpos; /* 0-bits */
   } else if(sicslowpan_is_iid_16_bit_compressable(ipaddr)) {
     /* compress IID to 16 bits xxxx::0000:00ff:fe00:XXXX */
@@ -436,6 +570,9 @@ uncompress_addr(uip_ipaddr_t *ipaddr, uint8_t const prefix[],
  * \note The context number 00 is reserved for the link local prefix.
  * For unicast addresses, if we cannot compress the prefix, we neither
  * compress the IID.
+ * \note A routing header directly after the IPv6 header is encoded
+ * with LOWPAN_NHC (RFC 6282, section 4.2), so that a UDP header behind
+ * an RPL source routing header is still compressed.
  * \param rime_destaddr L2 destination address, needed to compress IP
  * dest
  */
@@ -443,6 +580,10 @@ static void
 compress_hdr_hc06(rimeaddr_t *rime_destaddr)
 {
   uint8_t tmp, iphc0, iphc1;
+  struct context_cache_entry *dest_cache;
+  struct sicslowpan_addr_context *src_context, *dest_context;
+  struct uip_udp_hdr *udp_buf;
+  uint8_t proto;
 #if DEBUG
   PRINTF("before compression: ");
   for(tmp = 0; tmp < UIP_IP_BUF->len[1] + 40; tmp++) {
@@ -471,11 +612,25 @@ compress_hdr_hc06(rimeaddr_t *rime_destaddr)
    */
 
 
+  /* look up the contexts once, they also decide whether the third
+     byte is needed */
+  src_context = addr_context_lookup_cached(&own_context,
+                                           &UIP_IP_BUF->srcipaddr,
+                                           (rimeaddr_t *)&uip_lladdr);
+  dest_cache = &context_cache[rime_destaddr->u8[RIMEADDR_SIZE - 1] %
+                              CONTEXT_CACHE];
+  dest_context = addr_context_lookup_cached(dest_cache,
+                                            &UIP_IP_BUF->destipaddr,
+                                            rime_destaddr);
+  if(uip_is_addr_mcast(&UIP_IP_BUF->destipaddr)) {
+    dest_context = NULL;
+  }
+  if(uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+    src_context = NULL;
+  }
+
   /* check if dest context exists (for allocating third byte) */
-  /* TODO: fix this so that it remembers the looked up values for
-     avoiding two lookups - or set the lookup values immediately */
-  if(addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr) != NULL ||
-     addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr) != NULL) {
+  if(dest_context != NULL || src_context != NULL) {
     /* set context flag and increase hc06_ptr */
     PRINTF("IPHC: compressing dest or src ipaddr - setting CID\n");
     iphc1 |= SICSLOWPAN_IPHC_CID;
@@ -527,12 +682,19 @@ compress_hdr_hc06(rimeaddr_t *rime_destaddr)
 
   /* Note that the payload length is always compressed */
 
-  /* Next header. We compress it if UDP */
+  /* Next header. We compress it if UDP or a routing header */
 #if UIP_CONF_UDP
   if(UIP_IP_BUF->proto == UIP_PROTO_UDP) {
     iphc0 |= SICSLOWPAN_IPHC_NH_C;
   }
 #endif /*UIP_CONF_UDP*/
+#if SICSLOWPAN_COMPRESS_EXT_HDR
+  if(UIP_IP_BUF->proto == UIP_PROTO_ROUTING &&
+     UIP_EXT_BUF->len <= NHC_EXT_MAX_LEN &&
+     (UIP_EXT_BUF->len << 3) + 8 <= uip_len - UIP_IPH_LEN) {
+    iphc0 |= SICSLOWPAN_IPHC_NH_C;
+  }
+#endif /* SICSLOWPAN_COMPRESS_EXT_HDR */
 #ifdef SICSLOWPAN_NH_COMPRESSOR 
   if(SICSLOWPAN_NH_COMPRESSOR.is_compressable(UIP_IP_BUF->proto)) {
     iphc0 |= SICSLOWPAN_IPHC_NH_C;
@@ -571,24 +733,23 @@ compress_hdr_hc06(rimeaddr_t *rime_destaddr)
     PRINTF("IPHC: compressing unspecified - setting SAC\n");
     iphc1 |= SICSLOWPAN_IPHC_SAC;
     iphc1 |= SICSLOWPAN_IPHC_SAM_00;
-  } else if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr))
-     != NULL) {
+  } else if(src_context != NULL) {
     /* elide the prefix - indicate by CID and set context + SAC */
     PRINTF("IPHC: compressing src with context - setting CID & SAC ctx: %d\n",
-	   context->number);
+	   src_context->number);
     iphc1 |= SICSLOWPAN_IPHC_CID | SICSLOWPAN_IPHC_SAC;
-    RIME_IPHC_BUF[2] |= context->number << 4;
+    RIME_IPHC_BUF[2] |= src_context->number << 4;
     /* compession compare with this nodes address (source) */
 
     iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_SAM_BIT,
-                              &UIP_IP_BUF->srcipaddr, &uip_lladdr);
+                              &UIP_IP_BUF->srcipaddr, own_context.iid);
     /* No context found for this address */
   } else if(uip_is_addr_link_local(&UIP_IP_BUF->srcipaddr) &&
 	    UIP_IP_BUF->destipaddr.u16[1] == 0 &&
 	    UIP_IP_BUF->destipaddr.u16[2] == 0 &&
 	    UIP_IP_BUF->destipaddr.u16[3] == 0) {
     iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_SAM_BIT,
-                              &UIP_IP_BUF->srcipaddr, &uip_lladdr);
+                              &UIP_IP_BUF->srcipaddr, own_context.iid);
   } else {
     /* send the full address => SAC = 0, SAM = 00 */
     iphc1 |= SICSLOWPAN_IPHC_SAM_00; /* 128-bits */
@@ -625,21 +786,21 @@ compress_hdr_hc06(rimeaddr_t *rime_destaddr)
     }
   } else {
     /* Address is unicast, try to compress */
-    if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr)) != NULL) {
+    if(dest_context != NULL) {
       /* elide the prefix */
       iphc1 |= SICSLOWPAN_IPHC_DAC;
-      RIME_IPHC_BUF[2] |= context->number;
+      RIME_IPHC_BUF[2] |= dest_context->number;
       /* compession compare with link adress (destination) */
 
       iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_DAM_BIT,
-	       &UIP_IP_BUF->destipaddr, (uip_lladdr_t *)rime_destaddr);
+                                &UIP_IP_BUF->destipaddr, dest_cache->iid);
       /* No context found for this address */
     } else if(uip_is_addr_link_local(&UIP_IP_BUF->destipaddr) &&
 	      UIP_IP_BUF->destipaddr.u16[1] == 0 &&
 	      UIP_IP_BUF->destipaddr.u16[2] == 0 &&
 	      UIP_IP_BUF->destipaddr.u16[3] == 0) {
       iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_DAM_BIT,
-               &UIP_IP_BUF->destipaddr, (uip_lladdr_t *)rime_destaddr);
+                                &UIP_IP_BUF->destipaddr, dest_cache->iid);
     } else {
       /* send the full address */
       iphc1 |= SICSLOWPAN_IPHC_DAM_00; /* 128-bits */
@@ -649,52 +810,77 @@ compress_hdr_hc06(rimeaddr_t *rime_destaddr)
   }
 
   uncomp_hdr_len = UIP_IPH_LEN;
+  proto = UIP_IP_BUF->proto;
+
+#if SICSLOWPAN_COMPRESS_EXT_HDR
+  /* Routing header compression. The header is carried as is, but a
+     UDP header behind it can be compressed as well. */
+  if((iphc0 & SICSLOWPAN_IPHC_NH_C) && proto == UIP_PROTO_ROUTING) {
+    tmp = (UIP_EXT_BUF->len << 3) + 8;
+    proto = UIP_EXT_BUF->next;
+#if UIP_CONF_UDP
+    if(proto == UIP_PROTO_UDP) {
+      *hc06_ptr++ = SICSLOWPAN_NHC_EXT_HDR | SICSLOWPAN_NHC_EXT_EID_ROUTING |
+        SICSLOWPAN_NHC_EXT_NH;
+    } else
+#endif /* UIP_CONF_UDP */
+    {
+      *hc06_ptr++ = SICSLOWPAN_NHC_EXT_HDR | SICSLOWPAN_NHC_EXT_EID_ROUTING;
+      *hc06_ptr++ = proto;
+    }
+    *hc06_ptr++ = tmp - 2;
+    memcpy(hc06_ptr, (uint8_t *)UIP_EXT_BUF + 2, tmp - 2);
+    hc06_ptr += tmp - 2;
+    uncomp_hdr_len += tmp;
+  }
+#endif /* SICSLOWPAN_COMPRESS_EXT_HDR */
 
 #if UIP_CONF_UDP
   /* UDP header compression */
-  if(UIP_IP_BUF->proto == UIP_PROTO_UDP) {
+  if(proto == UIP_PROTO_UDP) {
+    udp_buf = (struct uip_udp_hdr *)&uip_buf[UIP_LLH_LEN + uncomp_hdr_len];
     PRINTF("IPHC: Uncompressed UDP ports on send side: %x, %x\n",
-	   UIP_HTONS(UIP_UDP_BUF->srcport), UIP_HTONS(UIP_UDP_BUF->destport));
+	   UIP_HTONS(udp_buf->srcport), UIP_HTONS(udp_buf->destport));
     /* Mask out the last 4 bits can be used as a mask */
-    if(((UIP_HTONS(UIP_UDP_BUF->srcport) & 0xfff0) == SICSLOWPAN_UDP_4_BIT_PORT_MIN) &&
-       ((UIP_HTONS(UIP_UDP_BUF->destport) & 0xfff0) == SICSLOWPAN_UDP_4_BIT_PORT_MIN)) {
+    if(((UIP_HTONS(udp_buf->srcport) & 0xfff0) == SICSLOWPAN_UDP_4_BIT_PORT_MIN) &&
+       ((UIP_HTONS(udp_buf->destport) & 0xfff0) == SICSLOWPAN_UDP_4_BIT_PORT_MIN)) {
       /* we can compress 12 bits of both source and dest */
       *hc06_ptr = SICSLOWPAN_NHC_UDP_CS_P_11;
       PRINTF("IPHC: remove 12 b of both source & dest with prefix 0xFOB\n");
       *(hc06_ptr + 1) =
-	(u8_t)((UIP_HTONS(UIP_UDP_BUF->srcport) -
+	(u8_t)((UIP_HTONS(udp_buf->srcport) -
 		SICSLOWPAN_UDP_4_BIT_PORT_MIN) << 4) +
-	(u8_t)((UIP_HTONS(UIP_UDP_BUF->destport) -
+	(u8_t)((UIP_HTONS(udp_buf->destport) -
 		SICSLOWPAN_UDP_4_BIT_PORT_MIN));
       hc06_ptr += 2;
-    } else if((UIP_HTONS(UIP_UDP_BUF->destport) & 0xff00) == SICSLOWPAN_UDP_8_BIT_PORT_MIN) {
+    } else if((UIP_HTONS(udp_buf->destport) & 0xff00) == SICSLOWPAN_UDP_8_BIT_PORT_MIN) {
       /* we can compress 8 bits of dest, leave source. */
       *hc06_ptr = SICSLOWPAN_NHC_UDP_CS_P_01;
       PRINTF("IPHC: leave source, remove 8 bits of dest with prefix 0xF0\n");
-      memcpy(hc06_ptr + 1, &UIP_UDP_BUF->srcport, 2);
+      memcpy(hc06_ptr + 1, &udp_buf->srcport, 2);
       *(hc06_ptr + 3) =
-	(u8_t)((UIP_HTONS(UIP_UDP_BUF->destport) -
+	(u8_t)((UIP_HTONS(udp_buf->destport) -
 		SICSLOWPAN_UDP_8_BIT_PORT_MIN));
       hc06_ptr += 4;
-    } else if((UIP_HTONS(UIP_UDP_BUF->srcport) & 0xff00) == SICSLOWPAN_UDP_8_BIT_PORT_MIN) {
+    } else if((UIP_HTONS(udp_buf->srcport) & 0xff00) == SICSLOWPAN_UDP_8_BIT_PORT_MIN) {
       /* we can compress 8 bits of src, leave dest. Copy compressed port */
       *hc06_ptr = SICSLOWPAN_NHC_UDP_CS_P_10;
       PRINTF("IPHC: remove 8 bits of source with prefix 0xF0, leave dest. hch: %i\n", *hc06_ptr);
       *(hc06_ptr + 1) =
-	(u8_t)((UIP_HTONS(UIP_UDP_BUF->srcport) -
+	(u8_t)((UIP_HTONS(udp_buf->srcport) -
 		SICSLOWPAN_UDP_8_BIT_PORT_MIN));
-      memcpy(hc06_ptr + 2, &UIP_UDP_BUF->destport, 2);
+      memcpy(hc06_ptr + 2, &udp_buf->destport, 2);
       hc06_ptr += 4;
     } else {
       /* we cannot compress. Copy uncompressed ports, full checksum  */
       *hc06_ptr = SICSLOWPAN_NHC_UDP_CS_P_00;
       PRINTF("IPHC: cannot compress headers\n");
-      memcpy(hc06_ptr + 1, &UIP_UDP_BUF->srcport, 4);
+      memcpy(hc06_ptr + 1, &udp_buf->srcport, 4);
       hc06_ptr += 5;
     }
     /* always inline the checksum  */
     if(1) {
-      memcpy(hc06_ptr, &UIP_UDP_BUF->udpchksum, 2);
+      memcpy(hc06_ptr, &udp_buf->udpchksum, 2);
       hc06_ptr += 2;
     }
     uncomp_hdr_len += UIP_UDPH_LEN;
@@ -734,6 +920,9 @@ static void
 uncompress_hdr_hc06(uint16_t ip_len)
 {
   uint8_t tmp, iphc0, iphc1;
+  uint8_t *nh_ptr;
+  uint8_t ext_len;
+  struct uip_udp_hdr *udp_buf;
   /* at least two byte will be used for the encoding */
   hc06_ptr = rime_ptr + rime_hdr_len + 2;
 
@@ -878,52 +1067,92 @@ uncompress_hdr_hc06(uint16_t ip_len)
   uncomp_hdr_len += UIP_IPH_LEN;
 
   /* Next header processing - continued */
+  nh_ptr = &SICSLOWPAN_IP_BUF->proto;
+  ext_len = 0;
   if((iphc0 & SICSLOWPAN_IPHC_NH_C)) {
     /* The next header is compressed, NHC is following */
+    if((*hc06_ptr & (SICSLOWPAN_NHC_MASK | SICSLOWPAN_NHC_EXT_EID_MASK)) ==
+       (SICSLOWPAN_NHC_EXT_HDR | SICSLOWPAN_NHC_EXT_EID_ROUTING)) {
+      /* A routing header, carried as is apart from its first two
+         bytes. If the NH bit is set, a compressed UDP header follows. */
+      *nh_ptr = UIP_PROTO_ROUTING;
+      nh_ptr = &SICSLOWPAN_EXT_BUF->next;
+      tmp = *hc06_ptr & SICSLOWPAN_NHC_EXT_NH;
+      hc06_ptr++;
+      if(!tmp) {
+        *nh_ptr = *hc06_ptr++;
+      }
+      if(*hc06_ptr > (NHC_EXT_MAX_LEN << 3) + 6) {
+        ext_len = 0;
+      } else {
+        ext_len = *hc06_ptr + 2;
+      }
+      hc06_ptr++;
+      if(ext_len == 0 || (ext_len & 7) != 0 ||
+         hc06_ptr + ext_len - 2 > rime_ptr + packetbuf_datalen()) {
+        PRINTF("sicslowpan uncompress_hdr: error bad routing header length %u\n",
+               ext_len);
+        uncomp_hdr_len = 0;
+        return;
+      }
+      SICSLOWPAN_EXT_BUF->len = (ext_len >> 3) - 1;
+      memcpy((uint8_t *)SICSLOWPAN_EXT_BUF + 2, hc06_ptr, ext_len - 2);
+      hc06_ptr += ext_len - 2;
+      uncomp_hdr_len += ext_len;
+      if(!tmp) {
+        goto nhc_done;
+      }
+      if((*hc06_ptr & SICSLOWPAN_NHC_UDP_MASK) != SICSLOWPAN_NHC_UDP_ID) {
+        PRINTF("sicslowpan uncompress_hdr: error no UDP after routing header\n");
+        uncomp_hdr_len = 0;
+        return;
+      }
+    }
     if((*hc06_ptr & SICSLOWPAN_NHC_UDP_MASK) == SICSLOWPAN_NHC_UDP_ID) {
       uint8_t checksum_compressed;
-      SICSLOWPAN_IP_BUF->proto = UIP_PROTO_UDP;
+      *nh_ptr = UIP_PROTO_UDP;
+      udp_buf = (struct uip_udp_hdr *)&sicslowpan_buf[UIP_LLIPH_LEN + ext_len];
       checksum_compressed = *hc06_ptr & SICSLOWPAN_NHC_UDP_CHECKSUMC;
       PRINTF("IPHC: Incoming header value: %i\n", *hc06_ptr);
       switch(*hc06_ptr & SICSLOWPAN_NHC_UDP_CS_P_11) {
       case SICSLOWPAN_NHC_UDP_CS_P_00:
 	/* 1 byte for NHC, 4 byte for ports, 2 bytes chksum */
-	memcpy(&SICSLOWPAN_UDP_BUF->srcport, hc06_ptr + 1, 2);
-	memcpy(&SICSLOWPAN_UDP_BUF->destport, hc06_ptr + 3, 2);
+	memcpy(&udp_buf->srcport, hc06_ptr + 1, 2);
+	memcpy(&udp_buf->destport, hc06_ptr + 3, 2);
 	PRINTF("IPHC: Uncompressed UDP ports (ptr+5): %x, %x\n",
-	       UIP_HTONS(SICSLOWPAN_UDP_BUF->srcport), UIP_HTONS(SICSLOWPAN_UDP_BUF->destport));
+	       UIP_HTONS(udp_buf->srcport), UIP_HTONS(udp_buf->destport));
 	hc06_ptr += 5;
 	break;
 
       case SICSLOWPAN_NHC_UDP_CS_P_01:
         /* 1 byte for NHC + source 16bit inline, dest = 0xF0 + 8 bit inline */
 	PRINTF("IPHC: Decompressing destination\n");
-	memcpy(&SICSLOWPAN_UDP_BUF->srcport, hc06_ptr + 1, 2);
-	SICSLOWPAN_UDP_BUF->destport = UIP_HTONS(SICSLOWPAN_UDP_8_BIT_PORT_MIN + (*(hc06_ptr + 3)));
+	memcpy(&udp_buf->srcport, hc06_ptr + 1, 2);
+	udp_buf->destport = UIP_HTONS(SICSLOWPAN_UDP_8_BIT_PORT_MIN + (*(hc06_ptr + 3)));
 	PRINTF("IPHC: Uncompressed UDP ports (ptr+4): %x, %x\n",
-	       UIP_HTONS(SICSLOWPAN_UDP_BUF->srcport), UIP_HTONS(SICSLOWPAN_UDP_BUF->destport));
+	       UIP_HTONS(udp_buf->srcport), UIP_HTONS(udp_buf->destport));
 	hc06_ptr += 4;
 	break;
 
       case SICSLOWPAN_NHC_UDP_CS_P_10:
         /* 1 byte for NHC + source = 0xF0 + 8bit inline, dest = 16 bit inline*/
 	PRINTF("IPHC: Decompressing source\n");
-	SICSLOWPAN_UDP_BUF->srcport = UIP_HTONS(SICSLOWPAN_UDP_8_BIT_PORT_MIN +
+	udp_buf->srcport = UIP_HTONS(SICSLOWPAN_UDP_8_BIT_PORT_MIN +
 					    (*(hc06_ptr + 1)));
-	memcpy(&SICSLOWPAN_UDP_BUF->destport, hc06_ptr + 2, 2);
+	memcpy(&udp_buf->destport, hc06_ptr + 2, 2);
 	PRINTF("IPHC: Uncompressed UDP ports (ptr+4): %x, %x\n",
-	       UIP_HTONS(SICSLOWPAN_UDP_BUF->srcport), UIP_HTONS(SICSLOWPAN_UDP_BUF->destport));
+	       UIP_HTONS(udp_buf->srcport), UIP_HTONS(udp_buf->destport));
 	hc06_ptr += 4;
 	break;
 
       case SICSLOWPAN_NHC_UDP_CS_P_11:
 	/* 1 byte for NHC, 1 byte for ports */
-	SICSLOWPAN_UDP_BUF->srcport = UIP_HTONS(SICSLOWPAN_UDP_4_BIT_PORT_MIN +
+	udp_buf->srcport = UIP_HTONS(SICSLOWPAN_UDP_4_BIT_PORT_MIN +
 					    (*(hc06_ptr + 1) >> 4));
-	SICSLOWPAN_UDP_BUF->destport = UIP_HTONS(SICSLOWPAN_UDP_4_BIT_PORT_MIN +
+	udp_buf->destport = UIP_HTONS(SICSLOWPAN_UDP_4_BIT_PORT_MIN +
 					     ((*(hc06_ptr + 1)) & 0x0F));
 	PRINTF("IPHC: Uncompressed UDP ports (ptr+2): %x, %x\n",
-	       UIP_HTONS(SICSLOWPAN_UDP_BUF->srcport), UIP_HTONS(SICSLOWPAN_UDP_BUF->destport));
+	       UIP_HTONS(udp_buf->srcport), UIP_HTONS(udp_buf->destport));
 	hc06_ptr += 2;
 	break;
 
@@ -932,7 +1161,7 @@ uncompress_hdr_hc06(uint16_t ip_len)
 	return;
       }
       if(!checksum_compressed) { /* has_checksum, default  */
-	memcpy(&SICSLOWPAN_UDP_BUF->udpchksum, hc06_ptr, 2);
+	memcpy(&udp_buf->udpchksum, hc06_ptr, 2);
 	hc06_ptr += 2;
 	PRINTF("IPHC: sicslowpan uncompress_hdr: checksum included\n");
       } else {
@@ -947,6 +1176,7 @@ uncompress_hdr_hc06(uint16_t ip_len)
 #endif
   }
 
+ nhc_done:
   rime_hdr_len = hc06_ptr - rime_ptr;
   
   /* IP length field. */
@@ -961,8 +1191,10 @@ uncompress_hdr_hc06(uint16_t ip_len)
   }
   
   /* length field in UDP header */
-  if(SICSLOWPAN_IP_BUF->proto == UIP_PROTO_UDP) {
-    memcpy(&SICSLOWPAN_UDP_BUF->udplen, &SICSLOWPAN_IP_BUF->len[0], 2);
+  if(*nh_ptr == UIP_PROTO_UDP) {
+    udp_buf = (struct uip_udp_hdr *)&sicslowpan_buf[UIP_LLIPH_LEN + ext_len];
+    udp_buf->udplen = UIP_HTONS(((uint16_t)SICSLOWPAN_IP_BUF->len[0] << 8) +
+                                SICSLOWPAN_IP_BUF->len[1] - ext_len);
   }
 
   return;
@@ -1259,6 +1491,12 @@ packet_sent(void *ptr, int status, int transmissions)
   neighbor_info_packet_sent(status, transmissions);
   printf("status %d\n",status);
 #endif /* SICSLOWPAN_CONF_NEIGHBOR_INFO */
+  if(frames_in_mac > 0) {
+    frames_in_mac--;
+  }
+  if(frames_in_mac == 0) {
+    NETSTACK_SCHED.sent();
+  }
 }
 /*--------------------------------------------------------------------*/
 /**
@@ -1282,6 +1520,7 @@ send_packet(rimeaddr_t *dest)
 
   /* Provide a callback function to receive the result of
      a packet transmission. */
+  frames_in_mac++;
   NETSTACK_MAC.send(&packet_sent, NULL);
 
   /* If we are sending multiple packets in a row, we need to let the
@@ -1467,6 +1706,25 @@ output(uip_lladdr_t *localdest)
   }
   return 1;
 }
+/*--------------------------------------------------------------------*/
+/**
+ * \brief The output function called by the packet scheduler.
+ *
+ * If no frame of the packet is left with the MAC layer, either
+ * because all sent callbacks have already been called or because the
+ * packet was dropped, the scheduler is told right away.
+ */
+static uint8_t
+sched_output(uip_lladdr_t *localdest)
+{
+  uint8_t ret;
+
+  ret = output(localdest);
+  if(frames_in_mac == 0) {
+    NETSTACK_SCHED.sent();
+  }
+  return ret;
+}
 
 /*--------------------------------------------------------------------*/
 /** \brief Process a received 6lowpan packet.
@@ -1712,9 +1970,11 @@ sicslowpan_init(void)
 
   /*
    * Set out output function as the function to be called from uIP to
-   * send a packet.
+   * send a packet. Packets go through the packet scheduler, which
+   * calls our output function when it is their turn.
    */
-  tcpip_set_outputfunc(output);
+  NETSTACK_SCHED.init(sched_output);
+  tcpip_set_outputfunc(NETSTACK_SCHED.send);
 
 #if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
 /* Preinitialize any address contexts for better header compression
@@ -1759,9 +2019,57 @@ sicslowpan_init(void)
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 1 */
 
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  context_table_update();
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
 }
 /*--------------------------------------------------------------------*/
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
+int
+sicslowpan_context_set(uint8_t number, const uint8_t *prefix)
+{
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  struct sicslowpan_addr_context *c;
+  int i;
+
+  if(number >= 16) {
+    return 0;
+  }
+  c = addr_context_lookup_by_number(number);
+  for(i = 0; c == NULL && i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+    if(addr_contexts[i].used == 0) {
+      c = &addr_contexts[i];
+    }
+  }
+  if(c == NULL) {
+    return 0;
+  }
+  c->used = 1;
+  c->number = number;
+  memcpy(c->prefix, prefix, sizeof(c->prefix));
+  context_table_update();
+  return 1;
+#else /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+  return 0;
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+}
+/*--------------------------------------------------------------------*/
+void
+sicslowpan_context_remove(uint8_t number)
+{
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  struct sicslowpan_addr_context *c;
+
+  c = addr_context_lookup_by_number(number);
+  if(c != NULL) {
+    c->used = 0;
+    context_table_update();
+  }
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+}
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
+/*--------------------------------------------------------------------*/
 const struct network_driver sicslowpan_driver = {
   "sicslowpan",
   sicslowpan_init,
@@ -143,6 +143,9 @@
 /* NHC_EXT_HDR */
 #define SICSLOWPAN_NHC_MASK                         0xF0
 #define SICSLOWPAN_NHC_EXT_HDR                      0xE0
+#define SICSLOWPAN_NHC_EXT_EID_MASK                 0x0E
+#define SICSLOWPAN_NHC_EXT_EID_ROUTING              0x06 /* EID 3 */
+#define SICSLOWPAN_NHC_EXT_NH                       0x01
 
 /**
  * \name LOWPAN_UDP encoding (works together with IPHC)
@@ -319,6 +322,22 @@ struct sicslowpan_nh_compressor {
 };
 
 
+/**
+ * \brief Set the 64-bit prefix of an IPHC address context
+ * \param number The context number, 0-15
+ * \param prefix The first 8 bytes of the prefix
+ * \return Non-zero if the context was set, zero if the number is out
+ * of range or all SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS contexts are in
+ * use with other numbers.
+ *
+ * Only available with HC06 compression. Contexts can also be set
+ * at compile time with SICSLOWPAN_CONF_ADDR_CONTEXT_0, _1 and _2.
+ */
+int sicslowpan_context_set(uint8_t number, const uint8_t *prefix);
+
+/** \brief Remove an IPHC address context */
+void sicslowpan_context_remove(uint8_t number);
+
 extern const struct network_driver sicslowpan_driver;
 
 extern const struct mac_driver *sicslowpan_mac;
@@ -45,11 +45,14 @@
 
 #include "net/uip-packetqueue.h"
 
+#include "net/nettrace.h"
+
 #include <string.h>
 
 #if UIP_CONF_IPV6
 #include "net/uip-nd6.h"
 #include "net/uip-ds6.h"
+#include "net/rpl/rpl-srh.h"
 #endif
 
 #define DEBUG 0
@@ -80,6 +83,7 @@ extern struct uip_fallback_interface UIP_FALLBACK_INTERFACE;
 #endif
 #if UIP_CONF_IPV6_RPL
 void rpl_init(void);
+int rpl_instance_nexthop(uip_ipaddr_t *nexthop);
 #endif
 process_event_t tcpip_event;
 #if UIP_CONF_ICMP6
@@ -117,6 +121,28 @@ enum {
   PACKET_INPUT
 };
 
+#if NETTRACE_CONF_ENABLED
+/* Records the IP packet in uip_buf, without link-layer header or
+   trailing link padding. */
+static void
+trace_ip(uint8_t type)
+{
+  u16_t len;
+
+  len = (UIP_IP_BUF->len[0] << 8) + UIP_IP_BUF->len[1];
+#if UIP_CONF_IPV6
+  len += UIP_IPH_LEN;
+#endif /* UIP_CONF_IPV6 */
+  if(len > uip_len) {
+    len = uip_len;
+  }
+  NETTRACE(type, UIP_IP_BUF, len);
+}
+#define TRACE_IP(type) trace_ip(type)
+#else /* NETTRACE_CONF_ENABLED */
+#define TRACE_IP(type)
+#endif /* NETTRACE_CONF_ENABLED */
+
 /* Called on IP packet output. */
 #if UIP_CONF_IPV6
 
@@ -127,6 +153,7 @@ tcpip_output(uip_lladdr_t *a)
 {
   int ret;
   if(outputfunc != NULL) {
+    TRACE_IP(NETTRACE_IP_OUT);
     ret = outputfunc(a);
     return ret;
   }
@@ -146,6 +173,7 @@ u8_t
 tcpip_output(void)
 {
   if(outputfunc != NULL) {
+    TRACE_IP(NETTRACE_IP_OUT);
     return outputfunc();
   }
   UIP_LOG("tcpip_output: Use tcpip_set_outputfunc() to set an output function");
@@ -189,6 +217,19 @@ check_for_tcp_syn(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if UIP_TCP && UIP_TCP_SNDBUF
+/* uIP sends at most one segment each time it is called. If the
+   connection that was just processed has more buffered data that may
+   be sent, we come back for it. */
+static void
+check_for_tcp_sndbuf(void)
+{
+  if(uip_conn != NULL && uip_sndbuf_pending(uip_conn)) {
+    tcpip_poll_tcp(uip_conn);
+  }
+}
+#endif /* UIP_TCP && UIP_TCP_SNDBUF */
+/*---------------------------------------------------------------------------*/
 static void
 packet_input(void)
 {
@@ -200,17 +241,20 @@ packet_input(void)
       check_for_tcp_syn();
       uip_input();
       if(uip_len > 0) {
-#if UIP_CONF_TCP_SPLIT
+#if UIP_CONF_TCP_SPLIT && !UIP_TCP_SNDBUF
         uip_split_output();
-#else /* UIP_CONF_TCP_SPLIT */
+#else /* UIP_CONF_TCP_SPLIT && !UIP_TCP_SNDBUF */
 #if UIP_CONF_IPV6
         tcpip_ipv6_output();
 #else
 	PRINTF("tcpip packet_input forward output len %d\n", uip_len);
         tcpip_output();
 #endif
-#endif /* UIP_CONF_TCP_SPLIT */
+#endif /* UIP_CONF_TCP_SPLIT && !UIP_TCP_SNDBUF */
       }
+#if UIP_TCP && UIP_TCP_SNDBUF
+      check_for_tcp_sndbuf();
+#endif /* UIP_TCP && UIP_TCP_SNDBUF */
     }
     tcpip_is_forwarding = 0;
   }
@@ -219,17 +263,20 @@ packet_input(void)
     check_for_tcp_syn();
     uip_input();
     if(uip_len > 0) {
-#if UIP_CONF_TCP_SPLIT
+#if UIP_CONF_TCP_SPLIT && !UIP_TCP_SNDBUF
       uip_split_output();
-#else /* UIP_CONF_TCP_SPLIT */
+#else /* UIP_CONF_TCP_SPLIT && !UIP_TCP_SNDBUF */
 #if UIP_CONF_IPV6
       tcpip_ipv6_output();
 #else
       PRINTF("tcpip packet_input output len %d\n", uip_len);
       tcpip_output();
 #endif
-#endif /* UIP_CONF_TCP_SPLIT */
+#endif /* UIP_CONF_TCP_SPLIT && !UIP_TCP_SNDBUF */
     }
+#if UIP_TCP && UIP_TCP_SNDBUF
+    check_for_tcp_sndbuf();
+#endif /* UIP_TCP && UIP_TCP_SNDBUF */
   }
 #endif /* UIP_CONF_IP_FORWARD */
 }
@@ -423,7 +470,7 @@ eventhandler(process_event_t ev, process_data_t data)
         for(cptr = &uip_udp_conns[0];
             cptr < &uip_udp_conns[UIP_UDP_CONNS]; ++cptr) {
           if(cptr->appstate.p == p) {
-            cptr->lport = 0;
+            uip_udp_remove(cptr);
           }
         }
       
@@ -454,6 +501,9 @@ eventhandler(process_event_t ev, process_data_t data)
 		PRINTF("tcpip_output after periodic len %d\n", uip_len);
               }
 #endif /* UIP_CONF_IPV6 */
+#if UIP_TCP_SNDBUF
+              check_for_tcp_sndbuf();
+#endif /* UIP_TCP_SNDBUF */
             }
           }
 #endif /* UIP_TCP */
@@ -510,6 +560,9 @@ eventhandler(process_event_t ev, process_data_t data)
           tcpip_output();
         }
 #endif /* UIP_CONF_IPV6 */
+#if UIP_TCP_SNDBUF
+        check_for_tcp_sndbuf();
+#endif /* UIP_TCP_SNDBUF */
         /* Start the periodic polling, if it isn't already active. */
         start_periodic_tcp_timer();
       }
@@ -539,6 +592,7 @@ eventhandler(process_event_t ev, process_data_t data)
 void
 tcpip_input(void)
 {
+  TRACE_IP(NETTRACE_IP_IN);
   process_post_synch(&tcpip_process, PACKET_INPUT, NULL);
   uip_len = 0;
 #if UIP_CONF_IPV6
@@ -552,6 +606,12 @@ tcpip_ipv6_output(void)
 {
   uip_ds6_nbr_t *nbr = NULL;
   uip_ipaddr_t* nexthop;
+#if RPL_SRH
+  uip_ipaddr_t srh_nexthop;
+#endif /* RPL_SRH */
+#if UIP_CONF_IPV6_RPL
+  uip_ipaddr_t instance_nexthop;
+#endif /* UIP_CONF_IPV6_RPL */
   
   if(uip_len == 0) {  
     return;
@@ -571,12 +631,27 @@ tcpip_ipv6_output(void)
 
     /* Next hop determination */
     nbr = NULL;
+#if RPL_SRH
+    /* In RPL non-storing mode, downward packets are source routed:
+       the root inserts the route, and the routers on the way take the
+       next hop from it. */
+    if(rpl_srh_output(&srh_nexthop)) {
+      nexthop = &srh_nexthop;
+    } else
+#endif /* RPL_SRH */
     if(uip_ds6_is_addr_onlink(&UIP_IP_BUF->destipaddr)){
       nexthop = &UIP_IP_BUF->destipaddr;
     } else {
       uip_ds6_route_t* locrt;
       locrt = uip_ds6_route_lookup(&UIP_IP_BUF->destipaddr);
       if(locrt == NULL) {
+#if UIP_CONF_IPV6_RPL
+        /* Traffic classes that are mapped to an RPL instance go up
+           through that instance's preferred parent. */
+        if(rpl_instance_nexthop(&instance_nexthop)) {
+          nexthop = &instance_nexthop;
+        } else
+#endif /* UIP_CONF_IPV6_RPL */
         if((nexthop = uip_ds6_defrt_choose()) == NULL) {
 #ifdef UIP_FALLBACK_INTERFACE
 	  UIP_FALLBACK_INTERFACE.output();
@@ -600,10 +675,8 @@ tcpip_ipv6_output(void)
       } else {
 #if UIP_CONF_IPV6_QUEUE_PKT
         /* copy outgoing pkt in the queuing buffer for later transmmit */
-        if(uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME) != NULL) {
-          memcpy(uip_packetqueue_buf(&nbr->packethandle), UIP_IP_BUF, uip_len);
-          uip_packetqueue_set_buflen(&nbr->packethandle, uip_len);
-        }
+        uip_packetqueue_enqueue(&nbr->packethandle, (uint8_t *)UIP_IP_BUF,
+                                uip_len, UIP_DS6_NBR_PACKET_LIFETIME);
 #endif
       /* RFC4861, 7.2.2:
        * "If the source address of the packet prompting the solicitation is the
@@ -624,12 +697,10 @@ tcpip_ipv6_output(void)
       if(nbr->state == NBR_INCOMPLETE) {
         PRINTF("tcpip_ipv6_output: nbr cache entry incomplete\n");
 #if UIP_CONF_IPV6_QUEUE_PKT
-        /* copy outgoing pkt in the queuing buffer for later transmmit and set
-           the destination nbr to nbr */
-        if(uip_packetqueue_alloc(&nbr->packethandle, UIP_DS6_NBR_PACKET_LIFETIME) != NULL) {
-          memcpy(uip_packetqueue_buf(&nbr->packethandle), UIP_IP_BUF, uip_len);
-          uip_packetqueue_set_buflen(&nbr->packethandle, uip_len);
-        }
+        /* append outgoing pkt to the neighbor's queue for later
+           transmit, behind the packets already waiting for the NA */
+        uip_packetqueue_enqueue(&nbr->packethandle, (uint8_t *)UIP_IP_BUF,
+                                uip_len, UIP_DS6_NBR_PACKET_LIFETIME);
         /*        memcpy(nbr->queue_buf, UIP_IP_BUF, uip_len);
                   nbr->queue_buf_len = uip_len;*/
         uip_len = 0;
@@ -667,10 +738,10 @@ tcpip_ipv6_output(void)
         nbr->queue_buf_len = 0;
         tcpip_output(&(nbr->lladdr));
         }*/
-      if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-        uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-        memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-        uip_packetqueue_free(&nbr->packethandle);
+      /* When the NA arrives, uip-nd6.c hands us the oldest queued
+       * packet, which was sent above; the rest follow in order. */
+      while((uip_len = uip_packetqueue_dequeue(&nbr->packethandle,
+                                               (uint8_t *)UIP_IP_BUF)) != 0) {
         tcpip_output(&(nbr->lladdr));
       }
 #endif /*UIP_CONF_IPV6_QUEUE_PKT*/
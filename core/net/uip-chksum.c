@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Word-at-a-time Internet checksum and incremental checksum update
+ *
+ *         The generic checksum code in uip.c and uip6.c adds two
+ *         bytes at a time and folds the carry on every iteration,
+ *         which is the right thing on 8- and 16-bit CPUs. On hosts
+ *         with 32- or 64-bit registers (the native and cooja
+ *         targets) it is considerably faster to sum aligned 32-bit
+ *         words into a 64-bit accumulator and fold the carries once
+ *         at the end. That implementation is enabled with
+ *         UIP_CHKSUM_CONF_WIDE, which must be paired with
+ *         UIP_ARCH_CHKSUM so that the generic code steps aside.
+ *
+ * \author
+ *         agent <agent@local>
+ */
+
+#include "net/uip.h"
+#include "net/uip_arch.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_chksum_adjust(uint16_t chksum, uint16_t old_word, uint16_t new_word)
+{
+  uint32_t sum;
+
+  /* RFC 1624, eqn. 3: HC' = ~(~HC + ~m + m'). The checksum and the
+     words may be in any byte order, as long as it is the same for
+     all three. */
+  sum = (uint16_t)~chksum;
+  sum += (uint16_t)~old_word;
+  sum += new_word;
+  sum = (sum & 0xffff) + (sum >> 16);
+  sum = (sum & 0xffff) + (sum >> 16);
+  return ~sum;
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_CHKSUM_WIDE
+/*
+ * Sum len bytes starting at data. The returned 16-bit one's
+ * complement sum is in network byte order as seen through a native
+ * 16-bit load, i.e. it can be stored directly into a packet header.
+ */
+static uint16_t
+wide_sum(const uint8_t *data, uint16_t len)
+{
+  uint64_t acc;
+  uint32_t w;
+  uint16_t h;
+  uint8_t odd;
+
+  acc = 0;
+
+  /* The one's complement sum is independent of byte order, but the
+     pairing of bytes into 16-bit words must be preserved. If data
+     starts on an odd address, we take the first byte by itself and
+     sum the rest with the pairing shifted by one byte; the result is
+     then byte swapped at the end (RFC 1071, section 2). */
+  odd = ((uintptr_t)data & 1);
+  if(odd && len > 0) {
+#if UIP_BYTE_ORDER == UIP_BIG_ENDIAN
+    acc = *data;
+#else
+    acc = (uint16_t)*data << 8;
+#endif
+    data++;
+    len--;
+  }
+
+  if(((uintptr_t)data & 2) && len >= 2) {
+    memcpy(&h, data, 2);
+    acc += h;
+    data += 2;
+    len -= 2;
+  }
+
+  /* The data is now 32-bit aligned. The 64-bit accumulator cannot
+     overflow for any length that fits in a uint16_t, so carries are
+     left in the upper half and folded only once. The words are
+     loaded through memcpy(), as the data is not an array of words;
+     the compiler makes plain aligned loads of them. */
+  while(len >= 16) {
+    memcpy(&w, data, 4);
+    acc += w;
+    memcpy(&w, data + 4, 4);
+    acc += w;
+    memcpy(&w, data + 8, 4);
+    acc += w;
+    memcpy(&w, data + 12, 4);
+    acc += w;
+    data += 16;
+    len -= 16;
+  }
+  while(len >= 4) {
+    memcpy(&w, data, 4);
+    acc += w;
+    data += 4;
+    len -= 4;
+  }
+
+  if(len >= 2) {
+    memcpy(&h, data, 2);
+    acc += h;
+    data += 2;
+    len -= 2;
+  }
+  if(len > 0) {
+#if UIP_BYTE_ORDER == UIP_BIG_ENDIAN
+    acc += (uint16_t)*data << 8;
+#else
+    acc += *data;
+#endif
+  }
+
+  acc = (acc & 0xffffffff) + (acc >> 32);
+  acc = (acc & 0xffff) + (acc >> 16);
+  acc = (acc & 0xffff) + (acc >> 16);
+  acc = (acc & 0xffff) + (acc >> 16);
+
+  if(odd) {
+    acc = ((acc & 0xff) << 8) | (acc >> 8);
+  }
+  return (uint16_t)acc;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Copy len bytes from src to dst and return their sum, as wide_sum()
+ * would for dst. The words are loaded and stored through memcpy(),
+ * which the compiler turns into plain, possibly unaligned, moves, so
+ * the pairing of bytes follows the start of the data rather than its
+ * address.
+ */
+static uint16_t
+wide_copy_sum(uint8_t *dst, const uint8_t *src, uint16_t len)
+{
+  uint64_t acc, acc2;
+  uint32_t w[8];
+  uint16_t h;
+
+  /* Two accumulators let the additions of a block run in parallel. */
+  acc = acc2 = 0;
+  while(len >= 32) {
+    memcpy(w, src, 32);
+    memcpy(dst, w, 32);
+    acc += w[0];
+    acc2 += w[1];
+    acc += w[2];
+    acc2 += w[3];
+    acc += w[4];
+    acc2 += w[5];
+    acc += w[6];
+    acc2 += w[7];
+    src += 32;
+    dst += 32;
+    len -= 32;
+  }
+  acc += acc2;
+  while(len >= 4) {
+    memcpy(w, src, 4);
+    memcpy(dst, w, 4);
+    acc += w[0];
+    src += 4;
+    dst += 4;
+    len -= 4;
+  }
+  if(len >= 2) {
+    memcpy(&h, src, 2);
+    memcpy(dst, &h, 2);
+    acc += h;
+    src += 2;
+    dst += 2;
+    len -= 2;
+  }
+  if(len > 0) {
+    *dst = *src;
+#if UIP_BYTE_ORDER == UIP_BIG_ENDIAN
+    acc += (uint16_t)*src << 8;
+#else
+    acc += *src;
+#endif
+  }
+
+  acc = (acc & 0xffffffff) + (acc >> 32);
+  acc = (acc & 0xffff) + (acc >> 16);
+  acc = (acc & 0xffff) + (acc >> 16);
+  acc = (acc & 0xffff) + (acc >> 16);
+  return (uint16_t)acc;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Add a block to a running one's complement sum. Both the running sum
+ * and the returned sum are in network byte order as seen through a
+ * native load.
+ */
+static uint16_t
+chksum(uint16_t sum, const uint8_t *data, uint16_t len)
+{
+  uint32_t acc;
+
+  acc = (uint32_t)sum + wide_sum(data, len);
+  acc = (acc & 0xffff) + (acc >> 16);
+  return (uint16_t)acc;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_chksum(uint16_t *data, uint16_t len)
+{
+  return wide_sum((uint8_t *)data, len);
+}
+/*---------------------------------------------------------------------------*/
+#ifndef UIP_ARCH_IPCHKSUM
+uint16_t
+uip_ipchksum(void)
+{
+  uint16_t sum;
+
+  sum = wide_sum(&uip_buf[UIP_LLH_LEN], UIP_IPH_LEN);
+  return (sum == 0) ? 0xffff : sum;
+}
+#endif
+/*---------------------------------------------------------------------------*/
+/*
+ * The checksum of the upper layer packet in uip_buf. If copylen is
+ * non-zero, the last copylen bytes of the packet are first copied
+ * from copy.
+ */
+static uint16_t
+upper_layer_chksum_copy(uint8_t proto, const uint8_t *copy, uint16_t copylen)
+{
+  struct uip_ip_hdr *ip = (struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN];
+  uint16_t upper_layer_len;
+  uint16_t sum;
+  uint16_t hdr_len;
+  uint32_t acc;
+
+#if UIP_CONF_IPV6
+  hdr_len = UIP_IPH_LEN + uip_ext_len;
+  upper_layer_len = (((uint16_t)(ip->len[0]) << 8) + ip->len[1]) -
+    uip_ext_len;
+#else /* UIP_CONF_IPV6 */
+  hdr_len = UIP_IPH_LEN;
+  upper_layer_len = (((uint16_t)(ip->len[0]) << 8) + ip->len[1]) -
+    UIP_IPH_LEN;
+#endif /* UIP_CONF_IPV6 */
+
+  /* First sum pseudoheader. The protocol and length fields cannot
+     carry. */
+  sum = UIP_HTONS(upper_layer_len + proto);
+  sum = chksum(sum, (uint8_t *)&ip->srcipaddr, 2 * sizeof(uip_ipaddr_t));
+
+  /* Sum upper layer header and data. The data to copy starts at an
+     even offset, so its sum can simply be added. */
+  sum = chksum(sum, &uip_buf[UIP_LLH_LEN + hdr_len],
+               upper_layer_len - copylen);
+  if(copylen > 0) {
+    acc = (uint32_t)sum +
+      wide_copy_sum(&uip_buf[UIP_LLH_LEN + hdr_len + upper_layer_len - copylen],
+                    copy, copylen);
+    sum = (uint16_t)((acc & 0xffff) + (acc >> 16));
+  }
+
+  return (sum == 0) ? 0xffff : sum;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+upper_layer_chksum(uint8_t proto)
+{
+  return upper_layer_chksum_copy(proto, NULL, 0);
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_CONF_IPV6
+uint16_t
+uip_icmp6chksum(void)
+{
+  return upper_layer_chksum(UIP_PROTO_ICMP6);
+}
+#endif /* UIP_CONF_IPV6 */
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP
+uint16_t
+uip_tcpchksum(void)
+{
+  return upper_layer_chksum(UIP_PROTO_TCP);
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+uip_tcpchksum_copy(const void *data, uint16_t len)
+{
+  return upper_layer_chksum_copy(UIP_PROTO_TCP, data, len);
+}
+#endif /* UIP_TCP */
+/*---------------------------------------------------------------------------*/
+#if UIP_UDP_CHECKSUMS
+uint16_t
+uip_udpchksum(void)
+{
+  return upper_layer_chksum(UIP_PROTO_UDP);
+}
+#endif /* UIP_UDP_CHECKSUMS */
+/*---------------------------------------------------------------------------*/
+#endif /* UIP_CHKSUM_WIDE */
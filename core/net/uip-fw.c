@@ -404,6 +404,7 @@ u8_t
 uip_fw_forward(void)
 {
   struct fwcache_entry *fw;
+  u16_t old_word;
 
   /* First check if the packet is destined for ourselves and return 0
      to indicate that the packet should be processed locally. */
@@ -462,15 +463,13 @@ uip_fw_forward(void)
     time_exceeded();
   }
   
-  /* Decrement the TTL (time-to-live) value in the IP header */
+  /* Decrement the TTL (time-to-live) value in the IP header and
+     update the IP checksum incrementally. The TTL shares a 16-bit
+     word with the protocol field. */
+  old_word = UIP_HTONS((BUF->ttl << 8) | BUF->proto);
   BUF->ttl = BUF->ttl - 1;
-  
-  /* Update the IP checksum. */
-  if(BUF->ipchksum >= UIP_HTONS(0xffff - 0x0100)) {
-    BUF->ipchksum = BUF->ipchksum + UIP_HTONS(0x0100) + 1;
-  } else {
-    BUF->ipchksum = BUF->ipchksum + UIP_HTONS(0x0100);
-  }
+  BUF->ipchksum = uip_chksum_adjust(BUF->ipchksum, old_word,
+                                    UIP_HTONS((BUF->ttl << 8) | BUF->proto));
 
   if(uip_len > 0) {
     uip_appdata = &uip_buf[UIP_LLH_LEN + UIP_TCPIP_HLEN];
@@ -514,10 +514,10 @@ uip_nd6_na_input(void)
     nbr->queue_buf_len = 0;
     return;
     }*/
-  if(uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-    uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-    memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-    uip_packetqueue_free(&nbr->packethandle);
+  /* Hand the oldest queued packet back to be sent; tcpip_ipv6_output()
+     sends the remaining ones after it. */
+  uip_len = uip_packetqueue_dequeue(&nbr->packethandle, (uint8_t *)UIP_IP_BUF);
+  if(uip_len != 0) {
     return;
   }
   
@@ -932,11 +932,11 @@ uip_nd6_ra_input(void)
     nbr->queue_buf_len = 0;
     return;
     }*/
-  if(nbr != NULL && uip_packetqueue_buflen(&nbr->packethandle) != 0) {
-    uip_len = uip_packetqueue_buflen(&nbr->packethandle);
-    memcpy(UIP_IP_BUF, uip_packetqueue_buf(&nbr->packethandle), uip_len);
-    uip_packetqueue_free(&nbr->packethandle);
-    return;
+  if(nbr != NULL) {
+    uip_len = uip_packetqueue_dequeue(&nbr->packethandle, (uint8_t *)UIP_IP_BUF);
+    if(uip_len != 0) {
+      return;
+    }
   }
 
 #endif /*UIP_CONF_IPV6_QUEUE_PKT */
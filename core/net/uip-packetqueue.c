@@ -1,13 +1,18 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "net/uip.h"
 
-#include "lib/memb.h"
-
 #include "net/uip-packetqueue.h"
 
-#define MAX_NUM_QUEUED_PACKETS 2
-MEMB(packets_memb, struct uip_packetqueue_packet, MAX_NUM_QUEUED_PACKETS);
+/* Packet descriptors. A descriptor is free when its handle is NULL. */
+static struct uip_packetqueue_packet packets[UIP_PACKETQUEUE_NUM];
+
+/* Packet data is kept back to back in this buffer, in allocation
+   order. When a packet is removed the data after it is moved down, so
+   the free space is always at the end. */
+static uint8_t databuf[UIP_PACKETQUEUE_BYTES];
+static uint16_t databuf_used;
 
 #define DEBUG 0
 #if DEBUG
@@ -17,15 +22,40 @@ MEMB(packets_memb, struct uip_packetqueue_packet, MAX_NUM_QUEUED_PACKETS);
 #define PRINTF(...)
 #endif
 
+/*---------------------------------------------------------------------------*/
+static void
+packet_remove(struct uip_packetqueue_packet *p)
+{
+  struct uip_packetqueue_packet **pp;
+  int i;
+
+  for(pp = &p->handle->packet; *pp != NULL; pp = &(*pp)->next) {
+    if(*pp == p) {
+      *pp = p->next;
+      break;
+    }
+  }
+  ctimer_stop(&p->lifetimer);
+
+  memmove(&databuf[p->offset], &databuf[p->offset + p->len],
+          databuf_used - p->offset - p->len);
+  databuf_used -= p->len;
+  for(i = 0; i < UIP_PACKETQUEUE_NUM; i++) {
+    if(packets[i].handle != NULL && packets[i].offset > p->offset) {
+      packets[i].offset -= p->len;
+    }
+  }
+
+  p->handle = NULL;
+}
 /*---------------------------------------------------------------------------*/
 static void
 packet_timedout(void *ptr)
 {
-  struct uip_packetqueue_handle *h = ptr;
+  struct uip_packetqueue_packet *p = ptr;
 
-  PRINTF("uip_packetqueue_free timed out %p\n", h);
-  memb_free(&packets_memb, h->packet);
-  h->packet = NULL;
+  PRINTF("uip_packetqueue packet timed out %p\n", p->handle);
+  packet_remove(p);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -35,52 +65,90 @@ uip_packetqueue_new(struct uip_packetqueue_handle *handle)
   handle->packet = NULL;
 }
 /*---------------------------------------------------------------------------*/
-struct uip_packetqueue_packet *
-uip_packetqueue_alloc(struct uip_packetqueue_handle *handle, clock_time_t lifetime)
+int
+uip_packetqueue_enqueue(struct uip_packetqueue_handle *handle,
+                        const uint8_t *data, uint16_t len,
+                        clock_time_t lifetime)
 {
-  PRINTF("uip_packetqueue_alloc %p\n", handle);
-  if(handle->packet != NULL) {
-    PRINTF("alloced\n");
-    return NULL;
+  struct uip_packetqueue_packet *p, **pp;
+  uint8_t n;
+  int i;
+
+  PRINTF("uip_packetqueue_enqueue %p len %u\n", handle, len);
+
+  n = 0;
+  for(pp = &handle->packet; *pp != NULL; pp = &(*pp)->next) {
+    n++;
   }
-  handle->packet = memb_alloc(&packets_memb);
-  if(handle->packet != NULL) {
-    ctimer_set(&handle->packet->lifetimer, lifetime,
-               packet_timedout, handle);
-  } else {
-    PRINTF("uip_packetqueue_alloc failed\n");
+  if(n >= UIP_PACKETQUEUE_MAX_PER_HANDLE) {
+    PRINTF("uip_packetqueue_enqueue: queue full\n");
+    return 0;
   }
-  return handle->packet;
-}
-/*---------------------------------------------------------------------------*/
-void
-uip_packetqueue_free(struct uip_packetqueue_handle *handle)
-{
-  PRINTF("uip_packetqueue_free %p\n", handle);
-  if(handle->packet != NULL) {
-    ctimer_stop(&handle->packet->lifetimer);
-    memb_free(&packets_memb, handle->packet);
-    handle->packet = NULL;
+  if(len > sizeof(databuf) - databuf_used) {
+    PRINTF("uip_packetqueue_enqueue: out of buffer space\n");
+    return 0;
+  }
+
+  p = NULL;
+  for(i = 0; i < UIP_PACKETQUEUE_NUM; i++) {
+    if(packets[i].handle == NULL) {
+      p = &packets[i];
+      break;
+    }
+  }
+  if(p == NULL) {
+    PRINTF("uip_packetqueue_enqueue: out of packets\n");
+    return 0;
   }
+
+  p->handle = handle;
+  p->next = NULL;
+  p->offset = databuf_used;
+  p->len = len;
+  memcpy(&databuf[p->offset], data, len);
+  databuf_used += len;
+  ctimer_set(&p->lifetimer, lifetime, packet_timedout, p);
+  *pp = p;
+
+  return 1;
 }
 /*---------------------------------------------------------------------------*/
-uint8_t *
-uip_packetqueue_buf(struct uip_packetqueue_handle *h)
+uint16_t
+uip_packetqueue_dequeue(struct uip_packetqueue_handle *handle, uint8_t *buf)
 {
-  return h->packet != NULL? h->packet->queue_buf: NULL;
+  struct uip_packetqueue_packet *p;
+  uint16_t len;
+
+  p = handle->packet;
+  if(p == NULL) {
+    return 0;
+  }
+  PRINTF("uip_packetqueue_dequeue %p len %u\n", handle, p->len);
+  len = p->len;
+  memcpy(buf, &databuf[p->offset], len);
+  packet_remove(p);
+  return len;
 }
 /*---------------------------------------------------------------------------*/
-uint16_t
-uip_packetqueue_buflen(struct uip_packetqueue_handle *h)
+void
+uip_packetqueue_free(struct uip_packetqueue_handle *handle)
 {
-  return h->packet != NULL? h->packet->queue_buf_len: 0;
+  PRINTF("uip_packetqueue_free %p\n", handle);
+  while(handle->packet != NULL) {
+    packet_remove(handle->packet);
+  }
 }
 /*---------------------------------------------------------------------------*/
-void
-uip_packetqueue_set_buflen(struct uip_packetqueue_handle *h, uint16_t len)
+uint8_t
+uip_packetqueue_len(struct uip_packetqueue_handle *handle)
 {
-  if(h->packet != NULL) {
-    h->packet->queue_buf_len = len;
+  struct uip_packetqueue_packet *p;
+  uint8_t n;
+
+  n = 0;
+  for(p = handle->packet; p != NULL; p = p->next) {
+    n++;
   }
+  return n;
 }
 /*---------------------------------------------------------------------------*/
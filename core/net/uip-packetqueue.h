@@ -3,33 +3,78 @@
 
 #include "sys/ctimer.h"
 
+/**
+ * The maximum number of packets queued for all handles together.
+ */
+#ifdef UIP_PACKETQUEUE_CONF_NUM
+#define UIP_PACKETQUEUE_NUM UIP_PACKETQUEUE_CONF_NUM
+#else
+#define UIP_PACKETQUEUE_NUM 4
+#endif
+
+/**
+ * The maximum number of packets queued for a single handle.
+ */
+#ifdef UIP_PACKETQUEUE_CONF_MAX_PER_HANDLE
+#define UIP_PACKETQUEUE_MAX_PER_HANDLE UIP_PACKETQUEUE_CONF_MAX_PER_HANDLE
+#else
+#define UIP_PACKETQUEUE_MAX_PER_HANDLE 4
+#endif
+
+/**
+ * The number of bytes of packet data that can be queued for all
+ * handles together. Packets only take up as many bytes as they are
+ * long, so a few full-sized packets or many small ones fit.
+ */
+#ifdef UIP_PACKETQUEUE_CONF_BYTES
+#define UIP_PACKETQUEUE_BYTES UIP_PACKETQUEUE_CONF_BYTES
+#else
+#define UIP_PACKETQUEUE_BYTES (2 * (UIP_BUFSIZE - UIP_LLH_LEN))
+#endif
+
 struct uip_packetqueue_handle;
 
 struct uip_packetqueue_packet {
-  struct uip_ds6_queued_packet *next;
-  uint8_t queue_buf[UIP_BUFSIZE - UIP_LLH_LEN];
-  uint16_t queue_buf_len;
-  struct ctimer lifetimer;
+  struct uip_packetqueue_packet *next;
   struct uip_packetqueue_handle *handle;
+  struct ctimer lifetimer;
+  uint16_t offset;
+  uint16_t len;
 };
 
+/* A FIFO of packets, oldest first. */
 struct uip_packetqueue_handle {
   struct uip_packetqueue_packet *packet;
 };
 
 void uip_packetqueue_new(struct uip_packetqueue_handle *handle);
 
+/**
+ * Append a copy of a packet to the tail of a queue.
+ *
+ * The packet is dropped from the queue when lifetime has passed. If
+ * the queue already holds UIP_PACKETQUEUE_MAX_PER_HANDLE packets, or
+ * if there is no room left in the shared packet pool, the packet is
+ * not queued.
+ *
+ * \return Non-zero if the packet was queued.
+ */
+int uip_packetqueue_enqueue(struct uip_packetqueue_handle *handle,
+                            const uint8_t *data, uint16_t len,
+                            clock_time_t lifetime);
 
-struct uip_packetqueue_packet *
-uip_packetqueue_alloc(struct uip_packetqueue_handle *handle, clock_time_t lifetime);
-
-
-void
-uip_packetqueue_free(struct uip_packetqueue_handle *handle);
+/**
+ * Remove the oldest packet from a queue and copy it to buf.
+ *
+ * \return The length of the packet, or zero if the queue was empty.
+ */
+uint16_t uip_packetqueue_dequeue(struct uip_packetqueue_handle *handle,
+                                 uint8_t *buf);
 
-uint8_t *uip_packetqueue_buf(struct uip_packetqueue_handle *h);
-uint16_t uip_packetqueue_buflen(struct uip_packetqueue_handle *h);
-void uip_packetqueue_set_buflen(struct uip_packetqueue_handle *h, uint16_t len);
+/** Drop all packets in a queue. */
+void uip_packetqueue_free(struct uip_packetqueue_handle *handle);
 
+/** The number of packets in a queue. */
+uint8_t uip_packetqueue_len(struct uip_packetqueue_handle *handle);
 
 #endif /* UIP_PACKETQUEUE_H */
@@ -57,6 +57,10 @@
  * forwarding) for sending packets. Therefore, the uip-fw module must
  * be set up with the appropriate network interfaces for this module
  * to work.
+ *
+ * With UIP_CONF_TCP_SNDBUF, uIP keeps several segments in flight and
+ * only splits a segment when it needs a prompt ACK from a peer that
+ * delays them, so this module is not used.
  */
 
 
@@ -88,6 +88,10 @@
 
 #include <string.h>
 
+#if UIP_TCP_SNDBUF
+#error UIP_CONF_TCP_SNDBUF is only implemented for IPv6
+#endif /* UIP_TCP_SNDBUF */
+
 /*---------------------------------------------------------------------------*/
 /* Variable definitions. */
 
@@ -134,6 +138,10 @@ void *uip_appdata;               /* The uip_appdata pointer points to
 void *uip_sappdata;              /* The uip_appdata pointer points to
 				    the application data which is to
 				    be sent. */
+static const void *uip_sconstdata; /* Data given to uip_send_const(),
+				      which is copied into the outgoing
+				      segment as its checksum is
+				      computed. */
 #if UIP_URGDATA > 0
 void *uip_urgdata;               /* The uip_urgdata pointer points to
    				    urgent data (out-of-band data), if
@@ -299,6 +307,40 @@ chksum(u16_t sum, const u8_t *data, u16_t len)
   return sum;
 }
 /*---------------------------------------------------------------------------*/
+/* Copy len bytes from src to dst and add them to sum, as chksum()
+   would for dst, in a single pass over the data. */
+static u16_t
+chksum_copy(u16_t sum, u8_t *dst, const u8_t *src, u16_t len)
+{
+  u16_t t;
+  u8_t hi, lo;
+
+  for(; len > 1; len -= 2) {
+    hi = *src++;
+    lo = *src++;
+    *dst++ = hi;
+    *dst++ = lo;
+    t = (hi << 8) + lo;
+    sum += t;
+    if(sum < t) {
+      sum++;		/* carry */
+    }
+  }
+
+  if(len == 1) {
+    hi = *src;
+    *dst = hi;
+    t = (hi << 8) + 0;
+    sum += t;
+    if(sum < t) {
+      sum++;		/* carry */
+    }
+  }
+
+  /* Return sum in host byte order. */
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
 u16_t
 uip_chksum(u16_t *data, u16_t len)
 {
@@ -317,8 +359,11 @@ uip_ipchksum(void)
 }
 #endif
 /*---------------------------------------------------------------------------*/
+/* The checksum of the upper layer packet in uip_buf. If copylen is
+   non-zero, the last copylen bytes of the packet are first copied
+   from copy. */
 static u16_t
-upper_layer_chksum(u8_t proto)
+upper_layer_chksum_copy(u8_t proto, const u8_t *copy, u16_t copylen)
 {
   u16_t upper_layer_len;
   u16_t sum;
@@ -336,13 +381,25 @@ upper_layer_chksum(u8_t proto)
   /* Sum IP source and destination addresses. */
   sum = chksum(sum, (u8_t *)&BUF->srcipaddr, 2 * sizeof(uip_ipaddr_t));
 
-  /* Sum TCP header and data. */
+  /* Sum TCP header and data. The data to copy starts at an even
+     offset, after the header, so it continues the same sum. */
   sum = chksum(sum, &uip_buf[UIP_IPH_LEN + UIP_LLH_LEN],
-	       upper_layer_len);
+	       upper_layer_len - copylen);
+  if(copylen > 0) {
+    sum = chksum_copy(sum, &uip_buf[UIP_IPH_LEN + UIP_LLH_LEN +
+				    upper_layer_len - copylen],
+		      copy, copylen);
+  }
     
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
 /*---------------------------------------------------------------------------*/
+static u16_t
+upper_layer_chksum(u8_t proto)
+{
+  return upper_layer_chksum_copy(proto, NULL, 0);
+}
+/*---------------------------------------------------------------------------*/
 #if UIP_CONF_IPV6
 u16_t
 uip_icmp6chksum(void)
@@ -358,6 +415,12 @@ uip_tcpchksum(void)
   return upper_layer_chksum(UIP_PROTO_TCP);
 }
 /*---------------------------------------------------------------------------*/
+u16_t
+uip_tcpchksum_copy(const void *data, u16_t len)
+{
+  return upper_layer_chksum_copy(UIP_PROTO_TCP, data, len);
+}
+/*---------------------------------------------------------------------------*/
 #if UIP_UDP_CHECKSUMS
 u16_t
 uip_udpchksum(void)
@@ -682,6 +745,7 @@ uip_process(u8_t flag)
 #endif /* UIP_UDP */
   
   uip_sappdata = uip_appdata = &uip_buf[UIP_IPTCPH_LEN + UIP_LLH_LEN];
+  uip_sconstdata = NULL;
 
   /* Check if we were invoked because of a poll request for a
      particular connection. */
@@ -1899,9 +1963,22 @@ uip_process(u8_t flag)
 
   BUF->urgp[0] = BUF->urgp[1] = 0;
   
-  /* Calculate TCP checksum. */
+  /* Calculate TCP checksum. Data given to uip_send_const() is copied
+     into the segment here. */
   BUF->tcpchksum = 0;
-  BUF->tcpchksum = ~(uip_tcpchksum());
+  if(uip_sconstdata != NULL && uip_len > UIP_IPTCPH_LEN) {
+#if UIP_CHKSUM_COPY
+    BUF->tcpchksum = ~(uip_tcpchksum_copy(uip_sconstdata,
+					  uip_len - UIP_IPTCPH_LEN));
+#else /* UIP_CHKSUM_COPY */
+    memcpy(&uip_buf[UIP_LLH_LEN + UIP_IPTCPH_LEN], uip_sconstdata,
+	   uip_len - UIP_IPTCPH_LEN);
+    BUF->tcpchksum = ~(uip_tcpchksum());
+#endif /* UIP_CHKSUM_COPY */
+  } else {
+    BUF->tcpchksum = ~(uip_tcpchksum());
+  }
+  uip_sconstdata = NULL;
 
  ip_send_nolen:
 #if UIP_CONF_IPV6
@@ -1959,11 +2036,35 @@ uip_send(const void *data, int len)
 		(int)((char *)uip_sappdata - (char *)&uip_buf[UIP_LLH_LEN + UIP_TCPIP_HLEN]));
   if(copylen > 0) {
     uip_slen = copylen;
+    uip_sconstdata = NULL;
     if(data != uip_sappdata) {
       memcpy(uip_sappdata, (data), uip_slen);
     }
   }
 }
 /*---------------------------------------------------------------------------*/
+void
+uip_send_const(const void *data, int len)
+{
+  int copylen;
+
+  /* Data in the packet buffer itself, or data that is not going into
+     the start of the segment, is copied right away. */
+  if((const u8_t *)data >= &uip_buf[0] &&
+     (const u8_t *)data < &uip_buf[UIP_BUFSIZE]) {
+    uip_send(data, len);
+    return;
+  }
+  if(uip_sappdata != &uip_buf[UIP_LLH_LEN + UIP_TCPIP_HLEN]) {
+    uip_send(data, len);
+    return;
+  }
+  copylen = MIN(len, UIP_BUFSIZE - UIP_LLH_LEN - UIP_TCPIP_HLEN);
+  if(copylen > 0) {
+    uip_slen = copylen;
+    uip_sconstdata = data;
+  }
+}
+/*---------------------------------------------------------------------------*/
 /** @} */
 #endif /* UIP_CONF_IPV6 */
@@ -602,6 +602,26 @@ struct uip_conn *uip_connect(uip_ipaddr_t *ripaddr, u16_t port);
  */
 CCIF void uip_send(const void *data, int len);
 
+/**
+ * Send data on the current connection without copying it first.
+ *
+ * This function works like uip_send(), but instead of copying the
+ * data into the packet buffer at once, uIP copies it when it builds
+ * the outgoing TCP segment, and computes the TCP checksum as it
+ * goes. The data is thus read once per segment instead of twice. It
+ * is meant for data that is already stored somewhere, such as a file
+ * in ROM, and must stay in place until the current uIP event has
+ * been handled. A retransmission is made by calling the function
+ * again with the same data.
+ *
+ * This function may only be used for TCP connections.
+ *
+ * \param data A pointer to the data which is to be sent.
+ *
+ * \param len The maximum amount of data bytes to be sent.
+ */
+CCIF void uip_send_const(const void *data, int len);
+
 /**
  * The length of any incoming data that is currently available (if available)
  * in the uip_appdata buffer.
@@ -799,7 +819,11 @@ CCIF void uip_send(const void *data, int len);
  *
  * \hideinitializer
  */
+#if UIP_TCP_SNDBUF
+#define uip_mss()             uip_sndbuf_mss(uip_conn)
+#else /* UIP_TCP_SNDBUF */
 #define uip_mss()             (uip_conn->mss)
+#endif /* UIP_TCP_SNDBUF */
 
 /**
  * Set up a new UDP connection.
@@ -837,7 +861,11 @@ struct uip_udp_conn *uip_udp_new(const uip_ipaddr_t *ripaddr, u16_t rport);
  *
  * \hideinitializer
  */
+#if UIP_CONF_IPV6 && UIP_CONN_HASH
+#define uip_udp_remove(conn) uip_udp_set_lport(conn, 0)
+#else
 #define uip_udp_remove(conn) (conn)->lport = 0
+#endif
 
 /**
  * Bind a UDP connection to a local port.
@@ -849,7 +877,11 @@ struct uip_udp_conn *uip_udp_new(const uip_ipaddr_t *ripaddr, u16_t rport);
  *
  * \hideinitializer
  */
+#if UIP_CONF_IPV6 && UIP_CONN_HASH
+#define uip_udp_bind(conn, port) uip_udp_set_lport(conn, port)
+#else
 #define uip_udp_bind(conn, port) (conn)->lport = port
+#endif
 
 /**
  * Send a UDP datagram of length len on the current connection.
@@ -1232,6 +1264,17 @@ CCIF u32_t uip_htonl(u32_t val);
  */
 CCIF extern void *uip_appdata;
 
+/**
+ * Pointer to where uip_send() puts the data to be sent.
+ */
+extern void *uip_sappdata;
+
+/**
+ * The length of the data that the application has sent with
+ * uip_send() so far during the current call to the application.
+ */
+extern u16_t uip_slen;
+
 #if UIP_URGDATA > 0
 /* u8_t *uip_urgdata:
  *
@@ -1313,11 +1356,43 @@ struct uip_conn {
   u8_t timer;         /**< The retransmission timer. */
   u8_t nrtx;          /**< The number of retransmissions for the last
 			 segment sent. */
+#if UIP_TCP_SNDBUF
+  u16_t sndbuf_head;  /**< Send buffer offset of the first
+			 unacknowledged byte. */
+  u16_t sndbuf_len;   /**< Number of bytes in the send buffer. */
+  u16_t snd_max;      /**< Number of bytes after snd_nxt that have been
+			 sent at least once, so snd_nxt + snd_max is the
+			 highest sequence number sent. */
+  u16_t snd_wnd;      /**< The window last advertised by the peer. */
+  u8_t sndbuf_flags;  /**< Send buffer state flags. */
+  u8_t dupacks;       /**< Number of duplicate ACKs received. */
+#endif /* UIP_TCP_SNDBUF */
 
   /** The application state. */
   uip_tcp_appstate_t appstate;
 };
 
+#if UIP_TCP_SNDBUF
+/**
+ * The amount of data the application may send on a connection.
+ *
+ * This is the implementation of uip_mss() when UIP_TCP_SNDBUF is
+ * enabled: the minimum of the connection's MSS and the free space in
+ * its send buffer.
+ */
+u16_t uip_sndbuf_mss(struct uip_conn *conn);
+
+/**
+ * Check if a connection has more to do with its send buffer.
+ *
+ * \return Non-zero if the connection has buffered data that the
+ * window allows to be sent, or if the application should be told
+ * that its data has been taken. The connection should then be polled
+ * with uip_poll_conn() again.
+ */
+int uip_sndbuf_pending(struct uip_conn *conn);
+#endif /* UIP_TCP_SNDBUF */
+
 
 /**
  * Pointer to the current TCP connection.
@@ -1351,6 +1426,9 @@ struct uip_udp_conn {
   u16_t lport;        /**< The local port number in network byte order. */
   u16_t rport;        /**< The remote port number in network byte order. */
   u8_t  ttl;          /**< Default time-to-live. */
+#if UIP_CONF_IPV6
+  u8_t  tc;           /**< Traffic class of outgoing packets. */
+#endif /* UIP_CONF_IPV6 */
 
   /** The application state. */
   uip_udp_appstate_t appstate;
@@ -1362,6 +1440,23 @@ struct uip_udp_conn {
 extern struct uip_udp_conn *uip_udp_conn;
 extern struct uip_udp_conn uip_udp_conns[UIP_UDP_CONNS];
 
+#if UIP_CONF_IPV6 && UIP_CONN_HASH
+/**
+ * Change the local port of a UDP connection.
+ *
+ * This is the implementation of uip_udp_bind() and uip_udp_remove()
+ * when UIP_CONN_HASH is enabled, as the connection must be moved to
+ * another hash bucket.
+ *
+ * \param conn A pointer to the uip_udp_conn structure for the
+ * connection.
+ *
+ * \param port The new local port number, in network byte order, or
+ * zero to remove the connection.
+ */
+void uip_udp_set_lport(struct uip_udp_conn *conn, u16_t port);
+#endif /* UIP_CONF_IPV6 && UIP_CONN_HASH */
+
 struct uip_fallback_interface {
   void (*init)(void);
   void (*output)(void);
@@ -2157,6 +2252,25 @@ u16_t uip_ipchksum(void);
  */
 u16_t uip_tcpchksum(void);
 
+#if UIP_CHKSUM_COPY
+/**
+ * Copy the payload into the TCP segment in uip_buf and calculate its
+ * TCP checksum.
+ *
+ * This does the same as copying len bytes of data to the end of the
+ * segment and calling uip_tcpchksum(), but it reads the payload only
+ * once. The TCP header and the length fields in the IP header must
+ * already have been set up.
+ *
+ * \param data The payload.
+ *
+ * \param len The length of the payload.
+ *
+ * \return The TCP checksum of the TCP segment.
+ */
+u16_t uip_tcpchksum_copy(const void *data, u16_t len);
+#endif /* UIP_CHKSUM_COPY */
+
 /**
  * Calculate the UDP checksum of the packet in uip_buf and uip_appdata.
  *
@@ -2175,6 +2289,25 @@ u16_t uip_udpchksum(void);
  */
 u16_t uip_icmp6chksum(void);
 
+/**
+ * Incrementally update an Internet checksum after a 16-bit word in
+ * the checksummed data has changed.
+ *
+ * This is used by forwarders that only rewrite a few header fields,
+ * such as the TTL, and therefore do not need to recompute the
+ * checksum over the whole header. See RFC1624.
+ *
+ * \param chksum The checksum as stored in the packet header.
+ *
+ * \param old_word The 16-bit word before it was changed.
+ *
+ * \param new_word The 16-bit word after it was changed.
+ *
+ * \return The updated checksum. All arguments and the return value
+ * must use the same byte order.
+ */
+u16_t uip_chksum_adjust(u16_t chksum, u16_t old_word, u16_t new_word);
+
 
 #endif /* __UIP_H__ */
 
@@ -97,6 +97,7 @@
 #if UIP_CONF_IPV6_RPL
 void uip_rpl_input(void);
 #endif /* UIP_CONF_IPV6_RPL */
+#include "net/rpl/rpl-srh.h"
 
 #if UIP_LOGGING == 1
 #include <stdio.h>
@@ -177,6 +178,11 @@ uip_buf_t uip_aligned_buf;
 void *uip_appdata;
 /* The uip_appdata pointer points to the application data which is to be sent*/
 void *uip_sappdata;
+#if UIP_TCP
+/* Data given to uip_send_const(), which is copied into the outgoing
+   segment as its checksum is computed. */
+static const void *uip_sconstdata;
+#endif /* UIP_TCP */
 
 #if UIP_URGDATA > 0
 /* The uip_urgdata pointer points to urgent data (out-of-band data), if present */
@@ -201,8 +207,13 @@ struct uip_conn *uip_conn;
 
 /* Temporary variables. */
 #if (UIP_TCP || UIP_UDP)
+#if UIP_CONN_HASH || UIP_CONNS > 255 || UIP_UDP_CONNS > 255 || \
+    UIP_LISTENPORTS > 255
+static u16_t c;
+#else
 static u8_t c;
 #endif
+#endif
 
 #if UIP_ACTIVE_OPEN || UIP_UDP
 /* Keeps track of the last port used for a new connection. */
@@ -248,6 +259,32 @@ static u8_t iss[4];
 u8_t uip_acc32[4];
 static u8_t opt;
 static u16_t tmp16;
+
+#if UIP_TCP_SNDBUF
+#if UIP_TCP_SNDBUF_SIZE < UIP_TCP_MSS
+#error UIP_TCP_SNDBUF_SIZE must be at least UIP_TCP_MSS
+#endif
+
+/* Flags in uip_conn->sndbuf_flags. */
+#define SNDBUF_ACK_PENDING   0x01 /* The application has not yet been
+                                     told that its data was taken. */
+#define SNDBUF_CLOSE_PENDING 0x02 /* The application has closed the
+                                     connection; send a FIN when the
+                                     buffer has drained. */
+#define SNDBUF_PEER_DELACK   0x04 /* The peer seems to delay its ACKs
+                                     until it has two segments. */
+
+/* The send buffers are rings of unacknowledged and unsent data; the
+   first unacknowledged byte, at sequence number snd_nxt, is at offset
+   sndbuf_head. The first uip_conn->len bytes are in flight. */
+static u8_t sndbufs[UIP_CONNS][UIP_TCP_SNDBUF_SIZE];
+
+/* Offset from snd_nxt of the segment being sent. */
+static u16_t sndbuf_seg_offset;
+
+/* Set when three duplicate ACKs have been received. */
+static u8_t sndbuf_fast_rexmit;
+#endif /* UIP_TCP_SNDBUF */
 #endif /* UIP_TCP */
 /** @} */
 
@@ -260,6 +297,140 @@ struct uip_udp_conn uip_udp_conns[UIP_UDP_CONNS];
 #endif /* UIP_UDP */
 /** @} */
 
+/*---------------------------------------------------------------------------*/
+/** @{ \name Connection hash tables                                          */
+/*---------------------------------------------------------------------------*/
+#if UIP_CONN_HASH
+/*
+ * The hash tables are chained through index arrays that parallel the
+ * connection tables, so struct uip_conn and struct uip_udp_conn are
+ * left unchanged. TCP connections are linked into their buckets when
+ * they are set up and unlinked when the slot is reused, so a chain
+ * may contain closed connections; lookups check the state as before.
+ */
+#define HASH_END      0xffff
+#define HASH_UNLINKED 0xfffe
+
+#define PORT_HASH(port) (((port) ^ ((port) >> 8)) & (UIP_CONN_HASH_SIZE - 1))
+
+#if UIP_TCP
+/* Connections by local port, remote port and remote address. */
+static u16_t tcp_hash[UIP_CONN_HASH_SIZE];
+static u16_t tcp_hash_next[UIP_CONNS];
+/* Connections by local port, used when choosing a new local port. */
+static u16_t tcp_lport_hash[UIP_CONN_HASH_SIZE];
+static u16_t tcp_lport_next[UIP_CONNS];
+/* Listening ports. */
+static u16_t listen_hash[UIP_CONN_HASH_SIZE];
+static u16_t listen_next[UIP_LISTENPORTS];
+#endif /* UIP_TCP */
+
+#if UIP_UDP
+/* UDP connections by local port. Unused connections are kept in the
+   bucket of port zero. */
+static u16_t udp_hash[UIP_CONN_HASH_SIZE];
+static u16_t udp_next[UIP_UDP_CONNS];
+#endif /* UIP_UDP */
+/*---------------------------------------------------------------------------*/
+static void
+hash_link(u16_t *head, u16_t *next, u16_t i)
+{
+  next[i] = *head;
+  *head = i;
+}
+/*---------------------------------------------------------------------------*/
+static void
+hash_unlink(u16_t *head, u16_t *next, u16_t i)
+{
+  u16_t *p;
+
+  for(p = head; *p != HASH_END; p = &next[*p]) {
+    if(*p == i) {
+      *p = next[i];
+      next[i] = HASH_UNLINKED;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP
+static u16_t
+tcp_hash_key(u16_t lport, u16_t rport, const uip_ipaddr_t *ripaddr)
+{
+  u16_t h;
+
+  h = lport ^ rport ^ ripaddr->u16[6] ^ ripaddr->u16[7];
+  return PORT_HASH(h);
+}
+/*---------------------------------------------------------------------------*/
+/* Must be called before the ports and the remote address of a
+   connection are changed. */
+static void
+tcp_hash_remove(struct uip_conn *conn)
+{
+  u16_t i = conn - uip_conns;
+
+  if(tcp_hash_next[i] != HASH_UNLINKED) {
+    hash_unlink(&tcp_hash[tcp_hash_key(conn->lport, conn->rport,
+                                       &conn->ripaddr)],
+                tcp_hash_next, i);
+    hash_unlink(&tcp_lport_hash[PORT_HASH(conn->lport)],
+                tcp_lport_next, i);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+tcp_hash_insert(struct uip_conn *conn)
+{
+  u16_t i = conn - uip_conns;
+
+  hash_link(&tcp_hash[tcp_hash_key(conn->lport, conn->rport,
+                                   &conn->ripaddr)],
+            tcp_hash_next, i);
+  hash_link(&tcp_lport_hash[PORT_HASH(conn->lport)], tcp_lport_next, i);
+}
+#endif /* UIP_TCP */
+/*---------------------------------------------------------------------------*/
+#if UIP_UDP
+void
+uip_udp_set_lport(struct uip_udp_conn *conn, u16_t port)
+{
+  u16_t i = conn - uip_udp_conns;
+
+  hash_unlink(&udp_hash[PORT_HASH(conn->lport)], udp_next, i);
+  conn->lport = port;
+  hash_link(&udp_hash[PORT_HASH(port)], udp_next, i);
+}
+#endif /* UIP_UDP */
+/*---------------------------------------------------------------------------*/
+static void
+conn_hash_init(void)
+{
+  for(c = 0; c < UIP_CONN_HASH_SIZE; ++c) {
+#if UIP_TCP
+    tcp_hash[c] = tcp_lport_hash[c] = listen_hash[c] = HASH_END;
+#endif /* UIP_TCP */
+#if UIP_UDP
+    udp_hash[c] = HASH_END;
+#endif /* UIP_UDP */
+  }
+#if UIP_TCP
+  for(c = 0; c < UIP_CONNS; ++c) {
+    tcp_hash_next[c] = tcp_lport_next[c] = HASH_UNLINKED;
+  }
+  for(c = 0; c < UIP_LISTENPORTS; ++c) {
+    listen_next[c] = HASH_UNLINKED;
+  }
+#endif /* UIP_TCP */
+#if UIP_UDP
+  for(c = 0; c < UIP_UDP_CONNS; ++c) {
+    hash_link(&udp_hash[PORT_HASH(0)], udp_next, c);
+  }
+#endif /* UIP_UDP */
+}
+#endif /* UIP_CONN_HASH */
+/** @} */
+
 /*---------------------------------------------------------------------------*/
 /** @{ \name ICMPv6 variables                                                */
 /*---------------------------------------------------------------------------*/
@@ -301,6 +472,134 @@ uip_add32(u8_t *op32, u16_t op16)
 
 #endif /* UIP_ARCH_ADD32 && UIP_TCP */
 
+#if UIP_TCP && UIP_TCP_SNDBUF
+/*---------------------------------------------------------------------------*/
+static void
+sndbuf_reset(struct uip_conn *conn)
+{
+  conn->sndbuf_head = 0;
+  conn->sndbuf_len = 0;
+  conn->snd_max = 0;
+  /* Most TCP receivers delay their ACKs, so we assume that the peer
+     does until it has acknowledged a single segment out of several
+     in flight. */
+  conn->sndbuf_flags = SNDBUF_PEER_DELACK;
+  conn->dupacks = 0;
+  /* Until the peer has told us its window, we only send one
+     segment at a time. */
+  conn->snd_wnd = conn->initialmss;
+}
+/*---------------------------------------------------------------------------*/
+static u16_t
+sndbuf_free(struct uip_conn *conn)
+{
+  return UIP_TCP_SNDBUF_SIZE - conn->sndbuf_len;
+}
+/*---------------------------------------------------------------------------*/
+/* Non-zero if the application may be told that its data was taken,
+   i.e. there is room for a full write. */
+static u8_t
+sndbuf_room(struct uip_conn *conn)
+{
+  return sndbuf_free(conn) >= conn->mss;
+}
+/*---------------------------------------------------------------------------*/
+/* The number of bytes of unsent data that may be sent now. */
+static u16_t
+sndbuf_sendable(struct uip_conn *conn)
+{
+  u16_t unsent, n;
+  u32_t wnd;
+
+  unsent = conn->sndbuf_len - conn->len;
+  if(unsent == 0) {
+    return 0;
+  }
+  n = unsent < conn->initialmss ? unsent : conn->initialmss;
+  if(conn->len == 0) {
+    /* Nothing is in flight: we always send a segment, even into a
+       zero window, so that the retransmission timer acts as the
+       persist timer. */
+    return n;
+  }
+
+  wnd = (u32_t)UIP_TCP_SNDBUF_SEGMENTS * conn->initialmss;
+  if(wnd > conn->snd_wnd) {
+    wnd = conn->snd_wnd;
+  }
+  if(conn->len >= wnd) {
+    return 0;
+  }
+  if(n > wnd - conn->len) {
+    n = wnd - conn->len;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static void
+sndbuf_write(struct uip_conn *conn, const u8_t *data, u16_t len)
+{
+  u8_t *buf = sndbufs[conn - uip_conns];
+  u16_t pos, n;
+
+  if(len > sndbuf_free(conn)) {
+    len = sndbuf_free(conn);
+  }
+  pos = conn->sndbuf_head + conn->sndbuf_len;
+  if(pos >= UIP_TCP_SNDBUF_SIZE) {
+    pos -= UIP_TCP_SNDBUF_SIZE;
+  }
+  conn->sndbuf_len += len;
+
+  n = UIP_TCP_SNDBUF_SIZE - pos;
+  if(n > len) {
+    n = len;
+  }
+  memcpy(&buf[pos], data, n);
+  memcpy(&buf[0], data + n, len - n);
+}
+/*---------------------------------------------------------------------------*/
+static void
+sndbuf_read(struct uip_conn *conn, u16_t offset, u8_t *data, u16_t len)
+{
+  u8_t *buf = sndbufs[conn - uip_conns];
+  u16_t pos, n;
+
+  pos = conn->sndbuf_head + offset;
+  if(pos >= UIP_TCP_SNDBUF_SIZE) {
+    pos -= UIP_TCP_SNDBUF_SIZE;
+  }
+  n = UIP_TCP_SNDBUF_SIZE - pos;
+  if(n > len) {
+    n = len;
+  }
+  memcpy(data, &buf[pos], n);
+  memcpy(data + n, &buf[0], len - n);
+}
+/*---------------------------------------------------------------------------*/
+u16_t
+uip_sndbuf_mss(struct uip_conn *conn)
+{
+  u16_t free;
+
+  free = sndbuf_free(conn);
+  return conn->mss < free ? conn->mss : free;
+}
+/*---------------------------------------------------------------------------*/
+int
+uip_sndbuf_pending(struct uip_conn *conn)
+{
+  if((conn->tcpstateflags & UIP_TS_MASK) != UIP_ESTABLISHED) {
+    return 0;
+  }
+  if(conn->sndbuf_flags & SNDBUF_CLOSE_PENDING) {
+    return conn->sndbuf_len == 0 || sndbuf_sendable(conn) > 0;
+  }
+  return sndbuf_sendable(conn) > 0 ||
+    ((conn->sndbuf_flags & SNDBUF_ACK_PENDING) && sndbuf_room(conn));
+}
+#endif /* UIP_TCP && UIP_TCP_SNDBUF */
+
 #if ! UIP_ARCH_CHKSUM
 /*---------------------------------------------------------------------------*/
 static u16_t
@@ -334,6 +633,42 @@ chksum(u16_t sum, const u8_t *data, u16_t len)
   return sum;
 }
 /*---------------------------------------------------------------------------*/
+#if UIP_TCP
+/* Copy len bytes from src to dst and add them to sum, as chksum()
+   would for dst, in a single pass over the data. */
+static u16_t
+chksum_copy(u16_t sum, u8_t *dst, const u8_t *src, u16_t len)
+{
+  u16_t t;
+  u8_t hi, lo;
+
+  for(; len > 1; len -= 2) {
+    hi = *src++;
+    lo = *src++;
+    *dst++ = hi;
+    *dst++ = lo;
+    t = (hi << 8) + lo;
+    sum += t;
+    if(sum < t) {
+      sum++;      /* carry */
+    }
+  }
+
+  if(len == 1) {
+    hi = *src;
+    *dst = hi;
+    t = (hi << 8) + 0;
+    sum += t;
+    if(sum < t) {
+      sum++;      /* carry */
+    }
+  }
+
+  /* Return sum in host byte order. */
+  return sum;
+}
+#endif /* UIP_TCP */
+/*---------------------------------------------------------------------------*/
 u16_t
 uip_chksum(u16_t *data, u16_t len)
 {
@@ -352,8 +687,11 @@ uip_ipchksum(void)
 }
 #endif
 /*---------------------------------------------------------------------------*/
+/* The checksum of the upper layer packet in uip_buf. If copylen is
+   non-zero, the last copylen bytes of the packet are first copied
+   from copy. */
 static u16_t
-upper_layer_chksum(u8_t proto)
+upper_layer_chksum_copy(u8_t proto, const u8_t *copy, u16_t copylen)
 {
 /* gcc 4.4.0 - 4.6.1 (maybe 4.3...) with -Os on 8 bit CPUS incorrectly compiles:
  * int bar (int);
@@ -375,13 +713,27 @@ upper_layer_chksum(u8_t proto)
   /* Sum IP source and destination addresses. */
   sum = chksum(sum, (u8_t *)&UIP_IP_BUF->srcipaddr, 2 * sizeof(uip_ipaddr_t));
 
-  /* Sum TCP header and data. */
+  /* Sum TCP header and data. The data to copy starts at an even
+     offset, after the header, so it continues the same sum. */
   sum = chksum(sum, &uip_buf[UIP_IPH_LEN + UIP_LLH_LEN + uip_ext_len],
-               upper_layer_len);
+               upper_layer_len - copylen);
+#if UIP_TCP
+  if(copylen > 0) {
+    sum = chksum_copy(sum, &uip_buf[UIP_IPH_LEN + UIP_LLH_LEN + uip_ext_len +
+                                    upper_layer_len - copylen],
+                      copy, copylen);
+  }
+#endif /* UIP_TCP */
     
   return (sum == 0) ? 0xffff : uip_htons(sum);
 }
 /*---------------------------------------------------------------------------*/
+static u16_t
+upper_layer_chksum(u8_t proto)
+{
+  return upper_layer_chksum_copy(proto, NULL, 0);
+}
+/*---------------------------------------------------------------------------*/
 u16_t
 uip_icmp6chksum(void)
 {
@@ -395,6 +747,12 @@ uip_tcpchksum(void)
 {
   return upper_layer_chksum(UIP_PROTO_TCP);
 }
+/*---------------------------------------------------------------------------*/
+u16_t
+uip_tcpchksum_copy(const void *data, u16_t len)
+{
+  return upper_layer_chksum_copy(UIP_PROTO_TCP, data, len);
+}
 #endif /* UIP_TCP */
 /*---------------------------------------------------------------------------*/
 #if UIP_UDP && UIP_UDP_CHECKSUMS
@@ -430,6 +788,10 @@ uip_init(void)
     uip_udp_conns[c].lport = 0;
   }
 #endif /* UIP_UDP */
+
+#if UIP_CONN_HASH
+  conn_hash_init();
+#endif /* UIP_CONN_HASH */
 }
 /*---------------------------------------------------------------------------*/
 #if UIP_TCP && UIP_ACTIVE_OPEN
@@ -448,8 +810,14 @@ uip_connect(uip_ipaddr_t *ripaddr, u16_t rport)
 
   /* Check if this port is already in use, and if so try to find
      another one. */
+#if UIP_CONN_HASH
+  for(c = tcp_lport_hash[PORT_HASH(uip_htons(lastport))]; c != HASH_END;
+      c = tcp_lport_next[c]) {
+    conn = &uip_conns[c];
+#else /* UIP_CONN_HASH */
   for(c = 0; c < UIP_CONNS; ++c) {
     conn = &uip_conns[c];
+#endif /* UIP_CONN_HASH */
     if(conn->tcpstateflags != UIP_CLOSED &&
        conn->lport == uip_htons(lastport)) {
       goto again;
@@ -474,6 +842,10 @@ uip_connect(uip_ipaddr_t *ripaddr, u16_t rport)
   if(conn == 0) {
     return 0;
   }
+
+#if UIP_CONN_HASH
+  tcp_hash_remove(conn);
+#endif /* UIP_CONN_HASH */
   
   conn->tcpstateflags = UIP_SYN_SENT;
 
@@ -488,6 +860,9 @@ uip_connect(uip_ipaddr_t *ripaddr, u16_t rport)
   conn->rcv_nxt[3] = 0;
 
   conn->initialmss = conn->mss = UIP_TCP_MSS;
+#if UIP_TCP_SNDBUF
+  sndbuf_reset(conn);
+#endif /* UIP_TCP_SNDBUF */
   
   conn->len = 1;   /* TCP length of the SYN is one. */
   conn->nrtx = 0;
@@ -498,6 +873,9 @@ uip_connect(uip_ipaddr_t *ripaddr, u16_t rport)
   conn->lport = uip_htons(lastport);
   conn->rport = rport;
   uip_ipaddr_copy(&conn->ripaddr, ripaddr);
+#if UIP_CONN_HASH
+  tcp_hash_insert(conn);
+#endif /* UIP_CONN_HASH */
   
   return conn;
 }
@@ -517,14 +895,23 @@ uip_udp_new(const uip_ipaddr_t *ripaddr, u16_t rport)
     lastport = 4096;
   }
   
+#if UIP_CONN_HASH
+  for(c = udp_hash[PORT_HASH(uip_htons(lastport))]; c != HASH_END;
+      c = udp_next[c]) {
+#else /* UIP_CONN_HASH */
   for(c = 0; c < UIP_UDP_CONNS; ++c) {
+#endif /* UIP_CONN_HASH */
     if(uip_udp_conns[c].lport == uip_htons(lastport)) {
       goto again;
     }
   }
 
   conn = 0;
+#if UIP_CONN_HASH
+  for(c = udp_hash[PORT_HASH(0)]; c != HASH_END; c = udp_next[c]) {
+#else /* UIP_CONN_HASH */
   for(c = 0; c < UIP_UDP_CONNS; ++c) {
+#endif /* UIP_CONN_HASH */
     if(uip_udp_conns[c].lport == 0) {
       conn = &uip_udp_conns[c];
       break;
@@ -535,7 +922,11 @@ uip_udp_new(const uip_ipaddr_t *ripaddr, u16_t rport)
     return 0;
   }
   
+#if UIP_CONN_HASH
+  uip_udp_set_lport(conn, UIP_HTONS(lastport));
+#else /* UIP_CONN_HASH */
   conn->lport = UIP_HTONS(lastport);
+#endif /* UIP_CONN_HASH */
   conn->rport = rport;
   if(ripaddr == NULL) {
     memset(&conn->ripaddr, 0, sizeof(uip_ipaddr_t));
@@ -543,6 +934,7 @@ uip_udp_new(const uip_ipaddr_t *ripaddr, u16_t rport)
     uip_ipaddr_copy(&conn->ripaddr, ripaddr);
   }
   conn->ttl = uip_ds6_if.cur_hop_limit;
+  conn->tc = 0;
   
   return conn;
 }
@@ -554,6 +946,9 @@ uip_unlisten(u16_t port)
 {
   for(c = 0; c < UIP_LISTENPORTS; ++c) {
     if(uip_listenports[c] == port) {
+#if UIP_CONN_HASH
+      hash_unlink(&listen_hash[PORT_HASH(port)], listen_next, c);
+#endif /* UIP_CONN_HASH */
       uip_listenports[c] = 0;
       return;
     }
@@ -566,6 +961,9 @@ uip_listen(u16_t port)
   for(c = 0; c < UIP_LISTENPORTS; ++c) {
     if(uip_listenports[c] == 0) {
       uip_listenports[c] = port;
+#if UIP_CONN_HASH
+      hash_link(&listen_hash[PORT_HASH(port)], listen_next, c);
+#endif /* UIP_CONN_HASH */
       return;
     }
   }
@@ -798,6 +1196,82 @@ uip_add_rcv_nxt(u16_t n)
   uip_conn->rcv_nxt[2] = uip_acc32[2];
   uip_conn->rcv_nxt[3] = uip_acc32[3];
 }
+/*---------------------------------------------------------------------------*/
+static void
+uip_update_rtt(struct uip_conn *conn)
+{
+  signed char m;
+  m = conn->rto - conn->timer;
+  /* This is taken directly from VJs original code in his paper */
+  m = m - (conn->sa >> 3);
+  conn->sa += m;
+  if(m < 0) {
+    m = -m;
+  }
+  m = m - (conn->sv >> 2);
+  conn->sv += m;
+  conn->rto = (conn->sa >> 3) + conn->sv;
+}
+#if UIP_TCP_SNDBUF
+/*---------------------------------------------------------------------------*/
+#define SEQ32(s) (((u32_t)(s)[0] << 24) | ((u32_t)(s)[1] << 16) | \
+                  ((u32_t)(s)[2] << 8) | (s)[3])
+
+/* Process the acknowledgement number of an incoming segment on an
+   established connection. Everything up to the acknowledgement number
+   is released from the send buffer; an ACK that does not move
+   snd_nxt and carries no data counts as a duplicate. After a
+   retransmission timeout only one segment is in flight again, but
+   the peer may still acknowledge anything up to snd_max. */
+static void
+sndbuf_ack(struct uip_conn *conn)
+{
+  u32_t acked;
+
+  acked = SEQ32(UIP_TCP_BUF->ackno) - SEQ32(conn->snd_nxt);
+
+  if(acked > 0 && acked <= conn->snd_max) {
+    /* There is no TCP option to find out whether the peer delays its
+       ACKs, but the ACKs tell: with more than one segment in flight,
+       a peer that acknowledges only the first one does not wait for
+       a second segment. */
+    if(conn->len > conn->initialmss) {
+      if(acked <= conn->initialmss) {
+        conn->sndbuf_flags &= ~SNDBUF_PEER_DELACK;
+      } else {
+        conn->sndbuf_flags |= SNDBUF_PEER_DELACK;
+      }
+    }
+
+    uip_add32(conn->snd_nxt, (u16_t)acked);
+    conn->snd_nxt[0] = uip_acc32[0];
+    conn->snd_nxt[1] = uip_acc32[1];
+    conn->snd_nxt[2] = uip_acc32[2];
+    conn->snd_nxt[3] = uip_acc32[3];
+
+    if(conn->nrtx == 0) {
+      uip_update_rtt(conn);
+    }
+    conn->timer = conn->rto;
+    conn->nrtx = 0;
+    conn->dupacks = 0;
+
+    /* What the peer had already received is not sent again. */
+    conn->len = acked < conn->len ? conn->len - acked : 0;
+    conn->snd_max -= acked;
+    conn->sndbuf_len -= acked;
+    conn->sndbuf_head += acked;
+    if(conn->sndbuf_head >= UIP_TCP_SNDBUF_SIZE) {
+      conn->sndbuf_head -= UIP_TCP_SNDBUF_SIZE;
+    }
+  } else if(acked == 0 && conn->len > 0 && uip_len == 0 &&
+            (UIP_TCP_BUF->flags & (TCP_SYN | TCP_FIN)) == 0) {
+    if(++conn->dupacks == 3) {
+      sndbuf_fast_rexmit = 1;
+    }
+  }
+}
+#endif /* UIP_TCP_SNDBUF */
 #endif
 /*---------------------------------------------------------------------------*/
 
@@ -879,11 +1353,25 @@ uip_process(u8_t flag)
   }
 #endif /* UIP_UDP */
   uip_sappdata = uip_appdata = &uip_buf[UIP_IPTCPH_LEN + UIP_LLH_LEN];
+#if UIP_TCP
+  uip_sconstdata = NULL;
+#endif /* UIP_TCP */
+#if UIP_TCP && UIP_TCP_SNDBUF
+  sndbuf_seg_offset = 0;
+  sndbuf_fast_rexmit = 0;
+#endif /* UIP_TCP && UIP_TCP_SNDBUF */
    
   /* Check if we were invoked because of a poll request for a
      particular connection. */
   if(flag == UIP_POLL_REQUEST) {
 #if UIP_TCP
+#if UIP_TCP_SNDBUF
+    /* With a send buffer, a poll request either sends the next
+       buffered segment or asks the application for more data. */
+    if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED) {
+      goto sndbuf_poll;
+    } else
+#endif /* UIP_TCP_SNDBUF */
     if((uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED &&
        !uip_outstanding(uip_connr)) {
       uip_flags = UIP_POLL;
@@ -981,6 +1469,17 @@ uip_process(u8_t flag)
 #endif /* UIP_ACTIVE_OPEN */
                      
             case UIP_ESTABLISHED:
+#if UIP_TCP_SNDBUF
+              /*
+               * With a send buffer, we go back to the first
+               * unacknowledged byte and send everything again from
+               * the buffer, starting with one segment.
+               */
+              uip_connr->len = 0;
+              uip_connr->dupacks = 0;
+              uip_flags = 0;
+              goto sndbuf_send;
+#else /* UIP_TCP_SNDBUF */
               /*
                * In the ESTABLISHED state, we call upon the application
                * to do the actual retransmit after which we jump into
@@ -990,6 +1489,7 @@ uip_process(u8_t flag)
               uip_flags = UIP_REXMIT;
               UIP_APPCALL();
               goto apprexmit;
+#endif /* UIP_TCP_SNDBUF */
                      
             case UIP_FIN_WAIT_1:
             case UIP_CLOSING:
@@ -1003,6 +1503,9 @@ uip_process(u8_t flag)
          * If there was no need for a retransmission, we poll the
          * application for new data.
          */
+#if UIP_TCP_SNDBUF
+        goto sndbuf_poll;
+#endif /* UIP_TCP_SNDBUF */
         uip_flags = UIP_POLL;
         UIP_APPCALL();
         goto appsend;
@@ -1229,6 +1732,32 @@ uip_process(u8_t flag)
          */
 
         PRINTF("Processing Routing header\n");
+#if RPL_SRH && UIP_CONF_ROUTER
+        /* An RPL source routing header, and we are not the final
+           destination: forward the packet to the next address in the
+           header. */
+        if(UIP_ROUTING_BUF->routing_type == RPL_RH_TYPE_SRH &&
+           UIP_ROUTING_BUF->seg_left > 0) {
+          switch(rpl_srh_input()) {
+            case 0:
+              if(UIP_IP_BUF->ttl <= 1) {
+                uip_icmp6_error_output(ICMP6_TIME_EXCEEDED,
+                                       ICMP6_TIME_EXCEED_TRANSIT, 0);
+                UIP_STAT(++uip_stat.ip.drop);
+                goto send;
+              }
+              UIP_IP_BUF->ttl = UIP_IP_BUF->ttl - 1;
+              UIP_STAT(++uip_stat.ip.forwarded);
+              goto send;
+            case 1:
+              UIP_STAT(++uip_stat.ip.drop);
+              goto drop;
+            case 2:
+              UIP_STAT(++uip_stat.ip.drop);
+              goto send;
+          }
+        }
+#endif /* RPL_SRH && UIP_CONF_ROUTER */
         if(UIP_ROUTING_BUF->seg_left > 0) {
           uip_icmp6_error_output(ICMP6_PARAM_PROB, ICMP6_PARAMPROB_HEADER, UIP_IPH_LEN + uip_ext_len + 2);
           UIP_STAT(++uip_stat.ip.drop);
@@ -1394,6 +1923,32 @@ uip_process(u8_t flag)
   }
 
   /* Demultiplex this UDP packet between the UDP "connections". */
+#if UIP_CONN_HASH
+  /* Walk the bucket of the destination port. To match the connection
+     that a linear scan would have found, the matching connection with
+     the lowest index is used. */
+  {
+    struct uip_udp_conn *match = NULL;
+
+    for(c = udp_hash[PORT_HASH(UIP_UDP_BUF->destport)]; c != HASH_END;
+        c = udp_next[c]) {
+      uip_udp_conn = &uip_udp_conns[c];
+      if(uip_udp_conn->lport != 0 &&
+         UIP_UDP_BUF->destport == uip_udp_conn->lport &&
+         (uip_udp_conn->rport == 0 ||
+          UIP_UDP_BUF->srcport == uip_udp_conn->rport) &&
+         (uip_is_addr_unspecified(&uip_udp_conn->ripaddr) ||
+          uip_ipaddr_cmp(&UIP_IP_BUF->srcipaddr, &uip_udp_conn->ripaddr)) &&
+         (match == NULL || uip_udp_conn < match)) {
+        match = uip_udp_conn;
+      }
+    }
+    if(match != NULL) {
+      uip_udp_conn = match;
+      goto udp_found;
+    }
+  }
+#else /* UIP_CONN_HASH */
   for(uip_udp_conn = &uip_udp_conns[0];
       uip_udp_conn < &uip_udp_conns[UIP_UDP_CONNS];
       ++uip_udp_conn) {
@@ -1413,6 +1968,7 @@ uip_process(u8_t flag)
       goto udp_found;
     }
   }
+#endif /* UIP_CONN_HASH */
   PRINTF("udp: no matching connection found\n");
 
 #if UIP_UDP_SEND_UNREACH_NOPORT
@@ -1467,7 +2023,10 @@ uip_process(u8_t flag)
   }
 #endif /* UIP_UDP_CHECKSUMS */
   UIP_STAT(++uip_stat.udp.sent);
-  goto ip_send_nolen;
+  UIP_IP_BUF->vtc = 0x60 | (uip_udp_conn->tc >> 4);
+  UIP_IP_BUF->tcflow = uip_udp_conn->tc << 4;
+  UIP_IP_BUF->flow = 0x00;
+  goto send;
 #endif /* UIP_UDP */
 
 #if UIP_TCP
@@ -1494,6 +2053,29 @@ uip_process(u8_t flag)
 
   /* Demultiplex this segment. */
   /* First check any active connections. */
+#if UIP_CONN_HASH
+  {
+    struct uip_conn *match = NULL;
+
+    for(c = tcp_hash[tcp_hash_key(UIP_TCP_BUF->destport,
+                                  UIP_TCP_BUF->srcport,
+                                  &UIP_IP_BUF->srcipaddr)];
+        c != HASH_END; c = tcp_hash_next[c]) {
+      uip_connr = &uip_conns[c];
+      if(uip_connr->tcpstateflags != UIP_CLOSED &&
+         UIP_TCP_BUF->destport == uip_connr->lport &&
+         UIP_TCP_BUF->srcport == uip_connr->rport &&
+         uip_ipaddr_cmp(&UIP_IP_BUF->srcipaddr, &uip_connr->ripaddr) &&
+         (match == NULL || uip_connr < match)) {
+        match = uip_connr;
+      }
+    }
+    if(match != NULL) {
+      uip_connr = match;
+      goto found;
+    }
+  }
+#else /* UIP_CONN_HASH */
   for(uip_connr = &uip_conns[0]; uip_connr <= &uip_conns[UIP_CONNS - 1];
       ++uip_connr) {
     if(uip_connr->tcpstateflags != UIP_CLOSED &&
@@ -1503,6 +2085,7 @@ uip_process(u8_t flag)
       goto found;
     }
   }
+#endif /* UIP_CONN_HASH */
 
   /* If we didn't find and active connection that expected the packet,
      either this packet is an old duplicate, or this is a SYN packet
@@ -1514,7 +2097,11 @@ uip_process(u8_t flag)
   
   tmp16 = UIP_TCP_BUF->destport;
   /* Next, check listening connections. */
+#if UIP_CONN_HASH
+  for(c = listen_hash[PORT_HASH(tmp16)]; c != HASH_END; c = listen_next[c]) {
+#else /* UIP_CONN_HASH */
   for(c = 0; c < UIP_LISTENPORTS; ++c) {
+#endif /* UIP_CONN_HASH */
     if(tmp16 == uip_listenports[c]) {
       goto found_listen;
     }
@@ -1609,6 +2196,9 @@ uip_process(u8_t flag)
     goto drop;
   }
   uip_conn = uip_connr;
+#if UIP_CONN_HASH
+  tcp_hash_remove(uip_connr);
+#endif /* UIP_CONN_HASH */
   
   /* Fill in the necessary fields for the new connection. */
   uip_connr->rto = uip_connr->timer = UIP_RTO;
@@ -1618,6 +2208,9 @@ uip_process(u8_t flag)
   uip_connr->lport = UIP_TCP_BUF->destport;
   uip_connr->rport = UIP_TCP_BUF->srcport;
   uip_ipaddr_copy(&uip_connr->ripaddr, &UIP_IP_BUF->srcipaddr);
+#if UIP_CONN_HASH
+  tcp_hash_insert(uip_connr);
+#endif /* UIP_CONN_HASH */
   uip_connr->tcpstateflags = UIP_SYN_RCVD;
 
   uip_connr->snd_nxt[0] = iss[0];
@@ -1625,6 +2218,9 @@ uip_process(u8_t flag)
   uip_connr->snd_nxt[2] = iss[2];
   uip_connr->snd_nxt[3] = iss[3];
   uip_connr->len = 1;
+#if UIP_TCP_SNDBUF
+  sndbuf_reset(uip_connr);
+#endif /* UIP_TCP_SNDBUF */
 
   /* rcv_nxt should be the seqno from the incoming packet + 1. */
   uip_connr->rcv_nxt[3] = UIP_TCP_BUF->seqno[3];
@@ -1738,6 +2334,14 @@ uip_process(u8_t flag)
      data. If so, we update the sequence number, reset the length of
      the outstanding data, calculate RTT estimations, and reset the
      retransmission timer. */
+#if UIP_TCP_SNDBUF
+  if((UIP_TCP_BUF->flags & TCP_ACK) &&
+     (uip_connr->tcpstateflags & UIP_TS_MASK) == UIP_ESTABLISHED) {
+    /* Established connections may have several segments in
+       flight. */
+    sndbuf_ack(uip_connr);
+  } else
+#endif /* UIP_TCP_SNDBUF */
   if((UIP_TCP_BUF->flags & TCP_ACK) && uip_outstanding(uip_connr)) {
     uip_add32(uip_connr->snd_nxt, uip_connr->len);
 
@@ -1753,18 +2357,7 @@ uip_process(u8_t flag)
    
       /* Do RTT estimation, unless we have done retransmissions. */
       if(uip_connr->nrtx == 0) {
-        signed char m;
-        m = uip_connr->rto - uip_connr->timer;
-        /* This is taken directly from VJs original code in his paper */
-        m = m - (uip_connr->sa >> 3);
-        uip_connr->sa += m;
-        if(m < 0) {
-          m = -m;
-        }
-        m = m - (uip_connr->sv >> 2);
-        uip_connr->sv += m;
-        uip_connr->rto = (uip_connr->sa >> 3) + uip_connr->sv;
-
+        uip_update_rtt(uip_connr);
       }
       /* Set the acknowledged flag. */
       uip_flags = UIP_ACKDATA;
@@ -1883,6 +2476,11 @@ uip_process(u8_t flag)
         if(uip_outstanding(uip_connr)) {
           goto drop;
         }
+#if UIP_TCP_SNDBUF
+        if(uip_connr->sndbuf_len > 0) {
+          goto drop;
+        }
+#endif /* UIP_TCP_SNDBUF */
         uip_add_rcv_nxt(1 + uip_len);
         uip_flags |= UIP_CLOSE;
         if(uip_len > 0) {
@@ -1941,6 +2539,9 @@ uip_process(u8_t flag)
          "persistent timer" and uses the retransmission mechanim.
       */
       tmp16 = ((u16_t)UIP_TCP_BUF->wnd[0] << 8) + (u16_t)UIP_TCP_BUF->wnd[1];
+#if UIP_TCP_SNDBUF
+      uip_connr->snd_wnd = tmp16;
+#endif /* UIP_TCP_SNDBUF */
       if(tmp16 > uip_connr->initialmss ||
          tmp16 == 0) {
         tmp16 = uip_connr->initialmss;
@@ -1963,6 +2564,23 @@ uip_process(u8_t flag)
          put into the uip_appdata and the length of the data should be
          put into uip_len. If the application don't have any data to
          send, uip_len must be set to 0. */
+#if UIP_TCP_SNDBUF
+      /* With a send buffer, the application is told that its data
+         was acknowledged when the data has been buffered and there
+         is room for more. Once it has closed the connection, it is
+         not called again. */
+      if((uip_connr->sndbuf_flags & SNDBUF_ACK_PENDING) &&
+         sndbuf_room(uip_connr)) {
+        uip_connr->sndbuf_flags &= ~SNDBUF_ACK_PENDING;
+        uip_flags |= UIP_ACKDATA;
+      }
+      uip_slen = 0;
+      if((uip_flags & (UIP_NEWDATA | UIP_ACKDATA)) &&
+         !(uip_connr->sndbuf_flags & SNDBUF_CLOSE_PENDING)) {
+        UIP_APPCALL();
+      }
+      goto appsend;
+#endif /* UIP_TCP_SNDBUF */
       if(uip_flags & (UIP_NEWDATA | UIP_ACKDATA)) {
         uip_slen = 0;
         UIP_APPCALL();
@@ -1976,6 +2594,10 @@ uip_process(u8_t flag)
           goto tcp_send_nodata;
         }
 
+#if UIP_TCP_SNDBUF
+        goto sndbuf_appsend;
+#endif /* UIP_TCP_SNDBUF */
+
         if(uip_flags & UIP_CLOSE) {
           uip_slen = 0;
           uip_connr->len = 1;
@@ -2018,7 +2640,9 @@ uip_process(u8_t flag)
           }
         }
         uip_connr->nrtx = 0;
+#if !UIP_TCP_SNDBUF
       apprexmit:
+#endif /* !UIP_TCP_SNDBUF */
         uip_appdata = uip_sappdata;
       
         /* If the application has data to be sent, or if the incoming
@@ -2040,6 +2664,103 @@ uip_process(u8_t flag)
         }
       }
       goto drop;
+
+#if UIP_TCP_SNDBUF
+    sndbuf_poll:
+      /* Ask the application for more data when everything it has
+         written so far has been sent, or when it has just written
+         something and may have more to add to the same segment. */
+      uip_flags = 0;
+      uip_slen = 0;
+      if((sndbuf_sendable(uip_connr) == 0 ||
+          (uip_connr->sndbuf_flags & SNDBUF_ACK_PENDING)) &&
+         sndbuf_room(uip_connr) &&
+         !(uip_connr->sndbuf_flags & SNDBUF_CLOSE_PENDING)) {
+        uip_flags = UIP_POLL;
+        if(uip_connr->sndbuf_flags & SNDBUF_ACK_PENDING) {
+          uip_connr->sndbuf_flags &= ~SNDBUF_ACK_PENDING;
+          uip_flags |= UIP_ACKDATA;
+        }
+        UIP_APPCALL();
+      }
+      goto appsend;
+
+    sndbuf_appsend:
+      /* Everything the application writes goes into the send buffer
+         and is sent from there. */
+      if(uip_flags & UIP_CLOSE) {
+        uip_slen = 0;
+        uip_connr->sndbuf_flags |= SNDBUF_CLOSE_PENDING;
+      }
+      if(uip_slen > 0) {
+        sndbuf_write(uip_connr, uip_sconstdata != NULL ?
+                     uip_sconstdata : uip_sappdata, uip_slen);
+        uip_connr->sndbuf_flags |= SNDBUF_ACK_PENDING;
+      }
+      uip_sconstdata = NULL;
+
+    sndbuf_send:
+      if((uip_connr->sndbuf_flags & SNDBUF_CLOSE_PENDING) &&
+         uip_connr->sndbuf_len == 0) {
+        uip_connr->len = 1;
+        uip_connr->tcpstateflags = UIP_FIN_WAIT_1;
+        uip_connr->nrtx = 0;
+        UIP_TCP_BUF->flags = TCP_FIN | TCP_ACK;
+        goto tcp_send_nodata;
+      }
+
+      uip_appdata = &uip_buf[UIP_IPTCPH_LEN + UIP_LLH_LEN];
+      if(sndbuf_fast_rexmit) {
+        /* Resend the first unacknowledged segment. */
+        tmp16 = uip_connr->len < uip_connr->initialmss ?
+          uip_connr->len : uip_connr->initialmss;
+        sndbuf_seg_offset = 0;
+        UIP_STAT(++uip_stat.tcp.rexmit);
+      } else {
+        tmp16 = sndbuf_sendable(uip_connr);
+        if(uip_slen > 0 && tmp16 == uip_connr->sndbuf_len - uip_connr->len &&
+           tmp16 < uip_connr->initialmss && sndbuf_room(uip_connr) &&
+           !(uip_connr->sndbuf_flags & SNDBUF_CLOSE_PENDING)) {
+          /* The application has just written less than a full
+             segment. It will be polled again right away, so we hold
+             the data back until it has nothing more to add. This
+             turns a series of small psock writes into a single
+             segment, without a Nagle timer. Incoming data is still
+             acknowledged below. */
+          tmp16 = 0;
+        }
+        if(uip_connr->len == 0 &&
+           tmp16 == uip_connr->sndbuf_len && tmp16 > 1 &&
+           (uip_connr->sndbuf_flags & SNDBUF_PEER_DELACK) &&
+           ((uip_connr->sndbuf_flags & SNDBUF_CLOSE_PENDING) ||
+            !sndbuf_room(uip_connr))) {
+          /* This segment would be the only one in flight and we
+             cannot go on until it is acknowledged, either to send
+             our FIN or to make room for the application. A peer that
+             delays its ACKs would keep us waiting, so we send the
+             data as two segments, which is acknowledged at once. */
+          tmp16 = (tmp16 + 1) / 2;
+        }
+        sndbuf_seg_offset = uip_connr->len;
+        uip_connr->len += tmp16;
+        if(uip_connr->len > uip_connr->snd_max) {
+          uip_connr->snd_max = uip_connr->len;
+        }
+      }
+      if(tmp16 > 0) {
+        sndbuf_read(uip_connr, sndbuf_seg_offset, uip_appdata, tmp16);
+        uip_len = tmp16 + UIP_TCPIP_HLEN;
+        UIP_TCP_BUF->flags = TCP_ACK | TCP_PSH;
+        goto tcp_send_noopts;
+      }
+      if(uip_flags & UIP_NEWDATA) {
+        uip_len = UIP_TCPIP_HLEN;
+        UIP_TCP_BUF->flags = TCP_ACK;
+        goto tcp_send_noopts;
+      }
+      goto drop;
+#endif /* UIP_TCP_SNDBUF */
+
     case UIP_LAST_ACK:
       /* We can close this connection if the peer has acknowledged our
          FIN. This is indicated by the UIP_ACKDATA flag. */
@@ -2134,6 +2855,17 @@ uip_process(u8_t flag)
   UIP_TCP_BUF->seqno[1] = uip_connr->snd_nxt[1];
   UIP_TCP_BUF->seqno[2] = uip_connr->snd_nxt[2];
   UIP_TCP_BUF->seqno[3] = uip_connr->snd_nxt[3];
+#if UIP_TCP_SNDBUF
+  if(sndbuf_seg_offset > 0) {
+    /* The segment does not start at the first unacknowledged
+       byte. */
+    uip_add32(UIP_TCP_BUF->seqno, sndbuf_seg_offset);
+    UIP_TCP_BUF->seqno[0] = uip_acc32[0];
+    UIP_TCP_BUF->seqno[1] = uip_acc32[1];
+    UIP_TCP_BUF->seqno[2] = uip_acc32[2];
+    UIP_TCP_BUF->seqno[3] = uip_acc32[3];
+  }
+#endif /* UIP_TCP_SNDBUF */
 
   UIP_IP_BUF->proto = UIP_PROTO_TCP;
   
@@ -2165,15 +2897,25 @@ uip_process(u8_t flag)
 
   UIP_TCP_BUF->urgp[0] = UIP_TCP_BUF->urgp[1] = 0;
   
-  /* Calculate TCP checksum. */
+  /* Calculate TCP checksum. Data given to uip_send_const() is copied
+     into the segment here. */
   UIP_TCP_BUF->tcpchksum = 0;
-  UIP_TCP_BUF->tcpchksum = ~(uip_tcpchksum());
+  if(uip_sconstdata != NULL && uip_len > UIP_IPTCPH_LEN) {
+#if UIP_CHKSUM_COPY
+    UIP_TCP_BUF->tcpchksum = ~(uip_tcpchksum_copy(uip_sconstdata,
+                                                  uip_len - UIP_IPTCPH_LEN));
+#else /* UIP_CHKSUM_COPY */
+    memcpy(&uip_buf[UIP_LLH_LEN + UIP_IPTCPH_LEN], uip_sconstdata,
+           uip_len - UIP_IPTCPH_LEN);
+    UIP_TCP_BUF->tcpchksum = ~(uip_tcpchksum());
+#endif /* UIP_CHKSUM_COPY */
+  } else {
+    UIP_TCP_BUF->tcpchksum = ~(uip_tcpchksum());
+  }
+  uip_sconstdata = NULL;
   UIP_STAT(++uip_stat.tcp.sent);
 
 #endif /* UIP_TCP */
-#if UIP_UDP
- ip_send_nolen:
-#endif
   UIP_IP_BUF->vtc = 0x60;
   UIP_IP_BUF->tcflow = 0x00;
   UIP_IP_BUF->flow = 0x00;
@@ -2215,10 +2957,38 @@ uip_send(const void *data, int len)
                 (int)((char *)uip_sappdata - (char *)&uip_buf[UIP_LLH_LEN + UIP_TCPIP_HLEN]));
   if(copylen > 0) {
     uip_slen = copylen;
+#if UIP_TCP
+    uip_sconstdata = NULL;
+#endif /* UIP_TCP */
     if(data != uip_sappdata) {
       memcpy(uip_sappdata, (data), uip_slen);
     }
   }
 }
 /*---------------------------------------------------------------------------*/
+#if UIP_TCP
+void
+uip_send_const(const void *data, int len)
+{
+  int copylen;
+
+  /* Data in the packet buffer itself, or data that is not going into
+     the start of the segment, is copied right away. */
+  if((const u8_t *)data >= &uip_buf[0] &&
+     (const u8_t *)data < &uip_buf[UIP_BUFSIZE]) {
+    uip_send(data, len);
+    return;
+  }
+  if(uip_sappdata != &uip_buf[UIP_LLH_LEN + UIP_TCPIP_HLEN]) {
+    uip_send(data, len);
+    return;
+  }
+  copylen = MIN(len, UIP_BUFSIZE - UIP_LLH_LEN - UIP_TCPIP_HLEN);
+  if(copylen > 0) {
+    uip_slen = copylen;
+    uip_sconstdata = data;
+  }
+}
+#endif /* UIP_TCP */
+/*---------------------------------------------------------------------------*/
 /** @} */
@@ -342,6 +342,40 @@
 #define UIP_LISTENPORTS (UIP_CONF_MAX_LISTENPORTS)
 #endif /* UIP_CONF_MAX_LISTENPORTS */
 
+/**
+ * Demultiplex incoming TCP and UDP packets through hash tables.
+ *
+ * With this option, uip6.c keeps the TCP connections hashed on
+ * their local port, remote port and remote address, and the UDP
+ * connections and listening TCP ports hashed on their local port,
+ * instead of scanning the connection tables for every incoming
+ * packet. This is useful when UIP_CONF_MAX_CONNECTIONS or
+ * UIP_CONF_UDP_CONNS are large. Each connection and listening port
+ * requires 2 bytes (4 for TCP connections) of additional memory.
+ *
+ * \note Only implemented for IPv6. UDP connections must be bound
+ * and removed with uip_udp_bind() and uip_udp_remove().
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_CONN_HASH
+#define UIP_CONN_HASH (UIP_CONF_CONN_HASH)
+#else /* UIP_CONF_CONN_HASH */
+#define UIP_CONN_HASH 0
+#endif /* UIP_CONF_CONN_HASH */
+
+/**
+ * The number of buckets in each of the connection hash tables. Must
+ * be a power of two.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_CONN_HASH_SIZE
+#define UIP_CONN_HASH_SIZE (UIP_CONF_CONN_HASH_SIZE)
+#else /* UIP_CONF_CONN_HASH_SIZE */
+#define UIP_CONN_HASH_SIZE 32
+#endif /* UIP_CONF_CONN_HASH_SIZE */
+
 /**
  * Determines if support for TCP urgent data notification should be
  * compiled in.
@@ -404,6 +438,62 @@
 #define UIP_RECEIVE_WINDOW (UIP_CONF_RECEIVE_WINDOW)
 #endif
 
+/**
+ * Buffer outgoing TCP data so that several segments can be in flight.
+ *
+ * By default, uIP allows a single unacknowledged segment per
+ * connection and asks the application to regenerate the data when a
+ * retransmission is needed. With this option, data sent with
+ * uip_send() is copied into a per-connection send buffer. uIP then
+ * keeps up to UIP_TCP_SNDBUF_SEGMENTS segments in flight, handles
+ * cumulative ACKs, does fast retransmit after three duplicate ACKs and
+ * retransmits from the buffer, so the application never sees
+ * UIP_REXMIT.
+ *
+ * The application API is unchanged: uip_acked() is reported as soon
+ * as the data has been taken into the buffer and there is room for
+ * another write, and uip_mss() never exceeds the free space in the
+ * buffer.
+ *
+ * Writes of less than a segment are held back while the application
+ * keeps writing, so that they are sent as one segment. Instead of
+ * splitting every segment like uip-split, uIP watches whether the peer
+ * delays its ACKs and only splits a segment when it would otherwise
+ * wait for a delayed ACK.
+ *
+ * \note Only implemented for IPv6.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_SNDBUF
+#define UIP_TCP_SNDBUF (UIP_CONF_TCP_SNDBUF)
+#else
+#define UIP_TCP_SNDBUF 0
+#endif
+
+/**
+ * The size of the per-connection TCP send buffer, in bytes.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_SNDBUF_SIZE
+#define UIP_TCP_SNDBUF_SIZE (UIP_CONF_TCP_SNDBUF_SIZE)
+#else
+#define UIP_TCP_SNDBUF_SIZE (4 * UIP_TCP_MSS)
+#endif
+
+/**
+ * The maximum number of unacknowledged segments per connection when
+ * UIP_TCP_SNDBUF is enabled.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_TCP_SNDBUF_SEGMENTS
+#define UIP_TCP_SNDBUF_SEGMENTS (UIP_CONF_TCP_SNDBUF_SEGMENTS)
+#else
+#define UIP_TCP_SNDBUF_SEGMENTS 4
+#endif
+
 /**
  * How long a connection should stay in the TIME_WAIT state.
  *
@@ -482,7 +572,8 @@
 #endif
 
 /**
- * If we use IPHC compression, how many address contexts do we support
+ * If we use IPHC compression, how many address contexts do we support.
+ * IPHC context numbers are 0-15, so at most 16.
  */
 #ifndef SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS 
 #define SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS 1
@@ -618,6 +709,32 @@ void uip_log(char *msg);
 #define UIP_BYTE_ORDER     (UIP_LITTLE_ENDIAN)
 #endif /* UIP_CONF_BYTE_ORDER */
 
+/**
+ * Use the word-at-a-time checksum implementation in uip-chksum.c.
+ *
+ * This implementation sums aligned 32-bit words into a 64-bit
+ * accumulator and is intended for CPUs with wide registers, such as
+ * the native and cooja targets. It replaces the generic checksum
+ * functions, so UIP_ARCH_CHKSUM must be set as well.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CHKSUM_CONF_WIDE
+#define UIP_CHKSUM_WIDE    (UIP_CHKSUM_CONF_WIDE)
+#else /* UIP_CHKSUM_CONF_WIDE */
+#define UIP_CHKSUM_WIDE    0
+#endif /* UIP_CHKSUM_CONF_WIDE */
+
+/**
+ * Whether uip_tcpchksum_copy() is available. Both the wide checksum
+ * code and the generic code in uip.c and uip6.c provide it; an
+ * architecture specific checksum (UIP_ARCH_CHKSUM) does not, and the
+ * payload is then copied before it is summed.
+ *
+ * \hideinitializer
+ */
+#define UIP_CHKSUM_COPY    (UIP_CHKSUM_WIDE || !UIP_ARCH_CHKSUM)
+
 /** @} */
 /*------------------------------------------------------------------------------*/
 
@@ -35,6 +35,7 @@
 
 #include "net/uip.h"
 #include "net/uipopt.h"
+#include "net/nettrace.h"
 
 #if UIP_CONF_IPV6
 
@@ -134,6 +135,8 @@ tapdev_poll(void)
   
   if(ret == -1) {
     perror("tapdev_poll: read");
+  } else {
+    NETTRACE(NETTRACE_RX, uip_buf, ret);
   }
   return ret;
 }
@@ -363,6 +366,7 @@ do_send(void)
   }
 #endif /* DROP */
 
+  NETTRACE(NETTRACE_TX, uip_buf, uip_len);
   ret = write(fd, uip_buf, uip_len);
 
   if(ret == -1) {
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Throughput benchmark for the uIP Internet checksum
+ *
+ *         Measures uip_chksum() over a range of payload sizes and
+ *         compares it to the byte-pair loop used by the generic uIP
+ *         checksum code. Build with DEFINES=UIP_CHKSUM_CONF_WIDE=0 to
+ *         measure the generic implementation through uip_chksum() as
+ *         well.
+ * \author
+ *         agent <agent@local>
+ */
+
+#include "contiki.h"
+#include "net/uip.h"
+#include "lib/random.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MIN_TIME (CLOCK_SECOND / 4)
+
+static const uint16_t sizes[] = { 8, 20, 40, 64, 127, 256, 512, 1280 };
+
+static uint8_t buf[1280 + 1];
+/*---------------------------------------------------------------------------*/
+static uint16_t
+bytepair_chksum(uint16_t sum, const uint8_t *data, uint16_t len)
+{
+  uint16_t t;
+  const uint8_t *dataptr;
+  const uint8_t *last_byte;
+
+  dataptr = data;
+  last_byte = data + len - 1;
+
+  while(dataptr < last_byte) {
+    t = (dataptr[0] << 8) + dataptr[1];
+    sum += t;
+    if(sum < t) {
+      sum++;
+    }
+    dataptr += 2;
+  }
+
+  if(dataptr == last_byte) {
+    t = (dataptr[0] << 8) + 0;
+    sum += t;
+    if(sum < t) {
+      sum++;
+    }
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns the number of kilobytes checksummed per second. */
+static unsigned long
+measure(int use_uip, const uint8_t *data, uint16_t len)
+{
+  clock_time_t start, elapsed;
+  unsigned long rounds, i;
+  volatile uint16_t sink;
+
+  rounds = 0;
+  start = clock_time();
+  do {
+    for(i = 0; i < 1000; i++) {
+      if(use_uip) {
+        sink = uip_chksum((uint16_t *)data, len);
+      } else {
+        sink = bytepair_chksum(0, data, len);
+      }
+    }
+    rounds += i;
+    elapsed = clock_time() - start;
+  } while(elapsed < MIN_TIME);
+  (void)sink;
+
+  return (unsigned long)((double)rounds * len * CLOCK_SECOND /
+                         elapsed / 1024);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(chksum_bench_process, "Checksum benchmark");
+AUTOSTART_PROCESSES(&chksum_bench_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(chksum_bench_process, ev, data)
+{
+  int i;
+  uint16_t len;
+
+  PROCESS_BEGIN();
+
+  for(i = 0; i < sizeof(buf); i++) {
+    buf[i] = random_rand();
+  }
+
+  printf("size  align  bytepair kB/s  uip_chksum kB/s\n");
+  for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    len = sizes[i];
+    if(uip_chksum((uint16_t *)buf, len) !=
+       uip_htons(bytepair_chksum(0, buf, len)) ||
+       uip_chksum((uint16_t *)&buf[1], len) !=
+       uip_htons(bytepair_chksum(0, &buf[1], len))) {
+      printf("checksum mismatch for size %u\n", len);
+    }
+    printf("%4u  even   %13lu  %15lu\n", len,
+           measure(0, buf, len), measure(1, buf, len));
+    printf("%4u  odd    %13lu  %15lu\n", len,
+           measure(0, &buf[1], len), measure(1, &buf[1], len));
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
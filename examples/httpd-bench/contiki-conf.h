@@ -0,0 +1,18 @@
+/*
+ * The native platform configuration, with a packet buffer and MSS of
+ * an Ethernet-sized IPv6 link so that the benchmark can use large
+ * segments.
+ */
+#ifndef __CONTIKI_CONF_H__HTTPD_BENCH
+#define __CONTIKI_CONF_H__HTTPD_BENCH
+
+#include "../../platform/native/contiki-conf.h"
+
+#undef UIP_CONF_BUFFER_SIZE
+#define UIP_CONF_BUFFER_SIZE     1280
+#undef UIP_CONF_TCP_MSS
+#define UIP_CONF_TCP_MSS         (UIP_CONF_BUFFER_SIZE - 60)
+#undef UIP_CONF_RECEIVE_WINDOW
+#define UIP_CONF_RECEIVE_WINDOW  UIP_CONF_TCP_MSS
+
+#endif /* __CONTIKI_CONF_H__HTTPD_BENCH */
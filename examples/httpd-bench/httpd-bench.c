@@ -0,0 +1,449 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Benchmark for sending large files with the web server
+ *
+ *         Runs uIP, protosockets and the web server on the build
+ *         host, and plays the part of an HTTP client that fetches a
+ *         large file from the web server's file system: from ROM with
+ *         httpd.c, or from CFS with httpd-cfs.c when built with
+ *         HTTPD_BENCH_CFS. Every segment
+ *         is checked for its TCP checksum, its sequence number and
+ *         its contents. Some segments are dropped to make the server
+ *         retransmit. The time per segment and the throughput are
+ *         then reported for a range of MSS values. Exits with a
+ *         non-zero status if the transfer fails.
+ * \author
+ *         agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "contiki-net.h"
+#include "http-strings.h"
+#if HTTPD_BENCH_CFS
+#include "cfs/cfs.h"
+#include "httpd-cfs.h"
+#else /* HTTPD_BENCH_CFS */
+#include "httpd.h"
+#include "httpd-fs.h"
+#include "httpd-cgi.h"
+#endif /* HTTPD_BENCH_CFS */
+
+#define FILE_SIZE      (200 * 1024L)
+#define CLIENT_PORT    40000
+#define CLIENT_ISN     1000
+#define DROP_INTERVAL  7
+
+#define IPBUF  ((struct uip_tcpip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+/* TCP flags and options, as in uip6.c. */
+#define TCP_FIN 0x01
+#define TCP_SYN 0x02
+#define TCP_PSH 0x08
+#define TCP_ACK 0x10
+#define TCP_OPT_MSS     2
+#define TCP_OPT_MSS_LEN 4
+
+static const uip_ipaddr_t client_addr =
+  {{ 0xaa, 0xaa, 0, 0, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x02, 0, 0x02, 0x02, 0x02 }};
+static const uip_ipaddr_t server_addr =
+  {{ 0xaa, 0xaa, 0, 0, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x01, 0, 0x01, 0x01, 0x01 }};
+
+static const char request[] = "GET /big.bin HTTP/1.0\r\n\r\n";
+
+/* The HTTP header and the file, as makefsdata -H lays them out. This
+   is also what the client expects to receive. */
+static char filedata[sizeof(http_header_200) + sizeof(http_content_type_binary) +
+                     FILE_SIZE];
+static int hdrlen;
+
+static uint8_t received[sizeof(filedata)];
+static long receivedlen;
+static uint16_t client_port = CLIENT_PORT;
+static uint32_t rcv_nxt, snd_nxt;
+static unsigned long segments;
+static int verify;
+/*---------------------------------------------------------------------------*/
+/* The rest of the system, as far as the web server needs it. */
+uip_ds6_netif_t uip_ds6_if;
+
+static uip_ds6_addr_t server_ds6_addr;
+
+uip_ds6_addr_t *
+uip_ds6_addr_lookup(uip_ipaddr_t *addr)
+{
+  return uip_ipaddr_cmp(addr, &server_addr) ? &server_ds6_addr : NULL;
+}
+uip_ds6_maddr_t *
+uip_ds6_maddr_lookup(uip_ipaddr_t *addr)
+{
+  return NULL;
+}
+uint8_t
+uip_ds6_is_addr_onlink(uip_ipaddr_t *addr)
+{
+  return 1;
+}
+void
+uip_ds6_select_src(uip_ipaddr_t *src, uip_ipaddr_t *dst)
+{
+  uip_ipaddr_copy(src, &server_addr);
+}
+void uip_ds6_init(void) {}
+void uip_icmp6_error_output(uint8_t type, uint8_t code, uint32_t param) {}
+void uip_icmp6_echo_request_input(void) {}
+void uip_nd6_ns_input(void) {}
+void uip_nd6_na_input(void) {}
+void uip_nd6_rs_input(void) {}
+void uip_nd6_ra_input(void) {}
+void uip_rpl_input(void) {}
+int rpl_srh_input(void) { return 0; }
+void tcpip_icmp6_call(uint8_t type) {}
+void webserver_log(char *msg) {}
+void webserver_log_file(uip_ipaddr_t *requester, char *file) {}
+void tcpip_poll_tcp(struct uip_conn *conn) {}
+void
+tcp_listen(u16_t port)
+{
+  uip_listen(port);
+}
+
+void
+tcp_attach(struct uip_conn *conn, void *appstate)
+{
+  conn->appstate.state = appstate;
+}
+void
+tcpip_uipcall(void)
+{
+  httpd_appcall(uip_conn->appstate.state);
+}
+/*---------------------------------------------------------------------------*/
+#if HTTPD_BENCH_CFS
+clock_time_t
+clock_time(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+file_init(void)
+{
+  int fd;
+
+  fd = cfs_open("big.bin", CFS_WRITE);
+  if(fd < 0 ||
+     cfs_write(fd, &filedata[hdrlen], FILE_SIZE) != FILE_SIZE) {
+    printf("FAIL: cannot write big.bin\n");
+    exit(1);
+  }
+  cfs_close(fd);
+}
+#else /* HTTPD_BENCH_CFS */
+void httpd_cgi_init(void) {}
+
+httpd_cgifunction
+httpd_cgi(char *name)
+{
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+int
+httpd_fs_open(const char *name, struct httpd_fs_file *file)
+{
+  if(strcmp(name, "/big.bin") != 0) {
+    return 0;
+  }
+  file->data = &filedata[hdrlen];
+  file->len = FILE_SIZE;
+  file->type = HTTPD_FS_TYPE_BINARY;
+  file->hdrlen = hdrlen;
+  file->flags = 0;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+file_init(void)
+{
+}
+#endif /* HTTPD_BENCH_CFS */
+/*---------------------------------------------------------------------------*/
+static uint16_t
+sum16(uint32_t sum, const uint8_t *data, int len)
+{
+  int i;
+
+  for(i = 0; i + 1 < len; i += 2) {
+    sum += (data[i] << 8) | data[i + 1];
+  }
+  if(len & 1) {
+    sum += data[len - 1] << 8;
+  }
+  while(sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+/* The TCP checksum of the packet in uip_buf, which must be 0xffff
+   when the checksum field is correct. */
+static uint16_t
+tcp_sum(void)
+{
+  int len = uip_len - UIP_IPH_LEN;
+
+  return sum16(len + UIP_PROTO_TCP +
+               sum16(0, IPBUF->srcipaddr.u8, 2 * sizeof(uip_ipaddr_t)),
+               &uip_buf[UIP_LLH_LEN + UIP_IPH_LEN], len);
+}
+/*---------------------------------------------------------------------------*/
+/* Put a segment from the client into uip_buf and let uIP process it. */
+static void
+client_send(uint8_t flags, const uint8_t *opt, int optlen,
+            const void *data, int datalen)
+{
+  struct uip_tcpip_hdr *h = IPBUF;
+  int len = UIP_TCPH_LEN + optlen + datalen;
+
+  memset(h, 0, UIP_IPTCPH_LEN);
+  h->vtc = 0x60;
+  h->len[0] = len >> 8;
+  h->len[1] = len & 0xff;
+  h->proto = UIP_PROTO_TCP;
+  h->ttl = 64;
+  uip_ipaddr_copy(&h->srcipaddr, &client_addr);
+  uip_ipaddr_copy(&h->destipaddr, &server_addr);
+  h->srcport = UIP_HTONS(client_port);
+  h->destport = UIP_HTONS(80);
+  h->seqno[0] = snd_nxt >> 24;
+  h->seqno[1] = snd_nxt >> 16;
+  h->seqno[2] = snd_nxt >> 8;
+  h->seqno[3] = snd_nxt;
+  h->ackno[0] = rcv_nxt >> 24;
+  h->ackno[1] = rcv_nxt >> 16;
+  h->ackno[2] = rcv_nxt >> 8;
+  h->ackno[3] = rcv_nxt;
+  h->tcpoffset = ((UIP_TCPH_LEN + optlen) / 4) << 4;
+  h->flags = flags;
+  h->wnd[0] = h->wnd[1] = 0xff;
+  memcpy(&uip_buf[UIP_LLH_LEN + UIP_IPTCPH_LEN], opt, optlen);
+  memcpy(&uip_buf[UIP_LLH_LEN + UIP_IPTCPH_LEN + optlen], data, datalen);
+  uip_len = UIP_IPH_LEN + len;
+  h->tcpchksum = ~UIP_HTONS(tcp_sum());
+
+  snd_nxt += datalen + ((flags & (TCP_SYN | TCP_FIN)) ? 1 : 0);
+  uip_input();
+}
+/*---------------------------------------------------------------------------*/
+static void
+fail(const char *msg)
+{
+  printf("FAIL: %s (segment %lu, %ld bytes received)\n",
+         msg, segments, receivedlen);
+  exit(1);
+}
+/*---------------------------------------------------------------------------*/
+/* Take the segment that uIP has sent, if any. Returns its TCP flags. */
+static uint8_t
+client_receive(void)
+{
+  struct uip_tcpip_hdr *h = IPBUF;
+  uint32_t seq;
+  int datalen;
+
+  if(uip_len == 0) {
+    fail("no segment from the server");
+  }
+  seq = ((uint32_t)h->seqno[0] << 24) | ((uint32_t)h->seqno[1] << 16) |
+    ((uint32_t)h->seqno[2] << 8) | h->seqno[3];
+  datalen = uip_len - UIP_IPH_LEN - (h->tcpoffset >> 4) * 4;
+  if(verify) {
+    if(tcp_sum() != 0xffff) {
+      fail("bad TCP checksum");
+    }
+    if(datalen > 0 && seq != rcv_nxt) {
+      fail("unexpected sequence number");
+    }
+    if(receivedlen + datalen > (long)sizeof(received)) {
+      fail("too much data");
+    }
+    memcpy(&received[receivedlen], &uip_buf[uip_len - datalen], datalen);
+  }
+  if(h->flags & TCP_SYN) {
+    rcv_nxt = seq + 1;
+  }
+  rcv_nxt += datalen;
+  receivedlen += datalen;
+  if(datalen > 0) {
+    segments++;
+  }
+  if(h->flags & TCP_FIN) {
+    rcv_nxt++;
+  }
+  return h->flags;
+}
+/*---------------------------------------------------------------------------*/
+/* Run the timers until uIP retransmits. */
+static void
+wait_rexmit(void)
+{
+  int i, n;
+
+  for(n = 0; n < 100; n++) {
+    for(i = 0; i < UIP_CONNS; i++) {
+      uip_periodic(i);
+      if(uip_len > 0) {
+        return;
+      }
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Fetch the file with the given MSS, dropping every drop:th data
+   segment if drop is non-zero. */
+static void
+fetch(int mss, int drop)
+{
+  uint8_t opt[4];
+  uint8_t flags;
+  uint32_t last;
+  unsigned long dropped;
+
+  /* A new port for every connection, as the last one is in TIME-WAIT. */
+  client_port++;
+  receivedlen = 0;
+  segments = 0;
+  snd_nxt = CLIENT_ISN;
+  rcv_nxt = 0;
+  dropped = 0;
+
+  opt[0] = TCP_OPT_MSS;
+  opt[1] = TCP_OPT_MSS_LEN;
+  opt[2] = mss >> 8;
+  opt[3] = mss & 0xff;
+  client_send(TCP_SYN, opt, sizeof(opt), NULL, 0);
+  if(!(client_receive() & TCP_SYN)) {
+    fail("no SYN-ACK");
+  }
+  client_send(TCP_ACK | TCP_PSH, NULL, 0, request, sizeof(request) - 1);
+
+  for(;;) {
+    last = rcv_nxt;
+    flags = client_receive();
+    if(drop && segments % drop == 0 && segments != dropped &&
+       rcv_nxt != last && !(flags & TCP_FIN)) {
+      /* Pretend that the segment was lost. */
+      dropped = segments;
+      rcv_nxt = last;
+      receivedlen -= uip_len - UIP_IPTCPH_LEN;
+      segments--;
+      uip_len = 0;
+      wait_rexmit();
+      continue;
+    }
+    if(flags & TCP_FIN) {
+      client_send(TCP_ACK | TCP_FIN, NULL, 0, NULL, 0);
+      break;
+    }
+    if(rcv_nxt == last) {
+      fail("the server stopped sending");
+    }
+    client_send(TCP_ACK, NULL, 0, NULL, 0);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  static const int mss[] = { 48, 128, 536, UIP_TCP_MSS };
+  int rounds;
+  unsigned i;
+  int r;
+  long l;
+  double t;
+
+  rounds = argc > 1 ? atoi(argv[1]) : 100;
+
+  strcpy(filedata, http_header_200);
+  strcat(filedata, http_content_type_binary);
+  hdrlen = strlen(filedata);
+  srand(1);
+  for(l = 0; l < FILE_SIZE; l++) {
+    filedata[hdrlen + l] = rand();
+  }
+  file_init();
+
+  uip_init();
+  httpd_init();
+
+  printf("%ld byte file, %d rounds\n", FILE_SIZE, rounds);
+  printf("%6s %10s %12s %10s\n", "mss", "segments", "ns/segment", "MB/s");
+  for(i = 0; i < sizeof(mss) / sizeof(mss[0]); i++) {
+    verify = 1;
+    fetch(mss[i], DROP_INTERVAL);
+    if(receivedlen != hdrlen + FILE_SIZE ||
+       memcmp(received, filedata, receivedlen) != 0) {
+      fail("the file did not arrive intact");
+    }
+
+    verify = 0;
+    t = now();
+    for(r = 0; r < rounds; r++) {
+      fetch(mss[i], 0);
+    }
+    t = now() - t;
+    printf("%6d %10lu %12.0f %10.1f\n", mss[i], segments,
+           t * 1e9 / rounds / segments,
+           (double)FILE_SIZE * rounds / t / 1e6);
+  }
+#if HTTPD_BENCH_CFS
+  cfs_remove("big.bin");
+#endif /* HTTPD_BENCH_CFS */
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
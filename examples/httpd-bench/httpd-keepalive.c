@@ -0,0 +1,920 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         Persistent connection tests for the web server
+ *
+ *         Runs uIP and apps/webserver/httpd.c on the build host with
+ *         several clients at once, and checks HTTP/1.1 keep-alive,
+ *         pipelined requests, the Accept-Encoding and Connection
+ *         headers, the request queue overflowing, the eviction of the
+ *         connection that has been idle the longest when the pool is
+ *         full, and the idle timeout. Exits with a non-zero status if
+ *         the server does not behave as expected.
+ *
+ *         It then loads a page of an HTML file and four objects over
+ *         HTTP/1.0 and HTTP/1.1, with the headers written by the web
+ *         server and stored by makefsdata -H, and prints the number of
+ *         round trips and packets it took. Each round trip, the
+ *         clients answer everything the server has sent, so the round
+ *         trips are the latency of the page load in units of the
+ *         round-trip time of the link. Built with UIP_CONF_TCP_SNDBUF,
+ *         the server keeps several segments in flight and sends
+ *         pipelined responses back to back; without it, it sends one
+ *         segment per acknowledgement.
+ * \author
+ *         agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "contiki-net.h"
+#include "http-strings.h"
+#include "httpd.h"
+#include "httpd-fs.h"
+#include "httpd-cgi.h"
+
+#define CLIENT_MSS    128
+#define CLIENT_PORT   40000
+#define CLIENT_ISN    1000
+#define CLIENTS       16
+#define MAX_PACKETS   64
+#define MAX_ROUNDS    1000
+#define RESPONSES     8
+
+#define IPBUF  ((struct uip_tcpip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+/* TCP flags and options, as in uip6.c. */
+#define TCP_FIN 0x01
+#define TCP_SYN 0x02
+#define TCP_RST 0x04
+#define TCP_PSH 0x08
+#define TCP_ACK 0x10
+#define TCP_OPT_MSS     2
+#define TCP_OPT_MSS_LEN 4
+
+static const uip_ipaddr_t client_addr =
+  {{ 0xaa, 0xaa, 0, 0, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x02, 0, 0x02, 0x02, 0x02 }};
+static const uip_ipaddr_t server_addr =
+  {{ 0xaa, 0xaa, 0, 0, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x01, 0, 0x01, 0x01, 0x01 }};
+
+/* The files of the page: the HTML file first, then the objects that
+   it refers to. */
+static const struct {
+  const char *name;
+  int len;
+  uint8_t type;
+} files[] = {
+  { "/index.html", 1000, HTTPD_FS_TYPE_HTML },
+  { "/style.css",  400,  HTTPD_FS_TYPE_CSS },
+  { "/logo.png",   600,  HTTPD_FS_TYPE_PNG },
+  { "/a.gif",      300,  HTTPD_FS_TYPE_GIF },
+  { "/b.gif",      300,  HTTPD_FS_TYPE_GIF },
+  { "/404.html",   100,  HTTPD_FS_TYPE_HTML },
+};
+#define FILES   (sizeof(files) / sizeof(files[0]))
+#define OBJECTS 4
+
+/* Each file with the header that makefsdata -H stores in front of
+   it. Without stored headers the web server writes them itself. */
+static char filedata[FILES][1200];
+static int hdrlens[FILES];
+static int stored_headers;
+/* A file that is only stored compressed, as makefsdata -z does. */
+static const char *gzipped;
+
+struct client {
+  uint16_t port;
+  uint32_t snd_nxt, rcv_nxt;
+  char open, fin, rst, closing;
+  /* Requests to send once the connection is open. */
+  char pending[256];
+  /* The responses expected, and where each of them ends. */
+  char expected[4096];
+  int expectedlen;
+  int ends[RESPONSES];
+  int responses;
+  char received[4096];
+  int receivedlen;
+};
+
+static struct client clients[CLIENTS];
+static int nclients;
+static uint16_t client_port = CLIENT_PORT;
+
+/* The packets that the server has sent and the clients have not yet
+   looked at. */
+static uint8_t packets[MAX_PACKETS][UIP_BUFSIZE];
+static uint16_t packetlens[MAX_PACKETS];
+static int packethead, packetcount;
+
+/* Connections that the web server has asked to be polled. */
+static struct uip_conn *polled[UIP_CONNS];
+static int npolled;
+
+static unsigned long server_packets, client_packets;
+static int rounds;
+/*---------------------------------------------------------------------------*/
+/* The rest of the system, as far as the web server needs it. */
+uip_ds6_netif_t uip_ds6_if;
+
+static uip_ds6_addr_t server_ds6_addr;
+
+uip_ds6_addr_t *
+uip_ds6_addr_lookup(uip_ipaddr_t *addr)
+{
+  return uip_ipaddr_cmp(addr, &server_addr) ? &server_ds6_addr : NULL;
+}
+uip_ds6_maddr_t *
+uip_ds6_maddr_lookup(uip_ipaddr_t *addr)
+{
+  return NULL;
+}
+uint8_t
+uip_ds6_is_addr_onlink(uip_ipaddr_t *addr)
+{
+  return 1;
+}
+void
+uip_ds6_select_src(uip_ipaddr_t *src, uip_ipaddr_t *dst)
+{
+  uip_ipaddr_copy(src, &server_addr);
+}
+void uip_ds6_init(void) {}
+void uip_icmp6_error_output(uint8_t type, uint8_t code, uint32_t param) {}
+void uip_icmp6_echo_request_input(void) {}
+void uip_nd6_ns_input(void) {}
+void uip_nd6_na_input(void) {}
+void uip_nd6_rs_input(void) {}
+void uip_nd6_ra_input(void) {}
+void uip_rpl_input(void) {}
+int rpl_srh_input(void) { return 0; }
+void tcpip_icmp6_call(uint8_t type) {}
+void webserver_log(char *msg) {}
+void webserver_log_file(uip_ipaddr_t *requester, char *file) {}
+void httpd_cgi_init(void) {}
+
+httpd_cgifunction
+httpd_cgi(char *name)
+{
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+fail(const char *msg)
+{
+  printf("FAIL: %s\n", msg);
+  exit(1);
+}
+/*---------------------------------------------------------------------------*/
+void
+tcpip_poll_tcp(struct uip_conn *conn)
+{
+  if(npolled == UIP_CONNS) {
+    fail("too many polls");
+  }
+  polled[npolled++] = conn;
+}
+/*---------------------------------------------------------------------------*/
+int
+httpd_fs_open(const char *name, struct httpd_fs_file *file)
+{
+  unsigned i;
+
+  for(i = 0; i < FILES; i++) {
+    if(strcmp(name, files[i].name) == 0) {
+      file->hdrlen = stored_headers ? hdrlens[i] : 0;
+      file->data = &filedata[i][hdrlens[i]];
+      file->len = files[i].len;
+      file->type = files[i].type;
+      file->flags = gzipped != NULL && strcmp(name, gzipped) == 0 ?
+        HTTPD_FS_GZIP : 0;
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+tcp_listen(u16_t port)
+{
+  uip_listen(port);
+}
+
+void
+tcp_attach(struct uip_conn *conn, void *appstate)
+{
+  conn->appstate.state = appstate;
+}
+void
+tcpip_uipcall(void)
+{
+  httpd_appcall(uip_conn->appstate.state);
+}
+/*---------------------------------------------------------------------------*/
+/* Queue the packet that uIP has put in uip_buf for the clients. */
+void
+tcpip_ipv6_output(void)
+{
+  int i;
+
+  if(packetcount == MAX_PACKETS) {
+    fail("too many packets from the server");
+  }
+  i = (packethead + packetcount) % MAX_PACKETS;
+  memcpy(packets[i], uip_buf, uip_len);
+  packetlens[i] = uip_len;
+  packetcount++;
+  server_packets++;
+  uip_len = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Send what uIP has output for the connection, and keep polling it
+   while it has buffered data to send, as tcpip.c does. */
+static void
+server_output(struct uip_conn *conn)
+{
+#if UIP_TCP_SNDBUF
+  int n;
+#endif /* UIP_TCP_SNDBUF */
+
+  if(uip_len > 0) {
+    tcpip_ipv6_output();
+  }
+#if UIP_TCP_SNDBUF
+  for(n = 0; uip_sndbuf_pending(conn); n++) {
+    if(n == MAX_PACKETS) {
+      fail("the send buffer never drains");
+    }
+    uip_poll_conn(conn);
+    if(uip_len > 0) {
+      tcpip_ipv6_output();
+    }
+  }
+#endif /* UIP_TCP_SNDBUF */
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+sum16(uint32_t sum, const uint8_t *data, int len)
+{
+  int i;
+
+  for(i = 0; i + 1 < len; i += 2) {
+    sum += (data[i] << 8) | data[i + 1];
+  }
+  if(len & 1) {
+    sum += data[len - 1] << 8;
+  }
+  while(sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+/* The TCP checksum of the packet in uip_buf, which must be 0xffff
+   when the checksum field is correct. */
+static uint16_t
+tcp_sum(void)
+{
+  int len = uip_len - UIP_IPH_LEN;
+
+  return sum16(len + UIP_PROTO_TCP +
+               sum16(0, IPBUF->srcipaddr.u8, 2 * sizeof(uip_ipaddr_t)),
+               &uip_buf[UIP_LLH_LEN + UIP_IPH_LEN], len);
+}
+/*---------------------------------------------------------------------------*/
+/* Put a segment from the client into uip_buf and let uIP process it. */
+static void
+client_send(struct client *c, uint8_t flags, const uint8_t *opt, int optlen,
+            const void *data, int datalen)
+{
+  struct uip_tcpip_hdr *h = IPBUF;
+  int len = UIP_TCPH_LEN + optlen + datalen;
+
+  memset(h, 0, UIP_IPTCPH_LEN);
+  h->vtc = 0x60;
+  h->len[0] = len >> 8;
+  h->len[1] = len & 0xff;
+  h->proto = UIP_PROTO_TCP;
+  h->ttl = 64;
+  uip_ipaddr_copy(&h->srcipaddr, &client_addr);
+  uip_ipaddr_copy(&h->destipaddr, &server_addr);
+  h->srcport = UIP_HTONS(c->port);
+  h->destport = UIP_HTONS(80);
+  h->seqno[0] = c->snd_nxt >> 24;
+  h->seqno[1] = c->snd_nxt >> 16;
+  h->seqno[2] = c->snd_nxt >> 8;
+  h->seqno[3] = c->snd_nxt;
+  h->ackno[0] = c->rcv_nxt >> 24;
+  h->ackno[1] = c->rcv_nxt >> 16;
+  h->ackno[2] = c->rcv_nxt >> 8;
+  h->ackno[3] = c->rcv_nxt;
+  h->tcpoffset = ((UIP_TCPH_LEN + optlen) / 4) << 4;
+  h->flags = flags;
+  h->wnd[0] = h->wnd[1] = 0xff;
+  memcpy(&uip_buf[UIP_LLH_LEN + UIP_IPTCPH_LEN], opt, optlen);
+  memcpy(&uip_buf[UIP_LLH_LEN + UIP_IPTCPH_LEN + optlen], data, datalen);
+  uip_len = UIP_IPH_LEN + len;
+  h->tcpchksum = ~UIP_HTONS(tcp_sum());
+
+  c->snd_nxt += datalen + ((flags & (TCP_SYN | TCP_FIN)) ? 1 : 0);
+  client_packets++;
+  uip_input();
+  server_output(uip_conn);
+}
+/*---------------------------------------------------------------------------*/
+static const char *
+content_type(int i)
+{
+  switch(files[i].type) {
+  case HTTPD_FS_TYPE_CSS:
+    return http_content_type_css;
+  case HTTPD_FS_TYPE_PNG:
+    return http_content_type_png;
+  case HTTPD_FS_TYPE_GIF:
+    return http_content_type_gif;
+  default:
+    return http_content_type_html;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Add the response that the server is expected to send for a request
+   of the file to what the client expects to receive. */
+static void
+expect(struct client *c, const char *name, int keepalive)
+{
+  unsigned i;
+  int found;
+  char *p;
+
+  for(i = 0; i < FILES - 1 && strcmp(name, files[i].name) != 0; i++);
+  found = i < FILES - 1;
+
+  if(c->responses == RESPONSES) {
+    fail("too many requests on a connection");
+  }
+  p = &c->expected[c->expectedlen];
+  if(stored_headers) {
+    memcpy(p, filedata[i], hdrlens[i]);
+    p[hdrlens[i]] = 0;
+  } else if(keepalive) {
+    strcpy(p, found ? http_header_200_11 : http_header_404_11);
+    sprintf(&p[strlen(p)], "Content-Length: %d\r\n", files[i].len);
+  } else {
+    strcpy(p, found ? http_header_200 : http_header_404);
+  }
+  if(!stored_headers) {
+    strcat(p, content_type(i));
+  }
+  c->expectedlen += strlen(p);
+  memcpy(&c->expected[c->expectedlen], &filedata[i][hdrlens[i]], files[i].len);
+  c->expectedlen += files[i].len;
+  c->ends[c->responses++] = c->expectedlen;
+}
+/*---------------------------------------------------------------------------*/
+/* Request a file, with the request line of the HTTP version and the
+   headers given. The request is sent at once if the connection is
+   open, and otherwise together with the acknowledgement of the
+   SYN-ACK. */
+static void
+request(struct client *c, const char *name, int version11,
+        const char *headers)
+{
+  char *p = &c->pending[strlen(c->pending)];
+
+  sprintf(p, "GET %s HTTP/1.%d\r\nHost: [aaaa::212:7401:1:101]\r\n%s\r\n",
+          name, version11, headers);
+  expect(c, name, version11 && strstr(headers, "close") == NULL);
+}
+/*---------------------------------------------------------------------------*/
+/* Request a compressed file with headers that refuse gzip: the server
+   answers 406 and closes the connection. */
+static void
+request_refused(struct client *c, const char *name, const char *headers)
+{
+  char *p = &c->pending[strlen(c->pending)];
+
+  sprintf(p, "GET %s HTTP/1.1\r\nHost: [aaaa::212:7401:1:101]\r\n%s\r\n",
+          name, headers);
+  p = &c->expected[c->expectedlen];
+  sprintf(p, "%s%s", http_header_406, http_content_type_plain);
+  c->expectedlen += strlen(p);
+  c->ends[c->responses++] = c->expectedlen;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_pending(struct client *c)
+{
+  if(c->open && c->pending[0] != 0) {
+    client_send(c, TCP_ACK | TCP_PSH, NULL, 0, c->pending, strlen(c->pending));
+    c->pending[0] = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct client *
+client_open(void)
+{
+  struct client *c;
+  uint8_t opt[4];
+
+  if(nclients == CLIENTS) {
+    fail("too many clients");
+  }
+  c = &clients[nclients++];
+  memset(c, 0, sizeof(*c));
+  c->port = ++client_port;
+  c->snd_nxt = CLIENT_ISN;
+
+  opt[0] = TCP_OPT_MSS;
+  opt[1] = TCP_OPT_MSS_LEN;
+  opt[2] = CLIENT_MSS >> 8;
+  opt[3] = CLIENT_MSS & 0xff;
+  client_send(c, TCP_SYN, opt, sizeof(opt), NULL, 0);
+  return c;
+}
+/*---------------------------------------------------------------------------*/
+static void
+client_close(struct client *c)
+{
+  if(!c->fin && !c->rst && !c->closing) {
+    c->closing = 1;
+    client_send(c, TCP_ACK | TCP_FIN, NULL, 0, NULL, 0);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* The number of responses that the client has received in full. */
+static int
+client_done(struct client *c)
+{
+  int i;
+
+  for(i = 0; i < c->responses && c->ends[i] <= c->receivedlen; i++);
+  return i;
+}
+/*---------------------------------------------------------------------------*/
+/* Give the next packet from the server to its client, which answers
+   the SYN-ACK with the pending requests, acknowledges data and closes
+   its end of the connection when the server does. */
+static void
+deliver(void)
+{
+  struct uip_tcpip_hdr *h = IPBUF;
+  struct client *c;
+  uint32_t seq;
+  uint8_t flags;
+  int i, datalen;
+
+  uip_len = packetlens[packethead];
+  memcpy(uip_buf, packets[packethead], uip_len);
+  packethead = (packethead + 1) % MAX_PACKETS;
+  packetcount--;
+
+  if(tcp_sum() != 0xffff) {
+    fail("bad TCP checksum");
+  }
+  c = NULL;
+  for(i = 0; i < nclients; i++) {
+    if(UIP_HTONS(h->destport) == clients[i].port) {
+      c = &clients[i];
+    }
+  }
+  if(c == NULL || c->rst) {
+    fail("a packet for a connection that is not open");
+  }
+
+  seq = ((uint32_t)h->seqno[0] << 24) | ((uint32_t)h->seqno[1] << 16) |
+    ((uint32_t)h->seqno[2] << 8) | h->seqno[3];
+  datalen = uip_len - UIP_IPH_LEN - (h->tcpoffset >> 4) * 4;
+  flags = h->flags;
+  if(flags & TCP_RST) {
+    c->rst = 1;
+    uip_len = 0;
+    return;
+  }
+  if(flags & TCP_SYN) {
+    c->rcv_nxt = seq + 1;
+    c->open = 1;
+    if(c->pending[0] != 0) {
+      send_pending(c);
+    } else {
+      client_send(c, TCP_ACK, NULL, 0, NULL, 0);
+    }
+    return;
+  }
+  if(datalen > 0) {
+    if(seq != c->rcv_nxt) {
+      fail("unexpected sequence number");
+    }
+    if(c->receivedlen + datalen > (int)sizeof(c->received)) {
+      fail("too much data");
+    }
+    memcpy(&c->received[c->receivedlen], &uip_buf[uip_len - datalen], datalen);
+    c->receivedlen += datalen;
+    c->rcv_nxt += datalen;
+    if(memcmp(c->received, c->expected, c->receivedlen) != 0) {
+      fail("the response is not the expected one");
+    }
+  }
+  if((flags & TCP_FIN) && !c->fin) {
+    c->fin = 1;
+    c->rcv_nxt++;
+    client_send(c, c->closing ? TCP_ACK : TCP_ACK | TCP_FIN, NULL, 0, NULL, 0);
+    c->closing = 1;
+  } else if(datalen > 0) {
+    client_send(c, TCP_ACK, NULL, 0, NULL, 0);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* One round trip: the clients receive what the server has sent and
+   answer it, and the server then handles the polls that it has asked
+   for, as tcpip.c would do. Returns the number of packets that were
+   delivered. */
+static int
+round_trip(void)
+{
+  int i, n;
+
+  n = packetcount;
+  for(i = 0; i < n; i++) {
+    deliver();
+  }
+  for(i = 0; i < npolled; i++) {
+    uip_poll_conn(polled[i]);
+    server_output(polled[i]);
+  }
+  npolled = 0;
+  rounds++;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+/* Run until the server and the clients have nothing more to send. */
+static void
+settle(void)
+{
+  while(packetcount > 0 || npolled > 0) {
+    if(rounds == MAX_ROUNDS) {
+      fail("the transfer does not end");
+    }
+    round_trip();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Close all clients and check that the server has freed all states. */
+static void
+close_all(void)
+{
+  int i;
+
+  for(i = 0; i < nclients; i++) {
+    client_close(&clients[i]);
+  }
+  settle();
+  if(httpd_stats.conns != 0) {
+    fail("connection states left over");
+  }
+  nclients = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+check_received(struct client *c, int responses, int fin, const char *msg)
+{
+  if(c->rst || c->fin != fin || client_done(c) != responses ||
+     c->receivedlen != c->ends[responses - 1]) {
+    printf("%d of %d responses, %d bytes, fin %d, rst %d\n",
+           client_done(c), c->responses, c->receivedlen, c->fin, c->rst);
+    fail(msg);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct uip_conn *
+server_conn(struct client *c)
+{
+  int i;
+
+  for(i = 0; i < UIP_CONNS; i++) {
+    if(uip_conns[i].tcpstateflags == UIP_ESTABLISHED &&
+       uip_conns[i].rport == UIP_HTONS(c->port)) {
+      return &uip_conns[i];
+    }
+  }
+  fail("no server connection for the client");
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_keepalive(void)
+{
+  struct client *c;
+  uint16_t requests, reused;
+
+  /* HTTP/1.0 requests are answered and the connection is closed. */
+  c = client_open();
+  request(c, "/index.html", 0, "");
+  settle();
+  check_received(c, 1, 1, "HTTP/1.0 response");
+  close_all();
+
+  /* HTTP/1.1 requests, one at a time, on the same connection. */
+  requests = httpd_stats.requests;
+  reused = httpd_stats.reused;
+  c = client_open();
+  request(c, "/index.html", 1, "");
+  settle();
+  check_received(c, 1, 0, "first HTTP/1.1 response");
+  request(c, "/style.css", 1, "");
+  send_pending(c);
+  settle();
+  check_received(c, 2, 0, "second HTTP/1.1 response");
+
+  /* Not found keeps the connection open, as the length is known. */
+  request(c, "/missing.html", 1, "");
+  send_pending(c);
+  settle();
+  check_received(c, 3, 0, "HTTP/1.1 404 response");
+
+  /* Two pipelined requests in one segment. */
+  request(c, "/a.gif", 1, "Accept: */*\r\n");
+  request(c, "/b.gif", 1, "");
+  send_pending(c);
+  settle();
+  check_received(c, 5, 0, "pipelined responses");
+
+  /* The client asks for the connection to be closed. */
+  request(c, "/logo.png", 1, "Connection: close\r\n");
+  send_pending(c);
+  settle();
+  check_received(c, 6, 1, "Connection: close response");
+  if(httpd_stats.requests - requests != 6 ||
+     httpd_stats.reused - reused != 5) {
+    fail("requests are not counted");
+  }
+  close_all();
+  printf("keep-alive, 404, pipelining and Connection: close: ok\n");
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_accept_encoding(void)
+{
+  struct client *c;
+
+  gzipped = "/style.css";
+
+  /* A compressed file is sent unless the client refuses gzip. Header
+     names and values are not case sensitive. */
+  c = client_open();
+  request(c, "/style.css", 1, "");
+  request(c, "/style.css", 1, "accept-encoding: deflate, GZIP;q=0.5\r\n");
+  settle();
+  request(c, "/style.css", 1, "Accept-Encoding: gzip, *;q=0\r\n");
+  request(c, "/style.css", 1, "ACCEPT-ENCODING: br, *\r\n");
+  send_pending(c);
+  settle();
+  check_received(c, 4, 0, "compressed file");
+  request_refused(c, "/style.css", "Accept-Encoding: gzip;q=0\r\n");
+  send_pending(c);
+  settle();
+  check_received(c, 5, 1, "gzip;q=0 is not answered with 406");
+  close_all();
+
+  c = client_open();
+  request_refused(c, "/style.css", "Accept-Encoding: br, *;q=0.000\r\n");
+  settle();
+  check_received(c, 1, 1, "*;q=0 is not answered with 406");
+  close_all();
+
+  /* The connection header. */
+  c = client_open();
+  request(c, "/index.html", 1, "connection: Keep-Alive, close\r\n");
+  settle();
+  check_received(c, 1, 1, "connection: close is not honoured");
+  close_all();
+
+  gzipped = NULL;
+  printf("Accept-Encoding and Connection headers: ok\n");
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_overflow(void)
+{
+  struct client *c;
+  int i;
+
+  /* More requests in a single segment than fit: the first one is
+     taken off the queue as it is answered, which makes room for
+     HTTPD_PIPELINE more. The last one is dropped, and the connection
+     is closed after the others have been answered. */
+  c = client_open();
+  for(i = 0; i <= HTTPD_PIPELINE + 1; i++) {
+    request(c, files[i].name, 1, "");
+  }
+  settle();
+  check_received(c, HTTPD_PIPELINE + 1, 1, "request queue overflow");
+  close_all();
+  printf("request queue overflow: ok\n");
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_eviction(void)
+{
+  struct client *c[CLIENTS];
+  uint16_t evicted, refused;
+  int i;
+
+  /* Fill the pool with idle persistent connections, and use the first
+     one again so that the second is the one idle the longest. */
+  for(i = 0; i < httpd_stats.pool; i++) {
+    c[i] = client_open();
+    request(c[i], "/a.gif", 1, "");
+    settle();
+  }
+  request(c[0], "/b.gif", 1, "");
+  send_pending(c[0]);
+  settle();
+  if(httpd_stats.conns != httpd_stats.pool) {
+    fail("the pool is not full");
+  }
+
+  evicted = httpd_stats.evicted;
+  refused = httpd_stats.refused;
+  c[i] = client_open();
+  request(c[i], "/index.html", 1, "");
+  settle();
+  if(!c[1]->rst) {
+    fail("the connection idle the longest was not aborted");
+  }
+  for(i = 0; i <= httpd_stats.pool; i++) {
+    if(i != 1 && c[i]->rst) {
+      fail("the wrong connection was aborted");
+    }
+  }
+  check_received(c[httpd_stats.pool], 1, 0, "response after eviction");
+  if(httpd_stats.evicted - evicted != 1 || httpd_stats.refused != refused ||
+     httpd_stats.conns != httpd_stats.pool) {
+    fail("eviction is not counted");
+  }
+  close_all();
+  printf("eviction of the connection idle the longest: ok\n");
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_idle_timeout(void)
+{
+  struct uip_conn *conn;
+  struct client *c;
+  int i;
+
+  c = client_open();
+  request(c, "/a.gif", 1, "");
+  settle();
+  conn = server_conn(c);
+  for(i = 1; i <= WEBSERVER_CONF_KEEPALIVE_TIMEOUT; i++) {
+    uip_poll_conn(conn);
+    server_output(conn);
+    if((packetcount > 0) != (i == WEBSERVER_CONF_KEEPALIVE_TIMEOUT)) {
+      fail("the idle connection is not closed when it times out");
+    }
+  }
+  settle();
+  check_received(c, 1, 1, "idle timeout");
+  close_all();
+  printf("idle timeout: ok\n");
+}
+/*---------------------------------------------------------------------------*/
+/* Load the HTML file and then the objects, with the given number of
+   connections at a time and of requests on each. HTTP/1.0 needs a new
+   connection for every request. */
+static void
+page_load(const char *name, int version11, int conns, int depth)
+{
+  struct client *slot[OBJECTS];
+  struct client *c;
+  unsigned long packets;
+  int i, next, done, loaded;
+
+  rounds = 0;
+  server_packets = client_packets = 0;
+
+  c = client_open();
+  request(c, files[0].name, version11, "");
+  while(client_done(c) < 1) {
+    if(round_trip() == 0) {
+      fail("the page load stalls");
+    }
+  }
+
+  for(i = 0; i < conns; i++) {
+    slot[i] = version11 && i == 0 ? c : NULL;
+  }
+  next = 1;
+  for(;;) {
+    loaded = 1;
+    for(i = 0; i < conns; i++) {
+      c = slot[i];
+      done = c == NULL ? 0 : client_done(c);
+      if(c != NULL && done < c->responses) {
+        loaded = 0;
+      }
+      while(next <= OBJECTS && (c == NULL || c->responses - done < depth)) {
+        if(c == NULL || !version11) {
+          c = slot[i] = client_open();
+          done = 0;
+        }
+        request(c, files[next++].name, version11, "");
+        loaded = 0;
+      }
+      if(c != NULL) {
+        send_pending(c);
+      }
+    }
+    if(loaded) {
+      break;
+    }
+    if(round_trip() == 0) {
+      fail("the page load stalls");
+    }
+  }
+
+  packets = server_packets + client_packets;
+  printf("%-28s %6d %8lu\n", name, rounds, packets);
+  close_all();
+}
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+  unsigned i;
+  int j;
+
+  for(i = 0; i < FILES; i++) {
+    /* As makefsdata -H does for files of known length. */
+    hdrlens[i] = sprintf(filedata[i],
+                         "%sServer: Contiki/2.7 http://www.contiki-os.org/\r\n"
+                         "%.*sContent-Length: %d\r\n\r\n",
+                         i == FILES - 1 ? "HTTP/1.1 404 Not found\r\n" :
+                         "HTTP/1.1 200 OK\r\n",
+                         (int)strlen(content_type(i)) - 2, content_type(i),
+                         files[i].len);
+    for(j = 0; j < files[i].len; j++) {
+      filedata[i][hdrlens[i] + j] = 'a' + (i + j) % 26;
+    }
+  }
+
+  uip_init();
+  httpd_init();
+
+  test_keepalive();
+  test_accept_encoding();
+  test_overflow();
+  test_eviction();
+  test_idle_timeout();
+
+  for(stored_headers = 0; stored_headers <= 1; stored_headers++) {
+    printf("\nPage load, %d byte file and %d objects, MSS %d, %s, %s:\n",
+           files[0].len, OBJECTS, CLIENT_MSS,
+           UIP_TCP_SNDBUF ? "send buffer" : "no send buffer",
+           stored_headers ? "stored headers" : "headers written by httpd");
+    printf("%-28s %6s %8s\n", "", "rtts", "packets");
+    page_load("HTTP/1.0", 0, 1, 1);
+    page_load("HTTP/1.0, 2 connections", 0, 2, 1);
+    page_load("HTTP/1.1 keep-alive", 1, 1, 1);
+    page_load("HTTP/1.1 pipelined", 1, 1, HTTPD_PIPELINE);
+    page_load("HTTP/1.1, 2 connections", 1, 2, 1);
+  }
+
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,600 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Segment counts for HTTP and Telnet style transfers
+ *
+ *         Runs uIP on the build host with two protosocket servers:
+ *         the web server, which sends the headers and the file as
+ *         separate writes, and a command shell
+ *         that writes its output one short line at a time, as
+ *         Telnet applications do. A client fetches a page and runs a
+ *         few shell commands, and the number of segments and
+ *         packets the server sent is printed.
+ *
+ *         Built with UIP_CONF_TCP_SNDBUF=0, every write is a segment
+ *         of its own; with the argument "split", each full-sized
+ *         segment is also sent through uip_split_output(). Built with
+ *         the send buffer, small writes are coalesced, and the page is
+ *         fetched once more with the client acknowledging the segments
+ *         in flight only after the server has timed out and sent the
+ *         first one again. Exits with a non-zero status if the client
+ *         does not receive what the servers sent.
+ * \author
+ *         agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "contiki-net.h"
+#include "net/uip-split.h"
+#include "http-strings.h"
+#include "httpd.h"
+#include "httpd-fs.h"
+#include "httpd-cgi.h"
+
+#define PAGE_SIZE     3000
+#define SHELL_PORT    23
+#define SHELL_LINES   10
+#define SHELL_PROMPT  "> "
+#define CLIENT_PORT   40000
+#define CLIENT_ISN    1000
+#define MAX_PACKETS   64
+
+#define IPBUF  ((struct uip_tcpip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+/* TCP flags and options, as in uip6.c. */
+#define TCP_FIN 0x01
+#define TCP_SYN 0x02
+#define TCP_RST 0x04
+#define TCP_PSH 0x08
+#define TCP_ACK 0x10
+#define TCP_OPT_MSS     2
+#define TCP_OPT_MSS_LEN 4
+
+static const uip_ipaddr_t client_addr =
+  {{ 0xaa, 0xaa, 0, 0, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x02, 0, 0x02, 0x02, 0x02 }};
+static const uip_ipaddr_t server_addr =
+  {{ 0xaa, 0xaa, 0, 0, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x01, 0, 0x01, 0x01, 0x01 }};
+
+static const char http_request[] = "GET /index.html HTTP/1.0\r\n\r\n";
+static const char *const shell_commands[] = { "ps\n", "netstat\n", "help\n" };
+#define SHELL_COMMANDS (sizeof(shell_commands) / sizeof(shell_commands[0]))
+
+static char page[PAGE_SIZE];
+
+/* What the client expects to receive. */
+static char expected[8 * 1024];
+static int expectedlen;
+
+/* The packets that the server has sent and the client has not yet
+   looked at. */
+static uint8_t packets[MAX_PACKETS][UIP_BUFSIZE];
+static uint16_t packetlens[MAX_PACKETS];
+static int packethead, packetcount;
+
+static uint8_t received[sizeof(expected)];
+static int receivedlen;
+static uint16_t server_port, client_port = CLIENT_PORT;
+static uint32_t rcv_nxt, snd_nxt;
+static unsigned long data_segments, server_packets, client_packets;
+static int split;
+static unsigned prompts, commands;
+/*---------------------------------------------------------------------------*/
+/* The rest of the system, as far as the servers need it. */
+uip_ds6_netif_t uip_ds6_if;
+
+static uip_ds6_addr_t server_ds6_addr;
+
+uip_ds6_addr_t *
+uip_ds6_addr_lookup(uip_ipaddr_t *addr)
+{
+  return uip_ipaddr_cmp(addr, &server_addr) ? &server_ds6_addr : NULL;
+}
+uip_ds6_maddr_t *
+uip_ds6_maddr_lookup(uip_ipaddr_t *addr)
+{
+  return NULL;
+}
+uint8_t
+uip_ds6_is_addr_onlink(uip_ipaddr_t *addr)
+{
+  return 1;
+}
+void
+uip_ds6_select_src(uip_ipaddr_t *src, uip_ipaddr_t *dst)
+{
+  uip_ipaddr_copy(src, &server_addr);
+}
+void uip_ds6_init(void) {}
+void uip_icmp6_error_output(uint8_t type, uint8_t code, uint32_t param) {}
+void uip_icmp6_echo_request_input(void) {}
+void uip_nd6_ns_input(void) {}
+void uip_nd6_na_input(void) {}
+void uip_nd6_rs_input(void) {}
+void uip_nd6_ra_input(void) {}
+void uip_rpl_input(void) {}
+int rpl_srh_input(void) { return 0; }
+void tcpip_icmp6_call(uint8_t type) {}
+void webserver_log(char *msg) {}
+void webserver_log_file(uip_ipaddr_t *requester, char *file) {}
+void tcpip_poll_tcp(struct uip_conn *conn) {}
+void httpd_cgi_init(void) {}
+
+httpd_cgifunction
+httpd_cgi(char *name)
+{
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+int
+httpd_fs_open(const char *name, struct httpd_fs_file *file)
+{
+  if(strcmp(name, "/index.html") != 0) {
+    return 0;
+  }
+  /* No stored header, so the web server writes it piece by piece. */
+  file->data = page;
+  file->len = PAGE_SIZE;
+  file->type = HTTPD_FS_TYPE_HTML;
+  file->hdrlen = 0;
+  file->flags = 0;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static struct psock shell_ps;
+static char shell_buf[32];
+static char shell_line[40];
+static int shell_i;
+
+static
+PT_THREAD(shell_thread(struct psock *p))
+{
+  PSOCK_BEGIN(p);
+
+  PSOCK_SEND_STR(p, "Contiki command shell\r\n");
+  for(;;) {
+    PSOCK_SEND_STR(p, SHELL_PROMPT);
+    PSOCK_READTO(p, '\n');
+    if(strncmp(shell_buf, "exit", 4) == 0) {
+      break;
+    }
+    for(shell_i = 0; shell_i < SHELL_LINES; shell_i++) {
+      sprintf(shell_line, "%d: %.*s\r\n", shell_i,
+              (int)PSOCK_DATALEN(p) - 1, shell_buf);
+      PSOCK_SEND_STR(p, shell_line);
+    }
+  }
+  PSOCK_CLOSE(p);
+
+  PSOCK_END(p);
+}
+/*---------------------------------------------------------------------------*/
+void
+tcp_listen(u16_t port)
+{
+  uip_listen(port);
+}
+
+void
+tcp_attach(struct uip_conn *conn, void *appstate)
+{
+  conn->appstate.state = appstate;
+}
+void
+tcpip_uipcall(void)
+{
+  if(uip_conn->lport == UIP_HTONS(SHELL_PORT)) {
+    if(uip_connected()) {
+      PSOCK_INIT(&shell_ps, (uint8_t *)shell_buf, sizeof(shell_buf));
+    }
+    if(!(uip_closed() || uip_aborted() || uip_timedout())) {
+      shell_thread(&shell_ps);
+    }
+  } else {
+    httpd_appcall(uip_conn->appstate.state);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+fail(const char *msg)
+{
+  printf("FAIL: %s (%d bytes received)\n", msg, receivedlen);
+  exit(1);
+}
+/*---------------------------------------------------------------------------*/
+/* Queue the packet that uIP has put in uip_buf for the client. */
+void
+tcpip_ipv6_output(void)
+{
+  int i;
+
+  if(packetcount == MAX_PACKETS) {
+    fail("too many packets from the server");
+  }
+  i = (packethead + packetcount) % MAX_PACKETS;
+  memcpy(packets[i], uip_buf, uip_len);
+  packetlens[i] = uip_len;
+  packetcount++;
+  server_packets++;
+  uip_len = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Send what uIP has output, and keep polling the connection while it
+   has buffered data to send, as tcpip.c does. */
+static void
+server_output(void)
+{
+#if UIP_TCP_SNDBUF
+  struct uip_conn *conn = uip_conn;
+  int n;
+#endif /* UIP_TCP_SNDBUF */
+
+  if(uip_len > 0) {
+#if !UIP_TCP_SNDBUF
+    if(split) {
+      uip_split_output();
+      return;
+    }
+#endif /* !UIP_TCP_SNDBUF */
+    tcpip_ipv6_output();
+  }
+#if UIP_TCP_SNDBUF
+  for(n = 0; conn != NULL && uip_sndbuf_pending(conn); n++) {
+    if(n == MAX_PACKETS) {
+      fail("the send buffer never drains");
+    }
+    uip_poll_conn(conn);
+    if(uip_len > 0) {
+      tcpip_ipv6_output();
+    }
+  }
+#endif /* UIP_TCP_SNDBUF */
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+sum16(uint32_t sum, const uint8_t *data, int len)
+{
+  int i;
+
+  for(i = 0; i + 1 < len; i += 2) {
+    sum += (data[i] << 8) | data[i + 1];
+  }
+  if(len & 1) {
+    sum += data[len - 1] << 8;
+  }
+  while(sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return sum;
+}
+/*---------------------------------------------------------------------------*/
+/* The TCP checksum of the packet in uip_buf, which must be 0xffff
+   when the checksum field is correct. */
+static uint16_t
+tcp_sum(void)
+{
+  int len = uip_len - UIP_IPH_LEN;
+
+  return sum16(len + UIP_PROTO_TCP +
+               sum16(0, IPBUF->srcipaddr.u8, 2 * sizeof(uip_ipaddr_t)),
+               &uip_buf[UIP_LLH_LEN + UIP_IPH_LEN], len);
+}
+/*---------------------------------------------------------------------------*/
+/* Put a segment from the client into uip_buf and let uIP process it. */
+static void
+client_send(uint8_t flags, const uint8_t *opt, int optlen,
+            const void *data, int datalen)
+{
+  struct uip_tcpip_hdr *h = IPBUF;
+  int len = UIP_TCPH_LEN + optlen + datalen;
+
+  memset(h, 0, UIP_IPTCPH_LEN);
+  h->vtc = 0x60;
+  h->len[0] = len >> 8;
+  h->len[1] = len & 0xff;
+  h->proto = UIP_PROTO_TCP;
+  h->ttl = 64;
+  uip_ipaddr_copy(&h->srcipaddr, &client_addr);
+  uip_ipaddr_copy(&h->destipaddr, &server_addr);
+  h->srcport = UIP_HTONS(client_port);
+  h->destport = UIP_HTONS(server_port);
+  h->seqno[0] = snd_nxt >> 24;
+  h->seqno[1] = snd_nxt >> 16;
+  h->seqno[2] = snd_nxt >> 8;
+  h->seqno[3] = snd_nxt;
+  h->ackno[0] = rcv_nxt >> 24;
+  h->ackno[1] = rcv_nxt >> 16;
+  h->ackno[2] = rcv_nxt >> 8;
+  h->ackno[3] = rcv_nxt;
+  h->tcpoffset = ((UIP_TCPH_LEN + optlen) / 4) << 4;
+  h->flags = flags;
+  h->wnd[0] = h->wnd[1] = 0xff;
+  memcpy(&uip_buf[UIP_LLH_LEN + UIP_IPTCPH_LEN], opt, optlen);
+  memcpy(&uip_buf[UIP_LLH_LEN + UIP_IPTCPH_LEN + optlen], data, datalen);
+  uip_len = UIP_IPH_LEN + len;
+  h->tcpchksum = ~UIP_HTONS(tcp_sum());
+
+  snd_nxt += datalen + ((flags & (TCP_SYN | TCP_FIN)) ? 1 : 0);
+  client_packets++;
+  uip_input();
+  server_output();
+}
+/*---------------------------------------------------------------------------*/
+/* Take the next packet that the server has sent. Returns its TCP
+   flags, and whether it had data in *datalen. */
+static uint8_t
+client_receive(int *datalen)
+{
+  struct uip_tcpip_hdr *h = IPBUF;
+  uint32_t seq;
+
+  if(packetcount == 0) {
+    fail("no packet from the server");
+  }
+  uip_len = packetlens[packethead];
+  memcpy(uip_buf, packets[packethead], uip_len);
+  packethead = (packethead + 1) % MAX_PACKETS;
+  packetcount--;
+
+  seq = ((uint32_t)h->seqno[0] << 24) | ((uint32_t)h->seqno[1] << 16) |
+    ((uint32_t)h->seqno[2] << 8) | h->seqno[3];
+  *datalen = uip_len - UIP_IPH_LEN - (h->tcpoffset >> 4) * 4;
+  if(tcp_sum() != 0xffff) {
+    fail("bad TCP checksum");
+  }
+  if(h->flags & TCP_RST) {
+    fail("the connection was reset");
+  }
+  if(h->flags & TCP_SYN) {
+    rcv_nxt = seq + 1;
+  } else if(*datalen > 0) {
+    if(seq != rcv_nxt) {
+      fail("unexpected sequence number");
+    }
+    if(receivedlen + *datalen > (int)sizeof(received)) {
+      fail("too much data");
+    }
+    memcpy(&received[receivedlen], &uip_buf[uip_len - *datalen], *datalen);
+    receivedlen += *datalen;
+    rcv_nxt += *datalen;
+    data_segments++;
+  }
+  if(h->flags & TCP_FIN) {
+    rcv_nxt++;
+  }
+  uip_len = 0;
+  return h->flags;
+}
+/*---------------------------------------------------------------------------*/
+#if UIP_TCP_SNDBUF
+/* Acknowledge the first segment, which tells the server the window
+   and lets it send several. Then take the segments in flight without
+   acknowledging them, and run the
+   timers until the server sends the first one again. That copy is
+   dropped, as the client already has it, and everything is then
+   acknowledged at once. The server must go on from there instead of
+   sending the other segments again. */
+static void
+late_ack(void)
+{
+  struct uip_tcpip_hdr *h;
+  uint32_t first;
+  int datalen, segs, i, n;
+
+  client_receive(&datalen);
+  client_send(TCP_ACK, NULL, 0, NULL, 0);
+  first = rcv_nxt;
+  for(segs = 0; packetcount > 0;) {
+    client_receive(&datalen);
+    if(datalen > 0) {
+      segs++;
+    }
+  }
+  if(segs < 2) {
+    fail("fewer than two segments in flight");
+  }
+
+  for(n = 0; packetcount == 0; n++) {
+    if(n == 100) {
+      fail("no retransmission");
+    }
+    for(i = 0; i < UIP_CONNS && packetcount == 0; i++) {
+      uip_periodic(i);
+      if(uip_len > 0) {
+        tcpip_ipv6_output();
+      }
+    }
+  }
+  h = (struct uip_tcpip_hdr *)&packets[packethead][UIP_LLH_LEN];
+  if(packetcount != 1 ||
+     (((uint32_t)h->seqno[0] << 24) | ((uint32_t)h->seqno[1] << 16) |
+      ((uint32_t)h->seqno[2] << 8) | h->seqno[3]) != first) {
+    fail("the retransmission is not the first segment");
+  }
+  packethead = (packethead + 1) % MAX_PACKETS;
+  packetcount--;
+
+  client_send(TCP_ACK, NULL, 0, NULL, 0);
+}
+#endif /* UIP_TCP_SNDBUF */
+/*---------------------------------------------------------------------------*/
+/* Whether the shell has printed a prompt that the client has not yet
+   answered. */
+static int
+shell_prompted(void)
+{
+  int len = strlen(SHELL_PROMPT);
+
+  if(server_port != SHELL_PORT || receivedlen < len ||
+     memcmp(&received[receivedlen - len], SHELL_PROMPT, len) != 0) {
+    return 0;
+  }
+  return ++prompts > commands;
+}
+/*---------------------------------------------------------------------------*/
+/* Connect to the port, send the first request, and then acknowledge
+   everything the server sends, answering each shell prompt with the
+   next command. The client acknowledges every segment, or with
+   late set, first lets the server time out as late_ack() does. The
+   connection is closed by the server. */
+static void
+transfer(uint16_t port, const char *request, int late)
+{
+  uint8_t opt[4];
+  uint8_t flags;
+  const char *cmd;
+  int datalen;
+
+  client_port++;
+  server_port = port;
+  snd_nxt = CLIENT_ISN;
+  rcv_nxt = 0;
+  receivedlen = 0;
+  prompts = commands = 0;
+  packethead = packetcount = 0;
+  data_segments = server_packets = client_packets = 0;
+
+  opt[0] = TCP_OPT_MSS;
+  opt[1] = TCP_OPT_MSS_LEN;
+  opt[2] = UIP_TCP_MSS >> 8;
+  opt[3] = UIP_TCP_MSS & 0xff;
+  client_send(TCP_SYN, opt, sizeof(opt), NULL, 0);
+  if(!(client_receive(&datalen) & TCP_SYN)) {
+    fail("no SYN-ACK");
+  }
+  if(request != NULL) {
+    client_send(TCP_ACK | TCP_PSH, NULL, 0, request, strlen(request));
+  } else {
+    client_send(TCP_ACK, NULL, 0, NULL, 0);
+  }
+#if UIP_TCP_SNDBUF
+  if(late) {
+    late_ack();
+  }
+#endif /* UIP_TCP_SNDBUF */
+
+  for(;;) {
+    flags = client_receive(&datalen);
+    if(flags & TCP_FIN) {
+      client_send(TCP_ACK | TCP_FIN, NULL, 0, NULL, 0);
+      break;
+    }
+    if(datalen > 0 && shell_prompted()) {
+      cmd = commands < SHELL_COMMANDS ? shell_commands[commands] : "exit\n";
+      commands++;
+      client_send(TCP_ACK | TCP_PSH, NULL, 0, cmd, strlen(cmd));
+    } else if(datalen > 0) {
+      client_send(TCP_ACK, NULL, 0, NULL, 0);
+    }
+  }
+  while(packetcount > 0) {
+    client_receive(&datalen);
+  }
+
+  if(receivedlen != expectedlen ||
+     memcmp(received, expected, receivedlen) != 0) {
+    fail("the transfer did not arrive intact");
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+expect_page(void)
+{
+  strcpy(expected, http_header_200);
+  strcat(expected, http_content_type_html);
+  expectedlen = strlen(expected);
+  memcpy(&expected[expectedlen], page, PAGE_SIZE);
+  expectedlen += PAGE_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(const char *name)
+{
+  printf("%-8s %8d %10lu %10lu %10lu\n", name, receivedlen,
+         data_segments, server_packets, client_packets);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  unsigned i;
+  int j;
+
+  split = argc > 1 && strcmp(argv[1], "split") == 0;
+
+  for(j = 0; j < PAGE_SIZE; j++) {
+    page[j] = 'a' + j % 26;
+  }
+
+  uip_init();
+  httpd_init();
+  uip_listen(UIP_HTONS(SHELL_PORT));
+
+#if UIP_TCP_SNDBUF
+  printf("With the TCP send buffer:\n");
+#else /* UIP_TCP_SNDBUF */
+  printf("Without the TCP send buffer%s:\n",
+         split ? ", with uip_split_output()" : "");
+#endif /* UIP_TCP_SNDBUF */
+  printf("%-8s %8s %10s %10s %10s\n",
+         "transfer", "bytes", "segments", "packets", "client");
+
+  expect_page();
+  transfer(80, http_request, 0);
+  report("http");
+
+  strcpy(expected, "Contiki command shell\r\n" SHELL_PROMPT);
+  for(i = 0; i < SHELL_COMMANDS; i++) {
+    for(j = 0; j < SHELL_LINES; j++) {
+      sprintf(&expected[strlen(expected)], "%d: %.*s\r\n", j,
+              (int)strlen(shell_commands[i]) - 1, shell_commands[i]);
+    }
+    strcat(expected, SHELL_PROMPT);
+  }
+  expectedlen = strlen(expected);
+  transfer(SHELL_PORT, NULL, 0);
+  report("telnet");
+
+#if UIP_TCP_SNDBUF
+  expect_page();
+  transfer(80, http_request, 1);
+  printf("late ACK after a retransmission timeout: ok\n");
+#endif /* UIP_TCP_SNDBUF */
+
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
@@ -74,7 +74,7 @@ collect_common_net_print(void)
   dag = rpl_get_any_dag();
   if(dag->preferred_parent != NULL) {
     PRINTF("Preferred parent: ");
-    PRINT6ADDR(rpl_get_parent_ipaddr(dag->preferred_parent));
+    PRINTLLADDR((uip_lladdr_t *)rpl_get_parent_lladdr(dag->preferred_parent));
     PRINTF("\n");
   }
   for(r = uip_ds6_route_head();
@@ -132,7 +132,8 @@ collect_common_send(void)
     preferred_parent = dag->preferred_parent;
     if(preferred_parent != NULL) {
       uip_ds6_nbr_t *nbr;
-      nbr = uip_ds6_nbr_lookup(rpl_get_parent_ipaddr(preferred_parent));
+      uip_ipaddr_t addr;
+      nbr = uip_ds6_nbr_lookup(rpl_get_parent_ipaddr(preferred_parent, &addr));
       if(nbr != NULL) {
         /* Use parts of the IPv6 address as the parent address, in reversed byte order. */
         parent.u8[RIMEADDR_SIZE - 1] = nbr->ipaddr.u8[sizeof(uip_ipaddr_t) - 2];
@@ -141,7 +142,7 @@ collect_common_send(void)
       }
     }
     rtmetric = dag->rank;
-    beacon_interval = (uint16_t) ((2L << dag->instance->dio_intcurrent) / 1000);
+    beacon_interval = (uint16_t) ((2L * dag->dio_timer.i_cur) / CLOCK_SECOND);
     num_neighbors = RPL_PARENT_COUNT(dag);
   } else {
     rtmetric = 0;
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         CoAP resource for reading and tuning the rule base of the
+ *         fuzzy objective function.
+ *
+ *         GET returns the binary representation described in
+ *         fuzzify.h, block-wise if needed. PUT replaces the records it
+ *         carries; every PUT must hold whole records and is applied
+ *         only if all of them are valid. DELETE restores the
+ *         compiled-in rules.
+ * \author
+ *         agent <agent@local>
+ */
+
+#include "contiki.h"
+#include "erbium.h"
+#include "net/rplfuzzy/rpl.h"
+#include "net/rplfuzzy/fuzzify.h"
+
+RESOURCE(fuzzy, METHOD_GET | METHOD_PUT | METHOD_DELETE, "rpl/fuzzy",
+         "title=\"Fuzzy OF rule base\";ct=42");
+
+/*---------------------------------------------------------------------------*/
+void
+fuzzy_handler(void *request, void *response, uint8_t *buffer,
+              uint16_t preferred_size, int32_t *offset)
+{
+  const uint8_t *payload;
+  uint16_t size;
+  uint16_t len;
+
+  switch(REST.get_method_type(request)) {
+  case METHOD_GET:
+    size = fuzzy_rules_size();
+    if(*offset >= size) {
+      REST.set_response_status(response, REST.status.BAD_OPTION);
+      return;
+    }
+    len = fuzzy_rules_read(buffer, *offset, preferred_size);
+    REST.set_header_content_type(response,
+                                 REST.type.APPLICATION_OCTET_STREAM);
+    REST.set_response_payload(response, buffer, len);
+    *offset += len;
+    if(*offset >= size) {
+      *offset = -1;
+    }
+    break;
+  case METHOD_PUT:
+    len = REST.get_request_payload(request, &payload);
+    if(len > 0 && rpl_of_fuzzy_update_rules(payload, len)) {
+      REST.set_response_status(response, REST.status.CHANGED);
+    } else {
+      REST.set_response_status(response, REST.status.BAD_REQUEST);
+    }
+    break;
+  case METHOD_DELETE:
+    rpl_of_fuzzy_reset_rules();
+    REST.set_response_status(response, REST.status.DELETED);
+    break;
+  default:
+    REST.set_response_status(response, REST.status.METHOD_NOT_ALLOWED);
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
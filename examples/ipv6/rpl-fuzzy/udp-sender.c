@@ -44,6 +44,11 @@
 #include "collect-common.h"
 #include "collect-view.h"
 
+#if WITH_COAP
+#include "erbium.h"
+extern resource_t resource_fuzzy;
+#endif /* WITH_COAP */
+
 #include <stdio.h>
 #include <string.h>
 
@@ -144,7 +149,7 @@ collect_common_send(void)
       }
     }
     rtmetric = dag->rank;
-    beacon_interval = (uint16_t) ((2L << dag->dio_intcurrent) / 1000);
+    beacon_interval = (uint16_t) ((2L * dag->dio_timer.i_cur) / CLOCK_SECOND);
     num_neighbors = RPL_PARENT_COUNT(dag);
   } else {
     rtmetric = 0;
@@ -228,6 +233,11 @@ PROCESS_THREAD(udp_client_process, ev, data)
 
   energest_init();
 
+#if WITH_COAP
+  rest_init_engine();
+  rest_activate_resource(&resource_fuzzy);
+#endif /* WITH_COAP */
+
   /* new connection with remote host */
   client_conn = udp_new(NULL, UIP_HTONS(UDP_SERVER_PORT), NULL);
   udp_bind(client_conn, UIP_HTONS(UDP_CLIENT_PORT));
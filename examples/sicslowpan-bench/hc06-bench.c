@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Benchmark and round-trip checker for 6lowpan HC06 compression
+ *
+ *         Compresses and uncompresses a corpus of typical IPv6, UDP,
+ *         ICMPv6 and TCP headers, checks that each packet comes back
+ *         unchanged and reports the time per packet in nanoseconds.
+ *         Exits with a non-zero status if any packet fails the round
+ *         trip.
+ * \author
+ *         agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hc06-harness.h"
+#include "net/uip.h"
+#include "net/sicslowpan.h"
+
+#define ITERATIONS 200000
+
+static const rimeaddr_t node_a = {{0x00, 0x12, 0x74, 0x01, 0x00, 0x01, 0x01, 0x01}};
+static const rimeaddr_t node_b = {{0x00, 0x12, 0x74, 0x02, 0x00, 0x02, 0x02, 0x02}};
+
+#define LL_A  0xfe, 0x80, 0, 0, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x01, 0x00, 0x01, 0x01, 0x01
+#define LL_B  0xfe, 0x80, 0, 0, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x02, 0x00, 0x02, 0x02, 0x02
+#define CTX0_A 0xaa, 0xaa, 0, 0, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x01, 0x00, 0x01, 0x01, 0x01
+#define CTX0_B 0xaa, 0xaa, 0, 0, 0, 0, 0, 0, 0x02, 0x12, 0x74, 0x02, 0x00, 0x02, 0x02, 0x02
+#define CTX0_16 0xaa, 0xaa, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xfe, 0, 0x12, 0x34
+#define CTX1_B 0xbb, 0xbb, 0, 0, 0, 0, 0, 1, 0x02, 0x12, 0x74, 0x02, 0x00, 0x02, 0x02, 0x02
+#define CTX7_X 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 7, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88
+#define GLOBAL 0x20, 0x01, 0x0d, 0xb8, 0xff, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01
+#define ALLNODES 0xff, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01
+#define RPLNODES 0xff, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x1a
+#define SOLICITED 0xff, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0xff, 0x02, 0x02, 0x02
+#define MDNS 0xff, 0x05, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xfb
+
+/* IPv6 header: version/tc/flow, payload length, next header, hops. */
+#define IP(len, proto, hops) 0x60, 0, 0, 0, 0, (len), (proto), (hops)
+#define UDP(sport, dport, len) \
+  (sport) >> 8, (sport) & 0xff, (dport) >> 8, (dport) & 0xff, 0, (len), 0x5a, 0xa5
+
+struct sample {
+  const char *name;
+  uint8_t data[80];
+  uint16_t len;
+  const rimeaddr_t *src, *dest;
+};
+
+static const struct sample corpus[] = {
+  { "udp link-local coap",
+    { IP(12, UIP_PROTO_UDP, 64), LL_A, LL_B, UDP(5683, 5683, 12),
+      0x40, 0x01, 0x12, 0x34 }, 52, &node_a, &node_b },
+  { "udp ctx0 4-bit ports",
+    { IP(10, UIP_PROTO_UDP, 64), CTX0_A, CTX0_B, UDP(0xf0b1, 0xf0b2, 10),
+      0xde, 0xad }, 50, &node_a, &node_b },
+  { "udp ctx0 16-bit iid",
+    { IP(8, UIP_PROTO_UDP, 63), CTX0_A, CTX0_16, UDP(1234, 0xf012, 8) },
+    48, &node_a, &node_b },
+  { "udp ctx0 -> ctx1",
+    { IP(8, UIP_PROTO_UDP, 64), CTX0_A, CTX1_B, UDP(8765, 5678, 8) },
+    48, &node_a, &node_b },
+  { "udp ctx7 inline iid",
+    { IP(8, UIP_PROTO_UDP, 64), CTX0_A, CTX7_X, UDP(8765, 5678, 8) },
+    48, &node_a, &node_b },
+  { "udp tc and flow label",
+    { 0x6b, 0x81, 0x23, 0x45, 0, 8, UIP_PROTO_UDP, 17, CTX0_A, CTX0_B,
+      UDP(5683, 5683, 8) }, 48, &node_a, &node_b },
+  { "udp global no context",
+    { IP(8, UIP_PROTO_UDP, 64), CTX0_A, GLOBAL, UDP(5683, 5683, 8) },
+    48, &node_a, &node_b },
+  { "udp mdns ff05::fb",
+    { IP(8, UIP_PROTO_UDP, 255), LL_A, MDNS, UDP(5353, 5353, 8) },
+    48, &node_a, &rimeaddr_null },
+  { "icmp rpl dio",
+    { IP(8, UIP_PROTO_ICMP6, 255), LL_A, RPLNODES,
+      155, 0x01, 0x12, 0x34, 0x1e, 0xf0, 0x01, 0x00 },
+    48, &node_a, &rimeaddr_null },
+  { "icmp ns solicited-node",
+    { IP(24, UIP_PROTO_ICMP6, 255), LL_A, SOLICITED,
+      135, 0, 0x12, 0x34, 0, 0, 0, 0, CTX0_B },
+    64, &node_a, &rimeaddr_null },
+  { "icmp echo all-nodes",
+    { IP(8, UIP_PROTO_ICMP6, 64), CTX0_A, ALLNODES,
+      128, 0, 0x12, 0x34, 0, 1, 0, 1 },
+    48, &node_a, &rimeaddr_null },
+  { "udp rpl source route",
+    { IP(32, UIP_PROTO_ROUTING, 64), CTX0_A, CTX0_B,
+      UIP_PROTO_UDP, 2, 3, 2, 0x88, 0x00, 0, 0,
+      0x02, 0x12, 0x74, 0x03, 0x00, 0x03, 0x03, 0x03,
+      0x02, 0x12, 0x74, 0x04, 0x00, 0x04, 0x04, 0x04,
+      UDP(5683, 5683, 8) },
+    72, &node_a, &node_b },
+  { "tcp ctx0",
+    { IP(20, UIP_PROTO_TCP, 64), CTX0_A, CTX0_B,
+      0x1f, 0x90, 0xc0, 0x01, 0, 0, 0, 1, 0, 0, 0, 2, 0x50, 0x10,
+      0x01, 0x00, 0x12, 0x34, 0, 0 },
+    60, &node_a, &node_b },
+};
+
+#define CORPUS_SIZE (sizeof(corpus) / sizeof(corpus[0]))
+
+static const uint8_t prefix_ctx1[] = { 0xbb, 0xbb, 0, 0, 0, 0, 0, 1 };
+static const uint8_t prefix_ctx7[] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 7 };
+/*---------------------------------------------------------------------------*/
+static double
+now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+static void
+dump(const char *what, const uint8_t *data, uint16_t len)
+{
+  uint16_t i;
+
+  printf("  %s:", what);
+  for(i = 0; i < len; i++) {
+    printf(" %02x", data[i]);
+  }
+  printf("\n");
+}
+/*---------------------------------------------------------------------------*/
+static int
+roundtrip(const struct sample *s, uint8_t *frame, uint16_t *framelen)
+{
+  uint8_t ip[UIP_BUFSIZE];
+  uint16_t len;
+
+  if(hc06_compress(s->data, s->len, s->src, s->dest, frame, framelen) == 0) {
+    printf("%s: compression failed\n", s->name);
+    return 0;
+  }
+  if(!hc06_uncompress(frame, *framelen, s->src, s->dest, ip, &len)) {
+    printf("%s: uncompression failed\n", s->name);
+    dump("frame", frame, *framelen);
+    return 0;
+  }
+  if(len != s->len || memcmp(ip, s->data, len) != 0) {
+    printf("%s: round trip mismatch\n", s->name);
+    dump("in   ", s->data, s->len);
+    dump("frame", frame, *framelen);
+    dump("out  ", ip, len);
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  const struct sample *s;
+  uint8_t frame[HC06_MAX_FRAME];
+  uint8_t ip[UIP_BUFSIZE];
+  uint16_t framelen, len;
+  long i, iterations;
+  double t0, tc, tu;
+  int failed;
+
+  iterations = argc > 1 ? atol(argv[1]) : ITERATIONS;
+
+  hc06_init();
+  sicslowpan_context_set(1, prefix_ctx1);
+  sicslowpan_context_set(7, prefix_ctx7);
+
+  failed = 0;
+  printf("%-24s %5s %5s %10s %10s\n", "packet", "ip", "frame",
+         "comp ns", "uncomp ns");
+  for(s = corpus; s < &corpus[CORPUS_SIZE]; s++) {
+    if(!roundtrip(s, frame, &framelen)) {
+      failed++;
+      continue;
+    }
+
+    t0 = now_ns();
+    for(i = 0; i < iterations; i++) {
+      hc06_compress(s->data, s->len, s->src, s->dest, frame, &framelen);
+    }
+    tc = (now_ns() - t0) / iterations;
+
+    t0 = now_ns();
+    for(i = 0; i < iterations; i++) {
+      hc06_uncompress(frame, framelen, s->src, s->dest, ip, &len);
+    }
+    tu = (now_ns() - t0) / iterations;
+
+    printf("%-24s %5u %5u %10.1f %10.1f\n", s->name, s->len, framelen,
+           tc, tu);
+  }
+
+  if(failed) {
+    printf("%d of %d packets failed the round trip\n", failed,
+           (int)CORPUS_SIZE);
+    return 1;
+  }
+  printf("all %d packets passed the round trip\n", (int)CORPUS_SIZE);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
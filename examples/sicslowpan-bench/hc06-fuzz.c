@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         libFuzzer entry point for 6lowpan HC06 uncompression
+ *
+ *         Each input is a 6lowpan frame preceded by one byte that
+ *         picks the link-layer source and destination. The frame is
+ *         uncompressed; if that works, the resulting IPv6 packet is
+ *         compressed and uncompressed again and must come back
+ *         unchanged.
+ *
+ *         Build with clang -fsanitize=fuzzer (make hc06-fuzz). Built
+ *         without libFuzzer (make hc06-fuzz-standalone), the program
+ *         runs the files named on the command line, or random frames
+ *         if there are none.
+ * \author
+ *         agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hc06-harness.h"
+#include "net/uip.h"
+#include "net/sicslowpan.h"
+
+static const rimeaddr_t lladdrs[] = {
+  {{0x00, 0x12, 0x74, 0x01, 0x00, 0x01, 0x01, 0x01}},
+  {{0x00, 0x12, 0x74, 0x02, 0x00, 0x02, 0x02, 0x02}},
+  {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+  {{0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff}},
+};
+
+static const uint8_t prefix_ctx1[] = { 0xbb, 0xbb, 0, 0, 0, 0, 0, 1 };
+
+static int initialized;
+/*---------------------------------------------------------------------------*/
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  const rimeaddr_t *src, *dest;
+  uint8_t ip[UIP_BUFSIZE], ip2[UIP_BUFSIZE];
+  uint8_t frame[HC06_MAX_FRAME];
+  uint16_t len, len2, framelen;
+  uint16_t udp, ulen;
+
+  if(!initialized) {
+    hc06_init();
+    sicslowpan_context_set(1, prefix_ctx1);
+    initialized = 1;
+  }
+
+  if(size < 3 || size > HC06_MAX_FRAME + 1) {
+    return 0;
+  }
+  src = &lladdrs[data[0] & 3];
+  dest = &lladdrs[(data[0] >> 2) & 3];
+
+  memset(ip, 0, sizeof(ip));
+  if(!hc06_uncompress(data + 1, size - 1, src, dest, ip, &len)) {
+    return 0;
+  }
+
+  /* HC06 always elides the UDP length and derives it from the IP
+     length, so a frame with an inline UDP header carrying some other
+     length cannot survive the round trip. The same goes for a UDP
+     header behind a routing header. */
+  udp = 0;
+  if(ip[6] == UIP_PROTO_UDP) {
+    udp = UIP_IPH_LEN;
+  } else if(ip[6] == UIP_PROTO_ROUTING && len >= UIP_IPH_LEN + 2 &&
+            ip[UIP_IPH_LEN] == UIP_PROTO_UDP) {
+    udp = UIP_IPH_LEN + (ip[UIP_IPH_LEN + 1] << 3) + 8;
+  }
+  if(udp != 0 && len >= udp + UIP_UDPH_LEN) {
+    ulen = ((ip[4] << 8) | ip[5]) - (udp - UIP_IPH_LEN);
+    ip[udp + 4] = ulen >> 8;
+    ip[udp + 5] = ulen & 0xff;
+  }
+
+  if(hc06_compress(ip, len, src, dest, frame, &framelen) == 0) {
+    /* Did not fit in a frame, e.g. an inline address that we would
+       have compressed differently. */
+    return 0;
+  }
+  memset(ip2, 0, sizeof(ip2));
+  if(!hc06_uncompress(frame, framelen, src, dest, ip2, &len2) ||
+     len2 != len || memcmp(ip, ip2, len) != 0) {
+    fprintf(stderr, "hc06-fuzz: packet did not survive a round trip\n");
+    abort();
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+#ifndef HC06_FUZZ_LIBFUZZER
+int
+main(int argc, char **argv)
+{
+  uint8_t buf[HC06_MAX_FRAME + 1];
+  size_t len;
+  long i;
+  int j;
+  FILE *f;
+
+  if(argc > 1) {
+    for(j = 1; j < argc; j++) {
+      f = fopen(argv[j], "rb");
+      if(f == NULL) {
+        perror(argv[j]);
+        return 1;
+      }
+      len = fread(buf, 1, sizeof(buf), f);
+      fclose(f);
+      LLVMFuzzerTestOneInput(buf, len);
+    }
+    return 0;
+  }
+
+  srandom(1);
+  for(i = 0; i < 1000000; i++) {
+    len = 3 + random() % (sizeof(buf) - 2);
+    for(j = 0; j < len; j++) {
+      buf[j] = random();
+    }
+    /* Give most inputs an IPHC dispatch. */
+    buf[1] = 0x60 | (buf[1] & 0x1f);
+    LLVMFuzzerTestOneInput(buf, len);
+  }
+  printf("1000000 random frames ok\n");
+  return 0;
+}
+#endif /* HC06_FUZZ_LIBFUZZER */
+/*---------------------------------------------------------------------------*/
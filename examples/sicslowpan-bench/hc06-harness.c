@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Host harness around the 6lowpan header compression code
+ *
+ *         sicslowpan.c is compiled into this file, so that its static
+ *         HC06 functions can be called directly on packets built in
+ *         memory. Everything else sicslowpan.c needs from the rest of
+ *         Contiki is stubbed out below.
+ * \author
+ *         agent <agent@local>
+ */
+
+#include "net/sicslowpan.c"
+
+#include "hc06-harness.h"
+
+uip_buf_t uip_aligned_buf;
+u16_t uip_len;
+u8_t uip_ext_len;
+uip_lladdr_t uip_lladdr;
+
+/*---------------------------------------------------------------------------*/
+/* Stubs */
+void uip_log(char *msg) {}
+void watchdog_periodic(void) {}
+void neighbor_info_packet_sent(int status, int numtx) {}
+void neighbor_info_packet_received(void) {}
+void tcpip_input(void) {}
+void tcpip_set_outputfunc(u8_t (*f)(uip_lladdr_t *)) {}
+clock_time_t clock_time(void) { return 0; }
+struct queuebuf *queuebuf_new_from_packetbuf(void) { return NULL; }
+void queuebuf_to_packetbuf(struct queuebuf *b) {}
+void queuebuf_free(struct queuebuf *b) {}
+
+static void mac_send(mac_callback_t sent, void *ptr) {}
+static void mac_nothing(void) {}
+static int mac_on(void) { return 1; }
+static int mac_off(int keep_radio_on) { return 1; }
+static unsigned short mac_cci(void) { return 0; }
+const struct mac_driver NETSTACK_MAC = {
+  "harness", mac_nothing, mac_send, mac_nothing, mac_on, mac_off, mac_cci
+};
+
+void
+uip_ds6_set_addr_iid(uip_ipaddr_t *ipaddr, uip_lladdr_t *lladdr)
+{
+  memcpy(ipaddr->u8 + 8, lladdr, UIP_LLADDR_LEN);
+  ipaddr->u8[8] ^= 0x02;
+}
+/*---------------------------------------------------------------------------*/
+void
+hc06_init(void)
+{
+  sicslowpan_init();
+}
+/*---------------------------------------------------------------------------*/
+int
+hc06_compress(const uint8_t *ip, uint16_t len,
+              const rimeaddr_t *src, const rimeaddr_t *dest,
+              uint8_t *frame, uint16_t *framelen)
+{
+  rimeaddr_t d;
+
+  if(len < UIP_IPH_LEN || len > UIP_BUFSIZE - UIP_LLH_LEN) {
+    return 0;
+  }
+  memcpy(&uip_buf[UIP_LLH_LEN], ip, len);
+  uip_len = len;
+  memcpy(&uip_lladdr, src, sizeof(uip_lladdr));
+  rimeaddr_copy(&d, dest);
+
+  packetbuf_clear();
+  rime_ptr = packetbuf_dataptr();
+  rime_hdr_len = 0;
+  uncomp_hdr_len = 0;
+  compress_hdr_hc06(&d);
+
+  /* A UDP packet too short to hold a UDP header, uIP never sends
+     those. */
+  if(uncomp_hdr_len > len) {
+    return 0;
+  }
+  if(rime_hdr_len + len - uncomp_hdr_len > HC06_MAX_FRAME) {
+    return 0;
+  }
+  memcpy(frame, rime_ptr, rime_hdr_len);
+  memcpy(frame + rime_hdr_len, &uip_buf[UIP_LLH_LEN + uncomp_hdr_len],
+         len - uncomp_hdr_len);
+  *framelen = rime_hdr_len + len - uncomp_hdr_len;
+  return rime_hdr_len;
+}
+/*---------------------------------------------------------------------------*/
+int
+hc06_uncompress(const uint8_t *frame, uint16_t framelen,
+                const rimeaddr_t *src, const rimeaddr_t *dest,
+                uint8_t *ip, uint16_t *len)
+{
+  if(framelen < 2 || framelen > HC06_MAX_FRAME ||
+     (frame[0] & 0xe0) != SICSLOWPAN_DISPATCH_IPHC) {
+    return 0;
+  }
+  packetbuf_clear();
+  memcpy(packetbuf_dataptr(), frame, framelen);
+  packetbuf_set_datalen(framelen);
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, src);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, dest);
+
+  rime_ptr = packetbuf_dataptr();
+  rime_hdr_len = 0;
+  uncomp_hdr_len = 0;
+  /* uncompress_hdr_hc06() leaves uncomp_hdr_len at zero when it
+     gives up, e.g. on an unknown context. */
+  uncompress_hdr_hc06(0);
+  if(uncomp_hdr_len == 0 || rime_hdr_len > framelen ||
+     uncomp_hdr_len + framelen - rime_hdr_len > UIP_BUFSIZE - UIP_LLH_LEN) {
+    return 0;
+  }
+  memcpy(ip, SICSLOWPAN_IP_BUF, uncomp_hdr_len);
+  memcpy(ip + uncomp_hdr_len, rime_ptr + rime_hdr_len,
+         framelen - rime_hdr_len);
+  *len = uncomp_hdr_len + framelen - rime_hdr_len;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Host harness around the 6lowpan header compression code
+ * \author
+ *         agent <agent@local>
+ */
+
+#ifndef __HC06_HARNESS_H__
+#define __HC06_HARNESS_H__
+
+#include "net/rime/rimeaddr.h"
+
+/* The largest 802.15.4 payload an unfragmented packet can have. */
+#define HC06_MAX_FRAME 127
+
+void hc06_init(void);
+
+/**
+ * Compress the IPv6 packet ip as sent from src to dest at the link
+ * layer, and write the 6lowpan frame to frame.
+ *
+ * \return The length of the compressed header, or zero if the
+ * packet could not be compressed into one frame.
+ */
+int hc06_compress(const uint8_t *ip, uint16_t len,
+                  const rimeaddr_t *src, const rimeaddr_t *dest,
+                  uint8_t *frame, uint16_t *framelen);
+
+/**
+ * Uncompress a 6lowpan frame received from src and addressed to
+ * dest and write the IPv6 packet to ip, which must hold UIP_BUFSIZE
+ * bytes.
+ *
+ * \return Non-zero if the frame could be uncompressed.
+ */
+int hc06_uncompress(const uint8_t *frame, uint16_t framelen,
+                    const rimeaddr_t *src, const rimeaddr_t *dest,
+                    uint8_t *ip, uint16_t *len);
+
+#endif /* __HC06_HARNESS_H__ */
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         TCP bulk transfer benchmark
+ *
+ *         Listens on TCP port 8000 and sends STREAM_LEN bytes to each
+ *         client that connects, then prints the time it took. Build
+ *         with SNDBUF=0 to compare uIP's single outstanding segment
+ *         with the UIP_CONF_TCP_SNDBUF send buffer, e.g. on the
+ *         native target:
+ *
+ *         time nc -6 <address> 8000 > /dev/null
+ *
+ *         The application uses the plain uIP callback API and
+ *         regenerates its data on uip_rexmit(), so the same code runs
+ *         in both modes.
+ * \author
+ *         agent <agent@local>
+ */
+
+#include "contiki.h"
+#include "contiki-net.h"
+
+#include <stdio.h>
+
+#define STREAM_PORT 8000
+#define STREAM_LEN  (256 * 1024UL)
+
+static uint32_t sent;
+static uint16_t last_len;
+static uint16_t rexmits;
+static clock_time_t start;
+/*---------------------------------------------------------------------------*/
+PROCESS(tcp_stream_process, "TCP stream");
+AUTOSTART_PROCESSES(&tcp_stream_process);
+/*---------------------------------------------------------------------------*/
+static void
+senddata(uint32_t offset, uint16_t len)
+{
+  uint8_t *p;
+  uint16_t i;
+
+  /* The stream is a counting byte pattern, so that any segment can
+     be regenerated from its offset. */
+  p = uip_appdata;
+  for(i = 0; i < len; ++i) {
+    p[i] = (uint8_t)(offset + i);
+  }
+  uip_send(uip_appdata, len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_next(void)
+{
+  last_len = uip_mss();
+  if(last_len > STREAM_LEN - sent) {
+    last_len = STREAM_LEN - sent;
+  }
+  if(last_len > 0) {
+    senddata(sent, last_len);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(void)
+{
+  clock_time_t t;
+
+  t = clock_time() - start;
+  if(t == 0) {
+    t = 1;
+  }
+  printf("tcp-stream: %lu bytes in %lu ms, %lu bytes/s, %u retransmissions\n",
+         (unsigned long)sent,
+         (unsigned long)t * 1000 / CLOCK_SECOND,
+         (unsigned long)sent * CLOCK_SECOND / t,
+         rexmits);
+}
+/*---------------------------------------------------------------------------*/
+static void
+appcall(void)
+{
+  if(uip_connected()) {
+    sent = 0;
+    last_len = 0;
+    rexmits = 0;
+    start = clock_time();
+    send_next();
+    return;
+  }
+
+  if(uip_closed() || uip_aborted() || uip_timedout()) {
+    if(sent < STREAM_LEN) {
+      report();
+    }
+    return;
+  }
+
+  if(uip_acked()) {
+    sent += last_len;
+    last_len = 0;
+    if(sent >= STREAM_LEN) {
+      report();
+      uip_close();
+      return;
+    }
+    send_next();
+  } else if(uip_rexmit()) {
+    ++rexmits;
+    senddata(sent, last_len);
+  } else if(uip_poll() && last_len == 0) {
+    send_next();
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(tcp_stream_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  tcp_listen(UIP_HTONS(STREAM_PORT));
+
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == tcpip_event);
+    appcall();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
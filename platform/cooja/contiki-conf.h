@@ -225,6 +225,10 @@ typedef unsigned long rtimer_clock_t;
 #define UIP_CONF_FWCACHE_SIZE    30
 #define UIP_CONF_BROADCAST       1
 #define UIP_ARCH_IPCHKSUM        1
+#ifndef UIP_CHKSUM_CONF_WIDE
+#define UIP_CHKSUM_CONF_WIDE     1
+#endif /* UIP_CHKSUM_CONF_WIDE */
+#define UIP_ARCH_CHKSUM          UIP_CHKSUM_CONF_WIDE
 #define UIP_CONF_UDP             1
 #define UIP_CONF_UDP_CHECKSUMS   1
 #define UIP_CONF_PINGADDRCONF    0
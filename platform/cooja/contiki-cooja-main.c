@@ -51,12 +51,14 @@
 
 #include "net/rime.h"
 #include "net/netstack.h"
+#include "net/nettrace.h"
 
 #include "dev/serial-line.h"
 #include "dev/cooja-radio.h"
 #include "dev/button-sensor.h"
 #include "dev/pir-sensor.h"
 #include "dev/vib-sensor.h"
+#include "dev/moteid.h"
 
 #include "sys/node-id.h"
 
@@ -225,6 +227,7 @@ contiki_init()
   }
 
   set_rime_addr();
+  NETTRACE_BOOT_RECORD(node_id, simRandomSeed);
   {
     uint8_t longaddr[8];
     uint16_t shortaddr;
@@ -39,6 +39,7 @@
 #include "net/packetbuf.h"
 #include "net/rime/rimestats.h"
 #include "net/netstack.h"
+#include "net/nettrace.h"
 
 #include "dev/radio.h"
 #include "dev/cooja-radio.h"
@@ -145,6 +146,7 @@ radio_read(void *buf, unsigned short bufsize)
 
   memcpy(buf, simInDataBuffer, simInSize);
   simInSize = 0;
+  NETTRACE(NETTRACE_RX, buf, tmp);
   return tmp;
 }
 /*---------------------------------------------------------------------------*/
@@ -193,6 +195,8 @@ radio_send(const void *payload, unsigned short payload_len)
   }
 #endif /* WITH_SEND_CCA */
 
+  NETTRACE(NETTRACE_TX, payload, payload_len);
+
   /* Copy packet data to temporary storage */
   memcpy(simOutDataBuffer, payload, payload_len);
   simOutSize = payload_len;
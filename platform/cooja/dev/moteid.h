@@ -32,5 +32,6 @@
 #define __MOTEID_H__
 
 extern int simMoteID;
+extern int simRandomSeed;
 
 #endif /* __MOTEID_H__ */
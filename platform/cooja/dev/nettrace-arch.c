@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         COOJA network trace output: one file per node, named
+ *         $NETTRACE_PREFIX<node id>.bin (default nettrace-<node id>.bin).
+ * \author
+ *         agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "contiki.h"
+#include "net/nettrace.h"
+#include "sys/node-id.h"
+
+#if NETTRACE_CONF_ENABLED
+
+/* Each node has its own copy: COOJA swaps the data of the nodes. */
+static FILE *trace;
+/*---------------------------------------------------------------------------*/
+void
+nettrace_arch_write(const void *data, uint16_t len)
+{
+  char name[FILENAME_MAX];
+  const char *prefix;
+
+  if(trace == NULL) {
+    prefix = getenv("NETTRACE_PREFIX");
+    snprintf(name, sizeof(name), "%s%d.bin",
+             prefix != NULL ? prefix : "nettrace-", node_id);
+    trace = fopen(name, "wb");
+    if(trace == NULL) {
+      return;
+    }
+  }
+  fwrite(data, 1, len, trace);
+  /* The simulator may stop the node at any time. */
+  fflush(trace);
+}
+/*---------------------------------------------------------------------------*/
+#endif /* NETTRACE_CONF_ENABLED */
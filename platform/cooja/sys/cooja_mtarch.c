@@ -59,6 +59,10 @@ struct frame {
   unsigned long rcx;
   unsigned long rbx;
   unsigned long rax;
+  unsigned long r12;
+  unsigned long r13;
+  unsigned long r14;
+  unsigned long r15;
 #else /* ON_64BIT_ARCH */
   unsigned long ebp;
   unsigned long edi;
@@ -94,7 +98,7 @@ cooja_mtarch_start(struct cooja_mtarch_thread *t,
   f->data    = (unsigned long)data;
   t->sp      = (unsigned long)&f->flags;
 #if ON_64BIT_ARCH
-  f->rbp     = (unsigned long)&f->rax;
+  f->rbp     = (unsigned long)&f->r15;
 #else /* ON_64BIT_ARCH */
   f->ebp     = (unsigned long)&f->eax;
 #endif /* ON_64BIT_ARCH */
@@ -106,7 +110,13 @@ void cooja_sw(void)
 {
   /* Store registers */
 #if ON_64BIT_ARCH
+  /* r12-r15 are callee-saved too: the thread must not return them
+     changed to the code that runs it. */
   __asm__ (
+      "pushq %r15\n\t"
+      "pushq %r14\n\t"
+      "pushq %r13\n\t"
+      "pushq %r12\n\t"
       "pushq %rax\n\t"
       "pushq %rbx\n\t"
       "pushq %rcx\n\t"
@@ -155,6 +165,10 @@ void cooja_sw(void)
       "popq %rcx\n\t"
       "popq %rbx\n\t"
       "popq %rax\n\t"
+      "popq %r12\n\t"
+      "popq %r13\n\t"
+      "popq %r14\n\t"
+      "popq %r15\n\t"
 
       "leave\n\t"
       "ret\n\t"
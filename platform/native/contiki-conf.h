@@ -115,7 +115,9 @@ typedef unsigned short uip_stats_t;
 #define SICSLOWPAN_CONF_MAXAGE                  8
 #endif /* SICSLOWPAN_CONF_FRAG */
 #define SICSLOWPAN_CONF_CONVENTIONAL_MAC	1
+#ifndef SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS
 #define SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS       2
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS */
 #ifndef SICSLOWPAN_CONF_MAX_MAC_TRANSMISSIONS
 #define SICSLOWPAN_CONF_MAX_MAC_TRANSMISSIONS   5
 #endif /* SICSLOWPAN_CONF_MAX_MAC_TRANSMISSIONS */
@@ -155,9 +157,16 @@ typedef unsigned short uip_stats_t;
 #define UIP_CONF_RECEIVE_WINDOW  48
 #define UIP_CONF_TCP_MSS         48
 #define UIP_CONF_UDP_CONNS       12
+#ifndef UIP_CONF_CONN_HASH
+#define UIP_CONF_CONN_HASH       1
+#endif /* UIP_CONF_CONN_HASH */
 #define UIP_CONF_FWCACHE_SIZE    30
 #define UIP_CONF_BROADCAST       1
 #define UIP_ARCH_IPCHKSUM        1
+#ifndef UIP_CHKSUM_CONF_WIDE
+#define UIP_CHKSUM_CONF_WIDE     1
+#endif /* UIP_CHKSUM_CONF_WIDE */
+#define UIP_ARCH_CHKSUM          UIP_CHKSUM_CONF_WIDE
 #define UIP_CONF_UDP             1
 #define UIP_CONF_UDP_CHECKSUMS   1
 #define UIP_CONF_PINGADDRCONF    0
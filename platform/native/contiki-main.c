@@ -42,6 +42,7 @@
 
 #include "contiki.h"
 #include "net/netstack.h"
+#include "net/nettrace.h"
 
 #include "ctk/ctk.h"
 #include "ctk/ctk-curses.h"
@@ -196,6 +197,7 @@ main(int argc, char **argv)
 #endif
 
   set_rime_addr();
+  NETTRACE_BOOT_RECORD(node_id, 0);
 
   queuebuf_init();
 
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         RFC 6206 conformance test for the trickle timer library.
+ *
+ *         A handful of trickle timers with different parameters run
+ *         side by side. The protocol callback checks, every time it is
+ *         called, that t lies in [I/2, I), that I doubles up to Imax,
+ *         that intervals follow each other without gaps, that t was
+ *         announced correctly one interval in advance, and that
+ *         transmissions are suppressed exactly when c >= k.
+ *         Consistent transmissions are injected right after an
+ *         interval starts; inconsistencies are injected at t.
+ *
+ * \author agent <agent@local>
+ */
+
+#include "contiki.h"
+#include "lib/trickle-timer.h"
+
+#include <stdio.h>
+/*---------------------------------------------------------------------------*/
+/* How many times each timer fires before the test is over. */
+#define FIRINGS        40
+/* Scheduling slack allowed for callbacks that run late, in ticks. */
+#define LATE           2
+/* Inject an inconsistency at every RESET_EVERY'th firing. */
+#define RESET_EVERY    5
+
+struct test {
+  struct trickle_timer tt;
+  struct ctimer inject;
+  clock_time_t i_min;
+  uint8_t i_max;
+  uint8_t k;
+  clock_time_t last_end;  /* End of the interval when we last fired */
+  clock_time_t next_t;    /* t announced for the next interval */
+  clock_time_t next_i;    /* I expected for the next interval */
+  uint16_t fired;
+  uint8_t pending;        /* Consistent transmissions to inject */
+  uint8_t heard;          /* Consistent transmissions in this interval */
+  uint8_t reset;          /* Reset to Imin since we last fired */
+  uint8_t done;
+};
+
+static struct test tests[] = {
+  { .i_min = 16, .i_max = 4, .k = 2 },
+  { .i_min = 10, .i_max = 3, .k = 1 },
+  { .i_min = 32, .i_max = 2, .k = TRICKLE_TIMER_INFINITE_REDUNDANCY },
+  { .i_min = 4,  .i_max = 6, .k = 3 },
+  { .i_min = 24, .i_max = 0, .k = 1 },
+};
+#define TESTS (sizeof(tests) / sizeof(tests[0]))
+
+static int failures;
+static int finished;
+
+PROCESS(trickle_conformance_process, "Trickle conformance test");
+AUTOSTART_PROCESSES(&trickle_conformance_process);
+/*---------------------------------------------------------------------------*/
+#define CHECK(t, cond, what) check((t), (cond), (what), __LINE__)
+static void
+check(struct test *t, int cond, const char *what, int line)
+{
+  if(!cond) {
+    failures++;
+    printf("FAIL timer %u, firing %u, line %d: %s "
+           "(I=%lu, start %lu, now %lu)\n",
+           (unsigned)(t - tests), t->fired, line, what,
+           (unsigned long)t->tt.i_cur, (unsigned long)t->tt.i_start,
+           (unsigned long)clock_time());
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+inject(void *ptr)
+{
+  struct test *t = ptr;
+  uint8_t i;
+
+  for(i = 0; i < t->pending; i++) {
+    trickle_timer_consistency(&t->tt);
+  }
+  t->heard = t->pending;
+}
+/*---------------------------------------------------------------------------*/
+static void
+reset(struct test *t)
+{
+  struct trickle_timer *tt = &t->tt;
+  clock_time_t start;
+  clock_time_t expires;
+
+  start = tt->i_start;
+  expires = TRICKLE_TIMER_EXPIRATION(tt);
+  if(tt->i_cur == tt->i_min) {
+    trickle_timer_inconsistency(tt);
+    CHECK(t, tt->i_start == start && TRICKLE_TIMER_EXPIRATION(tt) == expires,
+          "no reset when I is Imin");
+  } else {
+    ctimer_stop(&t->inject);
+    trickle_timer_inconsistency(tt);
+    CHECK(t, tt->i_cur == tt->i_min && tt->i_start == clock_time() &&
+          tt->c == 0, "reset to Imin");
+    t->reset = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+tx(void *ptr, uint8_t suppress)
+{
+  struct test *t = ptr;
+  struct trickle_timer *tt = &t->tt;
+  clock_time_t now;
+  clock_time_t offset;
+  uint8_t expected;
+
+  now = clock_time();
+  offset = now - tt->i_start;
+
+  CHECK(t, !t->done, "callback after stop");
+  CHECK(t, tt->i_cur >= tt->i_min && tt->i_cur <= TRICKLE_TIMER_INTERVAL_MAX(tt),
+        "I within [Imin, Imax]");
+  CHECK(t, offset >= tt->i_cur / 2 && offset < tt->i_cur + LATE,
+        "t within [I/2, I)");
+  if(t->reset) {
+    CHECK(t, tt->i_cur == tt->i_min, "I is Imin after a reset");
+  } else if(t->fired > 0) {
+    CHECK(t, tt->i_start == t->last_end, "intervals back to back");
+    CHECK(t, tt->i_cur == t->next_i, "I doubles up to Imax");
+    CHECK(t, offset >= t->next_t && offset <= t->next_t + LATE,
+          "t as announced");
+  }
+
+  expected = tt->k == TRICKLE_TIMER_INFINITE_REDUNDANCY || t->heard < tt->k ?
+    TRICKLE_TIMER_TX_OK : TRICKLE_TIMER_TX_SUPPRESS;
+  CHECK(t, suppress == expected, "suppressed exactly when c >= k");
+
+  t->fired++;
+  t->reset = 0;
+  t->heard = 0;
+  t->last_end = TRICKLE_TIMER_INTERVAL_END(tt);
+  t->next_i = TRICKLE_TIMER_NEXT_INTERVAL(tt);
+  t->next_t = TRICKLE_TIMER_NEXT_T(tt);
+  CHECK(t, t->next_t >= t->next_i / 2 && t->next_t < t->next_i,
+        "announced t within [I/2, I)");
+
+  if(t->fired == FIRINGS) {
+#if TRICKLE_TIMER_STATS
+    CHECK(t, tt->stats.tx + tt->stats.suppressed == FIRINGS &&
+          tt->stats.intervals >= FIRINGS, "statistics");
+#endif
+    trickle_timer_stop(tt);
+    CHECK(t, !trickle_timer_is_running(tt), "stopped");
+    ctimer_stop(&t->inject);
+    t->done = 1;
+    finished++;
+    process_poll(&trickle_conformance_process);
+  } else if(t->fired % RESET_EVERY == 0) {
+    reset(t);
+  } else if(t->fired % 4 != 0) {
+    /* Hear a few consistent transmissions just after the next interval
+       starts, well before its t. */
+    t->pending = t->fired % 4;
+    ctimer_set(&t->inject, t->last_end - now + 1, inject, t);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(trickle_conformance_process, ev, data)
+{
+  static struct etimer timeout;
+  static uint8_t i;
+
+  PROCESS_BEGIN();
+
+  for(i = 0; i < TESTS; i++) {
+    if(trickle_timer_config(&tests[i].tt, tests[i].i_min, tests[i].i_max,
+                            tests[i].k) != TRICKLE_TIMER_SUCCESS) {
+      printf("FAIL timer %u: config\n", i);
+      failures++;
+    }
+    trickle_timer_set(&tests[i].tt, tx, &tests[i]);
+  }
+
+  etimer_set(&timeout, 120 * CLOCK_SECOND);
+  while(finished < TESTS && !etimer_expired(&timeout)) {
+    PROCESS_WAIT_EVENT();
+  }
+
+  if(finished < TESTS) {
+    printf("FAIL timeout, %d of %u timers finished\n", finished,
+           (unsigned)TESTS);
+    failures++;
+  }
+
+  /* Stopped timers must stay quiet. */
+  etimer_set(&timeout, CLOCK_SECOND);
+  PROCESS_WAIT_UNTIL(etimer_expired(&timeout));
+
+  if(failures == 0) {
+    printf("TEST OK\n");
+  } else {
+    printf("TEST FAILED (%d failures)\n", failures);
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,12 @@
+TIMEOUT(300000);
+
+while(true) {
+  log.log("> " + msg + "\n");
+  if(msg.startsWith('TEST OK')) {
+    log.testOK();
+  }
+  if(msg.startsWith('TEST FAILED')) {
+    log.testFailed();
+  }
+  YIELD();
+}
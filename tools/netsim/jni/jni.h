@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+/**
+ * \file
+ *         Minimal JNI declarations for building COOJA node libraries
+ *         that are driven by netsim rather than by the Java VM.
+ * \author
+ *         agent <agent@local>
+ */
+
+#ifndef __NETSIM_JNI_H__
+#define __NETSIM_JNI_H__
+
+typedef int jint;
+typedef signed char jbyte;
+typedef void *jobject;
+typedef void *jbyteArray;
+
+struct JNINativeInterface_;
+typedef const struct JNINativeInterface_ *JNIEnv;
+
+/* netsim accesses node memory directly, so these are never called. */
+struct JNINativeInterface_ {
+  void (*SetByteArrayRegion)(JNIEnv *env, jbyteArray array,
+                             jint start, jint len, const jbyte *buf);
+  jbyte *(*GetByteArrayElements)(JNIEnv *env, jbyteArray array,
+                                 void *is_copy);
+  void (*ReleaseByteArrayElements)(JNIEnv *env, jbyteArray array,
+                                   jbyte *elems, jint mode);
+};
+
+#define JNIEXPORT
+#define JNICALL
+
+#endif /* __NETSIM_JNI_H__ */
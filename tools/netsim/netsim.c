@@ -0,0 +1,1197 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+/**
+ * \file
+ *         netsim: a headless discrete-event simulator for Contiki nodes.
+ *
+ *         Runs any number of Contiki nodes in one process, built as
+ *         COOJA node libraries (see Makefile.netsim). As in COOJA,
+ *         all nodes of a firmware share the library, and the memory
+ *         of the node that runs is swapped into the library's data
+ *         and BSS sections, so that each node has its own processes,
+ *         timers, packetbuf and network stack. Nodes are only run
+ *         when one of their timers expires or their radio has
+ *         something to report, so simulations run much faster than
+ *         real time.
+ *
+ *         Nodes are connected by a unit-disk radio medium with
+ *         distance-dependent loss, or by an explicit loss matrix.
+ *         Overlapping transmissions collide at the receiver.
+ *
+ *         With -R, a single node is instead fed the frames that a
+ *         node received in a recorded network trace (see
+ *         core/net/nettrace.h), at the times it received them.
+ * \author
+ *         agent <agent@local>
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <elf.h>
+#include <link.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/* Simulated time is kept in microseconds. */
+#define MILLISECOND 1000LL
+#define SECOND      (1000 * MILLISECOND)
+#define NEVER       INT64_MAX
+
+/* Signal strengths reported to the nodes' CCA. */
+#define SIGNAL_NONE    -100
+#define SIGNAL_STRONG  -10
+
+#define MAX_TYPES      8
+#define MAX_LINE       256
+
+#define CLASSNAME      "Netsim"
+#define JNI_FUNCTION(name) "Java_se_sics_cooja_corecomm_" CLASSNAME "_" name
+
+struct mote;
+
+struct region {
+  char *start;
+  size_t size;
+};
+
+struct mote_type {
+  char *file;
+  void *handle;
+  struct region regions[2];
+  size_t memsize;
+  char *initial;
+  struct mote *resident;
+
+  void (*init)(void *env, void *obj);
+  void (*tick)(void *env, void *obj);
+
+  int *simMoteID;
+  char *simMoteIDChanged;
+  int *simRandomSeed;
+  unsigned long *simCurrentTime;
+  int *simProcessRunValue;
+  int *simEtimerPending;
+  unsigned long *simNextExpirationTime;
+  char *simRadioHWOn;
+  char *simReceiving;
+  char *simInDataBuffer;
+  int *simInSize;
+  char *simOutDataBuffer;
+  int *simOutSize;
+  int *simSignalStrength;
+  int *simRadioChannel;
+  char *simLoggedData;
+  int *simLoggedLength;
+  char *simLoggedFlag;
+};
+
+struct link {
+  struct mote *dst;
+  double prr;
+  char interferes_only;
+};
+
+struct transmission {
+  struct mote *src;
+  int64_t end;
+  int channel;
+  int len;
+  char aborted;
+  int nheard;
+  struct mote **heard;
+  char data[];
+};
+
+struct stats {
+  unsigned long ticks;
+  unsigned long tx;
+  unsigned long tx_bytes;
+  unsigned long rx;
+  unsigned long rx_bytes;
+  unsigned long rx_lost;
+  unsigned long rx_collisions;
+};
+
+struct mote {
+  int id;
+  struct mote_type *type;
+  char *mem;
+  double x, y;
+  int64_t wakeup;
+
+  struct link *links;
+  int nlinks;
+
+  char radio_on;
+  int64_t radio_on_since;
+  int64_t radio_on_time;
+  struct transmission *tx;
+  struct transmission *rx;
+  char rx_corrupt;
+  char rx_lost;
+  int signals;
+
+  char line[MAX_LINE];
+  int linelen;
+
+  struct stats stats;
+};
+
+enum {
+  EV_TICK,
+  EV_TX_END,
+  EV_REPLAY_START,
+  EV_REPLAY_END,
+};
+
+/* Network trace format, see core/net/nettrace.h. */
+#define NETTRACE_HEADER_LEN  8
+#define NETTRACE_RECORD_LEN  7
+#define NETTRACE_BOOT        1
+#define NETTRACE_RX          2
+
+struct event {
+  int64_t time;
+  uint64_t seq;
+  int type;
+  struct mote *mote;
+  struct transmission *tx;
+};
+
+static struct mote_type types[MAX_TYPES];
+static int ntypes;
+
+static struct mote *motes;
+static int nmotes;
+
+static struct event *heap;
+static int heap_len, heap_size;
+static uint64_t event_seq;
+
+static int64_t now;
+
+/* Configuration. */
+static int64_t sim_time = 60 * SECOND;
+static uint64_t seed = 123456;
+static double tx_range = 50;
+static double interference_range = 100;
+static double area;
+static double tx_success = 1.0;
+static double rx_success = 1.0;
+static double bitrate_kbps = 250;
+static int64_t max_startup_delay = 1000 * MILLISECOND;
+static const char *positions_file;
+static const char *matrix_file;
+static const char *stats_file;
+static const char *replay_file;
+static int quiet;
+
+/* The recorded node, when replaying a trace. */
+static int replay_id = 1;
+static int64_t replay_boot;
+static int replay_seed;
+static int replay_has_boot;
+
+static uint64_t rng_state;
+/*---------------------------------------------------------------------------*/
+static void
+fatal(const char *message, const char *arg)
+{
+  fprintf(stderr, "netsim: %s%s%s\n", message, arg ? ": " : "",
+          arg ? arg : "");
+  exit(1);
+}
+/*---------------------------------------------------------------------------*/
+static void *
+xmalloc(size_t size)
+{
+  void *p;
+
+  p = calloc(1, size);
+  if(p == NULL) {
+    fatal("out of memory", NULL);
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+/* xorshift64*: the simulation must not depend on the C library's
+   random(), which the nodes may share. */
+static double
+rng_uniform(void)
+{
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return ((rng_state * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+heap_push(int64_t time, int type, struct mote *m, struct transmission *tx)
+{
+  struct event e;
+  int i, parent;
+
+  if(heap_len == heap_size) {
+    heap_size = heap_size ? heap_size * 2 : 1024;
+    heap = realloc(heap, heap_size * sizeof(struct event));
+    if(heap == NULL) {
+      fatal("out of memory", NULL);
+    }
+  }
+
+  e.time = time;
+  e.seq = event_seq++;
+  e.type = type;
+  e.mote = m;
+  e.tx = tx;
+
+  for(i = heap_len++; i > 0; i = parent) {
+    parent = (i - 1) / 2;
+    if(heap[parent].time < e.time ||
+       (heap[parent].time == e.time && heap[parent].seq < e.seq)) {
+      break;
+    }
+    heap[i] = heap[parent];
+  }
+  heap[i] = e;
+}
+/*---------------------------------------------------------------------------*/
+static struct event
+heap_pop(void)
+{
+  struct event top, last;
+  int i, child;
+
+  top = heap[0];
+  last = heap[--heap_len];
+  for(i = 0; (child = 2 * i + 1) < heap_len; i = child) {
+    if(child + 1 < heap_len &&
+       (heap[child + 1].time < heap[child].time ||
+        (heap[child + 1].time == heap[child].time &&
+         heap[child + 1].seq < heap[child].seq))) {
+      child++;
+    }
+    if(last.time < heap[child].time ||
+       (last.time == heap[child].time && last.seq < heap[child].seq)) {
+      break;
+    }
+    heap[i] = heap[child];
+  }
+  heap[i] = last;
+  return top;
+}
+/*---------------------------------------------------------------------------*/
+/* A mote has at most one pending tick: the earliest one requested. */
+static void
+schedule(struct mote *m, int64_t time)
+{
+  if(time < m->wakeup) {
+    m->wakeup = time;
+    heap_push(time, EV_TICK, m, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Returns where a variable of the library lives for mote m: in the
+   library if m is resident, else in m's saved memory. */
+static void *
+var(struct mote *m, void *addr)
+{
+  struct mote_type *t;
+  size_t offset;
+  int i;
+
+  t = m->type;
+  if(t->resident == m) {
+    return addr;
+  }
+  offset = 0;
+  for(i = 0; i < 2; i++) {
+    if((char *)addr >= t->regions[i].start &&
+       (char *)addr < t->regions[i].start + t->regions[i].size) {
+      return m->mem + offset + ((char *)addr - t->regions[i].start);
+    }
+    offset += t->regions[i].size;
+  }
+  fatal("variable outside of node memory", t->file);
+  return NULL;
+}
+#define VAR(m, name) (*(__typeof__((m)->type->name))var((m), (m)->type->name))
+/*---------------------------------------------------------------------------*/
+static void
+swap_in(struct mote *m)
+{
+  struct mote_type *t;
+  size_t offset;
+  int i;
+
+  t = m->type;
+  if(t->resident == m) {
+    return;
+  }
+  if(t->resident != NULL) {
+    offset = 0;
+    for(i = 0; i < 2; i++) {
+      memcpy(t->resident->mem + offset, t->regions[i].start,
+             t->regions[i].size);
+      offset += t->regions[i].size;
+    }
+  }
+  offset = 0;
+  for(i = 0; i < 2; i++) {
+    memcpy(t->regions[i].start, m->mem + offset, t->regions[i].size);
+    offset += t->regions[i].size;
+  }
+  t->resident = m;
+}
+/*---------------------------------------------------------------------------*/
+static void
+find_regions(struct mote_type *t)
+{
+  struct link_map *map;
+  Elf64_Ehdr ehdr;
+  Elf64_Shdr *shdrs;
+  char *names;
+  FILE *f;
+  int i;
+
+  if(dlinfo(t->handle, RTLD_DI_LINKMAP, &map) != 0) {
+    fatal("cannot locate the library in memory", t->file);
+  }
+
+  f = fopen(t->file, "rb");
+  if(f == NULL || fread(&ehdr, sizeof(ehdr), 1, f) != 1 ||
+     ehdr.e_ident[EI_CLASS] != ELFCLASS64) {
+    fatal("cannot read ELF header", t->file);
+  }
+  shdrs = xmalloc(ehdr.e_shnum * sizeof(Elf64_Shdr));
+  if(fseek(f, ehdr.e_shoff, SEEK_SET) != 0 ||
+     fread(shdrs, sizeof(Elf64_Shdr), ehdr.e_shnum, f) != ehdr.e_shnum) {
+    fatal("cannot read ELF section headers", t->file);
+  }
+  names = xmalloc(shdrs[ehdr.e_shstrndx].sh_size);
+  if(fseek(f, shdrs[ehdr.e_shstrndx].sh_offset, SEEK_SET) != 0 ||
+     fread(names, 1, shdrs[ehdr.e_shstrndx].sh_size, f) !=
+     shdrs[ehdr.e_shstrndx].sh_size) {
+    fatal("cannot read ELF section names", t->file);
+  }
+  fclose(f);
+
+  for(i = 0; i < ehdr.e_shnum; i++) {
+    if(strcmp(names + shdrs[i].sh_name, ".data") == 0) {
+      t->regions[0].start = (char *)map->l_addr + shdrs[i].sh_addr;
+      t->regions[0].size = shdrs[i].sh_size;
+    } else if(strcmp(names + shdrs[i].sh_name, ".bss") == 0) {
+      t->regions[1].start = (char *)map->l_addr + shdrs[i].sh_addr;
+      t->regions[1].size = shdrs[i].sh_size;
+    }
+  }
+  free(shdrs);
+  free(names);
+
+  if(t->regions[0].start == NULL || t->regions[1].start == NULL) {
+    fatal("no data or BSS section", t->file);
+  }
+  t->memsize = t->regions[0].size + t->regions[1].size;
+}
+/*---------------------------------------------------------------------------*/
+static void *
+symbol(struct mote_type *t, const char *name)
+{
+  void *p;
+
+  p = dlsym(t->handle, name);
+  if(p == NULL) {
+    fatal("symbol not found in firmware", name);
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+static struct mote_type *
+load_type(const char *file)
+{
+  struct mote_type *t;
+  char *path;
+  size_t offset;
+  int i;
+
+  path = realpath(file, NULL);
+  if(path == NULL) {
+    fatal("cannot find firmware", file);
+  }
+  for(i = 0; i < ntypes; i++) {
+    if(strcmp(types[i].file, path) == 0) {
+      free(path);
+      return &types[i];
+    }
+  }
+  if(ntypes == MAX_TYPES) {
+    fatal("too many firmware files", file);
+  }
+
+  t = &types[ntypes++];
+  t->file = path;
+  /* Lazy binding, like COOJA: unused undefined functions are fine. */
+  t->handle = dlopen(path, RTLD_LAZY | RTLD_LOCAL);
+  if(t->handle == NULL) {
+    fatal("cannot load firmware", dlerror());
+  }
+  find_regions(t);
+
+  t->init = (void (*)(void *, void *))symbol(t, JNI_FUNCTION("init"));
+  t->tick = (void (*)(void *, void *))symbol(t, JNI_FUNCTION("tick"));
+
+#define SYMBOL(name) t->name = symbol(t, #name)
+  SYMBOL(simMoteID);
+  SYMBOL(simMoteIDChanged);
+  SYMBOL(simRandomSeed);
+  SYMBOL(simCurrentTime);
+  SYMBOL(simProcessRunValue);
+  SYMBOL(simEtimerPending);
+  SYMBOL(simNextExpirationTime);
+  SYMBOL(simRadioHWOn);
+  SYMBOL(simReceiving);
+  SYMBOL(simInDataBuffer);
+  SYMBOL(simInSize);
+  SYMBOL(simOutDataBuffer);
+  SYMBOL(simOutSize);
+  SYMBOL(simSignalStrength);
+  SYMBOL(simRadioChannel);
+  SYMBOL(simLoggedData);
+  SYMBOL(simLoggedLength);
+  SYMBOL(simLoggedFlag);
+#undef SYMBOL
+
+  /* Every node starts from the memory the library was loaded with. */
+  t->initial = xmalloc(t->memsize);
+  offset = 0;
+  for(i = 0; i < 2; i++) {
+    memcpy(t->initial + offset, t->regions[i].start, t->regions[i].size);
+    offset += t->regions[i].size;
+  }
+  return t;
+}
+/*---------------------------------------------------------------------------*/
+static void
+node_output(struct mote *m)
+{
+  char *data;
+  int len, i;
+
+  len = VAR(m, simLoggedLength);
+  data = &VAR(m, simLoggedData);
+  for(i = 0; i < len; i++) {
+    if(data[i] == '\n' || m->linelen == MAX_LINE - 1) {
+      m->line[m->linelen] = '\0';
+      if(!quiet) {
+        printf("%lld\tID:%d\t%s\n", (long long)(now / MILLISECOND),
+               m->id, m->line);
+      }
+      m->linelen = 0;
+      if(data[i] == '\n') {
+        continue;
+      }
+    }
+    m->line[m->linelen++] = data[i];
+  }
+  VAR(m, simLoggedLength) = 0;
+  VAR(m, simLoggedFlag) = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_signal(struct mote *m)
+{
+  VAR(m, simSignalStrength) = m->signals > 0 ? SIGNAL_STRONG : SIGNAL_NONE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+start_transmission(struct mote *m, int len)
+{
+  struct transmission *tx;
+  struct mote *r;
+  struct link *l;
+  int64_t duration;
+  int i;
+
+  tx = xmalloc(sizeof(struct transmission) + len);
+  tx->heard = xmalloc(m->nlinks * sizeof(struct mote *));
+  tx->src = m;
+  tx->len = len;
+  tx->channel = VAR(m, simRadioChannel);
+  memcpy(tx->data, &VAR(m, simOutDataBuffer), len);
+
+  duration = (int64_t)(len * 8 * MILLISECOND / bitrate_kbps);
+  tx->end = now + (duration > 0 ? duration : 1);
+
+  m->tx = tx;
+  m->stats.tx++;
+  m->stats.tx_bytes += len;
+  if(m->rx != NULL) {
+    /* A radio cannot receive while it transmits. */
+    m->rx_corrupt = 1;
+  }
+
+  for(i = 0; i < m->nlinks; i++) {
+    l = &m->links[i];
+    r = l->dst;
+    if(!r->radio_on || VAR(r, simRadioChannel) != tx->channel) {
+      continue;
+    }
+    tx->heard[tx->nheard++] = r;
+    r->signals++;
+    set_signal(r);
+
+    if(r->rx != NULL) {
+      r->rx_corrupt = 1;
+    }
+    if(l->interferes_only) {
+      continue;
+    }
+    if(r->rx != NULL || r->tx != NULL || r->signals > 1) {
+      r->stats.rx_collisions++;
+      continue;
+    }
+
+    r->rx = tx;
+    r->rx_corrupt = 0;
+    r->rx_lost = rng_uniform() >= l->prr;
+    VAR(r, simReceiving) = 1;
+    schedule(r, now);
+  }
+
+  heap_push(tx->end, EV_TX_END, m, tx);
+}
+/*---------------------------------------------------------------------------*/
+static void
+end_transmission(struct transmission *tx)
+{
+  struct mote *m, *r;
+  int i;
+
+  m = tx->src;
+  if(m->tx == tx) {
+    m->tx = NULL;
+    VAR(m, simOutSize) = 0;
+    schedule(m, now);
+  }
+
+  for(i = 0; i < tx->nheard; i++) {
+    r = tx->heard[i];
+    r->signals--;
+    set_signal(r);
+    if(r->rx != tx) {
+      continue;
+    }
+    r->rx = NULL;
+    if(tx->aborted || r->rx_corrupt) {
+      r->stats.rx_collisions++;
+      VAR(r, simInSize) = 0;
+    } else if(r->rx_lost) {
+      r->stats.rx_lost++;
+      VAR(r, simInSize) = 0;
+    } else {
+      r->stats.rx++;
+      r->stats.rx_bytes += tx->len;
+      memcpy(&VAR(r, simInDataBuffer), tx->data, tx->len);
+      VAR(r, simInSize) = tx->len;
+    }
+    VAR(r, simReceiving) = 0;
+    schedule(r, now);
+  }
+
+  free(tx->heard);
+  free(tx);
+}
+/*---------------------------------------------------------------------------*/
+static void
+radio_after_tick(struct mote *m)
+{
+  char on;
+  int len;
+
+  on = VAR(m, simRadioHWOn);
+  if(on != m->radio_on) {
+    m->radio_on = on;
+    if(on) {
+      m->radio_on_since = now;
+      set_signal(m);
+    } else {
+      m->radio_on_time += now - m->radio_on_since;
+      VAR(m, simReceiving) = 0;
+      VAR(m, simInSize) = 0;
+      VAR(m, simOutSize) = 0;
+      if(m->tx != NULL) {
+        m->tx->aborted = 1;
+        m->tx = NULL;
+      }
+      m->rx = NULL;
+    }
+  }
+  if(!on) {
+    return;
+  }
+
+  len = VAR(m, simOutSize);
+  if(m->tx == NULL && len > 0) {
+    start_transmission(m, len);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+clock_after_tick(struct mote *m)
+{
+  long next;
+
+  if(VAR(m, simProcessRunValue) != 0) {
+    /* More events to process. */
+    schedule(m, now + MILLISECOND);
+    return;
+  }
+  if(VAR(m, simEtimerPending) == 0) {
+    return;
+  }
+  next = (long)VAR(m, simNextExpirationTime);
+  schedule(m, now + (next > 0 ? next : 1) * MILLISECOND);
+}
+/*---------------------------------------------------------------------------*/
+static void
+tick(struct mote *m)
+{
+  struct mote_type *t;
+
+  t = m->type;
+  swap_in(m);
+  *t->simCurrentTime = now / MILLISECOND;
+  t->tick(NULL, NULL);
+  m->stats.ticks++;
+
+  if(*t->simLoggedFlag) {
+    node_output(m);
+  }
+  radio_after_tick(m);
+  clock_after_tick(m);
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_link(struct mote *src, struct mote *dst, double prr, int interferes_only)
+{
+  struct link *l;
+
+  src->links = realloc(src->links, (src->nlinks + 1) * sizeof(struct link));
+  if(src->links == NULL) {
+    fatal("out of memory", NULL);
+  }
+  l = &src->links[src->nlinks++];
+  l->dst = dst;
+  l->prr = prr;
+  l->interferes_only = interferes_only;
+}
+/*---------------------------------------------------------------------------*/
+static struct mote *
+mote_by_id(int id)
+{
+  if(id < 1 || id > nmotes) {
+    return NULL;
+  }
+  return &motes[id - 1];
+}
+/*---------------------------------------------------------------------------*/
+static void
+read_positions(void)
+{
+  FILE *f;
+  char line[256];
+  struct mote *m;
+  double x, y;
+  int id;
+
+  f = fopen(positions_file, "r");
+  if(f == NULL) {
+    fatal("cannot open positions file", positions_file);
+  }
+  while(fgets(line, sizeof(line), f) != NULL) {
+    if(line[0] == '#' || sscanf(line, "%d %lf %lf", &id, &x, &y) != 3) {
+      continue;
+    }
+    m = mote_by_id(id);
+    if(m != NULL) {
+      m->x = x;
+      m->y = y;
+    }
+  }
+  fclose(f);
+}
+/*---------------------------------------------------------------------------*/
+/* Unit-disk graph: nodes within the transmission range receive, with
+   a success ratio that falls from tx_success at distance 0 to
+   tx_success * rx_success at the edge of the range. Nodes within the
+   interference range only interfere. */
+static void
+unit_disk_links(void)
+{
+  struct mote *a, *b;
+  double d2, r2, i2;
+  int i, j;
+
+  if(area <= 0) {
+    /* About a dozen neighbors per node. */
+    area = tx_range * sqrt(nmotes) / 2;
+  }
+  for(i = 0; i < nmotes; i++) {
+    motes[i].x = rng_uniform() * area;
+    motes[i].y = rng_uniform() * area;
+  }
+  if(positions_file != NULL) {
+    read_positions();
+  }
+
+  r2 = tx_range * tx_range;
+  i2 = interference_range * interference_range;
+  for(i = 0; i < nmotes; i++) {
+    a = &motes[i];
+    for(j = 0; j < nmotes; j++) {
+      b = &motes[j];
+      if(a == b) {
+        continue;
+      }
+      d2 = (a->x - b->x) * (a->x - b->x) + (a->y - b->y) * (a->y - b->y);
+      if(d2 <= r2) {
+        add_link(a, b, tx_success * (1.0 - d2 / r2 * (1.0 - rx_success)), 0);
+      } else if(d2 <= i2) {
+        add_link(a, b, 0, 1);
+      }
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Loss matrix: one "source destination success-ratio" line per
+   directed link. */
+static void
+matrix_links(void)
+{
+  FILE *f;
+  char line[256];
+  struct mote *src, *dst;
+  double prr;
+  int a, b;
+
+  f = fopen(matrix_file, "r");
+  if(f == NULL) {
+    fatal("cannot open loss matrix", matrix_file);
+  }
+  while(fgets(line, sizeof(line), f) != NULL) {
+    if(line[0] == '#' || sscanf(line, "%d %d %lf", &a, &b, &prr) != 3) {
+      continue;
+    }
+    src = mote_by_id(a);
+    dst = mote_by_id(b);
+    if(src == NULL || dst == NULL || src == dst) {
+      fprintf(stderr, "netsim: ignoring link %d -> %d\n", a, b);
+      continue;
+    }
+    add_link(src, dst, prr, 0);
+  }
+  fclose(f);
+}
+/*---------------------------------------------------------------------------*/
+static void
+create_motes(int argc, char *argv[])
+{
+  struct mote_type *t;
+  struct mote *m;
+  char *file, *sep;
+  int counts[MAX_TYPES * 4];
+  struct mote_type *which[MAX_TYPES * 4];
+  int i, j, n;
+
+  if(argc > MAX_TYPES * 4) {
+    fatal("too many firmware arguments", NULL);
+  }
+  nmotes = 0;
+  for(i = 0; i < argc; i++) {
+    file = strdup(argv[i]);
+    n = 1;
+    sep = strrchr(file, ':');
+    if(sep != NULL) {
+      *sep = '\0';
+      n = atoi(sep + 1);
+    }
+    which[i] = load_type(file);
+    counts[i] = n;
+    nmotes += n;
+    free(file);
+  }
+  if(nmotes == 0) {
+    fatal("no nodes to simulate", NULL);
+  }
+
+  motes = xmalloc(nmotes * sizeof(struct mote));
+  n = 0;
+  for(i = 0; i < argc; i++) {
+    for(j = 0; j < counts[i]; j++, n++) {
+      m = &motes[n];
+      t = which[i];
+      m->id = n + 1;
+      m->type = t;
+      m->mem = xmalloc(t->memsize);
+      memcpy(m->mem, t->initial, t->memsize);
+      m->wakeup = NEVER;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* A recorded frame starts to arrive. It is received if the radio of
+   the node is on, and the node does not transmit before it ends. */
+static void
+replay_start(struct mote *m, struct transmission *tx)
+{
+  m->signals++;
+  set_signal(m);
+  if(!m->radio_on || m->tx != NULL || m->rx != NULL ||
+     VAR(m, simRadioChannel) != tx->channel) {
+    return;
+  }
+  m->rx = tx;
+  m->rx_corrupt = 0;
+  VAR(m, simReceiving) = 1;
+  schedule(m, now);
+}
+/*---------------------------------------------------------------------------*/
+static void
+replay_end(struct mote *m, struct transmission *tx)
+{
+  m->signals--;
+  set_signal(m);
+  if(m->rx != tx) {
+    m->stats.rx_lost++;
+  } else {
+    m->rx = NULL;
+    if(m->rx_corrupt) {
+      m->stats.rx_collisions++;
+      VAR(m, simInSize) = 0;
+    } else {
+      m->stats.rx++;
+      m->stats.rx_bytes += tx->len;
+      memcpy(&VAR(m, simInDataBuffer), tx->data, tx->len);
+      VAR(m, simInSize) = tx->len;
+    }
+    VAR(m, simReceiving) = 0;
+    schedule(m, now);
+  }
+  free(tx);
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+get_le(const unsigned char *p, int len)
+{
+  unsigned long v;
+
+  v = 0;
+  while(len-- > 0) {
+    v = (v << 8) | p[len];
+  }
+  return v;
+}
+/*---------------------------------------------------------------------------*/
+/* Reads the trace to replay: the boot record gives the ID and random
+   seed of the recorded node, and every received frame is scheduled
+   to arrive again at the time the node read it from its radio. */
+static void
+load_replay(void)
+{
+  FILE *f;
+  unsigned char header[NETTRACE_HEADER_LEN];
+  struct transmission *tx;
+  int64_t time, duration;
+  unsigned long clock_second;
+  int type, len, frames;
+
+  f = fopen(replay_file, "rb");
+  if(f == NULL) {
+    fatal("cannot open trace", replay_file);
+  }
+  if(fread(header, 1, NETTRACE_HEADER_LEN, f) != NETTRACE_HEADER_LEN ||
+     memcmp(header, "CNTR", 4) != 0 || header[4] != 1) {
+    fatal("not a version 1 network trace", replay_file);
+  }
+  clock_second = get_le(&header[6], 2);
+  if(clock_second == 0) {
+    fatal("bad clock rate in trace", replay_file);
+  }
+
+  frames = 0;
+  while(fread(header, 1, NETTRACE_RECORD_LEN, f) == NETTRACE_RECORD_LEN) {
+    time = (int64_t)get_le(&header[0], 4) * SECOND / clock_second;
+    type = header[4];
+    len = get_le(&header[5], 2);
+    tx = xmalloc(sizeof(struct transmission) + len);
+    if(fread(tx->data, 1, len, f) != len) {
+      fatal("truncated trace", replay_file);
+    }
+    if(type == NETTRACE_BOOT && len >= 6 && !replay_has_boot) {
+      replay_id = get_le((unsigned char *)tx->data, 2);
+      replay_seed = (int)get_le((unsigned char *)tx->data + 2, 4);
+      replay_boot = time;
+      replay_has_boot = 1;
+    }
+    if(type != NETTRACE_RX || len == 0) {
+      free(tx);
+      continue;
+    }
+    tx->len = len;
+    tx->channel = VAR(&motes[0], simRadioChannel);
+    duration = (int64_t)(len * 8 * MILLISECOND / bitrate_kbps);
+    heap_push(time > duration ? time - duration : 0, EV_REPLAY_START,
+              &motes[0], tx);
+    heap_push(time, EV_REPLAY_END, &motes[0], tx);
+    frames++;
+  }
+  fclose(f);
+
+  if(!replay_has_boot) {
+    fprintf(stderr, "netsim: no boot record in %s\n", replay_file);
+  }
+  motes[0].id = replay_id;
+  if(!quiet) {
+    fprintf(stderr, "netsim: replaying %d frames to node %d\n", frames,
+            replay_id);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+boot_motes(void)
+{
+  struct mote *m;
+  int i;
+
+  for(i = 0; i < nmotes; i++) {
+    m = &motes[i];
+    swap_in(m);
+    *m->type->simMoteID = m->id;
+    *m->type->simMoteIDChanged = 1;
+    *m->type->simRandomSeed = (int)(seed + m->id);
+    if(replay_has_boot) {
+      *m->type->simRandomSeed = replay_seed;
+    }
+    m->type->init(NULL, NULL);
+    m->radio_on = *m->type->simRadioHWOn;
+    if(replay_file != NULL) {
+      /* The node boots on its second tick. */
+      schedule(m, replay_boot > MILLISECOND ? replay_boot - MILLISECOND : 0);
+    } else {
+      /* Whole milliseconds, as in COOJA: the nodes tick on them. */
+      schedule(m, (int64_t)(rng_uniform() * max_startup_delay / MILLISECOND) *
+               MILLISECOND);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_stats(void)
+{
+  FILE *f;
+  struct mote *m;
+  int i;
+
+  f = stdout;
+  if(stats_file != NULL) {
+    f = fopen(stats_file, "w");
+    if(f == NULL) {
+      fatal("cannot create stats file", stats_file);
+    }
+  }
+
+  fprintf(f, "# id ticks tx tx_bytes rx rx_bytes rx_lost rx_collisions"
+          " radio_on_percent\n");
+  for(i = 0; i < nmotes; i++) {
+    m = &motes[i];
+    if(m->radio_on) {
+      m->radio_on_time += now - m->radio_on_since;
+      m->radio_on_since = now;
+    }
+    fprintf(f, "%d %lu %lu %lu %lu %lu %lu %lu %.2f\n", m->id,
+            m->stats.ticks, m->stats.tx, m->stats.tx_bytes,
+            m->stats.rx, m->stats.rx_bytes, m->stats.rx_lost,
+            m->stats.rx_collisions,
+            now > 0 ? 100.0 * m->radio_on_time / now : 0.0);
+  }
+
+  if(f != stdout) {
+    fclose(f);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+usage(void)
+{
+  fprintf(stderr,
+          "usage: netsim [options] firmware[:count] ...\n"
+          "  -t seconds   simulated time (60)\n"
+          "  -s seed      random seed (123456)\n"
+          "  -r meters    transmission range (50)\n"
+          "  -i meters    interference range (100)\n"
+          "  -a meters    side of the square the nodes are placed in\n"
+          "               (default: about 12 neighbors per node)\n"
+          "  -p file      node positions, \"id x y\" per line\n"
+          "  -x ratio     transmission success ratio (1.0)\n"
+          "  -y ratio     reception success ratio at the edge of the\n"
+          "               range (1.0)\n"
+          "  -m file      loss matrix, \"src dst ratio\" per line, used\n"
+          "               instead of the unit-disk model\n"
+          "  -b kbps      radio bit rate (250)\n"
+          "  -d ms        maximum random startup delay (1000)\n"
+          "  -o file      write per-node statistics to file\n"
+          "  -q           do not print node output\n"
+          "  -R file      replay the frames received in a network trace\n"
+          "               to a single node\n");
+  exit(1);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char *argv[])
+{
+  struct timeval start, stop;
+  struct event e;
+  double wall;
+  int c;
+
+  while((c = getopt(argc, argv, "t:s:r:i:a:p:x:y:m:b:d:o:qR:")) != -1) {
+    switch(c) {
+    case 't':
+      sim_time = (int64_t)(atof(optarg) * SECOND);
+      break;
+    case 's':
+      seed = strtoull(optarg, NULL, 0);
+      break;
+    case 'r':
+      tx_range = atof(optarg);
+      break;
+    case 'i':
+      interference_range = atof(optarg);
+      break;
+    case 'a':
+      area = atof(optarg);
+      break;
+    case 'p':
+      positions_file = optarg;
+      break;
+    case 'x':
+      tx_success = atof(optarg);
+      break;
+    case 'y':
+      rx_success = atof(optarg);
+      break;
+    case 'm':
+      matrix_file = optarg;
+      break;
+    case 'b':
+      bitrate_kbps = atof(optarg);
+      break;
+    case 'd':
+      max_startup_delay = (int64_t)(atof(optarg) * MILLISECOND);
+      break;
+    case 'o':
+      stats_file = optarg;
+      break;
+    case 'q':
+      quiet = 1;
+      break;
+    case 'R':
+      replay_file = optarg;
+      break;
+    default:
+      usage();
+    }
+  }
+  if(optind == argc || bitrate_kbps <= 0) {
+    usage();
+  }
+
+  rng_state = seed * 2654435761ULL + 1;
+  create_motes(argc - optind, argv + optind);
+  if(replay_file != NULL) {
+    if(nmotes != 1) {
+      fatal("a trace is replayed to exactly one node", NULL);
+    }
+    /* Do not overwrite the recorded trace with the new one. */
+    setenv("NETTRACE_PREFIX", "replay-", 0);
+    load_replay();
+  } else if(matrix_file != NULL) {
+    matrix_links();
+  } else {
+    unit_disk_links();
+  }
+
+  gettimeofday(&start, NULL);
+  boot_motes();
+
+  while(heap_len > 0 && heap[0].time <= sim_time) {
+    e = heap_pop();
+    now = e.time;
+    switch(e.type) {
+    case EV_TICK:
+      if(e.mote->wakeup != e.time) {
+        /* Superseded by an earlier tick. */
+        continue;
+      }
+      e.mote->wakeup = NEVER;
+      tick(e.mote);
+      break;
+    case EV_TX_END:
+      end_transmission(e.tx);
+      break;
+    case EV_REPLAY_START:
+      replay_start(e.mote, e.tx);
+      break;
+    case EV_REPLAY_END:
+      replay_end(e.mote, e.tx);
+      break;
+    }
+  }
+  now = sim_time;
+  gettimeofday(&stop, NULL);
+
+  fflush(stdout);
+  print_stats();
+
+  wall = (stop.tv_sec - start.tv_sec) + (stop.tv_usec - start.tv_usec) / 1e6;
+  fprintf(stderr, "netsim: %d nodes, %.1f simulated seconds in %.2f s"
+          " (%.0fx real time)\n", nmotes, (double)sim_time / SECOND, wall,
+          wall > 0 ? sim_time / (wall * SECOND) : 0.0);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
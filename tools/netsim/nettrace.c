@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2026, agent <agent@local>.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         nettrace: prints and compares network traces
+ *         (see core/net/nettrace.h).
+ *
+ *           nettrace dump trace
+ *           nettrace diff [-i] [-t types] trace1 trace2
+ *
+ *         diff compares the records of two traces in order, and
+ *         exits with status 1 at the first records that differ.
+ *         -i ignores record times; -t compares only the records
+ *         of the given comma-separated types (boot, rx, tx, ip-in,
+ *         ip-out).
+ * \author
+ *         agent <agent@local>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Network trace format, see core/net/nettrace.h. */
+#define NETTRACE_HEADER_LEN  8
+#define NETTRACE_RECORD_LEN  7
+#define NETTRACE_BOOT        1
+#define NETTRACE_IP_OUT      5
+
+#define MAX_DATA 65535
+
+static const char *type_names[] = {
+  "?", "boot", "rx", "tx", "ip-in", "ip-out"
+};
+
+struct trace {
+  const char *file;
+  FILE *f;
+  unsigned long clock_second;
+  unsigned long n;
+};
+
+struct record {
+  unsigned long time;
+  int type;
+  int len;
+  unsigned char data[MAX_DATA];
+};
+
+static struct record r1, r2;
+/*---------------------------------------------------------------------------*/
+static void
+fatal(const char *message, const char *arg)
+{
+  fprintf(stderr, "nettrace: %s%s%s\n", message, arg ? ": " : "",
+          arg ? arg : "");
+  exit(2);
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+get_le(const unsigned char *p, int len)
+{
+  unsigned long v;
+
+  v = 0;
+  while(len-- > 0) {
+    v = (v << 8) | p[len];
+  }
+  return v;
+}
+/*---------------------------------------------------------------------------*/
+static const char *
+type_name(int type)
+{
+  if(type <= 0 || type > NETTRACE_IP_OUT) {
+    return type_names[0];
+  }
+  return type_names[type];
+}
+/*---------------------------------------------------------------------------*/
+static void
+open_trace(struct trace *t, const char *file)
+{
+  unsigned char header[NETTRACE_HEADER_LEN];
+
+  t->file = file;
+  t->n = 0;
+  t->f = fopen(file, "rb");
+  if(t->f == NULL) {
+    fatal("cannot open trace", file);
+  }
+  if(fread(header, 1, sizeof(header), t->f) != sizeof(header) ||
+     memcmp(header, "CNTR", 4) != 0) {
+    fatal("not a network trace", file);
+  }
+  if(header[4] != 1) {
+    fatal("unknown trace version", file);
+  }
+  t->clock_second = get_le(&header[6], 2);
+  if(t->clock_second == 0) {
+    fatal("bad clock rate", file);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Reads the next record. Times are converted to milliseconds. */
+static int
+read_record(struct trace *t, struct record *r)
+{
+  unsigned char header[NETTRACE_RECORD_LEN];
+
+  if(fread(header, 1, sizeof(header), t->f) != sizeof(header)) {
+    return 0;
+  }
+  r->time = get_le(&header[0], 4) * 1000ULL / t->clock_second;
+  r->type = header[4];
+  r->len = get_le(&header[5], 2);
+  if(fread(r->data, 1, r->len, t->f) != r->len) {
+    fatal("truncated trace", t->file);
+  }
+  t->n++;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_record(const char *prefix, struct record *r)
+{
+  int i;
+
+  printf("%s%lu\t%s\t%d\t", prefix, r->time, type_name(r->type), r->len);
+  if(r->type == NETTRACE_BOOT && r->len >= 6) {
+    printf("id %lu seed %lu\n", get_le(r->data, 2), get_le(r->data + 2, 4));
+    return;
+  }
+  for(i = 0; i < r->len; i++) {
+    printf("%02x", r->data[i]);
+  }
+  printf("\n");
+}
+/*---------------------------------------------------------------------------*/
+static int
+dump(const char *file)
+{
+  struct trace t;
+
+  open_trace(&t, file);
+  while(read_record(&t, &r1)) {
+    print_record("", &r1);
+  }
+  fclose(t.f);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+parse_types(char *list)
+{
+  unsigned mask;
+  char *name;
+  int i;
+
+  mask = 0;
+  for(name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+    for(i = 1; i <= NETTRACE_IP_OUT; i++) {
+      if(strcmp(name, type_names[i]) == 0) {
+        mask |= 1 << i;
+        break;
+      }
+    }
+    if(i > NETTRACE_IP_OUT) {
+      fatal("unknown record type", name);
+    }
+  }
+  return mask;
+}
+/*---------------------------------------------------------------------------*/
+static int
+next_selected(struct trace *t, struct record *r, unsigned types)
+{
+  while(read_record(t, r)) {
+    if(types & (1 << r->type)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+diff(int argc, char *argv[])
+{
+  struct trace t1, t2;
+  unsigned types;
+  unsigned long n;
+  int ignore_time, more1, more2, c;
+
+  ignore_time = 0;
+  types = ~0;
+  while((c = getopt(argc, argv, "it:")) != -1) {
+    switch(c) {
+    case 'i':
+      ignore_time = 1;
+      break;
+    case 't':
+      types = parse_types(optarg);
+      break;
+    default:
+      return -1;
+    }
+  }
+  if(argc - optind != 2) {
+    return -1;
+  }
+  open_trace(&t1, argv[optind]);
+  open_trace(&t2, argv[optind + 1]);
+
+  for(n = 1;; n++) {
+    more1 = next_selected(&t1, &r1, types);
+    more2 = next_selected(&t2, &r2, types);
+    if(!more1 && !more2) {
+      printf("traces are equal: %lu records compared\n", n - 1);
+      return 0;
+    }
+    if(!more1 || !more2) {
+      printf("%s ends after %lu compared records\n",
+             more1 ? t2.file : t1.file, n - 1);
+      if(more1) {
+        print_record("< ", &r1);
+      } else {
+        print_record("> ", &r2);
+      }
+      return 1;
+    }
+    if(r1.type != r2.type || r1.len != r2.len ||
+       memcmp(r1.data, r2.data, r1.len) != 0 ||
+       (!ignore_time && r1.time != r2.time)) {
+      printf("record %lu differs (records %lu and %lu in the traces)\n",
+             n, t1.n, t2.n);
+      print_record("< ", &r1);
+      print_record("> ", &r2);
+      return 1;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+usage(void)
+{
+  fprintf(stderr,
+          "usage: nettrace dump trace\n"
+          "       nettrace diff [-i] [-t types] trace1 trace2\n"
+          "  -i           ignore record times\n"
+          "  -t types     compare only these record types, separated by\n"
+          "               commas: boot, rx, tx, ip-in, ip-out\n");
+  exit(2);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char *argv[])
+{
+  int ret;
+
+  ret = -1;
+  if(argc == 3 && strcmp(argv[1], "dump") == 0) {
+    ret = dump(argv[2]);
+  } else if(argc >= 4 && strcmp(argv[1], "diff") == 0) {
+    ret = diff(argc - 1, argv + 1);
+  }
+  if(ret < 0) {
+    usage();
+  }
+  return ret;
+}
+/*---------------------------------------------------------------------------*/